@@ -0,0 +1,75 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Converts a binary visualizer log (-visualizer_binary_outputfile) back into
+// the text log read by AerialVision. The output is gzip compressed when its
+// name ends in ".gz".
+//
+// usage: vislog2txt <binary log> <text log>
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+#include <string>
+#include "../src/gpgpu-sim/visualizer_binlog.h"
+
+int main( int argc, char **argv )
+{
+   if (argc != 3) {
+      fprintf(stderr,"usage: %s <binary visualizer log> <text visualizer log>\n", argv[0]);
+      return 1;
+   }
+   visualizer_binlog_reader reader;
+   if (!reader.open(argv[1])) {
+      fprintf(stderr,"error - %s: %s\n", argv[1], reader.error());
+      return 1;
+   }
+   size_t len = strlen(argv[2]);
+   bool gzipped = len > 3 && strcmp(argv[2]+len-3,".gz") == 0;
+   gzFile out = gzopen(argv[2], gzipped? "wb" : "wbT");
+   if (out == NULL) {
+      fprintf(stderr,"error - could not open %s\n", argv[2]);
+      return 1;
+   }
+   std::string sample;
+   unsigned n_samples = 0;
+   while (reader.next_sample(sample)) {
+      if (!sample.empty() && gzwrite(out,sample.data(),sample.size()) <= 0) {
+         fprintf(stderr,"error - write to %s failed\n", argv[2]);
+         gzclose(out);
+         return 1;
+      }
+      n_samples++;
+   }
+   gzclose(out);
+   if (reader.error()) {
+      fprintf(stderr,"error - %s: %s (after %u samples)\n", argv[1], reader.error(), n_samples);
+      return 1;
+   }
+   printf("%u samples converted\n", n_samples);
+   return 0;
+}
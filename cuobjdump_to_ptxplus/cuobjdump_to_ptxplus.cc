@@ -27,101 +27,107 @@
 
 #include <iostream>
 #include <stdio.h>
-#include <fstream>
-#include <cassert>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 #include "cuobjdumpInstList.h"
+#include "cuobjdump_to_ptxplus.h"
 
 using namespace std;
 
-cuobjdumpInstList *g_instList = new cuobjdumpInstList();
-cuobjdumpInstList *g_headerList = new cuobjdumpInstList();
+cuobjdumpInstList *g_instList = NULL;
+cuobjdumpInstList *g_headerList = NULL;
+
+typedef struct yy_buffer_state *YY_BUFFER_STATE;
 
 int sass_parse();
-extern FILE *sass_in;
+extern int sass_lineno;
+YY_BUFFER_STATE sass__scan_string( const char *str );
+void sass__delete_buffer( YY_BUFFER_STATE b );
 
 int ptx_parse();
-extern FILE *ptx_in;
+extern int ptx_lineno;
+YY_BUFFER_STATE ptx__scan_string( const char *str );
+void ptx__delete_buffer( YY_BUFFER_STATE b );
 
 int elf_parse();
-extern FILE *elf_in;
+extern int elf_lineno;
+YY_BUFFER_STATE elf__scan_string( const char *str );
+void elf__delete_buffer( YY_BUFFER_STATE b );
 
+// parser state defined in ptx_parser.h and elf.y
 extern int g_error_detected;
+extern bool inEntryDirective;
+extern bool inParamDirective;
+extern bool inConstDirective;
+extern bool inTexDirective;
+extern int cmemcount;
+extern int lmemcount;
+
+// the parsers and instruction lists are not re-entrant, one conversion at a time
+static pthread_mutex_t g_convert_lock = PTHREAD_MUTEX_INITIALIZER;
 
-FILE *bin_in;
-FILE *ptxplus_out;
+// ptxplus text of the conversion in progress
+static std::string g_ptxplus_out;
 
 void output(const char * text)
 {
-	//printf(text);
-	fprintf(ptxplus_out, text);
+	g_ptxplus_out += text;
 }
 
 void output(const std::string text) {
-	output(text.c_str());
-}
-
-std::string fileToString(const char * fileName) {
-	ifstream fileStream(fileName, ios::in);
-	string text, line;
-	while(getline(fileStream,line)) {
-		text += (line + "\n");
-	}
-	fileStream.close();
-	return text;
+	g_ptxplus_out += text;
 }
 
-std::string extractFilename( const std::string& path )
+static void reset_parser_state()
 {
-	return path.substr( path.find_last_of( '/' ) +1 );
+	delete g_instList;
+	delete g_headerList;
+	g_instList = new cuobjdumpInstList();
+	g_headerList = new cuobjdumpInstList();
+
+	g_error_detected = 0;
+	inEntryDirective = false;
+	inParamDirective = false;
+	inConstDirective = false;
+	inTexDirective = false;
+	cmemcount = 1;
+	lmemcount = 1;
+	sass_lineno = 1;
+	ptx_lineno = 1;
+	elf_lineno = 1;
+
+	g_ptxplus_out.clear();
 }
 
-int main(int argc, char* argv[])
+static bool convert( const char *ptx, const char *sass, const char *elf )
 {
-	if(argc != 5)
-	{
-		cout << "Usage: " << argv[0] << " ptxfile sassfile elffile ptxplusfile(output)\n";
-		return 0;
-	}
-
-	string ptxfile = argv[1];
-	string sassfile = argv[2];
-	string elffile = argv[3];
-	string ptxplusfile = argv[4];
-
-	sass_in = fopen(sassfile.c_str(), "r" );
-	ptx_in = fopen(ptxfile.c_str(), "r" );
-	elf_in = fopen(elffile.c_str(), "r");
-	ptxplus_out = fopen(ptxplusfile.c_str(), "w" );
-
-
-	std::string elf = fileToString(elffile.c_str());
+	YY_BUFFER_STATE buf;
 
-	printf("RUNNING cuobjdump_to_ptxplus ...\n");
-
-
-	printf("Parsing .elf file %s\n", elffile.c_str());
+	printf("Parsing .elf section\n");
+	buf = elf__scan_string(elf);
 	elf_parse();
-	printf("Finished parsing .elf file %s\n", elffile.c_str());
+	elf__delete_buffer(buf);
 
 	//Parse original ptx
-	printf("Parsing .ptx file %s\n", ptxfile.c_str());
+	printf("Parsing .ptx section\n");
+	buf = ptx__scan_string(ptx);
 	ptx_parse();
+	ptx__delete_buffer(buf);
 	if (g_error_detected){
-		assert(0 && "ptx parsing failed");
+		printf("ERROR: ptx parsing failed\n");
+		return false;
 	}
-	printf("Finished parsing .ptx file %s\n", ptxfile.c_str());
 
 	// Copy real tex list from ptx to ptxplus instruction list
 	g_instList->setRealTexList(g_headerList->getRealTexList());
 
-	// Insert global memory from bin file
-//	g_instList->readGlobalMemoryFromBinFile(fileToString(binFilename));
-
 	// Parse cuobjdump output
-	printf("Parsing .sass file %s\n", sassfile.c_str());
+	printf("Parsing .sass section\n");
+	buf = sass__scan_string(sass);
 	sass_parse();
-	printf("Finished parsing .sass file %s\n", sassfile.c_str());
+	sass__delete_buffer(buf);
 
 	// Print ptxplus
 	output("//HEADER\n");
@@ -130,14 +136,21 @@ int main(int argc, char* argv[])
 	output("//INSTRUCTIONS\n");
 	g_instList->printCuobjdumpPtxPlusList(g_headerList);
 	output("//END INSTRUCTIONS\n");
+	return true;
+}
 
-	fclose(sass_in);
-	fclose(ptx_in);
-
-	fclose(ptxplus_out);
+extern "C" char *cuobjdump_to_ptxplus( const char *ptx, const char *sass, const char *elf )
+{
+	char *ptxplus = NULL;
 
+	pthread_mutex_lock(&g_convert_lock);
+	printf("RUNNING cuobjdump_to_ptxplus ...\n");
+	reset_parser_state();
+	if (convert(ptx, sass, elf))
+		ptxplus = strdup(g_ptxplus_out.c_str());
+	g_ptxplus_out.clear();
 	printf("DONE. \n");
+	pthread_mutex_unlock(&g_convert_lock);
 
-	return 0;
+	return ptxplus;
 }
-
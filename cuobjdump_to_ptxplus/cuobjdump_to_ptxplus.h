@@ -0,0 +1,41 @@
+// Copyright (c) 2009-2012, Jimmy Kwa, Andrew Boktor
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _CUOBJDUMP_TO_PTXPLUS_H_
+#define _CUOBJDUMP_TO_PTXPLUS_H_
+
+// In-process interface to the ptxplus converter.  The converter is linked into
+// the simulator as a single object that only exports this function, so its
+// parsers do not clash with the simulator's own PTX parser.
+//
+// Converts the cuobjdump output of one binary (its .ptx, .sass and .elf
+// sections, passed as text) to ptxplus.  Returns a malloc'ed string the caller
+// must free, or NULL if one of the sections could not be parsed.  Calls are
+// serialized internally, so the function can be used from several threads.
+extern "C" char *cuobjdump_to_ptxplus( const char *ptx, const char *sass, const char *elf );
+
+#endif //_CUOBJDUMP_TO_PTXPLUS_H_
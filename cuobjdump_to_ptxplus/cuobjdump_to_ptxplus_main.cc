@@ -0,0 +1,69 @@
+// Copyright (c) 2009-2012, Jimmy Kwa, Andrew Boktor
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+
+#include "cuobjdump_to_ptxplus.h"
+
+using namespace std;
+
+std::string fileToString(const char * fileName) {
+	ifstream fileStream(fileName, ios::in);
+	string text, line;
+	while(getline(fileStream,line)) {
+		text += (line + "\n");
+	}
+	fileStream.close();
+	return text;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc != 5)
+	{
+		cout << "Usage: " << argv[0] << " ptxfile sassfile elffile ptxplusfile(output)\n";
+		return 0;
+	}
+
+	string ptx = fileToString(argv[1]);
+	string sass = fileToString(argv[2]);
+	string elf = fileToString(argv[3]);
+
+	char *ptxplus = cuobjdump_to_ptxplus(ptx.c_str(), sass.c_str(), elf.c_str());
+	if (ptxplus == NULL)
+		return 1;
+
+	FILE *ptxplus_out = fopen(argv[4], "w");
+	fputs(ptxplus, ptxplus_out);
+	fclose(ptxplus_out);
+	free(ptxplus);
+
+	return 0;
+}
@@ -111,6 +111,8 @@
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <iterator>
+#include <vector>
 #ifdef OPENGL_SUPPORT
 #define GL_GLEXT_PROTOTYPES
 #ifdef __APPLE__
@@ -133,22 +135,28 @@
 #include "../src/cuda-sim/ptx_parser.h"
 #include "../src/gpgpusim_entrypoint.h"
 #include "../src/stream_manager.h"
+#include "../src/gpgpu-sim/workload_log.h"
 
 #include <pthread.h>
 #include <semaphore.h>
 
+#include <sys/stat.h>
 #ifdef __APPLE__
 #include <mach-o/dyld.h>
+#else
+#include <elf.h>
 #endif
 
 extern void synchronize();
 extern void exit_simulation();
+void cuobjdumpParseBinary(unsigned int handle);
 
 static int load_static_globals( symbol_table *symtab, unsigned min_gaddr, unsigned max_gaddr, gpgpu_t *gpu );
+static void load_module_data( symbol_table *symtab );
 static int load_constants( symbol_table *symtab, addr_t min_gaddr, gpgpu_t *gpu );
 
 static kernel_info_t *gpgpu_cuda_ptx_sim_init_grid( const char *kernel_key, 
-		gpgpu_ptx_sim_arg_list_t args,
+		gpgpu_ptx_sim_arg_list_t &args,
 		struct dim3 gridDim,
 		struct dim3 blockDim,
 		struct CUctx_st* context );
@@ -176,7 +184,6 @@ struct cudaArray
 
 cudaError_t g_last_cudaError = cudaSuccess;
 
-extern stream_manager *g_stream_manager;
 
 void register_ptx_function( const char *name, function_info *impl )
 {
@@ -198,7 +205,8 @@ void register_ptx_function( const char *name, function_info *impl )
 #endif
 
 struct _cuda_device_id {
-	_cuda_device_id(gpgpu_sim* gpu) {m_id = 0; m_next = NULL; m_gpgpu=gpu;}
+	_cuda_device_id(gpgpu_sim* gpu, unsigned id = 0) {m_id = id; m_next = NULL; m_gpgpu=gpu;}
+	void set_next( struct _cuda_device_id *next ) { m_next = next; }
 	struct _cuda_device_id *next() { return m_next; }
 	unsigned num_shader() const { return m_gpgpu->get_config().num_shader(); }
 	int num_devices() const {
@@ -226,50 +234,84 @@ private:
 	struct _cuda_device_id *m_next;
 };
 
+// device selected by cudaSetDevice, per host thread as in the CUDA runtime
+static __thread int g_active_device = 0;
+
 struct CUctx_st {
-	CUctx_st( _cuda_device_id *gpu ) { m_gpu = gpu; }
+	CUctx_st( _cuda_device_id *gpu ) { m_gpu = gpu; pthread_mutex_init(&m_kernel_lock,NULL); }
 
-	_cuda_device_id *get_device() { return m_gpu; }
+	// all simulated devices share one context; it follows the calling thread's active device
+	_cuda_device_id *get_device() { return m_gpu->get_device(g_active_device); }
 
 	void add_binary( symbol_table *symtab, unsigned fat_cubin_handle )
 	{
+		pthread_mutex_lock(&m_kernel_lock);
 		m_code[fat_cubin_handle] = symtab;
 		m_last_fat_cubin_handle = fat_cubin_handle;
+		pthread_mutex_unlock(&m_kernel_lock);
 	}
 
+	// called while the module of m_last_fat_cubin_handle is loaded, under
+	// the module lock
 	void add_ptxinfo( const char *deviceFun, const struct gpgpu_ptx_sim_kernel_info &info )
 	{
-		symbol *s = m_code[m_last_fat_cubin_handle]->lookup(deviceFun);
+		pthread_mutex_lock(&m_kernel_lock);
+		symbol_table *symtab = m_code[m_last_fat_cubin_handle];
+		pthread_mutex_unlock(&m_kernel_lock);
+		symbol *s = symtab->lookup(deviceFun);
 		assert( s != NULL );
 		function_info *f = s->get_pc();
 		assert( f != NULL );
 		f->set_kernel_info(info);
 	}
 
+	// the kernel is resolved on first use, so a binary extracted with cuobjdump
+	// is only parsed once one of its kernels is actually used
 	void register_function( unsigned fat_cubin_handle, const char *hostFun, const char *deviceFun )
 	{
-		if( m_code.find(fat_cubin_handle) != m_code.end() ) {
-			symbol *s = m_code[fat_cubin_handle]->lookup(deviceFun);
-			assert( s != NULL );
-			function_info *f = s->get_pc();
-			assert( f != NULL );
-			m_kernel_lookup[hostFun] = f;
-		} else {
-			m_kernel_lookup[hostFun] = NULL;
-		}
+		pthread_mutex_lock(&m_kernel_lock);
+		m_kernel_names[hostFun] = std::make_pair(fat_cubin_handle, std::string(deviceFun));
+		m_kernel_lookup.erase(hostFun);
+		pthread_mutex_unlock(&m_kernel_lock);
 	}
 
 	function_info *get_kernel(const char *hostFun)
 	{
+		pthread_mutex_lock(&m_kernel_lock);
 		std::map<const void*,function_info*>::iterator i=m_kernel_lookup.find(hostFun);
-		assert( i != m_kernel_lookup.end() );
-		return i->second;
+		if( i != m_kernel_lookup.end() ) {
+			function_info *f = i->second;
+			pthread_mutex_unlock(&m_kernel_lock);
+			return f;
+		}
+		std::map<const void*,std::pair<unsigned,std::string> >::iterator n=m_kernel_names.find(hostFun);
+		assert( n != m_kernel_names.end() );
+		unsigned fat_cubin_handle = n->second.first;
+		std::string deviceFun = n->second.second;
+		if( m_code.find(fat_cubin_handle) == m_code.end() && get_device()->get_gpgpu()->get_config().use_cuobjdump() ) {
+			// parsing serializes itself and calls back into add_binary()
+			pthread_mutex_unlock(&m_kernel_lock);
+			cuobjdumpParseBinary(fat_cubin_handle);
+			pthread_mutex_lock(&m_kernel_lock);
+		}
+		function_info *f = NULL;
+		if( m_code.find(fat_cubin_handle) != m_code.end() ) {
+			symbol *s = m_code[fat_cubin_handle]->lookup(deviceFun.c_str());
+			assert( s != NULL );
+			f = s->get_pc();
+			assert( f != NULL );
+		}
+		m_kernel_lookup[hostFun] = f;
+		pthread_mutex_unlock(&m_kernel_lock);
+		return f;
 	}
 
 private:
-	_cuda_device_id *m_gpu; // selected gpu
+	_cuda_device_id *m_gpu; // first gpu of the device list
 	std::map<unsigned,symbol_table*> m_code; // fat binary handle => global symbol table
 	unsigned m_last_fat_cubin_handle;
+	pthread_mutex_t m_kernel_lock;
+	std::map<const void*,std::pair<unsigned,std::string> > m_kernel_names; // unique id (CUDA app function address) => fat binary handle, kernel name
 	std::map<const void*,function_info*> m_kernel_lookup; // unique id (CUDA app function address) => kernel entry point
 };
 
@@ -288,7 +330,7 @@ public:
 	}
 	dim3 grid_dim() const { return m_GridDim; }
 	dim3 block_dim() const { return m_BlockDim; }
-	gpgpu_ptx_sim_arg_list_t get_args() { return m_args; }
+	gpgpu_ptx_sim_arg_list_t &get_args() { return m_args; }
 	struct CUstream_st *get_stream() { return m_stream; }
 
 private:
@@ -303,32 +345,41 @@ class _cuda_device_id *GPGPUSim_Init()
 {
 	static _cuda_device_id *the_device = NULL;
 	if( !the_device ) {
-		gpgpu_sim *the_gpu = gpgpu_ptx_sim_init_perf();
-
-		cudaDeviceProp *prop = (cudaDeviceProp *) calloc(sizeof(cudaDeviceProp),1);
-		snprintf(prop->name,256,"GPGPU-Sim_v%s", g_gpgpusim_version_string );
-		prop->major = 2;
-		prop->minor = 0;
-		prop->totalGlobalMem = 0x40000000 /* 1 GB */;
-		prop->memPitch = 0;
-		prop->maxThreadsPerBlock = 512;
-		prop->maxThreadsDim[0] = 512;
-		prop->maxThreadsDim[1] = 512;
-		prop->maxThreadsDim[2] = 512;
-		prop->maxGridSize[0] = 0x40000000;
-		prop->maxGridSize[1] = 0x40000000;
-		prop->maxGridSize[2] = 0x40000000;
-		prop->totalConstMem = 0x40000000;
-		prop->textureAlignment = 0;
-		prop->sharedMemPerBlock = the_gpu->shared_mem_size();
-		prop->regsPerBlock = the_gpu->num_registers_per_core();
-		prop->warpSize = the_gpu->wrp_size();
-		prop->clockRate = the_gpu->shader_clock();
+		gpgpu_ptx_sim_init_perf();
+		_cuda_device_id *last = NULL;
+		for( unsigned n=0; n < gpgpu_ptx_sim_num_devices(); n++ ) {
+			gpgpu_sim *the_gpu = gpgpu_ptx_sim_device(n);
+
+			cudaDeviceProp *prop = (cudaDeviceProp *) calloc(sizeof(cudaDeviceProp),1);
+			snprintf(prop->name,256,"GPGPU-Sim_v%s", g_gpgpusim_version_string );
+			prop->major = 2;
+			prop->minor = 0;
+			prop->totalGlobalMem = 0x40000000 /* 1 GB */;
+			prop->memPitch = 0;
+			prop->maxThreadsPerBlock = 512;
+			prop->maxThreadsDim[0] = 512;
+			prop->maxThreadsDim[1] = 512;
+			prop->maxThreadsDim[2] = 512;
+			prop->maxGridSize[0] = 0x40000000;
+			prop->maxGridSize[1] = 0x40000000;
+			prop->maxGridSize[2] = 0x40000000;
+			prop->totalConstMem = 0x40000000;
+			prop->textureAlignment = 0;
+			prop->sharedMemPerBlock = the_gpu->shared_mem_size();
+			prop->regsPerBlock = the_gpu->num_registers_per_core();
+			prop->warpSize = the_gpu->wrp_size();
+			prop->clockRate = the_gpu->shader_clock();
 #if (CUDART_VERSION >= 2010)
-		prop->multiProcessorCount = the_gpu->get_config().num_shader();
+			prop->multiProcessorCount = the_gpu->get_config().num_shader();
 #endif
-		the_gpu->set_prop(prop);
-		the_device = new _cuda_device_id(the_gpu);
+			the_gpu->set_prop(prop);
+			_cuda_device_id *dev = new _cuda_device_id(the_gpu,n);
+			if( last ) 
+				last->set_next(dev);
+			else
+				the_device = dev;
+			last = dev;
+		}
 	}
 	start_sim_thread(1);
 	return the_device;
@@ -341,6 +392,9 @@ static CUctx_st* GPGPUSim_Context()
 		_cuda_device_id *the_gpu = GPGPUSim_Init();
 		the_context = new CUctx_st(the_gpu);
 	}
+	// host threads start out on their active device (0 unless set)
+	if( g_stream_manager == NULL ) 
+		gpgpu_ptx_sim_set_device(g_active_device);
 	return the_context;
 }
 
@@ -402,7 +456,6 @@ typedef std::map<unsigned,CUevent_st*> event_tracker_t;
 
 int CUevent_st::m_next_event_uid;
 event_tracker_t g_timer_events;
-int g_active_device = 0; //active gpu that runs the code
 std::list<kernel_config> g_cuda_launch_stack;
 
 /*******************************************************************************
@@ -478,7 +531,13 @@ __host__ cudaError_t CUDARTAPI cudaMallocArray(struct cudaArray **array, const s
 
 __host__ cudaError_t CUDARTAPI cudaFree(void *devPtr)
 {
-	// TODO...  manage g_global_mem space?
+	if( devPtr == NULL ) 
+		return g_last_cudaError = cudaSuccess;
+	CUctx_st* context = GPGPUSim_Context();
+	// like the hardware, wait for work that may still use the block
+	synchronize();
+	if( !context->get_device()->get_gpgpu()->gpu_free((size_t)devPtr) ) 
+		return g_last_cudaError = cudaErrorInvalidDevicePointer;
 	return g_last_cudaError = cudaSuccess;
 }
 __host__ cudaError_t CUDARTAPI cudaFreeHost(void *ptr)
@@ -489,7 +548,16 @@ __host__ cudaError_t CUDARTAPI cudaFreeHost(void *ptr)
 
 __host__ cudaError_t CUDARTAPI cudaFreeArray(struct cudaArray *array)
 {
-	// TODO...  manage g_global_mem space?
+	if( array == NULL ) 
+		return g_last_cudaError = cudaSuccess;
+	CUctx_st* context = GPGPUSim_Context();
+	synchronize();
+	gpgpu_t *gpu = context->get_device()->get_gpgpu();
+	if( !gpu->gpu_free((size_t)array->devPtr) ) 
+		return g_last_cudaError = cudaErrorInvalidValue;
+	// texture references still bound to the array would read freed memory
+	gpu->gpgpu_ptx_sim_unbindArray(array);
+	free(array);
 	return g_last_cudaError = cudaSuccess;
 };
 
@@ -755,8 +823,8 @@ __host__ cudaError_t CUDARTAPI cudaGetDeviceCount(int *count)
 __host__ cudaError_t CUDARTAPI cudaGetDeviceProperties(struct cudaDeviceProp *prop, int device)
 {
 	_cuda_device_id *dev = GPGPUSim_Init();
-	if (device <= dev->num_devices() )  {
-		*prop= *dev->get_prop();
+	if (device >= 0 && device < dev->num_devices() )  {
+		*prop= *dev->get_device(device)->get_prop();
 		return g_last_cudaError = cudaSuccess;
 	} else {
 		return g_last_cudaError = cudaErrorInvalidDevice;
@@ -773,8 +841,9 @@ __host__ cudaError_t CUDARTAPI cudaChooseDevice(int *device, const struct cudaDe
 __host__ cudaError_t CUDARTAPI cudaSetDevice(int device)
 {
 	//set the active device to run cuda
-	if ( device <= GPGPUSim_Init()->num_devices() ) {
+	if ( device >= 0 && device < GPGPUSim_Init()->num_devices() ) {
 		g_active_device = device;
+		gpgpu_ptx_sim_set_device(device);
 		return g_last_cudaError = cudaSuccess;
 	} else {
 		return g_last_cudaError = cudaErrorInvalidDevice;
@@ -911,7 +980,7 @@ __host__ cudaError_t CUDARTAPI cudaLaunch( const char *hostFun )
 	if( mode )
 		sscanf(mode,"%u", &g_ptx_sim_mode);
 	gpgpusim_ptx_assert( !g_cuda_launch_stack.empty(), "empty launch stack" );
-	kernel_config config = g_cuda_launch_stack.back();
+	kernel_config &config = g_cuda_launch_stack.back(); // popped once the launch is queued
 	struct CUstream_st *stream = config.get_stream();
 	printf("\nGPGPU-Sim PTX: cudaLaunch for 0x%p (mode=%s) on stream %u\n", hostFun,
 			g_ptx_sim_mode?"functional simulation":"performance simulation", stream?stream->get_uid():0 );
@@ -1037,8 +1106,7 @@ __host__ cudaError_t CUDARTAPI cudaEventSynchronize(cudaEvent_t event)
 	printf("GPGPU-Sim API: cudaEventSynchronize ** waiting for event\n");
 	fflush(stdout);
 	CUevent_st *e = (CUevent_st*) event;
-	while( !e->done() )
-		;
+	g_stream_manager->wait_event(e);
 	printf("GPGPU-Sim API: cudaEventSynchronize ** event detected\n");
 	fflush(stdout);
 	return g_last_cudaError = cudaSuccess;
@@ -1283,6 +1351,115 @@ std::string get_app_binary(){
    return self_exe_path; 
 }
 
+//! Content hash of the fatbinary embedded in the application binary
+/*!
+ *	Used as the key of the cuobjdump section cache.  Only the .nv_fatbin section
+ *	is hashed so that rebuilding the host code alone keeps the cached sections
+ *	valid; the whole file is hashed if that section cannot be found.
+ * */
+static std::string fatbin_content_hash(const std::string &app_binary){
+	std::ifstream in(app_binary.c_str(), std::ios::in | std::ios::binary);
+	std::string image((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	size_t begin = 0;
+	size_t end = image.size();
+#ifndef __APPLE__
+	if (image.size() >= sizeof(Elf64_Ehdr) && !memcmp(image.data(), ELFMAG, SELFMAG) &&
+			image[EI_CLASS] == ELFCLASS64) {
+		const Elf64_Ehdr *ehdr = (const Elf64_Ehdr*)image.data();
+		if (ehdr->e_shoff + (size_t)ehdr->e_shnum * sizeof(Elf64_Shdr) <= image.size() &&
+				ehdr->e_shstrndx < ehdr->e_shnum) {
+			const Elf64_Shdr *shdr = (const Elf64_Shdr*)(image.data() + ehdr->e_shoff);
+			const Elf64_Shdr &strtab = shdr[ehdr->e_shstrndx];
+			for (unsigned i = 0; i < ehdr->e_shnum; i++) {
+				if (strtab.sh_offset + shdr[i].sh_name >= image.size())
+					continue;
+				const char *name = image.data() + strtab.sh_offset + shdr[i].sh_name;
+				if (!strncmp(name, ".nv_fatbin", image.size() - (strtab.sh_offset + shdr[i].sh_name)) &&
+						shdr[i].sh_offset + shdr[i].sh_size <= image.size()) {
+					begin = shdr[i].sh_offset;
+					end = begin + shdr[i].sh_size;
+					break;
+				}
+			}
+		}
+	}
+#endif
+	// 64-bit FNV-1a
+	unsigned long long hash = 0xcbf29ce484222325ULL;
+	for (size_t i = begin; i < end; i++) {
+		hash ^= (unsigned char)image[i];
+		hash *= 0x100000001b3ULL;
+	}
+	char key[64];
+	snprintf(key, 64, "%016llx_%zu", hash, end - begin);
+	return key;
+}
+
+static std::string basename_of(const std::string &path){
+	return path.substr(path.find_last_of('/') + 1);
+}
+
+//! Write the index of cuobjdumpSectionList to <dir>/sections
+/*!
+ *	One tab separated line per section, in list order:
+ *	  PTX <arch> <identifier> <ptx file>
+ *	  ELF <arch> <identifier> <elf file> <sass file>
+ *	File names are relative to dir.
+ * */
+static void save_cached_sections(const std::string &dir){
+	std::ofstream index((dir + "/sections").c_str());
+	for (std::list<cuobjdumpSection*>::iterator iter = cuobjdumpSectionList.begin();
+			iter != cuobjdumpSectionList.end();
+			iter++){
+		cuobjdumpPTXSection *ptx = dynamic_cast<cuobjdumpPTXSection*>(*iter);
+		cuobjdumpELFSection *elf = dynamic_cast<cuobjdumpELFSection*>(*iter);
+		if (ptx)
+			index << "PTX\t" << ptx->getArch() << "\t" << ptx->getIdentifier() << "\t"
+			      << basename_of(ptx->getPTXfilename()) << "\n";
+		else if (elf)
+			index << "ELF\t" << elf->getArch() << "\t" << elf->getIdentifier() << "\t"
+			      << basename_of(elf->getELFfilename()) << "\t"
+			      << basename_of(elf->getSASSfilename()) << "\n";
+	}
+}
+
+//! Rebuild cuobjdumpSectionList from a cache entry written by save_cached_sections
+static bool load_cached_sections(const std::string &dir){
+	std::ifstream index((dir + "/sections").c_str());
+	if (!index.is_open())
+		return false;
+	std::string line;
+	while (std::getline(index, line)) {
+		std::vector<std::string> fields;
+		std::stringstream ss(line);
+		std::string field;
+		while (std::getline(ss, field, '\t'))
+			fields.push_back(field);
+		cuobjdumpSection *section;
+		if (fields.size() == 4 && fields[0] == "PTX") {
+			cuobjdumpPTXSection *ptx = new cuobjdumpPTXSection();
+			ptx->setPTXfilename(dir + "/" + fields[3]);
+			section = ptx;
+		} else if (fields.size() == 5 && fields[0] == "ELF") {
+			cuobjdumpELFSection *elf = new cuobjdumpELFSection();
+			elf->setELFfilename(dir + "/" + fields[3]);
+			elf->setSASSfilename(dir + "/" + fields[4]);
+			section = elf;
+		} else {
+			printf("GPGPU-Sim PTX: ERROR ** malformed cuobjdump cache index %s/sections\n", dir.c_str());
+			exit(1);
+		}
+		section->setArch(atoi(fields[1].c_str()));
+		section->setIdentifier(fields[2]);
+		cuobjdumpSectionList.push_back(section);
+	}
+	return true;
+}
+
+// directory (with trailing '/') the cuobjdump parser writes section files to
+std::string g_cuobjdump_section_dir_str;
+const char *g_cuobjdump_section_dir = "";
+
 //! Call cuobjdump to extract everything (-elf -sass -ptx)
 /*!
  *	This Function extract the whole PTX (for all the files) using cuobjdump
@@ -1297,43 +1474,93 @@ void extract_code_using_cuobjdump(){
 
    std::string app_binary = get_app_binary(); 
 
-	char fname[1024];
-	snprintf(fname,1024,"_cuobjdump_complete_output_XXXXXX");
-	int fd=mkstemp(fname);
-	close(fd);
-	// Running cuobjdump using dynamic link to current process
-	snprintf(command,1000,"md5sum %s ", app_binary.c_str());
-	printf("Running md5sum using \"%s\"\n", command);
-	system(command);
-	// Running cuobjdump using dynamic link to current process
-	snprintf(command,1000,"$CUDA_INSTALL_PATH/bin/cuobjdump -ptx -elf -sass %s > %s", app_binary.c_str(), fname);
-	printf("Running cuobjdump using \"%s\"\n", command);
-	bool parse_output = true; 
-	int result = system(command);
-	if(result) {
-		if (context->get_device()->get_gpgpu()->get_config().experimental_lib_support() && (result == 65280)) {  
-			// Some CUDA application may exclusively use kernels provided by CUDA
-			// libraries (e.g. CUBLAS).  Skipping cuobjdump extraction from the
-			// executable for this case. 
-			// 65280 is the return code from cuobjdump denoting the specific error (tested on CUDA 4.0/4.1/4.2)
-			printf("WARNING: Failed to execute: %s\n", command); 
-			printf("         Executable binary does not contain any GPU kernel.\n"); 
-			parse_output = false; 
+	// With a cache directory the sections of a previously seen fatbinary are
+	// reused, and new ones are extracted into a private directory that is
+	// then published under the fatbinary hash.
+	const char *cache_dir = context->get_device()->get_gpgpu()->get_config().cuobjdump_cache_dir();
+	std::string cache_entry;
+	std::string cache_tmp;
+	if (cache_dir) {
+		cache_entry = std::string(cache_dir) + "/" + fatbin_content_hash(app_binary);
+		if (load_cached_sections(cache_entry)) {
+			printf("GPGPU-Sim PTX: using %zu cuobjdump sections cached in %s\n",
+					cuobjdumpSectionList.size(), cache_entry.c_str());
 		} else {
-			printf("ERROR: Failed to execute: %s\n", command); 
-			exit(1);
+			mkdir(cache_dir, 0777);
+			char tmpdir[1024];
+			snprintf(tmpdir, 1024, "%s.XXXXXX", cache_entry.c_str());
+			if (mkdtemp(tmpdir) == NULL) {
+				printf("GPGPU-Sim PTX: ERROR ** could not create %s in cuobjdump cache directory %s\n",
+						tmpdir, cache_dir);
+				exit(1);
+			}
+			cache_tmp = tmpdir;
 		}
 	}
+	if (!cache_dir || !cache_tmp.empty()) {
+		char fname[1024];
+		snprintf(fname,1024,"_cuobjdump_complete_output_XXXXXX");
+		int fd=mkstemp(fname);
+		close(fd);
+		// Running cuobjdump using dynamic link to current process
+		snprintf(command,1000,"md5sum %s ", app_binary.c_str());
+		printf("Running md5sum using \"%s\"\n", command);
+		system(command);
+		// Running cuobjdump using dynamic link to current process
+		snprintf(command,1000,"$CUDA_INSTALL_PATH/bin/cuobjdump -ptx -elf -sass %s > %s", app_binary.c_str(), fname);
+		printf("Running cuobjdump using \"%s\"\n", command);
+		bool parse_output = true; 
+		int result = system(command);
+		if(result) {
+			if (context->get_device()->get_gpgpu()->get_config().experimental_lib_support() && (result == 65280)) {  
+				// Some CUDA application may exclusively use kernels provided by CUDA
+				// libraries (e.g. CUBLAS).  Skipping cuobjdump extraction from the
+				// executable for this case. 
+				// 65280 is the return code from cuobjdump denoting the specific error (tested on CUDA 4.0/4.1/4.2)
+				printf("WARNING: Failed to execute: %s\n", command); 
+				printf("         Executable binary does not contain any GPU kernel.\n"); 
+				parse_output = false; 
+			} else {
+				printf("ERROR: Failed to execute: %s\n", command); 
+				exit(1);
+			}
+		}
 
-	if (parse_output) {
-		printf("Parsing file %s\n", fname);
-		cuobjdump_in = fopen(fname, "r");
+		if (parse_output) {
+			printf("Parsing file %s\n", fname);
+			cuobjdump_in = fopen(fname, "r");
 
-		cuobjdump_parse();
-		fclose(cuobjdump_in);
-		printf("Done parsing!!!\n");
-	} else {
-		printf("Parsing skipped for %s\n", fname); 
+			if (!cache_tmp.empty()) {
+				g_cuobjdump_section_dir_str = cache_tmp + "/";
+				g_cuobjdump_section_dir = g_cuobjdump_section_dir_str.c_str();
+			}
+			cuobjdump_parse();
+			g_cuobjdump_section_dir = "";
+			fclose(cuobjdump_in);
+			printf("Done parsing!!!\n");
+		} else {
+			printf("Parsing skipped for %s\n", fname); 
+		}
+
+		if (!cache_tmp.empty()) {
+			save_cached_sections(cache_tmp);
+			if (rename(cache_tmp.c_str(), cache_entry.c_str()) != 0) {
+				// another simulation published the same fatbinary first
+				snprintf(command, 1000, "rm -rf %s", cache_tmp.c_str());
+				system(command);
+			}
+			for (std::list<cuobjdumpSection*>::iterator iter = cuobjdumpSectionList.begin();
+					iter != cuobjdumpSectionList.end();
+					iter++)
+				delete *iter;
+			cuobjdumpSectionList.clear();
+			if (!load_cached_sections(cache_entry)) {
+				printf("GPGPU-Sim PTX: ERROR ** could not read cuobjdump cache entry %s\n", cache_entry.c_str());
+				exit(1);
+			}
+			printf("GPGPU-Sim PTX: cached %zu cuobjdump sections in %s\n",
+					cuobjdumpSectionList.size(), cache_entry.c_str());
+		}
 	}
 
 	if (context->get_device()->get_gpgpu()->get_config().experimental_lib_support()){
@@ -1535,6 +1762,7 @@ void cuobjdumpInit(){
 
 std::map<int, std::string> fatbinmap;
 std::map<int, bool>fatbin_registered;
+static pthread_mutex_t g_module_lock = PTHREAD_MUTEX_INITIALIZER; // serializes parsing of binaries
 
 //! Keep track of the association between filename and cubin handle
 void cuobjdumpRegisterFatBinary(unsigned int handle, char* filename){
@@ -1542,16 +1770,21 @@ void cuobjdumpRegisterFatBinary(unsigned int handle, char* filename){
 }
 
 //! Either submit PTX for simulation or convert SASS to PTXPlus and submit it
+//! Binaries are parsed one at a time; the simulation threads are paused while
+//! the parsed module is added to the shared instruction tables and device memory
 void cuobjdumpParseBinary(unsigned int handle){
 
-	if(fatbin_registered[handle]) return;
+	pthread_mutex_lock(&g_module_lock);
+	if(fatbin_registered[handle]) {
+		pthread_mutex_unlock(&g_module_lock);
+		return;
+	}
 	fatbin_registered[handle] = true;
 	CUctx_st *context = GPGPUSim_Context();
 
 	std::string fname = fatbinmap[handle];
 	cuobjdumpPTXSection* ptx = findPTXSection(fname);
 
-	symbol_table *symtab;
 	char *ptxcode;
 	const char *override_ptx_name = getenv("PTX_SIM_KERNELFILE"); 
    if (override_ptx_name == NULL or getenv("PTX_SIM_USE_PTX_FILE") == NULL) {
@@ -1560,26 +1793,28 @@ void cuobjdumpParseBinary(unsigned int handle){
 		printf("GPGPU-Sim PTX: overriding embedded ptx with '%s' (PTX_SIM_USE_PTX_FILE is set)\n", override_ptx_name);
 		ptxcode = readfile(override_ptx_name);
 	}
+	char *ptxplus_str = NULL;
 	if(context->get_device()->get_gpgpu()->get_config().convert_to_ptxplus() ) {
 		cuobjdumpELFSection* elfsection = findELFSection(ptx->getIdentifier());
 		assert (elfsection!= NULL);
-		char *ptxplus_str = gpgpu_ptx_sim_convert_ptx_and_sass_to_ptxplus(
+		ptxplus_str = gpgpu_ptx_sim_convert_ptx_and_sass_to_ptxplus(
 				ptx->getPTXfilename(),
 				elfsection->getELFfilename(),
 				elfsection->getSASSfilename());
-		symtab=gpgpu_ptx_sim_load_ptx_from_string(ptxplus_str, handle);
-		printf("Adding %s with cubin handle %u\n", ptx->getPTXfilename().c_str(), handle);
-		context->add_binary(symtab, handle);
-		gpgpu_ptxinfo_load_from_string( ptxcode, handle);
-		delete[] ptxplus_str;
-	} else {
-		symtab=gpgpu_ptx_sim_load_ptx_from_string(ptxcode, handle);
-		printf("Adding %s with cubin handle %u\n", ptx->getPTXfilename().c_str(), handle);
-		context->add_binary(symtab, handle);
-		gpgpu_ptxinfo_load_from_string( ptxcode, handle);
 	}
-	load_static_globals(symtab,STATIC_ALLOC_LIMIT,0xFFFFFFFF,context->get_device()->get_gpgpu());
-	load_constants(symtab,STATIC_ALLOC_LIMIT,context->get_device()->get_gpgpu());
+
+	gpgpu_ptx_sim_pause_devices();
+	symbol_table *symtab=gpgpu_ptx_sim_load_ptx_from_string(ptxplus_str ? ptxplus_str : ptxcode, handle);
+	printf("Adding %s with cubin handle %u\n", ptx->getPTXfilename().c_str(), handle);
+	context->add_binary(symtab, handle);
+	load_module_data(symtab);
+	gpgpu_ptx_sim_resume_devices();
+	delete[] ptxplus_str;
+
+	// only sets the kernel info of this module's functions, none of which has
+	// been launched yet, so the devices need not stay paused
+	gpgpu_ptxinfo_load_from_string( ptxcode, handle );
+	pthread_mutex_unlock(&g_module_lock);
 
 	//TODO: Remove temporarily files as per configurations
 }
@@ -1677,8 +1912,7 @@ void** CUDARTAPI __cudaRegisterFatBinary( void *fatCubin )
 				gpgpu_ptxinfo_load_from_string( ptx, source_num );
 			}
 			source_num++;
-			load_static_globals(symtab,STATIC_ALLOC_LIMIT,0xFFFFFFFF,context->get_device()->get_gpgpu());
-			load_constants(symtab,STATIC_ALLOC_LIMIT,context->get_device()->get_gpgpu());
+			load_module_data(symtab);
 		} else {
 			printf("GPGPU-Sim PTX: warning -- did not find an appropriate PTX in cubin\n");
 		}
@@ -1717,8 +1951,6 @@ void CUDARTAPI __cudaRegisterFunction(
 	unsigned fat_cubin_handle = (unsigned)(unsigned long long)fatCubinHandle;
 	printf("GPGPU-Sim PTX: __cudaRegisterFunction %s : hostFun 0x%p, fat_cubin_handle = %u\n",
 			deviceFun, hostFun, fat_cubin_handle);
-	if(context->get_device()->get_gpgpu()->get_config().use_cuobjdump())
-		cuobjdumpParseBinary(fat_cubin_handle);
 	context->register_function( fat_cubin_handle, hostFun, deviceFun );
 }
 
@@ -2055,6 +2287,8 @@ static int load_static_globals( symbol_table *symtab, unsigned min_gaddr, unsign
 				ptx_reg_t value = op.get_literal_value();
 				assert( (addr+offset+nbytes) < min_gaddr ); // min_gaddr is start of "heap" for cudaMalloc
 				gpu->get_global_memory()->write(addr+offset,nbytes,&value,NULL,NULL); // assuming little endian here
+				if( g_workload_recorder && g_workload_recorder->records(gpu) ) 
+					g_workload_recorder->write(addr+offset,nbytes,&value);
 				offset+=nbytes;
 				ng_bytes+=nbytes;
 			}
@@ -2066,6 +2300,17 @@ static int load_static_globals( symbol_table *symtab, unsigned min_gaddr, unsign
 	return ng_bytes;
 }
 
+// static globals and constants live at the same addresses on every simulated
+// device, so each device gets its own initialized copy
+static void load_module_data( symbol_table *symtab )
+{
+	for( unsigned n=0; n < gpgpu_ptx_sim_num_devices(); n++ ) {
+		gpgpu_t *gpu = gpgpu_ptx_sim_device(n);
+		load_static_globals(symtab,STATIC_ALLOC_LIMIT,0xFFFFFFFF,gpu);
+		load_constants(symtab,STATIC_ALLOC_LIMIT,gpu);
+	}
+}
+
 static int load_constants( symbol_table *symtab, addr_t min_gaddr, gpgpu_t *gpu ) 
 {
 	printf( "GPGPU-Sim PTX: loading constants with explicit initializers... " );
@@ -2099,6 +2344,8 @@ static int load_constants( symbol_table *symtab, addr_t min_gaddr, gpgpu_t *gpu
 				assert( addr+nbytes < min_gaddr );
 
 				gpu->get_global_memory()->write(addr,nbytes,&value,NULL,NULL); // assume little endian (so u8 is the first byte in u32)
+				if( g_workload_recorder && g_workload_recorder->records(gpu) ) 
+					g_workload_recorder->write(addr,nbytes,&value);
 				nc_bytes+=nbytes;
 				nbytes_written += nbytes;
 			}
@@ -2110,7 +2357,7 @@ static int load_constants( symbol_table *symtab, addr_t min_gaddr, gpgpu_t *gpu
 }
 
 kernel_info_t *gpgpu_cuda_ptx_sim_init_grid( const char *hostFun, 
-		gpgpu_ptx_sim_arg_list_t args,
+		gpgpu_ptx_sim_arg_list_t &args,
 		struct dim3 gridDim,
 		struct dim3 blockDim,
 		CUctx_st* context )
@@ -37,6 +37,7 @@ void setCuobjdumpidentifier(const char* identifier);
 void setCuobjdumpptxfilename(const char* filename);
 void setCuobjdumpelffilename(const char* filename);
 void setCuobjdumpsassfilename(const char* filename);
+extern const char *g_cuobjdump_section_dir;
 int elfserial = 1;
 int ptxserial = 1;
 FILE *ptxfile;
@@ -70,7 +71,7 @@ emptylines	:	emptylines NEWLINE
 
 section :	PTXHEADER {
 				addCuobjdumpSection(0);
-				snprintf(filename, 1024, "_cuobjdump_%d.ptx", ptxserial++);
+				snprintf(filename, 1024, "%s_cuobjdump_%d.ptx", g_cuobjdump_section_dir, ptxserial++);
 				ptxfile = fopen(filename, "w");
 				setCuobjdumpptxfilename(filename);
 			} headerinfo ptxcode {
@@ -78,12 +79,12 @@ section :	PTXHEADER {
 			}
 		|	ELFHEADER {
 				addCuobjdumpSection(1);
-				snprintf(filename, 1024, "_cuobjdump_%d.elf", elfserial);
+				snprintf(filename, 1024, "%s_cuobjdump_%d.elf", g_cuobjdump_section_dir, elfserial);
 				elffile = fopen(filename, "w");
 				setCuobjdumpelffilename(filename);
 			} headerinfo elfcode { 
 				fclose(elffile);
-				snprintf(filename, 1024, "_cuobjdump_%d.sass", elfserial++);
+				snprintf(filename, 1024, "%s_cuobjdump_%d.sass", g_cuobjdump_section_dir, elfserial++);
 				sassfile = fopen(filename, "w");
 				setCuobjdumpsassfilename(filename);
 			} sasscode { 
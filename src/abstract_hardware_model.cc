@@ -29,6 +29,7 @@
 
 #include "abstract_hardware_model.h"
 #include "cuda-sim/memory.h"
+#include "cuda-sim/device_heap.h"
 #include "cuda-sim/ptx_ir.h"
 #include "cuda-sim/ptx-stats.h"
 #include "cuda-sim/cuda-sim.h"
@@ -36,8 +37,8 @@
 #include "option_parser.h"
 #include <algorithm>
 
-unsigned mem_access_t::sm_next_access_uid = 0;   
-unsigned warp_inst_t::sm_next_uid = 0;
+__thread unsigned mem_access_t::sm_next_access_uid = 0;   
+__thread unsigned warp_inst_t::sm_next_uid = 0;
 
 void move_warp( warp_inst_t *&dst, warp_inst_t *&src )
 {
@@ -64,6 +65,10 @@ void gpgpu_functional_sim_config::reg_options(class OptionParser * opp)
 	                 &m_experimental_lib_support,
 	                 "Try to extract code from cuda libraries [Broken because of unknown cudaGetExportTable]",
 	                 "0");
+	option_parser_register(opp, "-gpgpu_cuobjdump_cache_dir", OPT_CSTR,
+	                 &m_cuobjdump_cache_dir,
+	                 "Directory caching the sections extracted by cuobjdump, keyed by fatbinary hash (NULL = do not cache)",
+	                 NULL);
     option_parser_register(opp, "-gpgpu_ptx_convert_to_ptxplus", OPT_BOOL,
                  &m_ptx_convert_to_ptxplus,
                  "Convert SASS (native ISA) to ptxplus and run ptxplus",
@@ -96,7 +101,7 @@ gpgpu_t::gpgpu_t( const gpgpu_functional_sim_config &config )
    m_tex_mem = new memory_space_impl<8192>("tex",64*1024);
    m_surf_mem = new memory_space_impl<8192>("surf",64*1024);
 
-   m_dev_malloc=GLOBAL_HEAP_START; 
+   m_dev_heap = new device_heap(GLOBAL_HEAP_START);
 
    if(m_function_model_config.get_ptx_inst_debug_to_file() != 0) 
       ptx_inst_debug_file = fopen(m_function_model_config.get_ptx_inst_debug_file(), "w");
@@ -551,7 +556,7 @@ void warp_inst_t::completed( unsigned long long cycle ) const
 }
 
 
-unsigned kernel_info_t::m_next_uid = 1;
+unsigned kernel_info_t::m_next_uid = 0;
 
 kernel_info_t::kernel_info_t( dim3 gridDim, dim3 blockDim, class function_info *entry )
 {
@@ -563,8 +568,12 @@ kernel_info_t::kernel_info_t( dim3 gridDim, dim3 blockDim, class function_info *
     m_next_cta.z=0;
     m_next_tid=m_next_cta;
     m_num_cores_running=0;
-    m_uid = m_next_uid++;
-    m_param_mem = new memory_space_impl<8192>("param",64*1024);
+    m_uid = __sync_add_and_fetch(&m_next_uid,1);
+    m_launch_index = 0;
+    m_param_mem = new flat_memory_space("param");
+    // control-flow analysis is deferred from load time to the first launch
+    if( entry ) 
+        entry->do_pdom();
 }
 
 kernel_info_t::~kernel_info_t()
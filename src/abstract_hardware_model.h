@@ -227,6 +227,12 @@ public:
       return m_next_tid.z < m_block_dim.z && m_next_tid.y < m_block_dim.y && m_next_tid.x < m_block_dim.x;
    }
    unsigned get_uid() const { return m_uid; }
+   // position of the launch among those of its device, counted from 1 (0 if
+   // not assigned yet); unlike the uid it does not depend on launches made
+   // on other devices, so -gpgpu_timing_kernels, -checkpoint_kernel and warp
+   // traces select launches by it
+   unsigned get_launch_index() const { return m_launch_index; }
+   void set_launch_index( unsigned index ) { m_launch_index = index; }
    std::string name() const;
 
    std::list<class ptx_thread_info *> &active_threads() { return m_active_threads; }
@@ -239,7 +245,8 @@ private:
    class function_info *m_kernel_entry;
 
    unsigned m_uid;
-   static unsigned m_next_uid;
+   static unsigned m_next_uid; // shared by all devices, incremented atomically
+   unsigned m_launch_index;
 
    dim3 m_grid_dim;
    dim3 m_block_dim;
@@ -423,6 +430,7 @@ public:
     bool convert_to_ptxplus() const { return m_ptx_convert_to_ptxplus; }
     bool use_cuobjdump() const { return m_ptx_use_cuobjdump; }
     bool experimental_lib_support() const { return m_experimental_lib_support; }
+    const char *cuobjdump_cache_dir() const { return m_cuobjdump_cache_dir; }
 
     int         get_ptx_inst_debug_to_file() const { return g_ptx_inst_debug_to_file; }
     const char* get_ptx_inst_debug_file() const  { return g_ptx_inst_debug_file; }
@@ -434,6 +442,7 @@ private:
     int m_ptx_convert_to_ptxplus;
     int m_ptx_use_cuobjdump;
     int m_experimental_lib_support;
+    char *m_cuobjdump_cache_dir;
     unsigned m_ptx_force_max_capability;
 
     int   g_ptx_inst_debug_to_file;
@@ -448,6 +457,9 @@ public:
     gpgpu_t( const gpgpu_functional_sim_config &config );
     void* gpu_malloc( size_t size );
     void* gpu_mallocarray( size_t count );
+    // return a block from gpu_malloc/gpu_mallocarray to the device heap and
+    // drop its backing storage; false if ptr does not start a live block
+    bool  gpu_free( size_t ptr );
     void  gpu_memset( size_t dst_start_addr, int c, size_t count );
     void  memcpy_to_gpu( size_t dst_start_addr, const void *src, size_t count );
     void  memcpy_from_gpu( void *dst, size_t src_start_addr, size_t count );
@@ -456,8 +468,11 @@ public:
     class memory_space *get_global_memory() { return m_global_mem; }
     class memory_space *get_tex_memory() { return m_tex_mem; }
     class memory_space *get_surf_memory() { return m_surf_mem; }
+    class device_heap *get_device_heap() { return m_dev_heap; }
 
     void gpgpu_ptx_sim_bindTextureToArray(const struct textureReference* texref, const struct cudaArray* array);
+    // forget every texture reference bound to array (before the array is freed)
+    void gpgpu_ptx_sim_unbindArray(const struct cudaArray* array);
     void gpgpu_ptx_sim_bindNameToTexture(const char* name, const struct textureReference* texref, int dim, int readmode, int ext);
     const char* gpgpu_ptx_sim_findNamefromTexture(const struct textureReference* texref);
 
@@ -490,6 +505,12 @@ public:
     const gpgpu_functional_sim_config &get_config() const { return m_function_model_config; }
     FILE* get_ptx_inst_debug_file() { return ptx_inst_debug_file; }
 
+    // shared/local memories and CTA info handed out to threads of this device,
+    // kept apart for functionally simulated CTAs (index 1) and timing CTAs (index 0)
+    std::map<unsigned,class memory_space*> &shared_memory_lookup( bool functional ) { return m_shared_memory_lookup[functional]; }
+    std::map<unsigned,class ptx_cta_info*> &ptx_cta_lookup( bool functional ) { return m_ptx_cta_lookup[functional]; }
+    std::map<unsigned,std::map<unsigned,class memory_space*> > &local_memory_lookup( bool functional ) { return m_local_memory_lookup[functional]; }
+
 protected:
     const gpgpu_functional_sim_config &m_function_model_config;
     FILE* ptx_inst_debug_file;
@@ -498,7 +519,11 @@ protected:
     class memory_space *m_tex_mem;
     class memory_space *m_surf_mem;
     
-    unsigned long long m_dev_malloc;
+    class device_heap *m_dev_heap;
+
+    std::map<unsigned,class memory_space*> m_shared_memory_lookup[2];
+    std::map<unsigned,class ptx_cta_info*> m_ptx_cta_lookup[2];
+    std::map<unsigned,std::map<unsigned,class memory_space*> > m_local_memory_lookup[2];
     
     std::map<std::string, const struct textureReference*> m_NameToTextureRef;
     std::map<const struct textureReference*,const struct cudaArray*> m_TextureRefToCudaArray;
@@ -678,7 +703,7 @@ private:
    active_mask_t m_warp_mask;
    mem_access_byte_mask_t m_byte_mask;
 
-   static unsigned sm_next_access_uid;
+   static __thread unsigned sm_next_access_uid;
 };
 
 class mem_fetch;
@@ -993,7 +1018,7 @@ protected:
     bool m_mem_accesses_created;
     std::list<mem_access_t> m_accessq;
 
-    static unsigned sm_next_uid;
+    static __thread unsigned sm_next_uid;
 };
 
 void move_warp( warp_inst_t *&dst, warp_inst_t *&src );
@@ -40,10 +40,12 @@
 #include <map>
 #include "../abstract_hardware_model.h"
 #include "memory.h"
+#include "device_heap.h"
 #include "ptx-stats.h"
 #include "ptx_loader.h"
 #include "ptx_parser.h"
 #include "../gpgpu-sim/gpu-sim.h"
+#include "../gpgpu-sim/workload_log.h"
 #include "ptx_sim.h"
 #include "../gpgpusim_entrypoint.h"
 #include "decuda_pred_table/decuda_pred_table.h"
@@ -58,7 +60,13 @@ int g_debug_thread_uid = 0;
 addr_t g_debug_pc = 0xBEEF1518;
 // Output debug information to file options
 
-unsigned g_ptx_sim_num_insn = 0;
+__thread unsigned g_ptx_sim_num_insn = 0; // per simulated device
+
+void ptx_sim_thread_counters_reset()
+{
+   g_ptx_sim_num_insn = 0;
+   g_ptx_thread_info_uid_next = 1;
+}
 unsigned gpgpu_param_num_shaders = 0;
 
 char *opcode_latency_int, *opcode_latency_fp, *opcode_latency_dp;
@@ -174,6 +182,23 @@ void gpgpu_t::gpgpu_ptx_sim_bindTextureToArray(const struct textureReference* te
    m_TextureRefToTexureInfo[texref] = texInfo;
 }
 
+void gpgpu_t::gpgpu_ptx_sim_unbindArray(const struct cudaArray* array)
+{
+   std::map<const struct textureReference*,const struct cudaArray*>::iterator t=m_TextureRefToCudaArray.begin();
+   while( t != m_TextureRefToCudaArray.end() ) {
+      if( t->second != array ) {
+         t++;
+         continue;
+      }
+      std::map<const struct textureReference*, const struct textureInfo*>::iterator i=m_TextureRefToTexureInfo.find(t->first);
+      if( i != m_TextureRefToTexureInfo.end() ) {
+         free((void*)i->second);
+         m_TextureRefToTexureInfo.erase(i);
+      }
+      m_TextureRefToCudaArray.erase(t++);
+   }
+}
+
 unsigned g_assemble_code_next_pc=0; 
 std::map<unsigned,function_info*> g_pc_to_finfo;
 std::vector<ptx_instruction*> function_info::s_g_pc_to_insn;
@@ -244,6 +269,30 @@ void function_info::ptx_assemble()
 
    printf("  done.\n");
    fflush(stdout);
+
+   m_assembled = true;
+}
+
+// the reconvergence point cache (g_rpts) is shared by all functions
+static pthread_mutex_t g_pdom_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void function_info::do_pdom()
+{
+   // m_pdom_done is published only after the callees are analysed too, so a
+   // thread that sees it set may run the kernel without taking the lock
+   if( __atomic_load_n(&m_pdom_done,__ATOMIC_ACQUIRE) ) 
+      return;
+   pthread_mutex_lock(&g_pdom_lock);
+   do_pdom_locked();
+   pthread_mutex_unlock(&g_pdom_lock);
+}
+
+void function_info::do_pdom_locked()
+{
+   if( m_pdom_done || m_pdom_in_progress || !m_assembled ) 
+      return;
+   m_pdom_in_progress = true;
+
    printf("GPGPU-Sim PTX: finding reconvergence points for \'%s\'...\n", m_name.c_str() );
 
    create_basic_blocks();
@@ -271,14 +320,27 @@ void function_info::ptx_assemble()
    }
 
    printf("GPGPU-Sim PTX: pre-decoding instructions for \'%s\'...\n", m_name.c_str() );
-   for ( unsigned ii=0; ii < n; ii += m_instr_mem[ii]->inst_size() ) { // handle branch instructions
-      ptx_instruction *pI = m_instr_mem[ii];
-      pI->pre_decode();
+   std::list<ptx_instruction*>::iterator i;
+   for ( i=m_instructions.begin(); i != m_instructions.end(); i++ ) {
+      ptx_instruction *pI = *i;
+      if ( !pI->is_label() ) 
+         pI->pre_decode();
    }
    printf("GPGPU-Sim PTX: ... done pre-decoding instructions for \'%s\'.\n", m_name.c_str() );
    fflush(stdout);
 
-   m_assembled = true;
+   // callees run as part of this kernel (recursive calls stop at m_pdom_in_progress)
+   for ( i=m_instructions.begin(); i != m_instructions.end(); i++ ) {
+      ptx_instruction *pI = *i;
+      if ( pI->get_opcode() == CALL_OP ) {
+         function_info *callee = pI->func_addr().get_symbol()->get_pc();
+         if ( callee ) 
+            callee->do_pdom_locked();
+      }
+   }
+
+   m_pdom_in_progress = false;
+   __atomic_store_n(&m_pdom_done,true,__ATOMIC_RELEASE);
 }
 
 addr_t shared_to_generic( unsigned smid, addr_t addr )
@@ -352,26 +414,30 @@ addr_t generic_to_global( addr_t addr )
 
 void* gpgpu_t::gpu_malloc( size_t size )
 {
-   unsigned long long result = m_dev_malloc;
+   unsigned long long result = m_dev_heap->allocate(size);
    if(g_debug_execution >= 3) {
-      printf("GPGPU-Sim PTX: allocating %zu bytes on GPU starting at address 0x%Lx\n", size, m_dev_malloc );
+      printf("GPGPU-Sim PTX: allocating %zu bytes on GPU starting at address 0x%Lx\n", size, result );
       fflush(stdout);
    }
-   m_dev_malloc += size;
-   if (size%256) m_dev_malloc += (256 - size%256); //align to 256 byte boundaries
    return(void*) result;
 }
 
 void* gpgpu_t::gpu_mallocarray( size_t size )
 {
-   unsigned long long result = m_dev_malloc;
+   return gpu_malloc(size);
+}
+
+bool gpgpu_t::gpu_free( size_t ptr )
+{
+   size_t size = m_dev_heap->free(ptr);
+   if( !size ) 
+      return false;
    if(g_debug_execution >= 3) {
-      printf("GPGPU-Sim PTX: allocating %zu bytes on GPU starting at address 0x%Lx\n", size, m_dev_malloc );
+      printf("GPGPU-Sim PTX: freeing %zu bytes on GPU starting at address 0x%Lx\n", size, (unsigned long long)ptr );
       fflush(stdout);
    }
-   m_dev_malloc += size;
-   if (size%256) m_dev_malloc += (256 - size%256); //align to 256 byte boundaries
-   return(void*) result;
+   m_global_mem->release(ptr,size);
+   return true;
 }
 
 
@@ -384,6 +450,8 @@ void gpgpu_t::memcpy_to_gpu( size_t dst_start_addr, const void *src, size_t coun
    char *src_data = (char*)src;
    for (unsigned n=0; n < count; n ++ ) 
       m_global_mem->write(dst_start_addr+n,1, src_data+n,NULL,NULL);
+   if( g_workload_recorder && g_workload_recorder->records(this) ) 
+      g_workload_recorder->write(dst_start_addr,count,src);
    if(g_debug_execution >= 3) {
       printf( " done.\n");
       fflush(stdout);
@@ -417,6 +485,8 @@ void gpgpu_t::memcpy_gpu_to_gpu( size_t dst, size_t src, size_t count )
       m_global_mem->read(src+n,1,&tmp); 
       m_global_mem->write(dst+n,1, &tmp,NULL,NULL);
    }
+   if( g_workload_recorder && g_workload_recorder->records(this) ) 
+      g_workload_recorder->copy(dst,src,count);
    if(g_debug_execution >= 3) {
       printf( " done.\n");
       fflush(stdout);
@@ -433,6 +503,8 @@ void gpgpu_t::gpu_memset( size_t dst_start_addr, int c, size_t count )
    unsigned char c_value = (unsigned char)c;
    for (unsigned n=0; n < count; n ++ ) 
       m_global_mem->write(dst_start_addr+n,1,&c_value,NULL,NULL);
+   if( g_workload_recorder && g_workload_recorder->records(this) ) 
+      g_workload_recorder->memset(dst_start_addr,c_value,count);
    if(g_debug_execution >= 3) {
       printf( " done.\n");
       fflush(stdout);
@@ -1071,11 +1143,13 @@ void function_info::finalize( memory_space *param_mem )
    for( std::map<unsigned,param_info>::iterator i=m_ptx_kernel_param_info.begin(); i!=m_ptx_kernel_param_info.end(); i++ ) {
       param_info &p = i->second;
       if (p.is_ptr_shared()) continue; // Pointer to local memory: Should we pass the allocated shared memory address to the param memory space? 
-      std::string name = p.get_name();
       int type = p.get_type();
-      param_t param_value = p.get_value();
-      param_value.type = type;
-      symbol *param = m_symtab->lookup(name.c_str());
+      const param_t &param_value = p.get_value();
+      symbol *param = p.get_symbol();
+      if( param == NULL ) {
+         param = m_symtab->lookup(p.get_name().c_str());
+         p.set_symbol(param);
+      }
       unsigned xtype = param->type()->get_key().scalar_type();
       assert(xtype==(unsigned)type);
       size_t size;
@@ -1086,21 +1160,35 @@ void function_info::finalize( memory_space *param_mem )
                 size, p.get_size()/8);
          size = (size<(p.get_size()/8))?size:(p.get_size()/8);
       } 
-      // copy the parameter over word-by-word so that parameter that crosses a memory page can be copied over
-      const size_t word_size = 4; 
-      for (size_t idx = 0; idx < size; idx += word_size) {
-         const char *pdata = reinterpret_cast<const char*>(param_value.pdata) + idx; // cast to char * for ptr arithmetic
-         param_mem->write(param_address + idx, word_size, pdata,NULL,NULL); 
-      }
+      // the parameter memory is flat (flat_memory_space), so a parameter is copied in one piece
+      param_mem->write(param_address, size, param_value.pdata, NULL, NULL); 
       param->set_address(param_address);
       param_address += size; 
    }
 }
 
+void function_info::get_param_layout( std::vector<param_layout> &layout ) const
+{
+   // same placement as finalize()
+   unsigned param_address = 0;
+   for( std::map<unsigned,param_info>::const_iterator i=m_ptx_kernel_param_info.begin(); i!=m_ptx_kernel_param_info.end(); i++ ) {
+      const param_info &p = i->second;
+      if (p.is_ptr_shared()) continue;
+      size_t size = p.get_value().size;
+      if( size > p.get_size() / 8 ) 
+         size = p.get_size() / 8;
+      param_layout l;
+      l.index = i->first;
+      l.address = param_address;
+      l.size = size;
+      layout.push_back(l);
+      param_address += size; 
+   }
+}
+
 void function_info::param_to_shared( memory_space *shared_mem, symbol_table *symtab ) 
 {
    // TODO: call this only for PTXPlus with GT200 models 
-   extern gpgpu_sim* g_the_gpu; 
    if (not g_the_gpu->get_config().convert_to_ptxplus()) return; 
 
    // copies parameters into simulated shared memory
@@ -1406,9 +1494,12 @@ unsigned ptx_sim_init_thread( kernel_info_t &kernel,
 {
    std::list<ptx_thread_info *> &active_threads = kernel.active_threads();
 
-   static std::map<unsigned,memory_space*> shared_memory_lookup;
-   static std::map<unsigned,ptx_cta_info*> ptx_cta_lookup;
-   static std::map<unsigned,std::map<unsigned,memory_space*> > local_memory_lookup;
+   // functionally simulated CTAs can run while the timing model has CTAs in
+   // flight on the same (sid,tid), so they get their own shared/local memories;
+   // each simulated device keeps its own set
+   std::map<unsigned,memory_space*> &shared_memory_lookup = gpu->shared_memory_lookup(isInFunctionalSimulationMode);
+   std::map<unsigned,ptx_cta_info*> &ptx_cta_lookup = gpu->ptx_cta_lookup(isInFunctionalSimulationMode);
+   std::map<unsigned,std::map<unsigned,memory_space*> > &local_memory_lookup = gpu->local_memory_lookup(isInFunctionalSimulationMode);
 
    if ( *thread_info != NULL ) {
       ptx_thread_info *thd = *thread_info;
@@ -1656,6 +1747,8 @@ void gpgpu_ptx_sim_memcpy_symbol(const char *hostVar, const void *src, size_t co
       if( to ) mem->write(dst+n,1,((char*)src)+n,NULL,NULL); 
       else mem->read(dst+n,1,((char*)src)+n); 
    }
+   if( to && g_workload_recorder && g_workload_recorder->records(gpu) ) 
+      g_workload_recorder->write(dst,count,src);
    fflush(stdout);
 }
 
@@ -1734,9 +1827,9 @@ which holds the data for the CUDA kernel to be executed
 void gpgpu_cuda_ptx_sim_main_func( kernel_info_t &kernel, bool openCL )
 {
      printf("GPGPU-Sim: Performing Functional Simulation, executing kernel %s...\n",kernel.name().c_str());
+     unsigned kernel_start_insn = g_ptx_sim_num_insn;
 
      //using a shader core object for book keeping, it is not needed but as most function built for performance simulation need it we use it here
-    extern gpgpu_sim *g_the_gpu;
 
     //we excute the kernel one CTA (Block) at the time, as synchronization functions work block wise
     while(!kernel.no_more_ctas_to_run()){
@@ -1748,8 +1841,11 @@ void gpgpu_cuda_ptx_sim_main_func( kernel_info_t &kernel, bool openCL )
         cta.execute();
     }
     
+   // per kernel stats; the kernel is deleted once it is registered as done
+   printf( "kernel_name = %s \nkernel_launch_uid = %u \nkernel_sim_mode = functional\nkernel_thread_insn = %u\n",
+           kernel.name().c_str(), kernel.get_uid(), g_ptx_sim_num_insn - kernel_start_insn );
+
    //registering this kernel as done      
-   extern stream_manager *g_stream_manager;
    
    //openCL kernel simulation calls don't register the kernel so we don't register its exit
    if(!openCL)
@@ -60,6 +60,8 @@ extern void   gpgpu_ptx_sim_register_global_variable(void *hostVar, const char *
 extern void   gpgpu_ptx_sim_memcpy_symbol(const char *hostVar, const void *src, size_t count, size_t offset, int to, gpgpu_t *gpu );
 
 extern void read_sim_environment_variables();
+// functional simulation counters of the calling thread back to their initial values
+void ptx_sim_thread_counters_reset();
 extern void ptxinfo_opencl_addinfo( std::map<std::string,function_info*> &kernels );
 unsigned ptx_sim_init_thread( kernel_info_t &kernel,
                               class ptx_thread_info** thread_info,
@@ -0,0 +1,174 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "device_heap.h"
+
+#include <assert.h>
+
+device_heap::device_heap( unsigned long long base )
+{
+   m_base = base;
+   m_top = base;
+   unsigned n_classes = 0;
+   for( size_t s=DEVICE_HEAP_ALIGN; s <= DEVICE_HEAP_MAX_CLASS; s <<= 1 ) 
+      n_classes++;
+   m_class_free.resize(n_classes);
+   m_live_bytes = 0;
+   m_peak_bytes = 0;
+   m_peak_footprint = 0;
+   m_n_allocs = 0;
+   m_n_frees = 0;
+   m_n_reused = 0;
+}
+
+unsigned device_heap::size_class( size_t size ) const
+{
+   unsigned c = 0;
+   for( size_t s=DEVICE_HEAP_ALIGN; s < size; s <<= 1 ) 
+      c++;
+   return c;
+}
+
+unsigned long long device_heap::allocate( size_t size )
+{
+   unsigned long long addr, block;
+   if( size <= DEVICE_HEAP_MAX_CLASS ) {
+      unsigned c = size_class(size);
+      block = (unsigned long long)DEVICE_HEAP_ALIGN << c;
+      if( !m_class_free[c].empty() ) {
+         addr = m_class_free[c].back();
+         m_class_free[c].pop_back();
+         m_n_reused++;
+      } else {
+         addr = allocate_range(block);
+      }
+   } else {
+      block = (size + DEVICE_HEAP_ALIGN - 1) & ~(unsigned long long)(DEVICE_HEAP_ALIGN - 1);
+      addr = allocate_range(block);
+   }
+   m_live[addr] = block;
+   m_live_bytes += block;
+   m_n_allocs++;
+   if( m_live_bytes > m_peak_bytes ) 
+      m_peak_bytes = m_live_bytes;
+   if( footprint() > m_peak_footprint ) 
+      m_peak_footprint = footprint();
+   return addr;
+}
+
+size_t device_heap::free( unsigned long long addr )
+{
+   std::map<unsigned long long,unsigned long long>::iterator b = m_live.find(addr);
+   if( b == m_live.end() ) 
+      return 0;
+   unsigned long long block = b->second;
+   m_live.erase(b);
+   m_live_bytes -= block;
+   m_n_frees++;
+   if( block <= DEVICE_HEAP_MAX_CLASS ) 
+      m_class_free[size_class(block)].push_back(addr);
+   else 
+      free_range(addr,block);
+   return block;
+}
+
+void device_heap::reserve_to( unsigned long long top )
+{
+   if( top <= m_top ) 
+      return;
+   m_top = top;
+   if( footprint() > m_peak_footprint ) 
+      m_peak_footprint = footprint();
+}
+
+unsigned long long device_heap::allocate_range( unsigned long long size )
+{
+   // best fit among the free ranges, else grow the heap
+   std::set<std::pair<unsigned long long,unsigned long long> >::iterator f = m_free_by_size.lower_bound(std::make_pair(size,0ULL));
+   if( f == m_free_by_size.end() ) {
+      unsigned long long addr = m_top;
+      m_top += size;
+      return addr;
+   }
+   unsigned long long addr = f->second;
+   unsigned long long range = f->first;
+   erase_free_range(m_free_by_addr.find(addr));
+   if( range > size ) 
+      insert_free_range(addr+size,range-size);
+   m_n_reused++;
+   return addr;
+}
+
+void device_heap::free_range( unsigned long long addr, unsigned long long size )
+{
+   // coalesce with the free ranges on either side
+   std::map<unsigned long long,unsigned long long>::iterator next = m_free_by_addr.lower_bound(addr);
+   if( next != m_free_by_addr.begin() ) {
+      std::map<unsigned long long,unsigned long long>::iterator prev = next;
+      --prev;
+      if( prev->first + prev->second == addr ) {
+         addr = prev->first;
+         size += prev->second;
+         erase_free_range(prev);
+      }
+   }
+   if( next != m_free_by_addr.end() && addr + size == next->first ) {
+      size += next->second;
+      erase_free_range(next);
+   }
+   if( addr + size == m_top ) 
+      m_top = addr;
+   else 
+      insert_free_range(addr,size);
+}
+
+void device_heap::insert_free_range( unsigned long long addr, unsigned long long size )
+{
+   m_free_by_addr[addr] = size;
+   m_free_by_size.insert(std::make_pair(size,addr));
+}
+
+void device_heap::erase_free_range( std::map<unsigned long long,unsigned long long>::iterator r )
+{
+   assert( r != m_free_by_addr.end() );
+   // ranges are keyed by address too, so equal sizes need no scan
+   std::set<std::pair<unsigned long long,unsigned long long> >::iterator s = m_free_by_size.find(std::make_pair(r->second,r->first));
+   assert( s != m_free_by_size.end() );
+   m_free_by_size.erase(s);
+   m_free_by_addr.erase(r);
+}
+
+void device_heap::print_stats( FILE *fout ) const
+{
+   fprintf(fout, "gpgpu_device_heap_live_bytes = %llu\n", m_live_bytes);
+   fprintf(fout, "gpgpu_device_heap_peak_bytes = %llu\n", m_peak_bytes);
+   fprintf(fout, "gpgpu_device_heap_footprint = %llu\n", footprint());
+   fprintf(fout, "gpgpu_device_heap_peak_footprint = %llu\n", m_peak_footprint);
+   fprintf(fout, "gpgpu_device_heap_allocs = %llu\n", m_n_allocs);
+   fprintf(fout, "gpgpu_device_heap_frees = %llu\n", m_n_frees);
+   fprintf(fout, "gpgpu_device_heap_reused = %llu\n", m_n_reused);
+}
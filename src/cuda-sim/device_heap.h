@@ -0,0 +1,91 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef device_heap_h_INCLUDED
+#define device_heap_h_INCLUDED
+
+#include <stdio.h>
+#include <map>
+#include <set>
+#include <vector>
+
+// Device memory allocator behind cudaMalloc/cudaFree.
+//
+// Requests up to DEVICE_HEAP_MAX_CLASS bytes are rounded up to a power of
+// two size class and freed blocks are kept on a free list per class for
+// reuse by the next request of that class.  Larger requests are rounded to
+// DEVICE_HEAP_ALIGN bytes and placed best-fit among the free ranges, which
+// are coalesced with their neighbours on free; free ranges that reach the
+// top of the heap lower it again.  Blocks of either kind that cannot be
+// satisfied from free memory are carved from the top of the heap.
+
+#define DEVICE_HEAP_ALIGN 256
+#define DEVICE_HEAP_MAX_CLASS (64*1024)
+
+class device_heap {
+public:
+   device_heap( unsigned long long base );
+
+   // DEVICE_HEAP_ALIGN aligned address of a new block of at least size bytes
+   unsigned long long allocate( size_t size );
+   // size of the block freed at addr; 0 if addr does not start a live block
+   size_t free( unsigned long long addr );
+
+   // first address above every block handed out so far
+   unsigned long long top() const { return m_top; }
+   // never hand out addresses below top (used when restoring a checkpoint)
+   void reserve_to( unsigned long long top );
+
+   unsigned long long live_bytes() const { return m_live_bytes; }
+   unsigned long long peak_bytes() const { return m_peak_bytes; }
+   unsigned long long footprint() const { return m_top - m_base; }
+   void print_stats( FILE *fout ) const;
+
+private:
+   unsigned size_class( size_t size ) const;
+   unsigned long long allocate_range( unsigned long long size );
+   void free_range( unsigned long long addr, unsigned long long size );
+   void insert_free_range( unsigned long long addr, unsigned long long size );
+   void erase_free_range( std::map<unsigned long long,unsigned long long>::iterator r );
+
+   unsigned long long m_base;
+   unsigned long long m_top;
+
+   std::vector<std::vector<unsigned long long> > m_class_free; // per size class
+   std::map<unsigned long long,unsigned long long> m_free_by_addr; // large free ranges: address -> size
+   std::set<std::pair<unsigned long long,unsigned long long> > m_free_by_size; // (size, address), best fit first
+   std::map<unsigned long long,unsigned long long> m_live; // address -> block size
+
+   unsigned long long m_live_bytes;
+   unsigned long long m_peak_bytes;
+   unsigned long long m_peak_footprint;
+   unsigned long long m_n_allocs;
+   unsigned long long m_n_frees;
+   unsigned long long m_n_reused;
+};
+
+#endif
@@ -153,11 +153,134 @@ template<unsigned BSIZE> void memory_space_impl<BSIZE>::set_watch( addr_t addr,
    m_watchpoints[watchpoint]=addr;
 }
 
+template<unsigned BSIZE> void memory_space_impl<BSIZE>::get_block_indices( std::vector<mem_addr_t> &indices ) const
+{
+   indices.clear();
+   indices.reserve(m_data.size());
+   typename map_t::const_iterator i_page;
+   for (i_page = m_data.begin(); i_page != m_data.end(); ++i_page) 
+      indices.push_back(i_page->first);
+}
+
+template<unsigned BSIZE> const unsigned char *memory_space_impl<BSIZE>::get_block( mem_addr_t blk_idx ) const
+{
+   typename map_t::const_iterator i = m_data.find(blk_idx);
+   if( i == m_data.end() ) 
+      return NULL;
+   return i->second.data();
+}
+
+template<unsigned BSIZE> void memory_space_impl<BSIZE>::map_block( mem_addr_t blk_idx, unsigned char *data )
+{
+   // data must stay valid (and hold BSIZE bytes) for the lifetime of this memory space 
+   m_data[blk_idx].adopt(data);
+}
+
+template<unsigned BSIZE> void memory_space_impl<BSIZE>::release( mem_addr_t addr, size_t length )
+{
+   mem_addr_t first = (addr + BSIZE - 1) >> m_log2_block_size;
+   mem_addr_t last = (addr + length) >> m_log2_block_size; // one past the last whole block
+   if( last <= first ) 
+      return;
+   if( last - first > m_data.size() ) {
+      // large range: cheaper to walk the allocated blocks
+      typename map_t::iterator i = m_data.begin();
+      while( i != m_data.end() ) {
+         if( i->first >= first && i->first < last ) 
+            m_data.erase(i++);
+         else 
+            ++i;
+      }
+   } else {
+      for( mem_addr_t blk=first; blk < last; blk++ ) 
+         m_data.erase(blk);
+   }
+}
+
 template class memory_space_impl<32>;
 template class memory_space_impl<64>;
 template class memory_space_impl<8192>;
 template class memory_space_impl<16*1024>;
 
+void flat_memory_space::grow( size_t size )
+{
+   if( size > m_data.size() ) 
+      m_data.resize((size + FLAT_MEM_BLOCK_SIZE - 1) & ~(size_t)(FLAT_MEM_BLOCK_SIZE - 1), 0);
+}
+
+void flat_memory_space::write( mem_addr_t addr, size_t length, const void *data, class ptx_thread_info *thd, const ptx_instruction *pI )
+{
+   grow(addr + length);
+   memcpy(&m_data[addr],data,length);
+   if( !m_watchpoints.empty() ) {
+      std::map<unsigned,mem_addr_t>::iterator i;
+      for( i=m_watchpoints.begin(); i!=m_watchpoints.end(); i++ ) {
+         mem_addr_t wa = i->second;
+         if( ((addr<=wa) && ((addr+length)>wa)) || ((addr>wa) && (addr < (wa+4))) ) 
+            hit_watchpoint(i->first,thd,pI);
+      }
+   }
+}
+
+void flat_memory_space::read( mem_addr_t addr, size_t length, void *data ) const
+{
+   size_t avail = addr < m_data.size() ? m_data.size() - addr : 0;
+   size_t n = length < avail ? length : avail;
+   if( n ) 
+      memcpy(data,&m_data[addr],n);
+   if( n < length ) 
+      memset((unsigned char*)data + n,0,length - n);
+}
+
+void flat_memory_space::print( const char *format, FILE *fout ) const
+{
+   const unsigned *words = (const unsigned*)(m_data.empty() ? NULL : &m_data[0]);
+   fprintf(fout, "%s - %#x:", m_name.c_str(), 0);
+   for( size_t d=0; d < m_data.size() / sizeof(unsigned); d++ ) {
+      if( d % 8 == 0 ) 
+         fprintf(fout, "\n");
+      fprintf(fout, format, words[d]);
+      fprintf(fout, " ");
+   }
+   fprintf(fout, "\n");
+   fflush(fout);
+}
+
+void flat_memory_space::set_watch( addr_t addr, unsigned watchpoint )
+{
+   m_watchpoints[watchpoint]=addr;
+}
+
+void flat_memory_space::get_block_indices( std::vector<mem_addr_t> &indices ) const
+{
+   indices.clear();
+   for( mem_addr_t b=0; b < m_data.size() / FLAT_MEM_BLOCK_SIZE; b++ ) 
+      indices.push_back(b);
+}
+
+const unsigned char *flat_memory_space::get_block( mem_addr_t blk_idx ) const
+{
+   if( (blk_idx + 1) * FLAT_MEM_BLOCK_SIZE > m_data.size() ) 
+      return NULL;
+   return &m_data[blk_idx * FLAT_MEM_BLOCK_SIZE];
+}
+
+void flat_memory_space::map_block( mem_addr_t blk_idx, unsigned char *data )
+{
+   // the buffer is contiguous, so the block is copied rather than adopted
+   grow((blk_idx + 1) * FLAT_MEM_BLOCK_SIZE);
+   memcpy(&m_data[blk_idx * FLAT_MEM_BLOCK_SIZE],data,FLAT_MEM_BLOCK_SIZE);
+}
+
+void flat_memory_space::release( mem_addr_t addr, size_t length )
+{
+   if( addr >= m_data.size() ) 
+      return;
+   if( addr + length > m_data.size() ) 
+      length = m_data.size() - addr;
+   memset(&m_data[addr],0,length);
+}
+
 void g_print_memory_space(memory_space *mem, const char *format = "%08x", FILE *fout = stdout) 
 {
     mem->print(format,fout);
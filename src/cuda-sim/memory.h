@@ -43,6 +43,7 @@
 #include <stdio.h>
 #include <string>
 #include <map>
+#include <vector>
 #include <stdlib.h>
 
 typedef address_type mem_addr_t;
@@ -55,16 +56,29 @@ public:
    {
       m_data = (unsigned char*)calloc(1,BSIZE);
       memcpy(m_data,another.m_data,BSIZE);
+      m_owned = true;
    }
    mem_storage()
    {
       m_data = (unsigned char*)calloc(1,BSIZE);
+      m_owned = true;
    }
    ~mem_storage()
    {
-      free(m_data);
+      if( m_owned ) 
+         free(m_data);
    }
 
+   // use externally managed storage (e.g. a memory-mapped checkpoint) for this block 
+   void adopt( unsigned char *data )
+   {
+      if( m_owned ) 
+         free(m_data);
+      m_data = data;
+      m_owned = false;
+   }
+   const unsigned char *data() const { return m_data; }
+
    void write( unsigned offset, size_t length, const unsigned char *data )
    {
       assert( offset + length <= BSIZE );
@@ -94,6 +108,7 @@ public:
 private:
    unsigned m_nbytes;
    unsigned char *m_data;
+   bool m_owned;
 };
 
 class ptx_thread_info;
@@ -107,6 +122,17 @@ public:
    virtual void read( mem_addr_t addr, size_t length, void *data ) const = 0;
    virtual void print( const char *format, FILE *fout ) const = 0;
    virtual void set_watch( addr_t addr, unsigned watchpoint ) = 0;
+
+   // block level access used by the checkpoint code (gpgpu-sim/checkpoint.h)
+   virtual unsigned block_size() const = 0;
+   virtual void get_block_indices( std::vector<mem_addr_t> &indices ) const = 0;
+   virtual const unsigned char *get_block( mem_addr_t blk_idx ) const = 0;
+   virtual void map_block( mem_addr_t blk_idx, unsigned char *data ) = 0;
+   virtual void clear() = 0;
+
+   // drop the storage of every block lying entirely inside [addr,addr+length);
+   // those bytes read as zero afterwards
+   virtual void release( mem_addr_t addr, size_t length ) = 0;
 };
 
 template<unsigned BSIZE> class memory_space_impl : public memory_space {
@@ -118,6 +144,13 @@ public:
    virtual void print( const char *format, FILE *fout ) const;
    virtual void set_watch( addr_t addr, unsigned watchpoint ); 
 
+   virtual unsigned block_size() const { return BSIZE; }
+   virtual void get_block_indices( std::vector<mem_addr_t> &indices ) const;
+   virtual const unsigned char *get_block( mem_addr_t blk_idx ) const;
+   virtual void map_block( mem_addr_t blk_idx, unsigned char *data );
+   virtual void clear() { m_data.clear(); }
+   virtual void release( mem_addr_t addr, size_t length );
+
 private:
    void read_single_block( mem_addr_t blk_idx, mem_addr_t addr, size_t length, void *data) const; 
    std::string m_name;
@@ -127,4 +160,32 @@ private:
    std::map<unsigned,mem_addr_t> m_watchpoints;
 };
 
+// Small memory starting at address 0 held in one contiguous buffer, for
+// spaces such as kernel parameters that only hold a few hundred bytes and
+// are created for every launch; unwritten bytes read as zero.
+class flat_memory_space : public memory_space {
+public:
+   flat_memory_space( std::string name ) : m_name(name) {}
+
+   virtual void write( mem_addr_t addr, size_t length, const void *data, ptx_thread_info *thd, const ptx_instruction *pI );
+   virtual void read( mem_addr_t addr, size_t length, void *data ) const;
+   virtual void print( const char *format, FILE *fout ) const;
+   virtual void set_watch( addr_t addr, unsigned watchpoint );
+
+   virtual unsigned block_size() const { return FLAT_MEM_BLOCK_SIZE; }
+   virtual void get_block_indices( std::vector<mem_addr_t> &indices ) const;
+   virtual const unsigned char *get_block( mem_addr_t blk_idx ) const;
+   virtual void map_block( mem_addr_t blk_idx, unsigned char *data );
+   virtual void clear() { m_data.clear(); }
+   virtual void release( mem_addr_t addr, size_t length );
+
+private:
+   enum { FLAT_MEM_BLOCK_SIZE = 256 };
+   void grow( size_t size );
+
+   std::string m_name;
+   std::vector<unsigned char> m_data; // always a whole number of blocks
+   std::map<unsigned,mem_addr_t> m_watchpoints;
+};
+
 #endif
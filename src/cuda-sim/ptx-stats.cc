@@ -29,6 +29,7 @@
 #include "ptx_sim.h"
 #include "ptx-stats.h"
 #include "../option_parser.h"
+#include "../gpgpusim_entrypoint.h"
 #include <stdio.h>
 #include <map>
 #include "../tr1_hash_map.h"
@@ -115,7 +116,16 @@ struct hash_ptx_file_line
 typedef tr1_hash_map<ptx_file_line, ptx_file_line_stats, hash_ptx_file_line> ptx_file_line_stats_map_t;
 #endif
 
-static ptx_file_line_stats_map_t ptx_file_line_stats_tracker;
+// the statistics are collected by the timing model, so each simulation thread
+// (one per simulated device) keeps its own table
+static __thread ptx_file_line_stats_map_t *t_ptx_file_line_stats_tracker = NULL;
+
+static ptx_file_line_stats_map_t &line_stats_tracker()
+{
+    if (t_ptx_file_line_stats_tracker == NULL) 
+        t_ptx_file_line_stats_tracker = new ptx_file_line_stats_map_t;
+    return *t_ptx_file_line_stats_tracker;
+}
 
 // output statistics to a file
 void ptx_file_line_stats_write_file()
@@ -126,7 +136,9 @@ void ptx_file_line_stats_write_file()
     ptx_file_line_stats_map_t::iterator it;
     FILE * pfile;
 
-    pfile = fopen(ptx_line_stats_filename, "w");
+    ptx_file_line_stats_map_t &ptx_file_line_stats_tracker = line_stats_tracker();
+    std::string filename = gpgpu_ptx_sim_output_filename(ptx_line_stats_filename);
+    pfile = fopen(filename.c_str(), "w");
     fprintf(pfile,"kernel line : count latency dram_traffic smem_bk_conflicts smem_warp gmem_access_generated gmem_warp exposed_latency warp_divergence\n");
     for( it=ptx_file_line_stats_tracker.begin(); it != ptx_file_line_stats_tracker.end(); it++ ) {
         fprintf(pfile, "%s %i : ", it->first.st.c_str(), it->first.line);
@@ -149,7 +161,7 @@ void ptx_file_line_stats_write_file()
 // counting the number of threads (not warps) executing this instruction
 void ptx_file_line_stats_add_exec_count(const ptx_instruction *pInsn)
 {
-    ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())].exec_count += 1;
+    line_stats_tracker()[ptx_file_line(pInsn->source_file(), pInsn->source_line())].exec_count += 1;
 }
 
 // attribute pipeline latency to this ptx instruction (specified by the pc)
@@ -158,7 +170,7 @@ void ptx_file_line_stats_add_latency(unsigned pc, unsigned latency)
 {
     const ptx_instruction *pInsn = function_info::pc_to_instruction(pc);
     
-    ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())].latency += latency;
+    line_stats_tracker()[ptx_file_line(pInsn->source_file(), pInsn->source_line())].latency += latency;
 }
 
 // attribute dram traffic to this ptx instruction (specified by the pc)
@@ -167,7 +179,7 @@ void ptx_file_line_stats_add_dram_traffic(unsigned pc, unsigned dram_traffic)
 {
     const ptx_instruction *pInsn = function_info::pc_to_instruction(pc);
     
-    ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())].dram_traffic += dram_traffic;
+    line_stats_tracker()[ptx_file_line(pInsn->source_file(), pInsn->source_line())].dram_traffic += dram_traffic;
 }
 
 // attribute the number of shared memory access cycles to a ptx instruction
@@ -176,7 +188,7 @@ void ptx_file_line_stats_add_smem_bank_conflict(unsigned pc, unsigned n_way_bkco
 {
     const ptx_instruction *pInsn = function_info::pc_to_instruction(pc);
     
-    ptx_file_line_stats& line_stats = ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())];
+    ptx_file_line_stats& line_stats = line_stats_tracker()[ptx_file_line(pInsn->source_file(), pInsn->source_line())];
     line_stats.smem_n_way_bank_conflict_total += n_way_bkconflict;
     line_stats.smem_warp_count += 1;
 }
@@ -187,7 +199,7 @@ void ptx_file_line_stats_add_uncoalesced_gmem(unsigned pc, unsigned n_access)
 {
     const ptx_instruction *pInsn = function_info::pc_to_instruction(pc);
     
-    ptx_file_line_stats& line_stats = ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())];
+    ptx_file_line_stats& line_stats = line_stats_tracker()[ptx_file_line(pInsn->source_file(), pInsn->source_line())];
     line_stats.gmem_n_access_total += n_access;
     line_stats.gmem_warp_count += 1;
 }
@@ -226,7 +238,7 @@ public:
         i_exlatinsn = exlat_insnmap.begin();
         for (; i_exlatinsn != exlat_insnmap.end(); ++i_exlatinsn) {
             const ptx_instruction *pInsn = i_exlatinsn->first;
-            ptx_file_line_stats& line_stats = ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())];
+            ptx_file_line_stats& line_stats = line_stats_tracker()[ptx_file_line(pInsn->source_file(), pInsn->source_line())];
             line_stats.exposed_latency += count;
         }
     }
@@ -234,13 +246,22 @@ public:
     insn_count_map ptx_inflight_memory_insns;
 };
 
-static ptx_inflight_memory_insn_tracker *inflight_mem_tracker = NULL;
+static __thread ptx_inflight_memory_insn_tracker *inflight_mem_tracker = NULL;
 
 void ptx_file_line_stats_create_exposed_latency_tracker(int n_shader_cores)
 {
+    delete[] inflight_mem_tracker;
     inflight_mem_tracker = new ptx_inflight_memory_insn_tracker[n_shader_cores];
 }
 
+void ptx_file_line_stats_reset()
+{
+    delete t_ptx_file_line_stats_tracker;
+    t_ptx_file_line_stats_tracker = NULL;
+    delete[] inflight_mem_tracker;
+    inflight_mem_tracker = NULL;
+}
+
 // add an inflight memory instruction
 void ptx_file_line_stats_add_inflight_memory_insn(int sc_id, unsigned pc)
 {
@@ -269,7 +290,7 @@ void ptx_file_line_stats_add_warp_divergence(unsigned pc, unsigned n_way_diverge
 {
     const ptx_instruction *pInsn = function_info::pc_to_instruction(pc);
     
-    ptx_file_line_stats& line_stats = ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())];
+    ptx_file_line_stats& line_stats = line_stats_tracker()[ptx_file_line(pInsn->source_file(), pInsn->source_line())];
     line_stats.warp_divergence += n_way_divergence;
 }
 
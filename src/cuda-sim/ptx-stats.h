@@ -37,6 +37,9 @@ void ptx_file_line_stats_options(option_parser_t opp);
 // output stats to a file
 void ptx_file_line_stats_write_file();
 
+// clear the calling thread's statistics before it simulates another configuration
+void ptx_file_line_stats_reset();
+
 #ifdef __cplusplus
 // stat collection interface to cuda-sim
 class ptx_instruction;
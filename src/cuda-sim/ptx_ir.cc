@@ -1242,6 +1242,8 @@ function_info::function_info(int entry_point )
    num_reconvergence_pairs = 0;
    m_symtab = NULL;
    m_assembled = false;
+   m_pdom_done = false;
+   m_pdom_in_progress = false;
    m_return_var_sym = NULL; 
    m_kernel_info.cmem = 0;
    m_kernel_info.lmem = 0;
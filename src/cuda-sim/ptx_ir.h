@@ -1076,9 +1076,10 @@ private:
 
 class param_info {
 public:
-   param_info() { m_valid = false; m_value_set=false; m_size = 0; m_is_ptr = false; }
+   param_info() { m_valid = false; m_value_set=false; m_size = 0; m_is_ptr = false; m_symbol = NULL; }
    param_info( std::string name, int type, size_t size, bool is_ptr, memory_space_t ptr_space ) 
    {
+      m_symbol = NULL;
       m_valid = true;
       m_value_set = false;
       m_name = name;
@@ -1099,8 +1100,12 @@ public:
    param_t get_value() const { assert(m_value_set); return m_value; }
    size_t get_size() const { assert(m_valid); return m_size; }
    bool is_ptr_shared() const { assert(m_valid); return (m_is_ptr and m_ptr_space == shared_space); }
+   // the parameter's symbol in the kernel's symbol table, looked up on the first launch
+   class symbol *get_symbol() const { return m_symbol; }
+   void set_symbol( class symbol *s ) { m_symbol = s; }
 private:
    bool m_valid;
+   class symbol *m_symbol;
    std::string m_name;
    int m_type;
    size_t m_size;
@@ -1175,6 +1180,9 @@ public:
    unsigned get_function_size() { return m_instructions.size();}
 
    void ptx_assemble();
+   // control-flow analysis and instruction pre-decoding of this function and
+   // every function it calls; done once, on the first launch of the kernel
+   void do_pdom();
  
    unsigned ptx_get_inst_op( ptx_thread_info *thread );
    void add_param( const char *name, struct param_t value )
@@ -1183,6 +1191,8 @@ public:
    }
    void add_param_name_type_size( unsigned index, std::string name, int type, size_t size, bool ptr, memory_space_t space );
    void add_param_data( unsigned argn, struct gpgpu_ptx_sim_arg *args );
+   // formal kernel parameters by argument index (sizes in bits)
+   const std::map<unsigned,param_info> &get_param_info() const { return m_ptx_kernel_param_info; }
    void add_return_var( const symbol *rv )
    {
       m_return_var_sym = rv;
@@ -1226,6 +1236,14 @@ public:
    }
 
    void finalize( memory_space *param_mem );
+   // argument index (as passed to add_param_data), param memory address and
+   // size of each argument placed by the last finalize()
+   struct param_layout {
+      unsigned index;
+      unsigned address;
+      size_t size;
+   };
+   void get_param_layout( std::vector<param_layout> &layout ) const;
    void param_to_shared( memory_space *shared_mem, symbol_table *symtab ); 
    void list_param( FILE *fout ) const;
 
@@ -1262,11 +1280,15 @@ public:
    bool is_entry_point() const { return m_entry_point; }
 
 private:
+   void do_pdom_locked();
+
    unsigned m_uid;
    unsigned m_local_mem_framesize;
    bool m_entry_point;
    bool m_extern;
    bool m_assembled;
+   bool m_pdom_done;        // read without g_pdom_lock, see do_pdom()
+   bool m_pdom_in_progress; // guarded by g_pdom_lock
    std::string m_name;
    ptx_instruction **m_instr_mem;
    unsigned m_start_PC;
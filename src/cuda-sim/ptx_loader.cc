@@ -29,6 +29,8 @@
 #include "ptx_ir.h"
 #include "cuda-sim.h"
 #include "ptx_parser.h"
+#include "../gpgpu-sim/workload_log.h"
+#include "../../cuobjdump_to_ptxplus/cuobjdump_to_ptxplus.h"
 #include <unistd.h>
 #include <dirent.h>
 #include <fstream>
@@ -97,52 +99,53 @@ void print_ptx_file( const char *p, unsigned source_num, const char *filename )
    fflush(stdout);
 }
 
-char* gpgpu_ptx_sim_convert_ptx_and_sass_to_ptxplus(const std::string ptxfilename, const std::string elffilename, const std::string sassfilename)
+static std::string read_section_file( const std::string &filename )
 {
-
-	printf("GPGPU-Sim PTX: converting EMBEDDED .ptx file to ptxplus \n");
-
-    char fname_ptxplus[1024];
-    snprintf(fname_ptxplus,1024,"_ptxplus_XXXXXX");
-    int fd4=mkstemp(fname_ptxplus);
-    close(fd4);
-
-	// Run cuobjdump_to_ptxplus
-	char commandline[1024];
-	int result;
-	snprintf(commandline, 1024, "$GPGPUSIM_ROOT/build/$GPGPUSIM_CONFIG/cuobjdump_to_ptxplus/cuobjdump_to_ptxplus %s %s %s %s",
-			ptxfilename.c_str(),
-			sassfilename.c_str(),
-			elffilename.c_str(),
-			fname_ptxplus);
-	fflush(stdout);
-	printf("GPGPU-Sim PTX: calling cuobjdump_to_ptxplus\ncommandline: %s\n", commandline);
-	result = system(commandline);
-	if(result){printf("GPGPU-Sim PTX: ERROR ** could not execute %s\n", commandline); exit(1);}
-
-
-	// Get ptxplus from file
-	std::ifstream fileStream(fname_ptxplus, std::ios::in);
+	std::ifstream fileStream(filename.c_str(), std::ios::in);
+	if (!fileStream.is_open()) {
+		printf("GPGPU-Sim PTX: ERROR ** could not open %s\n", filename.c_str());
+		exit(1);
+	}
 	std::string text, line;
 	while(getline(fileStream,line)) {
 		text += (line + "\n");
 	}
 	fileStream.close();
+	return text;
+}
 
-	char* ptxplus_str = new char [strlen(text.c_str())+1];
-	strcpy(ptxplus_str, text.c_str());
+char* gpgpu_ptx_sim_convert_ptx_and_sass_to_ptxplus(const std::string ptxfilename, const std::string elffilename, const std::string sassfilename)
+{
+
+	printf("GPGPU-Sim PTX: converting EMBEDDED .ptx file to ptxplus \n");
+
+	std::string ptx = read_section_file(ptxfilename);
+	std::string sass = read_section_file(sassfilename);
+	std::string elf = read_section_file(elffilename);
+
+	// Run the converter in-process
+	fflush(stdout);
+	char *text = cuobjdump_to_ptxplus(ptx.c_str(), sass.c_str(), elf.c_str());
+	if(text == NULL){
+		printf("GPGPU-Sim PTX: ERROR ** could not convert %s, %s and %s to ptxplus\n",
+				ptxfilename.c_str(), sassfilename.c_str(), elffilename.c_str());
+		exit(1);
+	}
 
-	if (!m_ptx_save_converted_ptxplus){
-		char rm_commandline[1024];
+	char* ptxplus_str = new char [strlen(text)+1];
+	strcpy(ptxplus_str, text);
+	free(text);
 
-		snprintf(rm_commandline,1024,"rm -f %s", fname_ptxplus);
+	if (m_ptx_save_converted_ptxplus){
+		char fname_ptxplus[1024];
+		snprintf(fname_ptxplus,1024,"_ptxplus_XXXXXX");
+		int fd4=mkstemp(fname_ptxplus);
+		close(fd4);
 
-		printf("GPGPU-Sim PTX: removing temporary files using \"%s\"\n", rm_commandline);
-		int rm_result = system(rm_commandline);
-		if( rm_result != 0 ) {
-			printf("GPGPU-Sim PTX: ERROR ** while removing temporary files %d\n", rm_result);
-			exit(1);
-		}
+		printf("GPGPU-Sim PTX: saving converted ptxplus to %s\n", fname_ptxplus);
+		FILE *fp = fopen(fname_ptxplus,"w");
+		fprintf(fp,"%s",ptxplus_str);
+		fclose(fp);
 	}
 	printf("GPGPU-Sim PTX: DONE converting EMBEDDED .ptx file to ptxplus \n");
 
@@ -177,6 +180,8 @@ symbol_table *gpgpu_ptx_sim_load_ptx_from_string( const char *p, unsigned source
 
     if ( g_debug_execution >= 100 ) 
        print_ptx_file(p,source_num,buf);
+    if ( g_workload_recorder ) 
+       g_workload_recorder->module(source_num,p);
 
     printf("GPGPU-Sim PTX: finished parsing EMBEDDED .ptx file %s\n",buf);
     return symtab;
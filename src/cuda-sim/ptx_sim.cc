@@ -128,7 +128,7 @@ unsigned ptx_cta_info::get_sm_idx() const
    return m_sm_idx;
 }
 
-unsigned g_ptx_thread_info_uid_next=1;
+__thread unsigned g_ptx_thread_info_uid_next=1;
 unsigned g_ptx_thread_info_delete_count=0;
 
 ptx_thread_info::~ptx_thread_info()
@@ -484,6 +484,6 @@ bool isspace_shared( unsigned smid, addr_t addr );
 bool isspace_global( addr_t addr );
 memory_space_t whichspace( addr_t addr );
 
-extern unsigned g_ptx_thread_info_uid_next;
+extern __thread unsigned g_ptx_thread_info_uid_next;
 
 #endif
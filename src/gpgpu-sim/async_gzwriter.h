@@ -0,0 +1,270 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ASYNC_GZWRITER_H_INCLUDED
+#define ASYNC_GZWRITER_H_INCLUDED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <assert.h>
+#include <pthread.h>
+#include <zlib.h>
+#include <string>
+#include <deque>
+#include <set>
+
+// Compressed log writer used by the visualizer, power trace and warp trace
+// files.
+//
+// Text is formatted with print(), or bytes appended with write(), into an
+// in-memory buffer owned by the simulation thread. commit() hands the buffer
+// over to a background thread that keeps a single gz stream open for the
+// lifetime of the writer, so zlib compression and disk I/O overlap with
+// simulation instead of stalling the cycle loop at every sample.  A buffer
+// may be committed with an encoder, which the background thread runs on it
+// before writing; files opened in transparent mode ("wbT") use this to
+// compress records individually.  The owner closes the writer when its
+// simulator is torn down; a later commit() reopens the file in append mode.
+// Writers still open at exit are drained and closed by an atexit() handler.
+//
+// The class is kept header-only so that the power model (which is also linked
+// into a standalone mcpat binary) can use it without the gpgpu-sim objects.
+class async_gzwriter {
+public:
+   async_gzwriter()
+   {
+      m_file = NULL;
+      m_zlevel = Z_DEFAULT_COMPRESSION;
+      m_done = false;
+      pthread_mutex_init(&m_lock,NULL);
+      pthread_mutex_init(&m_close_lock,NULL);
+      pthread_cond_init(&m_not_empty,NULL);
+      pthread_cond_init(&m_not_full,NULL);
+   }
+   ~async_gzwriter()
+   {
+      close();
+      pthread_cond_destroy(&m_not_full);
+      pthread_cond_destroy(&m_not_empty);
+      pthread_mutex_destroy(&m_close_lock);
+      pthread_mutex_destroy(&m_lock);
+   }
+
+   // rewrites a committed buffer on the writer thread; zlevel is the level
+   // the writer was opened with
+   typedef void (*encoder)( std::string &buf, int zlevel );
+
+   // mode is passed to gzopen (e.g. "w", "a" or "wbT"), zlevel to gzsetparams
+   bool open( const char *filename, const char *mode, int zlevel )
+   {
+      assert(m_file == NULL);
+      m_file = gzopen(filename,mode);
+      if (m_file == NULL)
+         return false;
+      gzsetparams(m_file,zlevel,Z_DEFAULT_STRATEGY);
+      m_filename = filename;
+      m_reopen_mode = mode;
+      if (m_reopen_mode.find('w') != std::string::npos)
+         m_reopen_mode[m_reopen_mode.find('w')] = 'a';
+      m_zlevel = zlevel;
+      m_done = false;
+      pthread_create(&m_thread,NULL,writer_thread,this);
+      // writers of several simulated devices open and close concurrently;
+      // the registry is constructed before the handler is registered so that
+      // it is still alive when close_all() runs at exit
+      pthread_mutex_lock(&registry_lock());
+      std::set<async_gzwriter*> &writers = open_writers();
+      static bool registered_atexit = false;
+      if (!registered_atexit) {
+         atexit(close_all);
+         registered_atexit = true;
+      }
+      writers.insert(this);
+      pthread_mutex_unlock(&registry_lock());
+      return true;
+   }
+   bool is_open() const { return m_file != NULL; }
+
+   void print( const char *fmt, ... )
+   {
+      char buf[256];
+      va_list ap;
+      va_start(ap,fmt);
+      int n = vsnprintf(buf,sizeof(buf),fmt,ap);
+      va_end(ap);
+      if (n < 0)
+         return;
+      if ((unsigned)n < sizeof(buf)) {
+         m_buffer.append(buf,n);
+         return;
+      }
+      size_t old_size = m_buffer.size();
+      m_buffer.resize(old_size+n+1);
+      va_start(ap,fmt);
+      vsnprintf(&m_buffer[old_size],n+1,fmt,ap);
+      va_end(ap);
+      m_buffer.resize(old_size+n);
+   }
+
+   // append raw bytes, e.g. the encoded chunks of the binary visualizer log
+   void write( const void *data, size_t size ) { m_buffer.append((const char*)data,size); }
+
+   // queue everything printed so far for compression; blocks only if the
+   // writer thread has fallen max_pending_buffers samples behind
+   void commit( encoder encode = NULL )
+   {
+      if (m_buffer.empty())
+         return;
+      if (m_file == NULL) {
+         // closed by the owner: later samples are appended to the same file
+         std::string filename = m_filename;
+         std::string mode = m_reopen_mode;
+         if (filename.empty() || !open(filename.c_str(),mode.c_str(),m_zlevel))
+            return;
+      }
+      pending p;
+      p.buf = new std::string;
+      p.buf->swap(m_buffer);
+      p.encode = encode;
+      pthread_mutex_lock(&m_lock);
+      while (m_pending.size() >= max_pending_buffers)
+         pthread_cond_wait(&m_not_full,&m_lock);
+      m_pending.push_back(p);
+      pthread_cond_signal(&m_not_empty);
+      pthread_mutex_unlock(&m_lock);
+   }
+
+   // commit, wait for the writer thread to drain and close the gz stream;
+   // the owner and the atexit() handler may both get here, only the first
+   // one joins the writer thread
+   void close()
+   {
+      if (m_filename.empty())
+         return; // never opened
+      pthread_mutex_lock(&registry_lock());
+      open_writers().erase(this);
+      pthread_mutex_lock(&m_close_lock);
+      pthread_mutex_unlock(&registry_lock());
+      close_unregistered();
+      pthread_mutex_unlock(&m_close_lock);
+   }
+
+private:
+   static const unsigned max_pending_buffers = 64;
+
+   struct pending {
+      std::string *buf;
+      encoder encode;
+   };
+
+   // called with m_close_lock held, after the writer left open_writers()
+   void close_unregistered()
+   {
+      if (m_file == NULL)
+         return;
+      commit();
+      pthread_mutex_lock(&m_lock);
+      m_done = true;
+      pthread_cond_signal(&m_not_empty);
+      pthread_mutex_unlock(&m_lock);
+      pthread_join(m_thread,NULL);
+      gzclose(m_file);
+      m_file = NULL;
+   }
+
+   static void *writer_thread( void *arg )
+   {
+      async_gzwriter *w = (async_gzwriter*)arg;
+      pthread_mutex_lock(&w->m_lock);
+      while (true) {
+         while (w->m_pending.empty() && !w->m_done)
+            pthread_cond_wait(&w->m_not_empty,&w->m_lock);
+         if (w->m_pending.empty())
+            break; // closed and fully drained
+         pending p = w->m_pending.front();
+         w->m_pending.pop_front();
+         pthread_cond_signal(&w->m_not_full);
+         pthread_mutex_unlock(&w->m_lock);
+         if (p.encode)
+            p.encode(*p.buf,w->m_zlevel);
+         gzwrite(w->m_file,p.buf->data(),p.buf->size());
+         delete p.buf;
+         pthread_mutex_lock(&w->m_lock);
+      }
+      pthread_mutex_unlock(&w->m_lock);
+      return NULL;
+   }
+
+   // guards open_writers() and the atexit() registration; taken before a
+   // writer's m_close_lock
+   static pthread_mutex_t &registry_lock()
+   {
+      static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+      return lock;
+   }
+   static std::set<async_gzwriter*> &open_writers()
+   {
+      static std::set<async_gzwriter*> writers;
+      return writers;
+   }
+   static void close_all()
+   {
+      while (true) {
+         // the writer's close lock is taken before the registry is released,
+         // so its owner cannot close and delete it underneath us
+         pthread_mutex_lock(&registry_lock());
+         async_gzwriter *w = NULL;
+         if (!open_writers().empty()) {
+            w = *open_writers().begin();
+            open_writers().erase(open_writers().begin());
+            pthread_mutex_lock(&w->m_close_lock);
+         }
+         pthread_mutex_unlock(&registry_lock());
+         if (w == NULL)
+            break;
+         w->close_unregistered();
+         pthread_mutex_unlock(&w->m_close_lock);
+      }
+   }
+
+   gzFile m_file;
+   std::string m_filename; // empty until the first open()
+   std::string m_reopen_mode; // the open() mode with "w" replaced by "a"
+   int m_zlevel;
+   std::string m_buffer; // filled by the simulation thread only
+
+   pthread_t m_thread;
+   pthread_mutex_t m_lock;
+   pthread_mutex_t m_close_lock; // serializes close() and close_all()
+   pthread_cond_t m_not_empty;
+   pthread_cond_t m_not_full;
+   std::deque<pending> m_pending;
+   bool m_done;
+};
+
+#endif
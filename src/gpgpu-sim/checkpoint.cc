@@ -0,0 +1,341 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "checkpoint.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <vector>
+
+#include "gpu-sim.h"
+#include "gpu-cache.h"
+#include "l2cache.h"
+#include "dram.h"
+#include "../cuda-sim/memory.h"
+#include "../cuda-sim/device_heap.h"
+#include "../gpgpusim_entrypoint.h"
+
+static void checkpoint_write( FILE *fp, const void *data, size_t size )
+{
+   if (size && fwrite(data,size,1,fp) != 1) {
+      printf("GPGPU-Sim uArch: ERROR ** cannot write checkpoint: %s\n", strerror(errno));
+      abort();
+   }
+}
+
+// pad the file with zeros up to a multiple of align
+static unsigned long long checkpoint_align( FILE *fp, unsigned long long align )
+{
+   static const char zeros[CHECKPOINT_ALIGN] = {0};
+   unsigned long long pos = ftello(fp);
+   unsigned long long pad = (align - pos % align) % align;
+   checkpoint_write(fp,zeros,pad);
+   return pos + pad;
+}
+
+static bool checkpoint_header_valid( const checkpoint_header &hdr )
+{
+   return !memcmp(hdr.magic,CHECKPOINT_MAGIC,sizeof(CHECKPOINT_MAGIC)) && hdr.version == CHECKPOINT_VERSION;
+}
+
+void gpgpu_sim::init_checkpoint()
+{
+   m_checkpoint_restore_launch = 0;
+   if (m_config.checkpoint_filename && m_config.checkpoint_kernel == 0) {
+      printf("GPGPU-Sim uArch: ERROR ** -checkpoint_file requires -checkpoint_kernel\n");
+      abort();
+   }
+   // every simulated device checkpoints (and restores) its own memory image
+   if (m_config.checkpoint_filename) 
+      m_checkpoint_filename = gpgpu_ptx_sim_output_filename(m_config.checkpoint_filename);
+   if (!m_config.checkpoint_restore_filename) 
+      return;
+   m_checkpoint_restore_filename = gpgpu_ptx_sim_output_filename(m_config.checkpoint_restore_filename);
+
+   // only the header is read here, the image is mapped when its kernel is launched
+   checkpoint_header hdr;
+   FILE *fp = fopen(m_checkpoint_restore_filename.c_str(),"rb");
+   if (!fp || fread(&hdr,sizeof(hdr),1,fp) != 1 || !checkpoint_header_valid(hdr)) {
+      printf("GPGPU-Sim uArch: ERROR ** '%s' is not a checkpoint file\n", m_checkpoint_restore_filename.c_str());
+      abort();
+   }
+   fclose(fp);
+   m_checkpoint_restore_launch = hdr.kernel_launch;
+   printf("GPGPU-Sim uArch: resuming from checkpoint '%s', kernels before launch %u are not simulated\n",
+          m_checkpoint_restore_filename.c_str(), m_checkpoint_restore_launch);
+}
+
+bool gpgpu_sim::checkpoint_kernel_launch( kernel_info_t *kinfo )
+{
+   unsigned launch = kinfo->get_launch_index();
+   assert(launch != 0);
+   if (m_checkpoint_restore_launch) {
+      if (launch < m_checkpoint_restore_launch) {
+         printf("GPGPU-Sim uArch: skipping kernel launch %u '%s' (before checkpoint)\n", launch, kinfo->name().c_str());
+         return false;
+      }
+      if (launch > m_checkpoint_restore_launch) {
+         printf("GPGPU-Sim uArch: ERROR ** kernel launch %u reached the scheduler before checkpointed launch %u\n", launch, m_checkpoint_restore_launch);
+         abort();
+      }
+      restore_checkpoint(m_checkpoint_restore_filename.c_str(),kinfo);
+      m_checkpoint_restore_launch = 0;
+   }
+   if (m_config.checkpoint_filename && launch == m_config.checkpoint_kernel) 
+      save_checkpoint(m_checkpoint_filename.c_str(),kinfo);
+   return true;
+}
+
+void gpgpu_sim::save_checkpoint( const char *filename, const kernel_info_t *kinfo )
+{
+   for (unsigned n=0; n < m_running_kernels.size(); n++) {
+      if (m_running_kernels[n] && !m_running_kernels[n]->done()) 
+         printf("GPGPU-Sim uArch: WARNING ** kernel %u is still running, its partial results are part of the checkpoint\n",
+                m_running_kernels[n]->get_uid());
+   }
+
+   FILE *fp = fopen(filename,"wb");
+   if (!fp) {
+      printf("GPGPU-Sim uArch: ERROR ** cannot create checkpoint '%s': %s\n", filename, strerror(errno));
+      abort();
+   }
+
+   checkpoint_header hdr;
+   memset(&hdr,0,sizeof(hdr));
+   memcpy(hdr.magic,CHECKPOINT_MAGIC,sizeof(CHECKPOINT_MAGIC));
+   hdr.version = CHECKPOINT_VERSION;
+   hdr.kernel_launch = kinfo->get_launch_index();
+   hdr.dev_malloc = m_dev_heap->top();
+   hdr.tot_sim_cycle = gpu_tot_sim_cycle;
+   hdr.tot_sim_insn = gpu_tot_sim_insn;
+   hdr.tot_issued_cta = gpu_tot_issued_cta;
+   checkpoint_write(fp,&hdr,sizeof(hdr)); // rewritten at the end
+
+   hdr.name_offset = checkpoint_align(fp,8);
+   hdr.name_length = kinfo->name().size();
+   checkpoint_write(fp,kinfo->name().c_str(),hdr.name_length);
+
+   hdr.texture_offset = checkpoint_align(fp,8);
+   std::map<std::string, const struct textureReference*>::const_iterator t;
+   for (t=m_NameToTextureRef.begin(); t != m_NameToTextureRef.end(); t++) {
+      std::map<const struct textureReference*,const struct cudaArray*>::const_iterator a = m_TextureRefToCudaArray.find(t->second);
+      if (a == m_TextureRefToCudaArray.end()) 
+         continue; // not bound
+      checkpoint_texture tex;
+      memset(&tex,0,sizeof(tex));
+      tex.name_length = t->first.size();
+      tex.devPtr32 = a->second->devPtr32;
+      tex.width = a->second->width;
+      tex.height = a->second->height;
+      tex.size = a->second->size;
+      tex.desc = a->second->desc;
+      checkpoint_write(fp,&tex,sizeof(tex));
+      checkpoint_write(fp,t->first.c_str(),tex.name_length);
+      checkpoint_align(fp,8);
+      hdr.n_textures++;
+   }
+
+   if (m_config.checkpoint_warm_state) {
+      if (!m_memory_config->m_L2_config.disabled()) {
+         hdr.l2_offset = checkpoint_align(fp,8);
+         hdr.n_l2_banks = m_memory_config->m_n_mem_sub_partition;
+         for (unsigned i=0; i < hdr.n_l2_banks; i++) {
+            tag_array *tags = m_memory_sub_partition[i]->get_L2_tag_array();
+            hdr.n_l2_lines = tags->size();
+            for (unsigned l=0; l < hdr.n_l2_lines; l++) {
+               const cache_block_t &block = tags->get_block(l);
+               checkpoint_l2_line line;
+               memset(&line,0,sizeof(line));
+               line.tag = block.m_tag;
+               line.block_addr = block.m_block_addr;
+               line.status = block.m_status;
+               checkpoint_write(fp,&line,sizeof(line));
+            }
+         }
+      }
+      hdr.dram_offset = checkpoint_align(fp,8);
+      hdr.n_dram = m_memory_config->m_n_mem;
+      for (unsigned i=0; i < hdr.n_dram; i++) {
+         dram_t *dram = m_memory_partition_unit[i]->get_dram();
+         hdr.n_dram_banks = dram->num_banks();
+         for (unsigned b=0; b < hdr.n_dram_banks; b++) {
+            checkpoint_dram_bank bank;
+            bank.active = dram->get_open_row(b,bank.row);
+            checkpoint_write(fp,&bank,sizeof(bank));
+         }
+      }
+   }
+
+   memory_space *spaces[CKPT_NUM_SPACES] = { m_global_mem, m_tex_mem, m_surf_mem };
+   std::vector<mem_addr_t> indices[CKPT_NUM_SPACES];
+   for (unsigned s=0; s < CKPT_NUM_SPACES; s++) {
+      spaces[s]->get_block_indices(indices[s]);
+      std::sort(indices[s].begin(),indices[s].end());
+      checkpoint_space_desc &desc = hdr.spaces[s];
+      desc.block_size = spaces[s]->block_size();
+      desc.n_blocks = indices[s].size();
+      desc.index_offset = checkpoint_align(fp,8);
+      for (unsigned i=0; i < indices[s].size(); i++) {
+         unsigned long long idx = indices[s][i];
+         checkpoint_write(fp,&idx,sizeof(idx));
+      }
+   }
+   unsigned long long image_size = 0;
+   for (unsigned s=0; s < CKPT_NUM_SPACES; s++) {
+      checkpoint_space_desc &desc = hdr.spaces[s];
+      desc.data_offset = checkpoint_align(fp,CHECKPOINT_ALIGN);
+      for (unsigned i=0; i < indices[s].size(); i++) 
+         checkpoint_write(fp,spaces[s]->get_block(indices[s][i]),desc.block_size);
+      image_size += desc.n_blocks * desc.block_size;
+   }
+
+   fseeko(fp,0,SEEK_SET);
+   checkpoint_write(fp,&hdr,sizeof(hdr));
+   if (fclose(fp) != 0) {
+      printf("GPGPU-Sim uArch: ERROR ** cannot write checkpoint '%s': %s\n", filename, strerror(errno));
+      abort();
+   }
+   printf("GPGPU-Sim uArch: wrote checkpoint '%s' before kernel launch %u '%s' (%llu bytes of device memory%s)\n",
+          filename, hdr.kernel_launch, kinfo->name().c_str(), image_size, hdr.dram_offset ? ", warm state" : "");
+}
+
+void gpgpu_sim::restore_checkpoint( const char *filename, const kernel_info_t *kinfo )
+{
+   int fd = open(filename,O_RDONLY);
+   struct stat st;
+   if (fd < 0 || fstat(fd,&st) != 0) {
+      printf("GPGPU-Sim uArch: ERROR ** cannot open checkpoint '%s': %s\n", filename, strerror(errno));
+      abort();
+   }
+   // private writable mapping: the memory spaces use the pages directly and
+   // copy-on-write keeps the file unchanged; the mapping is never released
+   unsigned long long file_size = st.st_size;
+   unsigned char *base = (unsigned char*)mmap(NULL,file_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+   close(fd);
+   if (base == MAP_FAILED) {
+      printf("GPGPU-Sim uArch: ERROR ** cannot map checkpoint '%s': %s\n", filename, strerror(errno));
+      abort();
+   }
+   const checkpoint_header &hdr = *(const checkpoint_header*)base;
+   assert(file_size >= sizeof(hdr) && checkpoint_header_valid(hdr));
+
+   std::string name((const char*)base + hdr.name_offset, hdr.name_length);
+   if (name != kinfo->name()) {
+      printf("GPGPU-Sim uArch: ERROR ** checkpoint '%s' was taken before kernel '%s', launch %u is '%s'\n",
+             filename, name.c_str(), kinfo->get_launch_index(), kinfo->name().c_str());
+      abort();
+   }
+
+   memory_space *spaces[CKPT_NUM_SPACES] = { m_global_mem, m_tex_mem, m_surf_mem };
+   for (unsigned s=0; s < CKPT_NUM_SPACES; s++) {
+      const checkpoint_space_desc &desc = hdr.spaces[s];
+      if (desc.block_size != spaces[s]->block_size() || desc.data_offset + desc.n_blocks * desc.block_size > file_size) {
+         printf("GPGPU-Sim uArch: ERROR ** checkpoint '%s' is truncated or has a different memory block size\n", filename);
+         abort();
+      }
+      const unsigned long long *indices = (const unsigned long long*)(base + desc.index_offset);
+      spaces[s]->clear();
+      for (unsigned long long i=0; i < desc.n_blocks; i++) 
+         spaces[s]->map_block(indices[i], base + desc.data_offset + i * desc.block_size);
+   }
+
+   // the application re-ran its cudaMalloc calls, which should land at the same addresses
+   if (m_dev_heap->top() != hdr.dev_malloc) {
+      printf("GPGPU-Sim uArch: WARNING ** device heap is at 0x%llx, checkpoint has 0x%llx\n", m_dev_heap->top(), hdr.dev_malloc);
+      m_dev_heap->reserve_to(hdr.dev_malloc);
+   }
+
+   const unsigned char *p = base + hdr.texture_offset;
+   for (unsigned i=0; i < hdr.n_textures; i++) {
+      const checkpoint_texture &tex = *(const checkpoint_texture*)p;
+      std::string texname((const char*)p + sizeof(tex), tex.name_length);
+      p += (sizeof(tex) + tex.name_length + 7) & ~7ULL;
+      std::map<std::string, const struct textureReference*>::const_iterator t = m_NameToTextureRef.find(texname);
+      std::map<const struct textureReference*,const struct cudaArray*>::const_iterator a;
+      if (t != m_NameToTextureRef.end()) 
+         a = m_TextureRefToCudaArray.find(t->second);
+      if (t == m_NameToTextureRef.end() || a == m_TextureRefToCudaArray.end()) {
+         printf("GPGPU-Sim uArch: WARNING ** texture '%s' of the checkpoint is not bound\n", texname.c_str());
+         continue;
+      }
+      const struct cudaArray *array = a->second;
+      if (array->devPtr32 != tex.devPtr32 || array->width != tex.width || array->height != tex.height || array->size != tex.size) 
+         printf("GPGPU-Sim uArch: WARNING ** texture '%s' is bound to a different array than in the checkpoint\n", texname.c_str());
+   }
+
+   gpu_tot_sim_cycle = hdr.tot_sim_cycle;
+   gpu_tot_sim_insn = hdr.tot_sim_insn;
+   gpu_tot_issued_cta = hdr.tot_issued_cta;
+
+   if (hdr.l2_offset) {
+      const checkpoint_l2_line *line = (const checkpoint_l2_line*)(base + hdr.l2_offset);
+      bool match = hdr.n_l2_banks == m_memory_config->m_n_mem_sub_partition && !m_memory_config->m_L2_config.disabled();
+      for (unsigned i=0; match && i < hdr.n_l2_banks; i++) 
+         match = m_memory_sub_partition[i]->get_L2_tag_array()->size() == hdr.n_l2_lines;
+      if (!match) {
+         printf("GPGPU-Sim uArch: WARNING ** L2 geometry differs from the checkpoint, L2 starts cold\n");
+      } else {
+         for (unsigned i=0; i < hdr.n_l2_banks; i++) {
+            tag_array *tags = m_memory_sub_partition[i]->get_L2_tag_array();
+            for (unsigned l=0; l < hdr.n_l2_lines; l++, line++) {
+               cache_block_t &block = tags->get_block(l);
+               block = cache_block_t();
+               // lines still waiting for a fill at checkpoint time start invalid
+               if (line->status == VALID || line->status == MODIFIED) {
+                  block.m_tag = line->tag;
+                  block.m_block_addr = line->block_addr;
+                  block.m_status = (cache_block_state)line->status;
+               }
+            }
+         }
+      }
+   }
+   if (hdr.dram_offset) {
+      const checkpoint_dram_bank *bank = (const checkpoint_dram_bank*)(base + hdr.dram_offset);
+      if (hdr.n_dram != m_memory_config->m_n_mem || hdr.n_dram_banks != m_memory_config->nbk) {
+         printf("GPGPU-Sim uArch: WARNING ** DRAM geometry differs from the checkpoint, all banks start closed\n");
+      } else {
+         for (unsigned i=0; i < hdr.n_dram; i++) {
+            dram_t *dram = m_memory_partition_unit[i]->get_dram();
+            for (unsigned b=0; b < hdr.n_dram_banks; b++, bank++) {
+               if (bank->active) 
+                  dram->set_open_row(b,bank->row);
+            }
+         }
+      }
+   }
+
+   printf("GPGPU-Sim uArch: restored checkpoint '%s' at kernel launch %u '%s', gpu_tot_sim_cycle = %llu\n",
+          filename, hdr.kernel_launch, name.c_str(), gpu_tot_sim_cycle);
+}
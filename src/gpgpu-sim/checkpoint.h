@@ -0,0 +1,124 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CHECKPOINT_H_INCLUDED
+#define CHECKPOINT_H_INCLUDED
+
+#include "../abstract_hardware_model.h"
+
+// Simulator checkpoints taken at a kernel boundary.
+//
+// With -checkpoint_file and -checkpoint_kernel N set, the state of the
+// simulated device is written when kernel launch N (counted from 1 on that
+// device, see kernel_info_t::get_launch_index) reaches the hardware scheduler, before any of its CTAs are issued: the global (which also holds
+// constant memory and module globals), texture and surface memory spaces,
+// the device heap pointer, the texture bindings, the total cycle,
+// instruction and CTA counters and, with -checkpoint_warm_state, the L2 tags
+// and the open row of every DRAM bank.
+//
+// With -checkpoint_restore_file set, the application is run again from the
+// start.  Its host side calls (cudaMalloc, cudaMemcpy, texture binds, stream
+// and event operations) execute as usual, which rebuilds the stream, event
+// and binding state, but kernel launches before N are retired without being
+// simulated.  At launch N the device memory is replaced by the checkpoint
+// image and timing simulation continues from there.  Device-to-host copies
+// made while kernels are being skipped therefore return stale data.
+//
+// The device image is laid out so it can be mapped instead of read: memory
+// blocks are page aligned and the memory spaces adopt the mapped pages
+// (MAP_PRIVATE, so writes stay private to the process), which makes restoring
+// a multi-gigabyte image cost only the pages the remaining kernels touch.
+//
+// File layout (host byte order):
+//   checkpoint_header
+//   kernel name, texture table, warm state, block index arrays
+//   padding to a page boundary, then the blocks of each memory space
+// All offsets are from the start of the file.
+
+#define CHECKPOINT_MAGIC "GPUCKPT"
+#define CHECKPOINT_VERSION 2
+#define CHECKPOINT_ALIGN 4096
+
+enum checkpoint_space {
+   CKPT_GLOBAL = 0,
+   CKPT_TEX,
+   CKPT_SURF,
+   CKPT_NUM_SPACES
+};
+
+struct checkpoint_space_desc {
+   unsigned block_size;
+   unsigned long long n_blocks;
+   unsigned long long index_offset;   // n_blocks x u64 block index
+   unsigned long long data_offset;    // n_blocks x block_size bytes, page aligned
+};
+
+// one entry of the texture table, followed by name_length bytes of name
+struct checkpoint_texture {
+   unsigned name_length;
+   int devPtr32;
+   int width;
+   int height;
+   int size;
+   struct cudaChannelFormatDesc desc;
+};
+
+struct checkpoint_l2_line {
+   unsigned long long tag;
+   unsigned long long block_addr;
+   unsigned status;
+   unsigned pad;
+};
+
+struct checkpoint_dram_bank {
+   unsigned row;
+   unsigned active;
+};
+
+struct checkpoint_header {
+   char magic[8];
+   unsigned version;
+   unsigned kernel_launch;
+   unsigned long long name_offset;
+   unsigned name_length;
+   unsigned n_textures;
+   unsigned long long texture_offset;
+   unsigned long long dev_malloc;
+   unsigned long long tot_sim_cycle;
+   unsigned long long tot_sim_insn;
+   unsigned long long tot_issued_cta;
+   // warm state, zero if not saved 
+   unsigned n_l2_banks;
+   unsigned n_l2_lines;        // per bank
+   unsigned long long l2_offset;
+   unsigned n_dram;
+   unsigned n_dram_banks;      // per channel
+   unsigned long long dram_offset;
+   checkpoint_space_desc spaces[CKPT_NUM_SPACES];
+};
+
+#endif
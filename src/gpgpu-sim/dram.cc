@@ -124,6 +124,27 @@ bool dram_t::full() const
    else return mrqq->full();
 }
 
+unsigned dram_t::num_banks() const
+{
+   return m_config->nbk;
+}
+
+bool dram_t::get_open_row( unsigned bank, unsigned &row ) const
+{
+   assert(bank < m_config->nbk);
+   row = bk[bank]->curr_row;
+   return bk[bank]->state == BANK_ACTIVE;
+}
+
+void dram_t::set_open_row( unsigned bank, unsigned row )
+{
+   // only valid between kernels, when no request is in flight 
+   assert(bank < m_config->nbk);
+   assert(bk[bank]->mrq == NULL);
+   bk[bank]->curr_row = row;
+   bk[bank]->state = BANK_ACTIVE;
+}
+
 unsigned dram_t::que_length() const
 {
    unsigned nreqs = 0;
@@ -489,22 +510,40 @@ void dram_t::print_stat( FILE* simFile )
    max_mrqs_temp = 0;
 }
 
-void dram_t::visualizer_print( gzFile visualizer_file )
+// "name: <dram id> [bank] value" rows
+void dram_t::visualizer_row( visualizer_log *visualizer_file, const char *name, unsigned value )
+{
+   visualizer_file->begin_row(name);
+   visualizer_file->value(id);
+   visualizer_file->value(value);
+   visualizer_file->end_row();
+}
+
+void dram_t::visualizer_row( visualizer_log *visualizer_file, const char *name, unsigned bank, unsigned value )
+{
+   visualizer_file->begin_row(name);
+   visualizer_file->value(id);
+   visualizer_file->value(bank);
+   visualizer_file->value(value);
+   visualizer_file->end_row();
+}
+
+void dram_t::visualizer_print( visualizer_log *visualizer_file )
 {
    // dram specific statistics
-   gzprintf(visualizer_file,"dramncmd: %u %u\n",id, n_cmd_partial);  
-   gzprintf(visualizer_file,"dramnop: %u %u\n",id,n_nop_partial);
-   gzprintf(visualizer_file,"dramnact: %u %u\n",id,n_act_partial);
-   gzprintf(visualizer_file,"dramnpre: %u %u\n",id,n_pre_partial);
-   gzprintf(visualizer_file,"dramnreq: %u %u\n",id,n_req_partial);
-   gzprintf(visualizer_file,"dramavemrqs: %u %u\n",id,
+   visualizer_row(visualizer_file,"dramncmd: ",n_cmd_partial);
+   visualizer_row(visualizer_file,"dramnop: ",n_nop_partial);
+   visualizer_row(visualizer_file,"dramnact: ",n_act_partial);
+   visualizer_row(visualizer_file,"dramnpre: ",n_pre_partial);
+   visualizer_row(visualizer_file,"dramnreq: ",n_req_partial);
+   visualizer_row(visualizer_file,"dramavemrqs: ",
             n_cmd_partial?(ave_mrqs_partial/n_cmd_partial ):0);
 
    // utilization and efficiency
-   gzprintf(visualizer_file,"dramutil: %u %u\n",  
-            id,n_cmd_partial?100*bwutil_partial/n_cmd_partial:0);
-   gzprintf(visualizer_file,"drameff: %u %u\n", 
-            id,n_activity_partial?100*bwutil_partial/n_activity_partial:0);
+   visualizer_row(visualizer_file,"dramutil: ",
+            n_cmd_partial?100*bwutil_partial/n_cmd_partial:0);
+   visualizer_row(visualizer_file,"drameff: ",
+            n_activity_partial?100*bwutil_partial/n_activity_partial:0);
 
    // reset for next interval
    bwutil_partial = 0;
@@ -518,17 +557,17 @@ void dram_t::visualizer_print( gzFile visualizer_file )
 
    // dram access type classification
    for (unsigned j = 0; j < m_config->nbk; j++) {
-      gzprintf(visualizer_file,"dramglobal_acc_r: %u %u %u\n", id, j, 
+      visualizer_row(visualizer_file,"dramglobal_acc_r: ",j,
                m_stats->mem_access_type_stats[GLOBAL_ACC_R][id][j]);
-      gzprintf(visualizer_file,"dramglobal_acc_w: %u %u %u\n", id, j, 
+      visualizer_row(visualizer_file,"dramglobal_acc_w: ",j,
                m_stats->mem_access_type_stats[GLOBAL_ACC_W][id][j]);
-      gzprintf(visualizer_file,"dramlocal_acc_r: %u %u %u\n", id, j, 
+      visualizer_row(visualizer_file,"dramlocal_acc_r: ",j,
                m_stats->mem_access_type_stats[LOCAL_ACC_R][id][j]);
-      gzprintf(visualizer_file,"dramlocal_acc_w: %u %u %u\n", id, j, 
+      visualizer_row(visualizer_file,"dramlocal_acc_w: ",j,
                m_stats->mem_access_type_stats[LOCAL_ACC_W][id][j]);
-      gzprintf(visualizer_file,"dramconst_acc_r: %u %u %u\n", id, j, 
+      visualizer_row(visualizer_file,"dramconst_acc_r: ",j,
                m_stats->mem_access_type_stats[CONST_ACC_R][id][j]);
-      gzprintf(visualizer_file,"dramtexture_acc_r: %u %u %u\n", id, j, 
+      visualizer_row(visualizer_file,"dramtexture_acc_r: ",j,
                m_stats->mem_access_type_stats[TEXTURE_ACC_R][id][j]);
    }
 }
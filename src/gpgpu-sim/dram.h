@@ -31,7 +31,7 @@
 
 #include "delayqueue.h"
 #include <set>
-#include <zlib.h>
+#include "visualizer_binlog.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -102,7 +102,7 @@ public:
    unsigned que_length() const; 
    bool returnq_full() const;
    unsigned int queue_limit() const;
-   void visualizer_print( gzFile visualizer_file );
+   void visualizer_print( visualizer_log *visualizer_file );
 
    class mem_fetch* return_queue_pop();
    class mem_fetch* return_queue_top();
@@ -110,6 +110,11 @@ public:
    void cycle();
    void dram_log (int task);
 
+   // open row of each bank, saved and restored by the checkpoint code 
+   unsigned num_banks() const;
+   bool get_open_row( unsigned bank, unsigned &row ) const;
+   void set_open_row( unsigned bank, unsigned row );
+
    class memory_partition_unit *m_memory_partition_unit;
    unsigned int id;
 
@@ -124,6 +129,8 @@ public:
 								unsigned &req) const;
 
 private:
+   void visualizer_row( visualizer_log *visualizer_file, const char *name, unsigned value );
+   void visualizer_row( visualizer_log *visualizer_file, const char *name, unsigned bank, unsigned value );
    void scheduler_fifo();
    void scheduler_frfcfs();
 
@@ -56,10 +56,15 @@
 #include "../debug.h"
 #include "../gpgpusim_entrypoint.h"
 #include "../cuda-sim/cuda-sim.h"
+#include "../cuda-sim/device_heap.h"
 #include "../trace.h"
 #include "mem_latency_stat.h"
 #include "power_stat.h"
 #include "visualizer.h"
+#include "visualizer_binlog.h"
+#include "warp_trace.h"
+#include "kernel_workers.h"
+#include "workload_log.h"
 #include "stats.h"
 
 #ifdef GPGPUSIM_POWER_MODEL
@@ -79,13 +84,14 @@ class  gpgpu_sim_wrapper {};
 
 bool g_interactive_debugger_enabled=false;
 
-unsigned long long  gpu_sim_cycle = 0;
-unsigned long long  gpu_tot_sim_cycle = 0;
+// cycle counts of the simulated GPU owned by the calling simulation thread
+__thread unsigned long long  gpu_sim_cycle = 0;
+__thread unsigned long long  gpu_tot_sim_cycle = 0;
 
 
 // performance counter for stalls due to congestion.
-unsigned int gpu_stall_dramfull = 0; 
-unsigned int gpu_stall_icnt2sh = 0;
+__thread unsigned int gpu_stall_dramfull = 0; 
+__thread unsigned int gpu_stall_icnt2sh = 0;
 
 /* Clock Domains */
 
@@ -110,6 +116,10 @@ void power_config::reg_options(class OptionParser * opp)
 			  	  	  	  	 &g_power_config_name,"GPUWattch XML file",
 	                   "gpuwattch.xml");
 
+	  option_parser_register(opp, "-gpuwattch_cacti_cache_dir", OPT_CSTR,
+			  	  	  	  	 &g_power_cacti_cache_dir,"Directory holding cached CACTI array solutions (NULL = do not cache)",
+	                   NULL);
+
 	   option_parser_register(opp, "-power_simulation_enabled", OPT_BOOL,
 	                          &g_power_simulation_enabled, "Turn on power simulator (1=On, 0=Off)",
 	                          "0");
@@ -383,6 +393,36 @@ void gpgpu_sim_config::reg_options(option_parser_t opp)
    option_parser_register(opp, "-gpgpu_max_cta", OPT_INT32, &gpu_max_cta_opt, 
                "terminates gpu simulation early (0 = no limit)",
                "0");
+   option_parser_register(opp, "-gpgpu_timing_kernels", OPT_CSTR, &gpgpu_timing_kernels, 
+               "Launches (counted from 1 on each device) of the kernels simulated in timing mode, others run functionally (e.g. 3-5,8,10-; empty = all)",
+               NULL);
+   option_parser_register(opp, "-gpgpu_timing_kernel_regex", OPT_CSTR, &gpgpu_timing_kernel_regex, 
+               "Only kernels whose name matches this extended regular expression are simulated in timing mode",
+               NULL);
+   option_parser_register(opp, "-gpgpu_timing_insn_budget", OPT_UINT64, &gpgpu_timing_insn_budget, 
+               "Kernels launched after this many instructions were simulated in timing mode run functionally (0 = no limit)",
+               "0");
+   option_parser_register(opp, "-gpgpu_cta_sample_period", OPT_UINT32, &gpgpu_cta_sample_period, 
+               "CTA sampling: of every <period> CTAs only the first -gpgpu_cta_sample_size are simulated in detail (0 = off)",
+               "0");
+   option_parser_register(opp, "-gpgpu_cta_sample_size", OPT_UINT32, &gpgpu_cta_sample_size, 
+               "CTA sampling: number of CTAs simulated in detail per sampling period",
+               "1");
+   option_parser_register(opp, "-gpgpu_cta_sample_warmup", OPT_UINT32, &gpgpu_cta_sample_warmup, 
+               "CTA sampling: number of CTAs at the start of each kernel that are always simulated in detail",
+               "0");
+   option_parser_register(opp, "-gpgpu_cta_sample_functional", OPT_BOOL, &gpgpu_cta_sample_functional, 
+               "CTA sampling: execute the CTAs that are not sampled functionally (0 = drop them, device memory results are incomplete)",
+               "1");
+   option_parser_register(opp, "-gpgpu_kernel_workers", OPT_UINT32, &gpgpu_kernel_workers, 
+               "Run kernels functionally and timing-simulate each selected kernel in one of up to this many forked worker processes (0 = off)",
+               "0");
+   option_parser_register(opp, "-gpgpu_kernel_worker_prefix", OPT_CSTR, &gpgpu_kernel_worker_prefix, 
+               "Prefix of the per-kernel worker logs and of the merged report",
+               "gpgpusim_worker");
+   option_parser_register(opp, "-gpgpu_record_workload", OPT_CSTR, &gpgpu_record_workload, 
+               "Record PTX modules, device memory writes and kernel launches to this file for batch simulation (see workload_log.h)",
+               NULL);
    option_parser_register(opp, "-gpgpu_runtime_stat", OPT_CSTR, &gpgpu_runtime_stat, 
                   "display runtime statistics such as dram utilization {<freq>:<flag>}",
                   "10000:0");
@@ -423,6 +463,33 @@ void gpgpu_sim_config::reg_options(option_parser_t opp)
    option_parser_register(opp, "-visualizer_zlevel", OPT_INT32,
                           &g_visualizer_zlevel, "Compression level of the visualizer output log (0=no comp, 9=highest)",
                           "6");
+   option_parser_register(opp, "-visualizer_binary_outputfile", OPT_CSTR,
+                          &g_visualizer_binary_filename, "Write the visualizer log in the binary columnar format to this file instead of the text log (convert with vislog2txt)",
+                          NULL);
+   option_parser_register(opp, "-visualizer_binary_chunk", OPT_INT32,
+                          &g_visualizer_binary_chunk, "Number of visualizer samples per compressed chunk of the binary log",
+                          "64");
+   option_parser_register(opp, "-warp_trace_record_file", OPT_CSTR,
+                          &warp_trace_record_filename, "Record the dynamic instructions, active masks and memory addresses of every warp to this file",
+                          NULL);
+   option_parser_register(opp, "-warp_trace_replay_file", OPT_CSTR,
+                          &warp_trace_replay_filename, "Drive the timing model from a trace written with -warp_trace_record_file instead of functional simulation",
+                          NULL);
+   option_parser_register(opp, "-warp_trace_zlevel", OPT_INT32,
+                          &warp_trace_zlevel, "Compression level of the warp trace (0=no comp, 9=highest)",
+                          "6");
+   option_parser_register(opp, "-checkpoint_file", OPT_CSTR,
+                          &checkpoint_filename, "Write a checkpoint of the simulated device to this file at the launch of -checkpoint_kernel",
+                          NULL);
+   option_parser_register(opp, "-checkpoint_kernel", OPT_UINT32,
+                          &checkpoint_kernel, "Kernel launch (counted from 1 on each device) before which the checkpoint is written",
+                          "0");
+   option_parser_register(opp, "-checkpoint_warm_state", OPT_BOOL,
+                          &checkpoint_warm_state, "Also checkpoint the L2 tags and the open DRAM rows",
+                          "0");
+   option_parser_register(opp, "-checkpoint_restore_file", OPT_CSTR,
+                          &checkpoint_restore_filename, "Skip the kernels before the checkpoint in this file and resume timing simulation from it",
+                          NULL);
     option_parser_register(opp, "-trace_enabled", OPT_BOOL, 
                           &Trace::enabled, "Turn on traces",
                           "0");
@@ -437,6 +504,10 @@ void gpgpu_sim_config::reg_options(option_parser_t opp)
     option_parser_register(opp, "-trace_sampling_memory_partition", OPT_INT32, 
                           &Trace::sampling_memory_partition, "The memory partition which is printed using MEMPART_DPRINTF. Default -1 (i.e. all)",
                           "-1");
+    option_parser_register(opp, "-trace_binary_file", OPT_CSTR, 
+                          &Trace::binary_file, "Write traces as binary records to this file instead of printing them "
+                          "(render with trace_decode). Default none",
+                          NULL);
    ptx_file_line_stats_options(opp);
 }
 
@@ -456,8 +527,16 @@ void increment_x_then_y_then_z( dim3 &i, const dim3 &bound)
    }
 }
 
+void gpgpu_sim::assign_launch_index( kernel_info_t *kinfo )
+{
+   // several host threads may launch on the same device
+   if (kinfo->get_launch_index() == 0) 
+      kinfo->set_launch_index(__sync_add_and_fetch(&m_launch_count,1));
+}
+
 void gpgpu_sim::launch( kernel_info_t *kinfo )
 {
+   assign_launch_index(kinfo);
    unsigned cta_size = kinfo->threads_per_cta();
    if ( cta_size > m_shader_config->n_thread_per_shader ) {
       printf("Execution error: Shader kernel CTA (block) size is too large for microarch config.\n");
@@ -475,6 +554,68 @@ void gpgpu_sim::launch( kernel_info_t *kinfo )
        }
    }
    assert(n < m_running_kernels.size());
+
+   if (m_warp_trace_writer) 
+      m_warp_trace_writer->add_kernel(kinfo->get_launch_index(),kinfo->name(),kinfo->get_grid_dim(),kinfo->get_cta_dim());
+   if (m_warp_trace_reader && !m_warp_trace_reader->check_kernel(kinfo->get_launch_index(),kinfo->name(),kinfo->get_grid_dim(),kinfo->get_cta_dim())) {
+      printf("GPGPU-Sim uArch: ERROR ** cannot replay kernel launch %u '%s' from warp trace '%s': %s\n",
+             kinfo->get_launch_index(), kinfo->name().c_str(), m_config.warp_trace_replay_filename, m_warp_trace_reader->error());
+      abort();
+   }
+}
+
+void gpgpu_sim::init_kernel_mode_selection()
+{
+   m_timing_kernel_ranges.clear();
+   if (m_config.gpgpu_timing_kernels && *m_config.gpgpu_timing_kernels) {
+      const char *p = m_config.gpgpu_timing_kernels;
+      while (*p) {
+         char *end;
+         unsigned first = strtoul(p,&end,10);
+         unsigned last = first;
+         bool valid = end != p;
+         p = end;
+         if (valid && *p == '-') {
+            p++;
+            last = strtoul(p,&end,10);
+            if (end == p) 
+               last = (unsigned)-1; // open range
+            p = end;
+         }
+         if (!valid || (*p && *p != ',') || last < first) {
+            printf("GPGPU-Sim uArch: ERROR ** invalid -gpgpu_timing_kernels '%s'\n", m_config.gpgpu_timing_kernels);
+            abort();
+         }
+         m_timing_kernel_ranges.push_back(std::make_pair(first,last));
+         if (*p == ',') 
+            p++;
+      }
+   }
+   m_timing_kernel_regex_set = m_config.gpgpu_timing_kernel_regex && *m_config.gpgpu_timing_kernel_regex;
+   if (m_timing_kernel_regex_set && 
+       regcomp(&m_timing_kernel_regex,m_config.gpgpu_timing_kernel_regex,REG_EXTENDED|REG_NOSUB) != 0) {
+      printf("GPGPU-Sim uArch: ERROR ** invalid -gpgpu_timing_kernel_regex '%s'\n", m_config.gpgpu_timing_kernel_regex);
+      abort();
+   }
+}
+
+bool gpgpu_sim::timing_simulate_kernel( const kernel_info_t *kinfo )
+{
+   // all criteria that are set must hold
+   if (!m_timing_kernel_ranges.empty()) {
+      unsigned launch = kinfo->get_launch_index();
+      assert(launch != 0);
+      bool in_range = false;
+      for (unsigned i=0; i < m_timing_kernel_ranges.size() && !in_range; i++) 
+         in_range = launch >= m_timing_kernel_ranges[i].first && launch <= m_timing_kernel_ranges[i].second;
+      if (!in_range) 
+         return false;
+   }
+   if (m_timing_kernel_regex_set && regexec(&m_timing_kernel_regex,kinfo->name().c_str(),0,NULL,0) != 0) 
+      return false;
+   if (m_config.gpgpu_timing_insn_budget && gpu_tot_sim_insn + gpu_sim_insn >= m_config.gpgpu_timing_insn_budget) 
+      return false;
+   return true;
 }
 
 bool gpgpu_sim::can_start_kernel()
@@ -549,10 +690,21 @@ gpgpu_sim::gpgpu_sim( const gpgpu_sim_config &config )
     m_shader_config = &m_config.m_shader_config;
     m_memory_config = &m_config.m_memory_config;
     set_ptx_warp_size(m_shader_config);
+
+    // the cycle and instruction counters are per thread, and a batch worker
+    // builds one simulator after another; a simulator is built on the
+    // thread that runs it
+    gpu_sim_cycle = 0;
+    gpu_tot_sim_cycle = 0;
+    m_sim_cycle = &gpu_sim_cycle;
+    m_tot_sim_cycle = &gpu_tot_sim_cycle;
+    gpu_stall_dramfull = 0;
+    gpu_stall_icnt2sh = 0;
+    ptx_sim_thread_counters_reset();
     ptx_file_line_stats_create_exposed_latency_tracker(m_config.num_shader());
 
 #ifdef GPGPUSIM_POWER_MODEL
-        m_gpgpusim_wrapper = new gpgpu_sim_wrapper(config.g_power_simulation_enabled,config.g_power_config_name);
+        m_gpgpusim_wrapper = new gpgpu_sim_wrapper(config.g_power_simulation_enabled,config.g_power_config_name,config.g_power_cacti_cache_dir);
 #endif
 
     m_shader_stats = new shader_core_stats(m_shader_config);
@@ -564,8 +716,58 @@ gpgpu_sim::gpgpu_sim( const gpgpu_sim_config &config )
     gpu_sim_insn = 0;
     gpu_tot_sim_insn = 0;
     gpu_tot_issued_cta = 0;
+    m_launch_count = 0;
     gpu_deadlock = false;
 
+    m_visualizer = NULL;
+    m_warp_trace_writer = NULL;
+    m_warp_trace_reader = NULL;
+    if (m_config.warp_trace_record_filename && m_config.warp_trace_replay_filename) {
+       printf("GPGPU-Sim uArch: ERROR ** -warp_trace_record_file and -warp_trace_replay_file cannot be used together\n");
+       abort();
+    }
+    // every simulated device records (and replays) its own trace
+    if (m_config.warp_trace_record_filename) {
+       std::string filename = gpgpu_ptx_sim_output_filename(m_config.warp_trace_record_filename);
+       m_warp_trace_writer = new warp_trace_writer();
+       if (!m_warp_trace_writer->open(filename.c_str(),m_config.warp_trace_zlevel)) {
+          printf("GPGPU-Sim uArch: ERROR ** cannot create warp trace '%s'\n", filename.c_str());
+          abort();
+       }
+    }
+    if (m_config.warp_trace_replay_filename) {
+       std::string filename = gpgpu_ptx_sim_output_filename(m_config.warp_trace_replay_filename);
+       m_warp_trace_reader = new warp_trace_reader();
+       if (!m_warp_trace_reader->open(filename.c_str())) {
+          printf("GPGPU-Sim uArch: ERROR ** cannot read warp trace '%s': %s\n", filename.c_str(),
+                 m_warp_trace_reader->error());
+          abort();
+       }
+       printf("GPGPU-Sim uArch: replaying warp trace '%s' (no functional simulation)\n", filename.c_str());
+    }
+
+    init_kernel_mode_selection();
+    m_kernel_workers = NULL;
+    if (m_config.gpgpu_kernel_workers) {
+       // a forked worker has only the simulation thread, so nothing it
+       // simulates may depend on a helper thread of the parent
+       if (m_warp_trace_writer) {
+          printf("GPGPU-Sim uArch: ERROR ** -gpgpu_kernel_workers cannot be used with -warp_trace_record_file\n");
+          abort();
+       }
+       if (Trace::binary_output) {
+          printf("GPGPU-Sim uArch: ERROR ** -gpgpu_kernel_workers cannot be used with -trace_binary_file\n");
+          abort();
+       }
+       if (m_config.g_power_simulation_enabled && (m_config.g_power_trace_enabled || m_config.g_steady_power_levels_enabled)) {
+          printf("GPGPU-Sim uArch: ERROR ** -gpgpu_kernel_workers cannot be used with -power_trace_enabled or -steady_power_levels_enabled\n");
+          abort();
+       }
+       m_kernel_workers = new kernel_worker_pool(m_config.gpgpu_kernel_workers,m_config.gpgpu_kernel_worker_prefix);
+    }
+    if (m_config.gpgpu_record_workload && !g_workload_recorder) 
+       g_workload_recorder = new workload_recorder(m_config.gpgpu_record_workload,this);
+    init_checkpoint();
 
     m_cluster = new simt_core_cluster*[m_shader_config->n_simt_clusters];
     for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
@@ -583,6 +785,10 @@ gpgpu_sim::gpgpu_sim( const gpgpu_sim_config &config )
 
     icnt_wrapper_init();
     icnt_create(m_shader_config->n_simt_clusters,m_memory_config->m_n_mem_sub_partition);
+    if (m_kernel_workers && icnt_has_worker_threads()) {
+       printf("GPGPU-Sim uArch: ERROR ** -gpgpu_kernel_workers cannot be used with parallel_subnets in the interconnect configuration\n");
+       abort();
+    }
 
     time_vector_create(NUM_MEM_REQ_STAT);
     fprintf(stdout, "GPGPU-Sim uArch: performance model initialization complete.\n");
@@ -596,6 +802,28 @@ gpgpu_sim::gpgpu_sim( const gpgpu_sim_config &config )
     last_liveness_message_time = 0;
 }
 
+gpgpu_sim::~gpgpu_sim()
+{
+    close_output_files();
+    delete m_visualizer;
+    delete m_warp_trace_writer;
+    delete m_warp_trace_reader;
+    if (m_timing_kernel_regex_set) 
+        regfree(&m_timing_kernel_regex);
+}
+
+void gpgpu_sim::close_output_files()
+{
+    if (m_visualizer) 
+        m_visualizer->close();
+    if (m_warp_trace_writer) 
+        m_warp_trace_writer->close();
+#ifdef GPGPUSIM_POWER_MODEL
+    if (m_config.g_power_simulation_enabled) 
+        m_gpgpusim_wrapper->close_files();
+#endif
+}
+
 int gpgpu_sim::shared_mem_size() const
 {
    return m_shader_config->gpgpu_shmem_size;
@@ -685,6 +913,8 @@ void gpgpu_sim::init()
     gpu_sim_insn = 0;
     last_gpu_sim_insn = 0;
     m_total_cta_launched=0;
+    memset(&m_cta_sample,0,sizeof(m_cta_sample));
+    get_memory_totals(m_cta_sample.l2_accesses,m_cta_sample.l2_misses,m_cta_sample.dram_reads,m_cta_sample.dram_writes);
 
     reinit_clock_domains();
     set_param_gpgpu_num_shaders(m_config.num_shader());
@@ -893,6 +1123,9 @@ void gpgpu_sim::gpu_print_stat()
    printf("gpu_tot_sim_insn = %lld\n", gpu_tot_sim_insn+gpu_sim_insn);
    printf("gpu_tot_ipc = %12.4f\n", (float)(gpu_tot_sim_insn+gpu_sim_insn) / (gpu_tot_sim_cycle+gpu_sim_cycle));
    printf("gpu_tot_issued_cta = %lld\n", gpu_tot_issued_cta);
+   m_dev_heap->print_stats(stdout);
+   if (m_config.gpgpu_cta_sample_period > 1) 
+      print_cta_sample_stats(stdout);
 
 
 
@@ -1081,6 +1314,7 @@ void shader_core_ctx::issue_block2core( kernel_info_t &kernel )
     // bind functional simulation state of threads to hardware resources (simulation) 
     warp_set_t warps;
     unsigned nthreads_in_block= 0;
+    dim3 ctaid = kernel.get_next_cta_id();
     for (unsigned i = start_thread; i<end_thread; i++) {
         m_threadState[i].m_cta_id = free_cta_hw_id;
         unsigned warp_id = i/m_config->warp_size;
@@ -1090,6 +1324,8 @@ void shader_core_ctx::issue_block2core( kernel_info_t &kernel )
     }
     assert( nthreads_in_block > 0 && nthreads_in_block <= m_config->n_thread_per_shader); // should be at least one, but less than max
     m_cta_status[free_cta_hw_id]=nthreads_in_block;
+    m_cta_issue_cycle[free_cta_hw_id]=gpu_tot_sim_cycle + gpu_sim_cycle;
+    m_cta_n_insn[free_cta_hw_id]=0;
 
     // now that we know which warps are used in this CTA, we can allocate
     // resources for use in CTA-wide barrier operations
@@ -1097,6 +1333,10 @@ void shader_core_ctx::issue_block2core( kernel_info_t &kernel )
 
     // initialize the SIMT stacks and fetch hardware
     init_warps( free_cta_hw_id, start_thread, end_thread);
+    if (m_trace_writer || m_trace_reader) {
+        dim3 grid = kernel.get_grid_dim();
+        warp_trace_begin_cta(kernel, ctaid.x + grid.x * (ctaid.y + grid.y * ctaid.z), start_thread, end_thread);
+    }
     m_n_active_cta++;
 
     shader_CTA_count_log(m_sid, 1);
@@ -1139,8 +1379,160 @@ int gpgpu_sim::next_clock_domain(void)
    return mask;
 }
 
+bool gpgpu_sim::cta_sampled( const kernel_info_t &kernel ) const
+{
+    if (m_config.gpgpu_cta_sample_period <= 1) 
+        return true;
+    dim3 cta = kernel.get_next_cta_id();
+    dim3 grid = kernel.get_grid_dim();
+    unsigned idx = cta.x + grid.x * (cta.y + grid.y * cta.z);
+    if (idx < m_config.gpgpu_cta_sample_warmup) 
+        return true;
+    return (idx - m_config.gpgpu_cta_sample_warmup) % m_config.gpgpu_cta_sample_period < m_config.gpgpu_cta_sample_size;
+}
+
+// CTAs between the samples are executed functionally (or dropped) before the
+// cores get to them, so the clusters only ever issue sampled CTAs
+void gpgpu_sim::skip_unsampled_ctas()
+{
+    for (unsigned n=0; n < m_running_kernels.size(); n++) {
+        kernel_info_t *kernel = m_running_kernels[n];
+        if (!kernel || kernel->no_more_ctas_to_run()) 
+            continue;
+        unsigned resident = m_shader_config->max_cta(*kernel) * m_shader_config->num_shader();
+        if (resident > m_cta_sample.resident_ctas) 
+            m_cta_sample.resident_ctas = resident;
+        while (!kernel->no_more_ctas_to_run() && !cta_sampled(*kernel)) {
+            if (m_config.gpgpu_cta_sample_functional) {
+                functionalCoreSim cta(kernel,this,m_shader_config->warp_size);
+                cta.execute();
+            } else {
+                kernel->increment_cta_id();
+            }
+            m_cta_sample.n_skipped++;
+        }
+        if (kernel->done()) {
+            printf("GPGPU-Sim uArch: GPU detected kernel \'%s\' finished (remaining CTAs not sampled).\n", kernel->name().c_str());
+            set_kernel_done(kernel);
+        }
+    }
+}
+
+void gpgpu_sim::record_cta_sample( unsigned long long cycles, unsigned long long insn )
+{
+    m_cta_sample.n_detailed++;
+    m_cta_sample.sum_cycles += cycles;
+    m_cta_sample.sumsq_cycles += (double)cycles * cycles;
+    m_cta_sample.sum_insn += insn;
+    m_cta_sample.sumsq_insn += (double)insn * insn;
+    m_cta_sample.sum_cycles_insn += (double)cycles * insn;
+}
+
+void gpgpu_sim::get_memory_totals( unsigned long long &l2_accesses, unsigned long long &l2_misses,
+                                   unsigned long long &dram_reads, unsigned long long &dram_writes ) const
+{
+    l2_accesses = l2_misses = dram_reads = dram_writes = 0;
+    for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) {
+        struct cache_sub_stats css;
+        css.clear();
+        m_memory_sub_partition[i]->get_L2cache_sub_stats(css);
+        l2_accesses += css.accesses;
+        l2_misses += css.misses;
+    }
+    for (unsigned i=0;i<m_memory_config->m_n_mem;i++) {
+        unsigned cmd, activity, nop, act, pre, rd, wr, req;
+        m_memory_partition_unit[i]->set_dram_power_stats(cmd,activity,nop,act,pre,rd,wr,req);
+        dram_reads += rd;
+        dram_writes += wr;
+    }
+}
+
+// sample variance of a per-CTA quantity, or of the covariance of two when
+// given their sum of products
+static double cta_sample_var( unsigned long long n, double sum_a, double sum_b, double sum_ab )
+{
+    if (n < 2) 
+        return 0;
+    return (sum_ab - sum_a * sum_b / n) / (n - 1);
+}
+
+// The simulated CTAs are measured; only the skipped ones are estimated.
+//
+// Instructions: every skipped CTA is taken to execute the mean instruction
+// count of the sampled ones, whose standard error gives the interval.
+//
+// Cycles: CTAs run in waves of resident_ctas, and a kernel takes about as
+// long per wave whether the wave is full or not, so cycles extrapolate with
+// the number of waves rather than the number of CTAs.  A grid that fits in
+// one wave needs no extrapolation.  Each extra wave lasts about one CTA
+// lifetime, so its duration carries the relative error of the mean CTA
+// latency.
+//
+// IPC: ratio of the two estimates, with its interval from the first order
+// (delta method) variance including the covariance of the per-CTA means.
+void gpgpu_sim::print_cta_sample_stats( FILE *fout ) const
+{
+    const cta_sample_stats &cs = m_cta_sample;
+    unsigned long long n = cs.n_detailed;
+    unsigned long long n_total = n + cs.n_skipped;
+    if (!n) 
+        return;
+    const double z95 = 1.96;
+    double scale = (double)n_total / n;
+    double mean_cycles = cs.sum_cycles / n;
+    double mean_insn = cs.sum_insn / n;
+    // variances of the two per-CTA means and their covariance
+    double var_cycles = cta_sample_var(n,cs.sum_cycles,cs.sum_cycles,cs.sumsq_cycles) / n;
+    double var_insn = cta_sample_var(n,cs.sum_insn,cs.sum_insn,cs.sumsq_insn) / n;
+    double cov = cta_sample_var(n,cs.sum_cycles,cs.sum_insn,cs.sum_cycles_insn) / n;
+    if (var_cycles < 0) var_cycles = 0;
+    if (var_insn < 0) var_insn = 0;
+
+    double est_insn = gpu_sim_insn + cs.n_skipped * mean_insn;
+    double var_est_insn = (double)cs.n_skipped * cs.n_skipped * var_insn;
+
+    unsigned resident = cs.resident_ctas ? cs.resident_ctas : 1;
+    unsigned long long waves_detailed = (n + resident - 1) / resident;
+    unsigned long long waves_total = (n_total + resident - 1) / resident;
+    double cycles_per_wave = (double)gpu_sim_cycle / waves_detailed;
+    double extra_cycles = (waves_total - waves_detailed) * cycles_per_wave;
+    double est_cycles = gpu_sim_cycle + extra_cycles;
+    // extra_cycles scales with the mean CTA latency
+    double d_cycles = (mean_cycles > 0) ? extra_cycles / mean_cycles : 0;
+    double var_est_cycles = d_cycles * d_cycles * var_cycles;
+
+    unsigned long long l2_accesses, l2_misses, dram_reads, dram_writes;
+    get_memory_totals(l2_accesses,l2_misses,dram_reads,dram_writes);
+
+    fprintf(fout, "cta_sample_detailed = %llu\n", n);
+    fprintf(fout, "cta_sample_skipped = %llu\n", cs.n_skipped);
+    fprintf(fout, "cta_sample_scale = %.4f\n", scale);
+    fprintf(fout, "cta_sample_resident_ctas = %u\n", resident);
+    fprintf(fout, "cta_sample_waves = %llu (%llu simulated)\n", waves_total, waves_detailed);
+    fprintf(fout, "cta_sample_mean_cta_cycles = %.1f (+/- %.1f)\n", mean_cycles, z95 * sqrt(var_cycles));
+    fprintf(fout, "cta_sample_mean_cta_insn = %.1f (+/- %.1f)\n", mean_insn, z95 * sqrt(var_insn));
+    fprintf(fout, "gpu_sim_cycle_estimate = %.0f (+/- %.0f)\n", est_cycles, z95 * sqrt(var_est_cycles));
+    fprintf(fout, "gpu_sim_insn_estimate = %.0f (+/- %.0f)\n", est_insn, z95 * sqrt(var_est_insn));
+    if (est_cycles > 0 && est_insn > 0) {
+        double ipc = est_insn / est_cycles;
+        double cov_est = cs.n_skipped * d_cycles * cov;
+        double rel_var = var_est_insn / (est_insn * est_insn) + var_est_cycles / (est_cycles * est_cycles)
+                       - 2 * cov_est / (est_insn * est_cycles);
+        if (rel_var < 0) 
+            rel_var = 0;
+        fprintf(fout, "gpu_ipc_estimate = %12.4f (+/- %.4f)\n", ipc, z95 * ipc * sqrt(rel_var));
+    }
+    // memory traffic is work done per CTA, so it scales with the CTA count
+    fprintf(fout, "L2_total_cache_accesses_estimate = %.0f\n", (l2_accesses - cs.l2_accesses) * scale);
+    fprintf(fout, "L2_total_cache_misses_estimate = %.0f\n", (l2_misses - cs.l2_misses) * scale);
+    fprintf(fout, "dram_reads_estimate = %.0f\n", (dram_reads - cs.dram_reads) * scale);
+    fprintf(fout, "dram_writes_estimate = %.0f\n", (dram_writes - cs.dram_writes) * scale);
+}
+
 void gpgpu_sim::issue_block2core()
 {
+    if (m_config.gpgpu_cta_sample_period > 1) 
+        skip_unsampled_ctas();
     unsigned last_issued = m_last_cluster_issue; 
     for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
         unsigned idx = (i + last_issued + 1) % m_shader_config->n_simt_clusters;
@@ -36,7 +36,9 @@
 #include <iostream>
 #include <fstream>
 #include <list>
+#include <vector>
 #include <stdio.h>
+#include <regex.h>
 
 
 
@@ -117,6 +119,7 @@ struct power_config {
 	void reg_options(class OptionParser * opp);
 
 	char *g_power_config_name;
+	char *g_power_cacti_cache_dir;
 
 	bool m_valid;
     bool g_power_simulation_enabled;
@@ -273,8 +276,8 @@ struct memory_config {
 };
 
 // global counters and flags (please try not to add to this list!!!)
-extern unsigned long long  gpu_sim_cycle;
-extern unsigned long long  gpu_tot_sim_cycle;
+extern __thread unsigned long long  gpu_sim_cycle;
+extern __thread unsigned long long  gpu_tot_sim_cycle;
 extern bool g_interactive_debugger_enabled;
 
 class gpgpu_sim_config : public power_config, public gpgpu_functional_sim_config {
@@ -314,6 +317,7 @@ public:
     unsigned num_shader() const { return m_shader_config.num_shader(); }
     unsigned num_cluster() const { return m_shader_config.n_simt_clusters; }
     unsigned get_max_concurrent_kernel() const { return max_concurrent_kernel; }
+    unsigned get_kernel_workers() const { return gpgpu_kernel_workers; }
 
 private:
     void init_clock_domains(void ); 
@@ -336,6 +340,21 @@ private:
     unsigned gpu_max_cycle_opt;
     unsigned gpu_max_insn_opt;
     unsigned gpu_max_cta_opt;
+    // per-kernel choice of timing or functional (fast-forward) simulation
+    char *gpgpu_timing_kernels;
+    char *gpgpu_timing_kernel_regex;
+    unsigned long long gpgpu_timing_insn_budget;
+    // statistical CTA sampling
+    unsigned gpgpu_cta_sample_period;
+    unsigned gpgpu_cta_sample_size;
+    unsigned gpgpu_cta_sample_warmup;
+    bool  gpgpu_cta_sample_functional;
+
+    // kernel-parallel timing simulation (kernel_workers.h)
+    unsigned gpgpu_kernel_workers;
+    char *gpgpu_kernel_worker_prefix;
+    // workload recording for gpgpusim_batch (workload_log.h)
+    char *gpgpu_record_workload;
     char *gpgpu_runtime_stat;
     bool  gpgpu_flush_l1_cache;
     bool  gpgpu_flush_l2_cache;
@@ -349,6 +368,19 @@ private:
     bool  g_visualizer_enabled;
     char *g_visualizer_filename;
     int   g_visualizer_zlevel;
+    char *g_visualizer_binary_filename;
+    int   g_visualizer_binary_chunk;
+
+    // trace-driven simulation (warp_trace.h)
+    char *warp_trace_record_filename;
+    char *warp_trace_replay_filename;
+    int   warp_trace_zlevel;
+
+    // checkpoint and restore at a kernel launch (checkpoint.h)
+    char *checkpoint_filename;
+    unsigned checkpoint_kernel;
+    bool  checkpoint_warm_state;
+    char *checkpoint_restore_filename;
 
 
     // statistics collection
@@ -365,10 +397,14 @@ private:
 class gpgpu_sim : public gpgpu_t {
 public:
    gpgpu_sim( const gpgpu_sim_config &config );
+   ~gpgpu_sim();
 
    void set_prop( struct cudaDeviceProp *prop );
 
    void launch( kernel_info_t *kinfo );
+   // numbers a launch made on this device in the order the host issues it
+   // (see kernel_info_t::get_launch_index); keeps an index already assigned
+   void assign_launch_index( kernel_info_t *kinfo );
    bool can_start_kernel();
    unsigned finished_kernel();
    void set_kernel_done( kernel_info_t *kernel );
@@ -419,6 +455,38 @@ public:
     */
     simt_core_cluster * getSIMTCluster();
 
+   // per-warp instruction traces; NULL unless recording or replaying
+   class warp_trace_writer *get_warp_trace_writer() { return m_warp_trace_writer; }
+   class warp_trace_reader *get_warp_trace_reader() { return m_warp_trace_reader; }
+
+   // called when a kernel reaches the hardware scheduler; saves or restores
+   // a checkpoint as configured and returns false if the kernel precedes the
+   // restored checkpoint and must be retired without simulating it
+   bool checkpoint_kernel_launch( kernel_info_t *kinfo );
+
+   // true if the kernel is selected for timing simulation by
+   // -gpgpu_timing_kernels, -gpgpu_timing_kernel_regex and
+   // -gpgpu_timing_insn_budget; the others are run functionally, which
+   // updates device memory but leaves cycle counts, caches and DRAM untouched
+   bool timing_simulate_kernel( const kernel_info_t *kinfo );
+
+   // cycles from issue to completion and thread instructions of a CTA
+   // simulated in detail, for the extrapolation done by CTA sampling
+   void record_cta_sample( unsigned long long cycles, unsigned long long insn );
+
+   // NULL unless -gpgpu_kernel_workers is set
+   class kernel_worker_pool *get_kernel_workers() { return m_kernel_workers; }
+   // called in a forked kernel worker: the writer threads of the output files
+   // opened by the parent do not exist there, so the worker abandons those
+   // files and opens its own on the next sample
+   void detach_output_files();
+   // drain and close the visualizer and power trace files; called when the
+   // simulation thread exits, a sample taken afterwards appends to them
+   void close_output_files();
+
+   // L2 accesses and misses and DRAM reads and writes since the simulator was built
+   void get_memory_totals( unsigned long long &l2_accesses, unsigned long long &l2_misses,
+                           unsigned long long &dram_reads, unsigned long long &dram_writes ) const;
 
 private:
    // clocks
@@ -435,6 +503,16 @@ private:
 
    void gpgpu_debug();
 
+   void init_kernel_mode_selection();
+   bool cta_sampled( const kernel_info_t &kernel ) const;
+   void skip_unsampled_ctas();
+   void print_cta_sample_stats( FILE *fout ) const;
+
+   // checkpoint.cc
+   void init_checkpoint();
+   void save_checkpoint( const char *filename, const kernel_info_t *kinfo );
+   void restore_checkpoint( const char *filename, const kernel_info_t *kinfo );
+
 ///// data /////
 
    class simt_core_cluster **m_cluster;
@@ -443,6 +521,7 @@ private:
 
    std::vector<kernel_info_t*> m_running_kernels;
    unsigned m_last_issued_kernel;
+   unsigned m_launch_count; // launches numbered by assign_launch_index()
 
    std::list<unsigned> m_finished_kernel;
    unsigned m_total_cta_launched;
@@ -470,6 +549,27 @@ private:
    class memory_stats_t     *m_memory_stats;
    class power_stat_t *m_power_stats;
    class gpgpu_sim_wrapper *m_gpgpusim_wrapper;
+   class visualizer_log *m_visualizer;                  // opened at the first visualizer sample
+   class warp_trace_writer *m_warp_trace_writer;
+   class warp_trace_reader *m_warp_trace_reader;
+   class kernel_worker_pool *m_kernel_workers;
+   unsigned m_checkpoint_restore_launch; // 0 once the checkpoint has been restored
+   std::string m_checkpoint_filename;         // per device, see gpgpu_ptx_sim_output_filename
+   std::string m_checkpoint_restore_filename;
+   std::vector<std::pair<unsigned,unsigned> > m_timing_kernel_ranges; // launch indices, inclusive
+   bool m_timing_kernel_regex_set;
+   regex_t m_timing_kernel_regex;
+
+   // CTA sampling, reset at every init()
+   struct cta_sample_stats {
+      unsigned long long n_detailed;
+      unsigned long long n_skipped;
+      double sum_cycles, sumsq_cycles;
+      double sum_insn, sumsq_insn;
+      double sum_cycles_insn; // for the covariance of per-CTA cycles and instructions
+      unsigned resident_ctas; // CTAs the GPU holds at once (one wave), largest over the sampled kernels
+      unsigned long long l2_accesses, l2_misses, dram_reads, dram_writes; // totals at init()
+   } m_cta_sample;
    unsigned long long  gpu_tot_issued_cta;
    unsigned long long  last_gpu_sim_insn;
 
@@ -482,7 +582,16 @@ private:
    std::string executed_kernel_info_string(); //< format the kernel information into a string for stat printout
    void clear_executed_kernel_info(); //< clear the kernel information after stat printout
 
+   // the cycle counters of the thread that simulates this GPU
+   const volatile unsigned long long *m_sim_cycle;
+   const volatile unsigned long long *m_tot_sim_cycle;
+
 public:
+   // gpu_sim_cycle and gpu_tot_sim_cycle are per thread; these read the
+   // counters of this GPU from any thread, e.g. the CUDA API host thread
+   unsigned long long sim_cycle() const { return *m_sim_cycle; }
+   unsigned long long tot_sim_cycle() const { return *m_tot_sim_cycle; }
+
    unsigned long long  gpu_sim_insn;
    unsigned long long  gpu_tot_sim_insn;
    unsigned long long  gpu_sim_insn_last_update;
@@ -27,96 +27,225 @@
 
 #include "icnt_wrapper.h"
 #include <assert.h>
+#include <pthread.h>
+#include <string.h>
+#include <stdlib.h>
 #include "../intersim2/globals.hpp"
 #include "../intersim2/interconnect_interface.hpp"
+#include "local_interconnect.h"
 
-icnt_create_p                icnt_create;
-icnt_init_p                  icnt_init;
-icnt_has_buffer_p            icnt_has_buffer;
-icnt_push_p                  icnt_push;
-icnt_pop_p                   icnt_pop;
-icnt_transfer_p              icnt_transfer;
-icnt_busy_p                  icnt_busy;
-icnt_display_stats_p         icnt_display_stats;
-icnt_display_overall_stats_p icnt_display_overall_stats;
-icnt_display_state_p         icnt_display_state;
-icnt_get_flit_size_p         icnt_get_flit_size;
-
-int   g_network_mode;
-char* g_network_config_filename;
+// each simulated device selects and owns its interconnect on its own
+// simulation thread
+__thread icnt_create_p                icnt_create;
+__thread icnt_init_p                  icnt_init;
+__thread icnt_has_buffer_p            icnt_has_buffer;
+__thread icnt_push_p                  icnt_push;
+__thread icnt_pop_p                   icnt_pop;
+__thread icnt_transfer_p              icnt_transfer;
+__thread icnt_busy_p                  icnt_busy;
+__thread icnt_display_stats_p         icnt_display_stats;
+__thread icnt_display_overall_stats_p icnt_display_overall_stats;
+__thread icnt_display_state_p         icnt_display_state;
+__thread icnt_get_flit_size_p         icnt_get_flit_size;
+
+__thread int   g_network_mode;
+__thread char* g_network_config_filename;
 
 #include "../option_parser.h"
 
 // Wrapper to intersim2 to accompany old icnt_wrapper
 // TODO: use delegate/boost/c++11<funtion> instead
 
+// intersim2 keeps its topology parameters and flit/credit pools in
+// process-wide globals.  When several simulated devices share the process,
+// each keeps its own InterconnectInterface and the intersim2 calls of all
+// devices are serialized, switching g_icnt_interface to the caller's.
+static bool g_icnt_shared = false;
+static pthread_mutex_t g_intersim2_lock = PTHREAD_MUTEX_INITIALIZER;
+static const char *g_intersim2_config = NULL;
+static __thread InterconnectInterface *t_icnt_interface = NULL;
+
+class intersim2_guard {
+public:
+   intersim2_guard()
+   {
+      if (g_icnt_shared) {
+         pthread_mutex_lock(&g_intersim2_lock);
+         g_icnt_interface = t_icnt_interface;
+      }
+   }
+   ~intersim2_guard()
+   {
+      if (g_icnt_shared)
+         pthread_mutex_unlock(&g_intersim2_lock);
+   }
+};
+
+void icnt_set_shared( bool shared )
+{
+   g_icnt_shared = shared;
+}
+
+bool icnt_has_worker_threads()
+{
+   if (g_network_mode != INTERSIM)
+      return false;
+   intersim2_guard g;
+   return g_icnt_interface->UsesWorkerThreads();
+}
+
 static void intersim2_create(unsigned int n_shader, unsigned int n_mem)
 {
+   intersim2_guard g;
    g_icnt_interface->CreateInterconnect(n_shader, n_mem);
 }
 
 static void intersim2_init()
 {
+   intersim2_guard g;
    g_icnt_interface->Init();
 }
 
 static bool intersim2_has_buffer(unsigned input, unsigned int size)
 {
+   intersim2_guard g;
    return g_icnt_interface->HasBuffer(input, size);
 }
 
 static void intersim2_push(unsigned input, unsigned output, void* data, unsigned int size)
 {
+   intersim2_guard g;
    g_icnt_interface->Push(input, output, data, size);
 }
 
 static void* intersim2_pop(unsigned output)
 {
+   intersim2_guard g;
    return g_icnt_interface->Pop(output);
 }
 
 static void intersim2_transfer()
 {
+   intersim2_guard g;
    g_icnt_interface->Advance();
 }
 
 static bool intersim2_busy()
 {
+   intersim2_guard g;
    return g_icnt_interface->Busy();
 }
 
 static void intersim2_display_stats()
 {
+   intersim2_guard g;
    g_icnt_interface->DisplayStats();
 }
 
 static void intersim2_display_overall_stats()
 {
+   intersim2_guard g;
    g_icnt_interface->DisplayOverallStats();
 }
 
 static void intersim2_display_state(FILE *fp)
 {
+   intersim2_guard g;
    g_icnt_interface->DisplayState(fp);
 }
 
 static unsigned intersim2_get_flit_size()
 {
+   intersim2_guard g;
    return g_icnt_interface->GetFlitSize();
 }
 
+// Wrapper to the built-in crossbar (-network_mode 2)
+
+static __thread local_xbar_config g_local_xbar_config;
+static __thread local_interconnect *g_local_xbar = NULL;
+
+static void local_xbar_create(unsigned int n_shader, unsigned int n_mem)
+{
+   g_local_xbar->create(n_shader, n_mem);
+}
+
+static void local_xbar_init()
+{
+   g_local_xbar->init();
+}
+
+static bool local_xbar_has_buffer(unsigned input, unsigned int size)
+{
+   return g_local_xbar->has_buffer(input, size);
+}
+
+static void local_xbar_push(unsigned input, unsigned output, void* data, unsigned int size)
+{
+   g_local_xbar->push(input, output, data, size);
+}
+
+static void* local_xbar_pop(unsigned output)
+{
+   return g_local_xbar->pop(output);
+}
+
+static void local_xbar_transfer()
+{
+   g_local_xbar->advance();
+}
+
+static bool local_xbar_busy()
+{
+   return g_local_xbar->busy();
+}
+
+static void local_xbar_display_stats()
+{
+   g_local_xbar->display_stats();
+}
+
+static void local_xbar_display_overall_stats()
+{
+   g_local_xbar->display_overall_stats();
+}
+
+static void local_xbar_display_state(FILE *fp)
+{
+   g_local_xbar->display_state(fp);
+}
+
+static unsigned local_xbar_get_flit_size()
+{
+   return g_local_xbar->get_flit_size();
+}
+
 void icnt_reg_options( class OptionParser * opp )
 {
-   option_parser_register(opp, "-network_mode", OPT_INT32, &g_network_mode, "Interconnection network mode", "1");
+   option_parser_register(opp, "-network_mode", OPT_INT32, &g_network_mode, "Interconnection network mode (1 = intersim2, 2 = built-in crossbar)", "1");
    option_parser_register(opp, "-inter_config_file", OPT_CSTR, &g_network_config_filename, "Interconnection network config file", "mesh");
+   g_local_xbar_config.reg_options(opp);
 }
 
 void icnt_wrapper_init()
 {
    switch (g_network_mode) {
       case INTERSIM:
-         //FIXME: delete the object: may add icnt_done wrapper
-         g_icnt_interface = InterconnectInterface::New(g_network_config_filename);
+         {
+            intersim2_guard g;
+            if (g_icnt_shared) {
+               // the topology globals are shared, so every device must use the same network
+               if (g_intersim2_config && strcmp(g_intersim2_config, g_network_config_filename)) {
+                  printf("GPGPU-Sim: all simulated devices using intersim2 must share one -inter_config_file (%s != %s)\n",
+                         g_network_config_filename, g_intersim2_config);
+                  abort();
+               }
+               g_intersim2_config = g_network_config_filename;
+            }
+            //FIXME: delete the object: may add icnt_done wrapper
+            g_icnt_interface = InterconnectInterface::New(g_network_config_filename);
+            t_icnt_interface = g_icnt_interface;
+         }
          icnt_create     = intersim2_create;
          icnt_init       = intersim2_init;
          icnt_has_buffer = intersim2_has_buffer;
@@ -129,6 +258,20 @@ void icnt_wrapper_init()
          icnt_display_state = intersim2_display_state;
          icnt_get_flit_size = intersim2_get_flit_size;
          break;
+      case LOCAL_XBAR:
+         g_local_xbar = new local_interconnect(g_local_xbar_config);
+         icnt_create     = local_xbar_create;
+         icnt_init       = local_xbar_init;
+         icnt_has_buffer = local_xbar_has_buffer;
+         icnt_push       = local_xbar_push;
+         icnt_pop        = local_xbar_pop;
+         icnt_transfer   = local_xbar_transfer;
+         icnt_busy       = local_xbar_busy;
+         icnt_display_stats = local_xbar_display_stats;
+         icnt_display_overall_stats = local_xbar_display_overall_stats;
+         icnt_display_state = local_xbar_display_state;
+         icnt_get_flit_size = local_xbar_get_flit_size;
+         break;
       default:
          assert(0);
          break;
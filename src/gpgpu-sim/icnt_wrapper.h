@@ -45,26 +45,31 @@ typedef void (*icnt_display_overall_stats_p)( );
 typedef void (*icnt_display_state_p)(FILE* fp);
 typedef unsigned (*icnt_get_flit_size_p)();
 
-extern icnt_create_p     icnt_create;
-extern icnt_init_p       icnt_init;
-extern icnt_has_buffer_p icnt_has_buffer;
-extern icnt_push_p       icnt_push;
-extern icnt_pop_p        icnt_pop;
-extern icnt_transfer_p   icnt_transfer;
-extern icnt_busy_p       icnt_busy;
+extern __thread icnt_create_p     icnt_create;
+extern __thread icnt_init_p       icnt_init;
+extern __thread icnt_has_buffer_p icnt_has_buffer;
+extern __thread icnt_push_p       icnt_push;
+extern __thread icnt_pop_p        icnt_pop;
+extern __thread icnt_transfer_p   icnt_transfer;
+extern __thread icnt_busy_p       icnt_busy;
 extern icnt_drain_p      icnt_drain;
-extern icnt_display_stats_p icnt_display_stats;
-extern icnt_display_overall_stats_p icnt_display_overall_stats;
-extern icnt_display_state_p icnt_display_state;
-extern icnt_get_flit_size_p icnt_get_flit_size;
-extern int g_network_mode;
+extern __thread icnt_display_stats_p icnt_display_stats;
+extern __thread icnt_display_overall_stats_p icnt_display_overall_stats;
+extern __thread icnt_display_state_p icnt_display_state;
+extern __thread icnt_get_flit_size_p icnt_get_flit_size;
+extern __thread int g_network_mode;
 
 enum network_mode {
    INTERSIM = 1,
+   LOCAL_XBAR = 2,
    N_NETWORK_MODE
 };
 
 void icnt_wrapper_init();
 void icnt_reg_options( class OptionParser * opp );
+// serialize intersim2 between several simulated devices in one process
+void icnt_set_shared( bool shared );
+// true if the calling thread's interconnect is stepped with helper threads
+bool icnt_has_worker_threads();
 
 #endif
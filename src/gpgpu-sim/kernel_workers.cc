@@ -0,0 +1,200 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "kernel_workers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "gpu-sim.h"
+#include "../gpgpusim_entrypoint.h"
+
+static kernel_worker_pool *g_kernel_worker_pool = NULL;
+
+static void finish_at_exit()
+{
+   if (g_kernel_worker_pool) 
+      g_kernel_worker_pool->finish();
+}
+
+kernel_worker_pool::kernel_worker_pool( unsigned max_workers, const char *prefix )
+{
+   m_max_workers = max_workers;
+   m_prefix = prefix;
+   m_finished = false;
+   g_kernel_worker_pool = this;
+   atexit(finish_at_exit);
+}
+
+std::string kernel_worker_pool::log_name( unsigned uid ) const
+{
+   char buf[32];
+   snprintf(buf,32,"_kernel_%u.log",uid);
+   return m_prefix + buf;
+}
+
+void kernel_worker_pool::wait_one()
+{
+   int status;
+   pid_t pid;
+   do {
+      pid = waitpid(-1,&status,0);
+   } while (pid < 0 && errno == EINTR);
+   if (pid < 0) {
+      // no children left (e.g. reaped elsewhere), nothing to wait for
+      m_running.clear();
+      return;
+   }
+   std::map<pid_t,unsigned>::iterator w = m_running.find(pid);
+   if (w == m_running.end()) 
+      return;
+   m_kernels[w->second].status = status;
+   if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) 
+      printf("GPGPU-Sim: WARNING ** timing worker of kernel %u failed, see %s\n", w->second, log_name(w->second).c_str());
+   m_running.erase(w);
+}
+
+void kernel_worker_pool::fork_kernel( gpgpu_sim *gpu, kernel_info_t *kernel )
+{
+   while (m_running.size() >= m_max_workers) 
+      wait_one();
+
+   unsigned uid = kernel->get_uid();
+   std::string log = log_name(uid);
+   fflush(stdout);
+   fflush(stderr);
+   pid_t pid = fork();
+   if (pid < 0) {
+      printf("GPGPU-Sim: ERROR ** cannot fork timing worker: %s\n", strerror(errno));
+      abort();
+   }
+   if (pid == 0) {
+      // worker: timing simulation of this kernel only, then exit without
+      // running the parent's atexit handlers
+      int fd = open(log.c_str(),O_WRONLY|O_CREAT|O_TRUNC,0644);
+      if (fd < 0) 
+         _exit(2);
+      dup2(fd,1);
+      dup2(fd,2);
+      close(fd);
+      g_kernel_worker_pool = NULL;
+      char suffix[32];
+      snprintf(suffix,32,"_kernel_%u",uid);
+      gpgpu_ptx_sim_set_output_suffix(suffix);
+      gpu->detach_output_files();
+      gpu->init();
+      gpu->launch(kernel);
+      while (gpu->active()) {
+         gpu->cycle();
+         gpu->deadlock_check();
+      }
+      gpu->print_stats();
+      gpu->update_stats();
+      fflush(stdout);
+      _exit(0);
+   }
+   printf("GPGPU-Sim: kernel %u '%s' timing simulation forked to worker %d (%s)\n", uid, kernel->name().c_str(), (int)pid, log.c_str());
+   m_running[pid] = uid;
+   m_kernels[uid].name = kernel->name();
+   m_kernels[uid].status = -1;
+}
+
+// value of the last "<key> = <value>" line of a worker log
+static bool last_stat( const char *filename, const char *key, unsigned long long &value )
+{
+   FILE *fp = fopen(filename,"r");
+   if (!fp) 
+      return false;
+   char line[1024];
+   size_t keylen = strlen(key);
+   bool found = false;
+   while (fgets(line,sizeof(line),fp)) {
+      if (!strncmp(line,key,keylen) && !strncmp(line+keylen," = ",3)) {
+         value = strtoull(line+keylen+3,NULL,10);
+         found = true;
+      }
+   }
+   fclose(fp);
+   return found;
+}
+
+void kernel_worker_pool::finish()
+{
+   if (m_finished) 
+      return;
+   m_finished = true;
+   while (!m_running.empty()) 
+      wait_one();
+
+   std::string report = m_prefix + "_report.log";
+   FILE *out = fopen(report.c_str(),"w");
+   if (!out) {
+      printf("GPGPU-Sim: ERROR ** cannot write '%s': %s\n", report.c_str(), strerror(errno));
+      return;
+   }
+   unsigned long long tot_cycle = 0, tot_insn = 0;
+   printf("GPGPU-Sim: kernel-parallel timing simulation results (%s):\n", report.c_str());
+   fprintf(out, "%-8s %-14s %-14s %-10s %s\n", "uid", "gpu_sim_cycle", "gpu_sim_insn", "gpu_ipc", "kernel_name");
+   std::map<unsigned,worker_result>::const_iterator k;
+   for (k=m_kernels.begin(); k != m_kernels.end(); k++) {
+      std::string log = log_name(k->first);
+      unsigned long long cycle = 0, insn = 0;
+      if (!last_stat(log.c_str(),"gpu_sim_cycle",cycle) || !last_stat(log.c_str(),"gpu_sim_insn",insn)) {
+         fprintf(out, "%-8u %-14s %-14s %-10s %s\n", k->first, "-", "-", "-", k->second.name.c_str());
+         continue;
+      }
+      tot_cycle += cycle;
+      tot_insn += insn;
+      fprintf(out, "%-8u %-14llu %-14llu %-10.4f %s\n", k->first, cycle, insn, cycle ? (double)insn/cycle : 0.0, k->second.name.c_str());
+   }
+   fprintf(out, "gpu_tot_sim_cycle = %llu\n", tot_cycle);
+   fprintf(out, "gpu_tot_sim_insn = %llu\n", tot_insn);
+   fprintf(out, "gpu_tot_ipc = %12.4f\n", tot_cycle ? (double)tot_insn/tot_cycle : 0.0);
+
+   // full statistics of every kernel, in launch order
+   for (k=m_kernels.begin(); k != m_kernels.end(); k++) {
+      std::string log = log_name(k->first);
+      fprintf(out, "\n==== kernel %u '%s' (%s) ====\n", k->first, k->second.name.c_str(), log.c_str());
+      FILE *in = fopen(log.c_str(),"r");
+      if (!in) 
+         continue;
+      char buf[8192];
+      size_t n;
+      while ((n = fread(buf,1,sizeof(buf),in)) > 0) 
+         fwrite(buf,1,n,out);
+      fclose(in);
+   }
+   fclose(out);
+   printf("gpu_tot_sim_cycle = %llu\n", tot_cycle);
+   printf("gpu_tot_sim_insn = %llu\n", tot_insn);
+   fflush(stdout);
+}
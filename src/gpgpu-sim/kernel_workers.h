@@ -0,0 +1,81 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KERNEL_WORKERS_H_INCLUDED
+#define KERNEL_WORKERS_H_INCLUDED
+
+#include <sys/types.h>
+#include <string>
+#include <vector>
+#include <map>
+
+// Kernel-parallel timing simulation (-gpgpu_kernel_workers N).
+//
+// The simulation thread executes every kernel functionally, which produces
+// the device memory state each following kernel starts from.  Just before a
+// kernel selected for timing simulation (see -gpgpu_timing_kernels) is
+// executed, the process forks: the copy-on-write image of the process is the
+// memory snapshot of that kernel, and the child timing-simulates only this
+// kernel with cold caches, writes its statistics to <prefix>_kernel_<uid>.log
+// and exits.  At most N children run at a time.  When the application exits
+// the parent waits for all of them and merges their statistics, in launch
+// order, into <prefix>_report.log.
+//
+// The child only runs the simulation thread; host threads of the application
+// and helper threads of the simulator do not exist in it, so nothing it does
+// may wait on them.  The options that rely on helper threads during timing
+// simulation (-trace_binary_file, power trace files, parallel_subnets in the
+// interconnect) are rejected together with -gpgpu_kernel_workers, and the
+// child writes its visualizer log and PTX line statistics to files of its
+// own, named with the suffix _kernel_<uid>.
+
+class kernel_worker_pool {
+public:
+   kernel_worker_pool( unsigned max_workers, const char *prefix );
+
+   // fork a worker that timing-simulates kernel; returns in the parent only
+   void fork_kernel( class gpgpu_sim *gpu, class kernel_info_t *kernel );
+
+   // wait for all workers and write the merged report
+   void finish();
+
+private:
+   void wait_one();
+   std::string log_name( unsigned uid ) const;
+
+   unsigned m_max_workers;
+   std::string m_prefix;
+   std::map<pid_t,unsigned> m_running; // pid -> kernel uid
+   struct worker_result {
+      std::string name;
+      int status;
+   };
+   std::map<unsigned,worker_result> m_kernels; // by uid
+   bool m_finished;
+};
+
+#endif
@@ -166,7 +166,7 @@ void memory_partition_unit::cache_cycle(unsigned cycle)
     }
 }
 
-void memory_partition_unit::visualizer_print( gzFile visualizer_file ) const 
+void memory_partition_unit::visualizer_print( visualizer_log *visualizer_file ) const 
 {
     m_dram->visualizer_print(visualizer_file);
     for (unsigned p = 0; p < m_config->m_n_sub_partition_per_memory_channel; p++) {
@@ -480,14 +480,17 @@ void memory_sub_partition::print( FILE *fp ) const
        m_L2cache->display_state(fp);
 }
 
-void memory_stats_t::visualizer_print( gzFile visualizer_file )
+void memory_stats_t::visualizer_print( visualizer_log *visualizer_file )
 {
-   // gzprintf(visualizer_file, "Ltwowritemiss: %d\n", L2_write_miss);
-   // gzprintf(visualizer_file, "Ltwowritehit: %d\n",  L2_write_access-L2_write_miss);
-   // gzprintf(visualizer_file, "Ltworeadmiss: %d\n", L2_read_miss);
-   // gzprintf(visualizer_file, "Ltworeadhit: %d\n", L2_read_access-L2_read_miss);
-   if (num_mfs)
-      gzprintf(visualizer_file, "averagemflatency: %lld\n", mf_total_lat/num_mfs);
+   // visualizer_file->print("Ltwowritemiss: %d\n", L2_write_miss);
+   // visualizer_file->print("Ltwowritehit: %d\n",  L2_write_access-L2_write_miss);
+   // visualizer_file->print("Ltworeadmiss: %d\n", L2_read_miss);
+   // visualizer_file->print("Ltworeadhit: %d\n", L2_read_access-L2_read_miss);
+   if (num_mfs) {
+      visualizer_file->begin_row("averagemflatency: ");
+      visualizer_file->value(mf_total_lat/num_mfs);
+      visualizer_file->end_row();
+   }
 }
 
 void gpgpu_sim::print_dram_stats(FILE *fout) const
@@ -600,7 +603,14 @@ void memory_sub_partition::get_L2cache_sub_stats(struct cache_sub_stats &css) co
     }
 }
 
-void memory_sub_partition::visualizer_print( gzFile visualizer_file )
+tag_array *memory_sub_partition::get_L2_tag_array()
+{
+    if (m_config->m_L2_config.disabled()) 
+        return NULL;
+    return m_L2cache->get_tag_array();
+}
+
+void memory_sub_partition::visualizer_print( visualizer_log *visualizer_file )
 {
     // TODO: Add visualizer stats for L2 cache 
 }
@@ -68,7 +68,7 @@ public:
 
    void set_done( mem_fetch *mf );
 
-   void visualizer_print( gzFile visualizer_file ) const;
+   void visualizer_print( visualizer_log *visualizer_file ) const;
    void print_stat( FILE *fp ) { m_dram->print_stat(fp); }
    void visualize() const { m_dram->visualize(); }
    void print( FILE *fp ) const;
@@ -91,6 +91,7 @@ public:
    int global_sub_partition_id_to_local_id(int global_sub_partition_id) const; 
 
    unsigned get_mpid() const { return m_id; }
+   class dram_t *get_dram() { return m_dram; }
 
 private: 
 
@@ -170,13 +171,16 @@ public:
    bool dram_L2_queue_full() const; 
    void dram_L2_queue_push( class mem_fetch* mf ); 
 
-   void visualizer_print( gzFile visualizer_file );
+   void visualizer_print( visualizer_log *visualizer_file );
    void print_cache_stat(unsigned &accesses, unsigned &misses) const;
    void print( FILE *fp ) const;
 
    void accumulate_L2cache_stats(class cache_stats &l2_stats) const;
    void get_L2cache_sub_stats(struct cache_sub_stats &css) const;
 
+   // NULL if the L2 cache is disabled 
+   class tag_array *get_L2_tag_array();
+
 private:
 // data
    unsigned m_id;  //< the global sub partition ID
@@ -38,11 +38,17 @@
 // Depends on a get_mpid() function
 #define MEMPART_DPRINTF(...) do {\
     if (MEMPART_DTRACE(MEMORY_PARTITION_UNIT)) {\
-        printf( MEMPART_PRINT_STR,\
-                gpu_sim_cycle + gpu_tot_sim_cycle,\
-                Trace::trace_streams_str[Trace::MEMORY_PARTITION_UNIT],\
-                get_mpid() );\
-        printf(__VA_ARGS__);\
+        if (Trace::binary_output) {\
+            static int trace_fmt_id = -1;\
+            Trace::binary_record( &trace_fmt_id, gpu_sim_cycle + gpu_tot_sim_cycle,\
+                                  Trace::MEMORY_PARTITION_UNIT, Trace::PREFIX_MEMPART, get_mpid(), -1, __VA_ARGS__ );\
+        } else {\
+            printf( MEMPART_PRINT_STR,\
+                    gpu_sim_cycle + gpu_tot_sim_cycle,\
+                    Trace::trace_streams_str[Trace::MEMORY_PARTITION_UNIT],\
+                    get_mpid() );\
+            printf(__VA_ARGS__);\
+        }\
     }\
 } while (0)
 
@@ -0,0 +1,281 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "local_interconnect.h"
+#include <assert.h>
+#include "../option_parser.h"
+
+void local_xbar_config::reg_options( class OptionParser * opp )
+{
+   option_parser_register(opp, "-local_xbar_flit_size", OPT_UINT32, &flit_size,
+                          "Flit size in bytes of the built-in crossbar (-network_mode 2)", "32");
+   option_parser_register(opp, "-local_xbar_in_buffer_limit", OPT_UINT32, &in_buffer_limit,
+                          "Flits each crossbar input port can queue per subnet", "64");
+   option_parser_register(opp, "-local_xbar_out_buffer_limit", OPT_UINT32, &out_buffer_limit,
+                          "Flits each crossbar output (ejection) buffer can hold per subnet", "64");
+   option_parser_register(opp, "-local_xbar_latency", OPT_UINT32, &latency,
+                          "Crossbar traversal latency in interconnect cycles", "5");
+   option_parser_register(opp, "-local_xbar_bandwidth", OPT_UINT32, &bandwidth,
+                          "Flits per crossbar port per interconnect cycle", "1");
+}
+
+void local_interconnect::stats::clear()
+{
+   packets = 0;
+   flits = 0;
+   total_latency = 0;
+   max_latency = 0;
+   output_conflicts = 0;
+   eject_stalls = 0;
+}
+
+void local_interconnect::stats::add_packet( unsigned n_flits, unsigned long long latency )
+{
+   packets++;
+   flits += n_flits;
+   total_latency += latency;
+   if (latency > max_latency)
+      max_latency = latency;
+}
+
+void local_interconnect::stats::add( const stats &other )
+{
+   packets += other.packets;
+   flits += other.flits;
+   total_latency += other.total_latency;
+   if (other.max_latency > max_latency)
+      max_latency = other.max_latency;
+   output_conflicts += other.output_conflicts;
+   eject_stalls += other.eject_stalls;
+}
+
+local_interconnect::local_interconnect( const local_xbar_config &config )
+   : m_config(config)
+{
+   m_n_shader = 0;
+   m_n_mem = 0;
+   m_n_nodes = 0;
+   m_time = 0;
+   m_kernel_start = 0;
+}
+
+void local_interconnect::create( unsigned n_shader, unsigned n_mem )
+{
+   assert(m_config.flit_size > 0 && m_config.bandwidth > 0);
+   m_n_shader = n_shader;
+   m_n_mem = n_mem;
+   m_n_nodes = n_shader + n_mem;
+   for (unsigned n = 0; n < N_NET; n++) {
+      subnet &net = m_net[n];
+      net.in_queue.assign(m_n_nodes, std::deque<packet>());
+      net.in_flits.assign(m_n_nodes, 0);
+      net.in_busy_until.assign(m_n_nodes, 0);
+      net.out_queue.assign(m_n_nodes, std::deque<packet>());
+      net.out_flits.assign(m_n_nodes, 0);
+      net.out_busy_until.assign(m_n_nodes, 0);
+      net.out_rr.assign(m_n_nodes, 0);
+      net.requests.assign(m_n_nodes, std::vector<unsigned>());
+      for (unsigned i = 0; i < m_n_nodes; i++)
+         net.requests[i].reserve(m_n_nodes);
+      net.queued = 0;
+      net.in_flight = 0;
+   }
+}
+
+void local_interconnect::init()
+{
+   // per-kernel statistics; queued packets (if any) are left untouched
+   for (unsigned n = 0; n < N_NET; n++) {
+      m_overall[n].add(m_stats[n]);
+      m_stats[n].clear();
+   }
+   m_kernel_start = m_time;
+}
+
+bool local_interconnect::has_buffer( unsigned input, unsigned size ) const
+{
+   const subnet &net = m_net[subnet_of_input(input)];
+   unsigned flits = n_flits(size);
+   // a packet larger than the whole buffer is accepted into an empty queue
+   // rather than deadlocking the sender
+   if (net.in_flits[input] == 0)
+      return true;
+   return net.in_flits[input] + flits <= m_config.in_buffer_limit;
+}
+
+void local_interconnect::push( unsigned input, unsigned output, void *data, unsigned size )
+{
+   assert(has_buffer(input, size));
+   assert(output < m_n_nodes);
+   subnet &net = m_net[subnet_of_input(input)];
+   assert(subnet_of_input(input) == subnet_of_output(output));
+   packet p;
+   p.data = data;
+   p.output = output;
+   p.n_flits = n_flits(size);
+   p.push_time = m_time;
+   p.ready_time = 0;
+   net.in_queue[input].push_back(p);
+   net.in_flits[input] += p.n_flits;
+   net.queued++;
+}
+
+void *local_interconnect::pop( unsigned output )
+{
+   subnet &net = m_net[subnet_of_output(output)];
+   std::deque<packet> &q = net.out_queue[output];
+   // ready times are monotonic per output since the port serializes grants
+   if (q.empty() || q.front().ready_time > m_time)
+      return NULL;
+   packet p = q.front();
+   q.pop_front();
+   net.out_flits[output] -= p.n_flits;
+   net.in_flight--;
+   return p.data;
+}
+
+void local_interconnect::arbitrate( unsigned n )
+{
+   subnet &net = m_net[n];
+   stats &st = m_stats[n];
+   // gather the head packet of every idle input under its output port
+   for (unsigned i = 0; i < m_n_nodes; i++) {
+      if (net.in_queue[i].empty() || net.in_busy_until[i] > m_time)
+         continue;
+      net.requests[net.in_queue[i].front().output].push_back(i);
+   }
+
+   for (unsigned o = 0; o < m_n_nodes; o++) {
+      std::vector<unsigned> &req = net.requests[o];
+      if (req.empty())
+         continue;
+      if (net.out_busy_until[o] > m_time) {
+         st.output_conflicts += req.size();
+         req.clear();
+         continue;
+      }
+      // round-robin: first requester at or after the priority pointer
+      unsigned winner = req[0];
+      for (unsigned r = 0; r < req.size(); r++) {
+         if (req[r] >= net.out_rr[o]) {
+            winner = req[r];
+            break;
+         }
+      }
+      st.output_conflicts += req.size() - 1;
+      req.clear();
+
+      packet &p = net.in_queue[winner].front();
+      if (net.out_flits[o] != 0 && net.out_flits[o] + p.n_flits > m_config.out_buffer_limit) {
+         st.eject_stalls++;
+         continue;
+      }
+
+      unsigned xfer = (p.n_flits + m_config.bandwidth - 1) / m_config.bandwidth;
+      net.in_busy_until[winner] = m_time + xfer;
+      net.out_busy_until[o] = m_time + xfer;
+      net.out_rr[o] = (winner + 1) % m_n_nodes;
+
+      p.ready_time = m_time + xfer + m_config.latency;
+      unsigned long long lat = p.ready_time - p.push_time;
+      st.add_packet(p.n_flits, lat);
+
+      net.out_flits[o] += p.n_flits;
+      net.out_queue[o].push_back(p);
+      net.in_flits[winner] -= p.n_flits;
+      net.in_queue[winner].pop_front();
+      net.queued--;
+      net.in_flight++;
+   }
+}
+
+void local_interconnect::advance()
+{
+   for (unsigned n = 0; n < N_NET; n++) {
+      if (m_net[n].queued)
+         arbitrate(n);
+   }
+   m_time++;
+}
+
+bool local_interconnect::busy() const
+{
+   for (unsigned n = 0; n < N_NET; n++) {
+      if (m_net[n].queued || m_net[n].in_flight)
+         return true;
+   }
+   return false;
+}
+
+void local_interconnect::print_stats( const char *label, const stats &st, unsigned long long cycles ) const
+{
+   printf("%s packets = %llu\n", label, st.packets);
+   printf("%s flits = %llu\n", label, st.flits);
+   printf("%s average packet latency = %.4f\n", label,
+          st.packets ? (double)st.total_latency / st.packets : 0.0);
+   printf("%s maximum packet latency = %llu\n", label, st.max_latency);
+   printf("%s accepted flit rate per port = %.4f\n", label,
+          (cycles && m_n_nodes) ? (double)st.flits / cycles / m_n_nodes : 0.0);
+   printf("%s output conflicts = %llu\n", label, st.output_conflicts);
+   printf("%s ejection buffer stalls = %llu\n", label, st.eject_stalls);
+}
+
+void local_interconnect::display_stats() const
+{
+   static const char *name[N_NET] = { "local_xbar req_net", "local_xbar reply_net" };
+   for (unsigned n = 0; n < N_NET; n++)
+      print_stats(name[n], m_stats[n], m_time - m_kernel_start);
+}
+
+void local_interconnect::display_overall_stats() const
+{
+   static const char *name[N_NET] = { "local_xbar overall req_net", "local_xbar overall reply_net" };
+   for (unsigned n = 0; n < N_NET; n++) {
+      stats total = m_overall[n];
+      total.add(m_stats[n]);
+      print_stats(name[n], total, m_time);
+   }
+}
+
+void local_interconnect::display_state( FILE *fp ) const
+{
+   fprintf(fp, "GPGPU-Sim uArch: ICNT (local crossbar) state at cycle %llu\n", m_time);
+   static const char *name[N_NET] = { "req_net", "reply_net" };
+   for (unsigned n = 0; n < N_NET; n++) {
+      const subnet &net = m_net[n];
+      fprintf(fp, "   %s: %u packets queued, %u in flight\n", name[n], net.queued, net.in_flight);
+      for (unsigned i = 0; i < m_n_nodes; i++) {
+         if (!net.in_queue[i].empty())
+            fprintf(fp, "   %s input %u: %zu packets (%u flits)\n",
+                    name[n], i, net.in_queue[i].size(), net.in_flits[i]);
+         if (!net.out_queue[i].empty())
+            fprintf(fp, "   %s output %u: %zu packets (%u flits), head ready at %llu\n",
+                    name[n], i, net.out_queue[i].size(), net.out_flits[i],
+                    net.out_queue[i].front().ready_time);
+      }
+   }
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef LOCAL_INTERCONNECT_H
+#define LOCAL_INTERCONNECT_H
+
+#include <stdio.h>
+#include <deque>
+#include <vector>
+
+// Cycle-approximate crossbar selected with -network_mode 2.  It replaces the
+// intersim2 router pipeline with a direct model of what a single-stage
+// crossbar costs: every port moves local_xbar_bandwidth flits per interconnect
+// cycle, a packet occupies its input and output port for as many cycles as it
+// has flits, and it becomes visible at the destination local_xbar_latency
+// cycles after its last flit crossed.  Input queues and ejection buffers are
+// bounded in flits.  Requests (shader -> memory) and replies (memory ->
+// shader) travel on separate subnets, matching the two-subnet intersim2
+// configurations shipped in configs/.
+
+struct local_xbar_config {
+   unsigned flit_size;         // bytes per flit
+   unsigned in_buffer_limit;   // flits per input queue (per subnet)
+   unsigned out_buffer_limit;  // flits per ejection buffer (per subnet)
+   unsigned latency;           // cycles from last flit crossing to delivery
+   unsigned bandwidth;         // flits per port per interconnect cycle
+
+   void reg_options( class OptionParser * opp );
+};
+
+class local_interconnect {
+public:
+   local_interconnect( const local_xbar_config &config );
+
+   void create( unsigned n_shader, unsigned n_mem );
+   void init();
+   bool has_buffer( unsigned input, unsigned size ) const;
+   void push( unsigned input, unsigned output, void *data, unsigned size );
+   void *pop( unsigned output );
+   void advance();
+   bool busy() const;
+
+   void display_stats() const;
+   void display_overall_stats() const;
+   void display_state( FILE *fp ) const;
+   unsigned get_flit_size() const { return m_config.flit_size; }
+
+private:
+   enum { REQ_NET = 0, REPLY_NET = 1, N_NET = 2 };
+
+   struct packet {
+      void *data;
+      unsigned output;
+      unsigned n_flits;
+      unsigned long long push_time;
+      unsigned long long ready_time;
+   };
+
+   struct stats {
+      stats() { clear(); }
+      void clear();
+      void add_packet( unsigned n_flits, unsigned long long latency );
+      void add( const stats &other );
+      unsigned long long packets;
+      unsigned long long flits;
+      unsigned long long total_latency;    // push to ejection-buffer arrival
+      unsigned long long max_latency;
+      unsigned long long output_conflicts; // requests that lost arbitration
+      unsigned long long eject_stalls;     // grants blocked by a full ejection buffer
+   };
+
+   struct subnet {
+      std::vector< std::deque<packet> > in_queue;
+      std::vector<unsigned> in_flits;
+      std::vector<unsigned long long> in_busy_until;
+      std::vector< std::deque<packet> > out_queue;
+      std::vector<unsigned> out_flits;       // includes flits still in flight
+      std::vector<unsigned long long> out_busy_until;
+      std::vector<unsigned> out_rr;          // round-robin input priority
+      std::vector< std::vector<unsigned> > requests;
+      unsigned queued;                       // packets waiting at inputs
+      unsigned in_flight;                    // packets past arbitration, not yet popped
+   };
+
+   unsigned subnet_of_input( unsigned input ) const { return input < m_n_shader ? REQ_NET : REPLY_NET; }
+   unsigned subnet_of_output( unsigned output ) const { return output < m_n_shader ? REPLY_NET : REQ_NET; }
+   unsigned n_flits( unsigned size ) const { return (size + m_config.flit_size - 1) / m_config.flit_size; }
+   void arbitrate( unsigned n );
+   void print_stats( const char *label, const stats &st, unsigned long long cycles ) const;
+
+   const local_xbar_config &m_config;
+   unsigned m_n_shader;
+   unsigned m_n_mem;
+   unsigned m_n_nodes;
+   unsigned long long m_time;
+   unsigned long long m_kernel_start;
+   subnet m_net[N_NET];
+   stats m_stats[N_NET];    // current kernel
+   stats m_overall[N_NET];  // all completed kernels
+};
+
+#endif
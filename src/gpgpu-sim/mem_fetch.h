@@ -138,7 +138,7 @@ private:
    // requesting instruction (put last so mem_fetch prints nicer in gdb)
    warp_inst_t m_inst;
 
-   static unsigned sm_next_mf_request_uid;
+   static __thread unsigned sm_next_mf_request_uid;
 
    const class memory_config *m_mem_config;
    unsigned icnt_flit_size;
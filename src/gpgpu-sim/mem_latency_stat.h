@@ -29,7 +29,7 @@
 #define MEM_LATENCY_STAT_H
 
 #include <stdio.h>
-#include <zlib.h>
+#include "visualizer_binlog.h"
 #include <map>
 
 class memory_stats_t {
@@ -45,7 +45,7 @@ public:
    void memlatstat_lat_pw();
    void memlatstat_print(unsigned n_mem, unsigned gpu_mem_n_bk);
 
-   void visualizer_print( gzFile visualizer_file );
+   void visualizer_print( visualizer_log *visualizer_file );
 
    unsigned m_n_shader;
 
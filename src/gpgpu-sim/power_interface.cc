@@ -26,11 +26,17 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "power_interface.h"
+#include "../gpgpusim_entrypoint.h"
 
 void init_mcpat(const gpgpu_sim_config &config, class gpgpu_sim_wrapper *wrapper, unsigned stat_sample_freq, unsigned tot_inst, unsigned inst){
 
-	wrapper->init_mcpat(config.g_power_config_name, config.g_power_filename, config.g_power_trace_filename,
-	    			config.g_metric_trace_filename,config.g_steady_state_tracking_filename,config.g_power_simulation_enabled,
+	// every simulated device writes its own power reports and traces
+	std::string power_filename = gpgpu_ptx_sim_output_filename(config.g_power_filename);
+	std::string power_trace_filename = gpgpu_ptx_sim_output_filename(config.g_power_trace_filename);
+	std::string metric_trace_filename = gpgpu_ptx_sim_output_filename(config.g_metric_trace_filename);
+	std::string steady_state_tracking_filename = gpgpu_ptx_sim_output_filename(config.g_steady_state_tracking_filename);
+	wrapper->init_mcpat(config.g_power_config_name, power_filename.c_str(), power_trace_filename.c_str(),
+	    			metric_trace_filename.c_str(),steady_state_tracking_filename.c_str(),config.g_power_simulation_enabled,
 	    			config.g_power_trace_enabled,config.g_steady_power_levels_enabled,config.g_power_per_cycle_dump,
 	    			config.gpu_steady_power_deviation,config.gpu_steady_min_period,config.g_power_trace_zlevel,
 	    			tot_inst+inst,stat_sample_freq
@@ -40,7 +46,7 @@ void init_mcpat(const gpgpu_sim_config &config, class gpgpu_sim_wrapper *wrapper
 
 void mcpat_cycle(const gpgpu_sim_config &config, const struct shader_core_config *shdr_config, class gpgpu_sim_wrapper *wrapper, class power_stat_t *power_stats, unsigned stat_sample_freq, unsigned tot_cycle, unsigned cycle, unsigned tot_inst, unsigned inst){
 
-	static bool mcpat_init=true;
+	static __thread bool mcpat_init=true; // per simulation thread, like the cycle counters
 
 	if(mcpat_init){ // If first cycle, don't have any power numbers yet
 		mcpat_init=false;
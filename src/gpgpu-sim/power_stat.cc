@@ -102,7 +102,7 @@ void power_mem_stat_t::save_stats(){
     }
 }
 
-void power_mem_stat_t::visualizer_print( gzFile power_visualizer_file ){
+void power_mem_stat_t::visualizer_print( visualizer_log *power_visualizer_file ){
 
 }
 
@@ -137,7 +137,7 @@ power_core_stat_t::power_core_stat_t( const struct shader_core_config *shader_co
 
 }
 
-void power_core_stat_t::visualizer_print( gzFile visualizer_file )
+void power_core_stat_t::visualizer_print( visualizer_log *visualizer_file )
 {
 
 }
@@ -278,7 +278,7 @@ power_stat_t::power_stat_t( const struct shader_core_config *shader_config,float
 	m_mem_config = mem_config;
 }
 
-void power_stat_t::visualizer_print( gzFile visualizer_file )
+void power_stat_t::visualizer_print( visualizer_log *visualizer_file )
 {
 	pwr_core_stat->visualizer_print(visualizer_file);
 	pwr_mem_stat->visualizer_print(visualizer_file);
@@ -29,7 +29,7 @@
 #define POWER_STAT_H
 
 #include <stdio.h>
-#include <zlib.h>
+#include "visualizer_binlog.h"
 #include "mem_latency_stat.h"
 #include "gpu-sim.h"
 
@@ -74,7 +74,7 @@ struct shader_core_power_stats_pod {
 class power_core_stat_t : public shader_core_power_stats_pod {
 public:
    power_core_stat_t(const struct shader_core_config *shader_config, shader_core_stats *core_stats);
-   void visualizer_print( gzFile visualizer_file );
+   void visualizer_print( visualizer_log *visualizer_file );
    void print (FILE *fout);
    void init();
    void save_stats();
@@ -114,7 +114,7 @@ struct mem_power_stats_pod{
 class power_mem_stat_t : public mem_power_stats_pod{
 public:
    power_mem_stat_t(const struct memory_config *mem_config, const struct shader_core_config *shdr_config, memory_stats_t *mem_stats, shader_core_stats *shdr_stats);
-   void visualizer_print( gzFile visualizer_file );
+   void visualizer_print( visualizer_log *visualizer_file );
    void print (FILE *fout) const;
    void init();
    void save_stats();
@@ -129,7 +129,7 @@ private:
 class power_stat_t {
 public:
    power_stat_t( const struct shader_core_config *shader_config,float * average_pipeline_duty_cycle,float * active_sms,shader_core_stats * shader_stats, const struct memory_config *mem_config,memory_stats_t * memory_stats);
-   void visualizer_print( gzFile visualizer_file );
+   void visualizer_print( visualizer_log *visualizer_file );
    void print (FILE *fout) const;
    void save_stats(){
 	   pwr_core_stat->save_stats();
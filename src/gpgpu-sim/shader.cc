@@ -296,6 +296,11 @@ shader_core_ctx::shader_core_ctx( class gpgpu_sim *gpu,
     
     m_last_inst_gpu_sim_cycle = 0;
     m_last_inst_gpu_tot_sim_cycle = 0;
+
+    m_trace_writer = gpu->get_warp_trace_writer();
+    m_trace_reader = gpu->get_warp_trace_reader();
+    if (m_trace_writer || m_trace_reader) 
+        m_warp_trace.resize(config->max_warps_per_shader);
 }
 
 void shader_core_ctx::reinit(unsigned start_thread, unsigned end_thread, bool reset_not_completed ) 
@@ -467,52 +472,52 @@ void shader_core_stats::event_warp_issued( unsigned s_id, unsigned warp_id, unsi
     }
 }
 
-void shader_core_stats::visualizer_print( gzFile visualizer_file )
+void shader_core_stats::visualizer_print( visualizer_log *visualizer_file )
 {
     // warp divergence breakdown
-    gzprintf(visualizer_file, "WarpDivergenceBreakdown:");
+    visualizer_file->begin_row("WarpDivergenceBreakdown: ");
     unsigned int total=0;
     unsigned int cf = (m_config->gpgpu_warpdistro_shader==-1)?m_config->num_shader():1;
-    gzprintf(visualizer_file, " %d", (shader_cycle_distro[0] - last_shader_cycle_distro[0]) / cf );
-    gzprintf(visualizer_file, " %d", (shader_cycle_distro[1] - last_shader_cycle_distro[1]) / cf );
-    gzprintf(visualizer_file, " %d", (shader_cycle_distro[2] - last_shader_cycle_distro[2]) / cf );
+    visualizer_file->value( (int)((shader_cycle_distro[0] - last_shader_cycle_distro[0]) / cf) );
+    visualizer_file->value( (int)((shader_cycle_distro[1] - last_shader_cycle_distro[1]) / cf) );
+    visualizer_file->value( (int)((shader_cycle_distro[2] - last_shader_cycle_distro[2]) / cf) );
     for (unsigned i=0; i<m_config->warp_size+3; i++) {
        if ( i>=3 ) {
           total += (shader_cycle_distro[i] - last_shader_cycle_distro[i]);
           if ( ((i-3) % (m_config->warp_size/8)) == ((m_config->warp_size/8)-1) ) {
-             gzprintf(visualizer_file, " %d", total / cf );
+             visualizer_file->value( (int)(total / cf) );
              total=0;
           }
        }
        last_shader_cycle_distro[i] = shader_cycle_distro[i];
     }
-    gzprintf(visualizer_file,"\n");
+    visualizer_file->end_row();
 
     // warp issue breakdown
     unsigned sid = m_config->gpgpu_warp_issue_shader;
     unsigned count = 0;
     unsigned warp_id_issued_sum = 0;
-    gzprintf(visualizer_file, "WarpIssueSlotBreakdown:");
+    visualizer_file->begin_row("WarpIssueSlotBreakdown: ");
     if(m_shader_warp_slot_issue_distro[sid].size() > 0){
         for ( std::vector<unsigned>::const_iterator iter = m_shader_warp_slot_issue_distro[ sid ].begin();
               iter != m_shader_warp_slot_issue_distro[ sid ].end(); iter++, count++ ) {
             unsigned diff = count < m_last_shader_warp_slot_issue_distro.size() ?
                             *iter - m_last_shader_warp_slot_issue_distro[ count ] :
                             *iter;
-            gzprintf( visualizer_file, " %d", diff );
+            visualizer_file->value( (int)diff );
             warp_id_issued_sum += diff;
         }
         m_last_shader_warp_slot_issue_distro = m_shader_warp_slot_issue_distro[ sid ];
     }else{
-        gzprintf( visualizer_file, " 0");
+        visualizer_file->value(0);
     }
-    gzprintf(visualizer_file,"\n");
+    visualizer_file->end_row();
 
     #define DYNAMIC_WARP_PRINT_RESOLUTION 32
     unsigned total_issued_this_resolution = 0;
     unsigned dynamic_id_issued_sum = 0;
     count = 0;
-    gzprintf(visualizer_file, "WarpIssueDynamicIdBreakdown:");
+    visualizer_file->begin_row("WarpIssueDynamicIdBreakdown: ");
     if(m_shader_dynamic_warp_issue_distro[sid].size() > 0){
         for ( std::vector<unsigned>::const_iterator iter = m_shader_dynamic_warp_issue_distro[ sid ].begin();
               iter != m_shader_dynamic_warp_issue_distro[ sid ].end(); iter++, count++ ) {
@@ -521,42 +526,46 @@ void shader_core_stats::visualizer_print( gzFile visualizer_file )
                             *iter;
             total_issued_this_resolution += diff;
             if ( ( count + 1 ) % DYNAMIC_WARP_PRINT_RESOLUTION == 0 ) {
-                gzprintf( visualizer_file, " %d", total_issued_this_resolution );
+                visualizer_file->value( (int)total_issued_this_resolution );
                 dynamic_id_issued_sum += total_issued_this_resolution;
                 total_issued_this_resolution = 0;
             }
         }
         if ( count % DYNAMIC_WARP_PRINT_RESOLUTION != 0 ) {
-            gzprintf( visualizer_file, " %d", total_issued_this_resolution );
+            visualizer_file->value( (int)total_issued_this_resolution );
             dynamic_id_issued_sum += total_issued_this_resolution;
         }
         m_last_shader_dynamic_warp_issue_distro = m_shader_dynamic_warp_issue_distro[ sid ];
         assert( warp_id_issued_sum == dynamic_id_issued_sum );
     }else{
-        gzprintf( visualizer_file, " 0");
+        visualizer_file->value(0);
     }
-    gzprintf(visualizer_file,"\n");
+    visualizer_file->end_row();
 
     // overall cache miss rates
-    gzprintf(visualizer_file, "gpgpu_n_cache_bkconflict: %d\n", gpgpu_n_cache_bkconflict);
-    gzprintf(visualizer_file, "gpgpu_n_shmem_bkconflict: %d\n", gpgpu_n_shmem_bkconflict);     
+    visualizer_file->begin_row("gpgpu_n_cache_bkconflict: ");
+    visualizer_file->value( (int)gpgpu_n_cache_bkconflict );
+    visualizer_file->end_row();
+    visualizer_file->begin_row("gpgpu_n_shmem_bkconflict: ");
+    visualizer_file->value( (int)gpgpu_n_shmem_bkconflict );
+    visualizer_file->end_row();
 
 
    // instruction count per shader core
-   gzprintf(visualizer_file, "shaderinsncount:  ");
+   visualizer_file->begin_row("shaderinsncount:  ",true);
    for (unsigned i=0;i<m_config->num_shader();i++) 
-      gzprintf(visualizer_file, "%u ", m_num_sim_insn[i] );
-   gzprintf(visualizer_file, "\n");
+      visualizer_file->value( (unsigned)m_num_sim_insn[i] );
+   visualizer_file->end_row();
    // warp instruction count per shader core
-   gzprintf(visualizer_file, "shaderwarpinsncount:  ");
+   visualizer_file->begin_row("shaderwarpinsncount:  ",true);
    for (unsigned i=0;i<m_config->num_shader();i++)
-      gzprintf(visualizer_file, "%u ", m_num_sim_winsn[i] );
-   gzprintf(visualizer_file, "\n");
+      visualizer_file->value( (unsigned)m_num_sim_winsn[i] );
+   visualizer_file->end_row();
    // warp divergence per shader core
-   gzprintf(visualizer_file, "shaderwarpdiv: ");
+   visualizer_file->begin_row("shaderwarpdiv: ",true);
    for (unsigned i=0;i<m_config->num_shader();i++) 
-      gzprintf(visualizer_file, "%u ", m_n_diverge[i] );
-   gzprintf(visualizer_file, "\n");
+      visualizer_file->value( (unsigned)m_n_diverge[i] );
+   visualizer_file->end_row();
 }
 
 #define PROGRAM_MEM_START 0xF0000000 /* should be distinct from other memory spaces... 
@@ -616,8 +625,13 @@ void shader_core_ctx::fetch()
                         did_exit=true;
                     }
                 }
-                if( did_exit ) 
+                if( did_exit ) {
                     m_warp[warp_id].set_done_exit();
+                    if( m_trace_writer ) {
+                        warp_trace_stream &stream = m_warp_trace[warp_id];
+                        m_trace_writer->add_warp(stream.kernel_launch, stream.cta, stream.warp, stream.out);
+                    }
+                }
             }
 
             // this code fetches instructions from the i-cache or generates memory requests
@@ -686,7 +700,11 @@ void shader_core_ctx::issue_warp( register_set& pipe_reg_set, const warp_inst_t*
     **pipe_reg = *next_inst; // static instruction information
     (*pipe_reg)->issue( active_mask, warp_id, gpu_tot_sim_cycle + gpu_sim_cycle, m_warp[warp_id].get_dynamic_warp_id() ); // dynamic instruction information
     m_stats->shader_cycle_distro[2+(*pipe_reg)->active_count()]++;
-    func_exec_inst( **pipe_reg );
+    if( m_trace_reader ) 
+        warp_trace_replay_inst( **pipe_reg, active_mask );
+    else
+        func_exec_inst( **pipe_reg );
+    m_cta_n_insn[m_warp[warp_id].get_cta_id()] += (*pipe_reg)->active_count();
     if( next_inst->op == BARRIER_OP ){
     	m_warp[warp_id].store_info_of_last_inst_at_barrier(*pipe_reg);
         m_barriers.warp_reaches_barrier(m_warp[warp_id].get_cta_id(),warp_id,const_cast<warp_inst_t*> (next_inst));
@@ -695,11 +713,123 @@ void shader_core_ctx::issue_warp( register_set& pipe_reg_set, const warp_inst_t*
         m_warp[warp_id].set_membar();
     }
 
-    updateSIMTStack(warp_id,*pipe_reg);
+    if( m_trace_reader ) {
+        warp_trace_update_simt_stack(warp_id,*pipe_reg);
+    } else {
+        updateSIMTStack(warp_id,*pipe_reg);
+        if( m_trace_writer ) 
+            warp_trace_record_inst(**pipe_reg,*next_inst,active_mask);
+    }
     m_scoreboard->reserveRegisters(*pipe_reg);
     m_warp[warp_id].set_next_pc(next_inst->pc + next_inst->isize);
 }
 
+void shader_core_ctx::warp_trace_begin_cta( kernel_info_t &kernel, unsigned cta, unsigned start_thread, unsigned end_thread )
+{
+    unsigned start_warp = start_thread / m_config->warp_size;
+    unsigned end_warp = end_thread / m_config->warp_size + ((end_thread % m_config->warp_size)? 1 : 0);
+    for (unsigned i = start_warp; i < end_warp; ++i) {
+        warp_trace_stream &stream = m_warp_trace[i];
+        stream.kernel_launch = kernel.get_launch_index();
+        stream.cta = cta;
+        stream.warp = i - start_warp;
+        stream.out.reset();
+        if( m_trace_reader && !m_trace_reader->load_warp(stream.kernel_launch, stream.cta, stream.warp, stream.in) ) {
+            printf("GPGPU-Sim uArch: ERROR ** cannot replay warp %u of CTA %u of kernel launch %u '%s': %s\n",
+                   stream.warp, stream.cta, stream.kernel_launch, kernel.name().c_str(), m_trace_reader->error());
+            abort();
+        }
+    }
+}
+
+// called after updateSIMTStack() so that the thread states and the resolved
+// reconvergence pc are those the SIMT stack was updated with
+void shader_core_ctx::warp_trace_record_inst( const warp_inst_t &inst, const warp_inst_t &static_inst, const active_mask_t &issue_mask )
+{
+    warp_trace_record &r = m_trace_record;
+    unsigned wtid = inst.warp_id() * m_config->warp_size;
+    r.pc = inst.pc;
+    r.exec_mask = inst.get_active_mask();
+    r.is_mem = (inst.is_load() || inst.is_store()) && r.exec_mask.any();
+    r.is_atomic = inst.isatomic();
+    r.space = inst.space;
+    r.data_size = inst.data_size;
+    r.done.reset();
+    for (unsigned t = 0; t < m_config->warp_size; t++) {
+        if( r.is_mem && r.exec_mask.test(t) ) 
+            r.addr[t] = m_trace_raw_addr[t];
+        if( !issue_mask.test(t) ) 
+            continue;
+        if( ptx_thread_done(wtid+t) ) 
+            r.done.set(t);
+        else
+            r.next_pc[t] = m_thread[wtid+t]->get_pc();
+    }
+    r.has_rpc = (static_inst.reconvergence_pc == RECONVERGE_RETURN_PC);
+    r.rpc = inst.reconvergence_pc;
+    m_warp_trace[inst.warp_id()].out.add(r, issue_mask, inst.isize);
+}
+
+// stands in for func_exec_inst(): applies the recorded predication, memory
+// addresses and thread exits, then runs the usual per-thread bookkeeping
+void shader_core_ctx::warp_trace_replay_inst( warp_inst_t &inst, const active_mask_t &issue_mask )
+{
+    warp_trace_record &r = m_trace_record;
+    warp_trace_stream &stream = m_warp_trace[inst.warp_id()];
+    if( !stream.in.next(r, issue_mask, inst.isize) || r.pc != inst.pc ) {
+        printf("GPGPU-Sim uArch: ERROR ** warp trace out of sync at pc 0x%04x (warp %u of CTA %u of kernel launch %u)\n",
+               inst.pc, stream.warp, stream.cta, stream.kernel_launch);
+        abort();
+    }
+    bool bar_red = (inst.op == BARRIER_OP) && (inst.bar_type == RED);
+    unsigned wtid = inst.warp_id() * m_config->warp_size;
+    for (unsigned t = 0; t < m_config->warp_size; t++) {
+        if( !issue_mask.test(t) ) 
+            continue;
+        unsigned tid = wtid + t;
+        if( !r.exec_mask.test(t) ) {
+            inst.set_not_active(t);
+        } else {
+            if( r.is_atomic || bar_red ) 
+                inst.add_callback(t, NULL, NULL, NULL, r.is_atomic);
+            if( r.is_mem ) {
+                inst.space = r.space;
+                inst.data_size = r.data_size;
+                inst.set_addr(t, r.addr[t]);
+            }
+        }
+        if( r.done.test(t) ) {
+            m_thread[tid]->set_done();
+            m_thread[tid]->exitCore();
+            m_thread[tid]->registerExit();
+        }
+        checkExecutionStatusAndUpdate(inst,t,tid);
+    }
+    if( inst.is_load() || inst.is_store() )
+        inst.generate_mem_accesses();
+}
+
+void shader_core_ctx::warp_trace_update_simt_stack( unsigned warp_id, warp_inst_t *inst )
+{
+    const warp_trace_record &r = m_trace_record;
+    const simt_mask_t &issue_mask = m_simt_stack[warp_id]->get_active_mask();
+    simt_mask_t thread_done;
+    addr_vector_t next_pc;
+    unsigned wtid = warp_id * m_config->warp_size;
+    for (unsigned i = 0; i < m_config->warp_size; i++) {
+        if( ptx_thread_done(wtid+i) ) {
+            thread_done.set(i);
+            next_pc.push_back( (address_type)-1 );
+        } else {
+            // only the threads of the top of stack entry are looked at
+            next_pc.push_back( issue_mask.test(i)? r.next_pc[i] : (address_type)-1 );
+        }
+    }
+    if( r.has_rpc ) 
+        inst->reconvergence_pc = r.rpc;
+    m_simt_stack[warp_id]->update(thread_done,next_pc,inst->reconvergence_pc, inst->op,inst->isize,inst->pc);
+}
+
 void shader_core_ctx::issue(){
     //really is issue;
     for (unsigned i = 0; i < schedulers.size(); i++) {
@@ -1919,6 +2049,7 @@ void shader_core_ctx::register_cta_thread_exit( unsigned cta_num )
       m_n_active_cta--;
       m_barriers.deallocate_barrier(cta_num);
       shader_CTA_count_unlog(m_sid, 1);
+      m_gpu->record_cta_sample(gpu_tot_sim_cycle + gpu_sim_cycle - m_cta_issue_cycle[cta_num], m_cta_n_insn[cta_num]);
       printf("GPGPU-Sim uArch: Shader %d finished CTA #%d (%lld,%lld), %u CTAs running\n", m_sid, cta_num, gpu_sim_cycle, gpu_tot_sim_cycle,
              m_n_active_cta );
       if( m_n_active_cta == 0 ) {
@@ -3429,6 +3560,8 @@ void shader_core_ctx::checkExecutionStatusAndUpdate(warp_inst_t &inst, unsigned
 {
     if(inst.isatomic())
            m_warp[inst.warp_id()].inc_n_atomic();
+        if (m_trace_writer && (inst.is_load() || inst.is_store()) && inst.active(t))
+            m_trace_raw_addr[t] = inst.get_addr(t);
         if (inst.space.is_local() && (inst.is_load() || inst.is_store())) {
             new_addr_type localaddrs[MAX_ACCESSES_PER_INSN_PER_THREAD];
             unsigned num_addrs;
@@ -53,6 +53,7 @@
 #include "stats.h"
 #include "gpu-cache.h"
 #include "traffic_breakdown.h"
+#include "warp_trace.h"
 
 
 
@@ -1483,7 +1484,7 @@ public:
 
     void event_warp_issued( unsigned s_id, unsigned warp_id, unsigned num_issued, unsigned dynamic_warp_id );
 
-    void visualizer_print( gzFile visualizer_file );
+    void visualizer_print( visualizer_log *visualizer_file );
 
     void print( FILE *fout ) const;
 
@@ -1760,6 +1761,12 @@ public:
     void issue_warp( register_set& warp, const warp_inst_t *pI, const active_mask_t &active_mask, unsigned warp_id );
     void func_exec_inst( warp_inst_t &inst );
 
+    // trace-driven simulation (see warp_trace.h)
+    void warp_trace_begin_cta( kernel_info_t &kernel, unsigned cta, unsigned start_thread, unsigned end_thread );
+    void warp_trace_record_inst( const warp_inst_t &inst, const warp_inst_t &static_inst, const active_mask_t &issue_mask );
+    void warp_trace_replay_inst( warp_inst_t &inst, const active_mask_t &issue_mask );
+    void warp_trace_update_simt_stack( unsigned warp_id, warp_inst_t *inst );
+
      // Returns numbers of addresses in translated_addrs
     unsigned translate_local_memaddr( address_type localaddr, unsigned tid, unsigned num_shader, unsigned datasize, new_addr_type* translated_addrs );
 
@@ -1788,6 +1795,8 @@ public:
     // CTA scheduling / hardware thread allocation
     unsigned m_n_active_cta; // number of Cooperative Thread Arrays (blocks) currently running on this shader.
     unsigned m_cta_status[MAX_CTA_PER_SHADER]; // CTAs status 
+    unsigned long long m_cta_issue_cycle[MAX_CTA_PER_SHADER]; // for CTA sampling statistics
+    unsigned long long m_cta_n_insn[MAX_CTA_PER_SHADER];
     unsigned m_not_completed; // number of threads to be completed (==0 when all thread on this core completed) 
     std::bitset<MAX_THREAD_PER_SM> m_active_threads;
     
@@ -1831,6 +1840,18 @@ public:
     // is that the dynamic_warp_id is a running number unique to every warp
     // run on this shader, where the warp_id is the static warp slot.
     unsigned m_dynamic_warp_id;
+
+    // trace-driven simulation: one stream per hardware warp
+    warp_trace_writer *m_trace_writer;
+    warp_trace_reader *m_trace_reader;
+    struct warp_trace_stream {
+        unsigned kernel_launch, cta, warp;
+        warp_trace_encoder out;
+        warp_trace_decoder in;
+    };
+    std::vector<warp_trace_stream> m_warp_trace;
+    warp_trace_record m_trace_record;
+    new_addr_type m_trace_raw_addr[MAX_WARP_SIZE]; // addresses before local memory translation
 };
 
 class simt_core_cluster {
@@ -43,11 +43,17 @@
 // Depends on a get_sid() function
 #define SHADER_DPRINTF(x, ...) do {\
     if (SHADER_DTRACE(x)) {\
-        printf( SHADER_PRINT_STR,\
-                gpu_sim_cycle + gpu_tot_sim_cycle,\
-                Trace::trace_streams_str[Trace::x],\
-                get_sid() );\
-        printf(__VA_ARGS__);\
+        if (Trace::binary_output) {\
+            static int trace_fmt_id = -1;\
+            Trace::binary_record( &trace_fmt_id, gpu_sim_cycle + gpu_tot_sim_cycle,\
+                                  Trace::x, Trace::PREFIX_SHADER, get_sid(), -1, __VA_ARGS__ );\
+        } else {\
+            printf( SHADER_PRINT_STR,\
+                    gpu_sim_cycle + gpu_tot_sim_cycle,\
+                    Trace::trace_streams_str[Trace::x],\
+                    get_sid() );\
+            printf(__VA_ARGS__);\
+        }\
     }\
 } while (0)
 
@@ -55,12 +61,18 @@
 // Depends on a m_id member
 #define SCHED_DPRINTF(...) do {\
     if (SHADER_DTRACE(WARP_SCHEDULER)) {\
-        printf( SCHED_PRINT_STR,\
-                gpu_sim_cycle + gpu_tot_sim_cycle,\
-                Trace::trace_streams_str[Trace::WARP_SCHEDULER],\
-                get_sid(),\
-                m_id );\
-        printf(__VA_ARGS__);\
+        if (Trace::binary_output) {\
+            static int trace_fmt_id = -1;\
+            Trace::binary_record( &trace_fmt_id, gpu_sim_cycle + gpu_tot_sim_cycle,\
+                                  Trace::WARP_SCHEDULER, Trace::PREFIX_SCHED, get_sid(), m_id, __VA_ARGS__ );\
+        } else {\
+            printf( SCHED_PRINT_STR,\
+                    gpu_sim_cycle + gpu_tot_sim_cycle,\
+                    Trace::trace_streams_str[Trace::WARP_SCHEDULER],\
+                    get_sid(),\
+                    m_id );\
+            printf(__VA_ARGS__);\
+        }\
     }\
 } while (0)
 
@@ -40,12 +40,33 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
-static unsigned long long  min_snap_shot_interval = 0;
-static unsigned long long  next_snap_shot_cycle = 0;
-static std::list<snap_shot_trigger*> list_ss_trigger;
+// the loggers are fed by the timing model, so each simulation thread (one per
+// simulated device) registers and updates its own set
+struct stat_tool_loggers {
+   std::list<snap_shot_trigger*> list_ss_trigger;
+   std::list<spill_log_interface*> list_spill_log;
+   std::vector<insn_warp_occ_logger> iwo_logger;
+   std::vector<linear_histogram_logger> s_warp_occ_logger;
+   std::vector<linear_histogram_logger> s_mem_acc_logger;
+   std::vector<linear_histogram_logger> s_mem_lat_logger;
+   std::vector<linear_histogram_logger> s_cache_access_logger;
+};
+
+static __thread stat_tool_loggers *t_loggers = NULL;
+
+static stat_tool_loggers &loggers()
+{
+   if (t_loggers == NULL) 
+      t_loggers = new stat_tool_loggers();
+   return *t_loggers;
+}
+
+static __thread unsigned long long  min_snap_shot_interval = 0;
+static __thread unsigned long long  next_snap_shot_cycle = 0;
 
 void add_snap_shot_trigger (snap_shot_trigger* ss_trigger)
 {
+   std::list<snap_shot_trigger*> &list_ss_trigger = loggers().list_ss_trigger;
    // quick optimization assuming that all snap shot intervals are perfect multiples of each other
    if (min_snap_shot_interval == 0 || min_snap_shot_interval > ss_trigger->get_interval()) {
       min_snap_shot_interval = ss_trigger->get_interval();
@@ -56,11 +77,13 @@ void add_snap_shot_trigger (snap_shot_trigger* ss_trigger)
 
 void remove_snap_shot_trigger (snap_shot_trigger* ss_trigger)
 {
+   std::list<snap_shot_trigger*> &list_ss_trigger = loggers().list_ss_trigger;
    list_ss_trigger.remove(ss_trigger);
 }
 
 void try_snap_shot (unsigned long long  current_cycle)
 {
+   std::list<snap_shot_trigger*> &list_ss_trigger = loggers().list_ss_trigger;
    if (min_snap_shot_interval == 0) return;
    if (current_cycle != next_snap_shot_cycle) return;
    
@@ -73,17 +96,18 @@ void try_snap_shot (unsigned long long  current_cycle)
 
 ////////////////////////////////////////////////////////////////////////////////
  
-static unsigned long long  spill_interval = 0;
-static unsigned long long  next_spill_cycle = 0;
-static std::list<spill_log_interface*> list_spill_log;
+static __thread unsigned long long  spill_interval = 0;
+static __thread unsigned long long  next_spill_cycle = 0;
 
 void add_spill_log (spill_log_interface* spill_log)
 {
+   std::list<spill_log_interface*> &list_spill_log = loggers().list_spill_log;
    list_spill_log.push_back(spill_log);
 }
 
 void remove_spill_log (spill_log_interface* spill_log)
 {
+   std::list<spill_log_interface*> &list_spill_log = loggers().list_spill_log;
    list_spill_log.remove(spill_log);
 }
 
@@ -95,6 +119,7 @@ void set_spill_interval (unsigned long long  interval)
 
 void spill_log_to_file (FILE *fout, int final, unsigned long long  current_cycle)
 {
+   std::list<spill_log_interface*> &list_spill_log = loggers().list_spill_log;
    if (!final && spill_interval == 0) return;
    if (!final && current_cycle <= next_spill_cycle) return;
 
@@ -112,8 +137,8 @@ void spill_log_to_file (FILE *fout, int final, unsigned long long  current_cycle
 
 unsigned translate_pc_to_ptxlineno(unsigned pc);
 
-static int n_thread_CFloggers = 0;
-static thread_CFlocality** thread_CFlogger = NULL;
+static __thread int n_thread_CFloggers = 0;
+static __thread thread_CFlocality** thread_CFlogger = NULL;
 
 void create_thread_CFlogger( int n_loggers, int n_threads, address_type start_pc, unsigned long long  logging_interval) 
 {
@@ -176,7 +201,7 @@ void cflog_visualizer_print(FILE *fout)
    }
 }
 
-void cflog_visualizer_gzprint(gzFile fout) 
+void cflog_visualizer_gzprint(visualizer_log *fout) 
 {
    if (thread_CFlogger == NULL) return;  // this means no visualizer output 
    for (int i = 0; i < n_thread_CFloggers; i++) {
@@ -186,12 +211,11 @@ void cflog_visualizer_gzprint(gzFile fout)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-int insn_warp_occ_logger::s_ids = 0;
-
-static std::vector<insn_warp_occ_logger> iwo_logger;
+__thread int insn_warp_occ_logger::s_ids = 0;
 
 void insn_warp_occ_create( int n_loggers, int simd_width )
 {
+   std::vector<insn_warp_occ_logger> &iwo_logger = loggers().iwo_logger;
    iwo_logger.clear();
    iwo_logger.assign(n_loggers, insn_warp_occ_logger(simd_width));
    for (unsigned i = 0; i < iwo_logger.size(); i++) {
@@ -201,12 +225,14 @@ void insn_warp_occ_create( int n_loggers, int simd_width )
 
 void insn_warp_occ_log( int logger_id, address_type pc, int warp_occ)
 {
+   std::vector<insn_warp_occ_logger> &iwo_logger = loggers().iwo_logger;
    if (warp_occ <= 0) return;
    iwo_logger[logger_id].log(pc, warp_occ);
 }
 
 void insn_warp_occ_print( FILE *fout )
 {
+   std::vector<insn_warp_occ_logger> &iwo_logger = loggers().iwo_logger;
    for (unsigned i = 0; i < iwo_logger.size(); i++) {
       iwo_logger[i].print(fout);
    }
@@ -214,16 +240,15 @@ void insn_warp_occ_print( FILE *fout )
 
 ////////////////////////////////////////////////////////////////////////////////
 
-int linear_histogram_logger::s_ids = 0;
+__thread int linear_histogram_logger::s_ids = 0;
 
 /////////////////////////////////////////////////////////////////////////////////////
 // per-shadercore active thread distribution (warp occ) logger
 /////////////////////////////////////////////////////////////////////////////////////
 
-static std::vector<linear_histogram_logger> s_warp_occ_logger;
-
 void shader_warp_occ_create( int n_loggers, int simd_width, unsigned long long  logging_interval)
 {
+   std::vector<linear_histogram_logger> &s_warp_occ_logger = loggers().s_warp_occ_logger;
    // simd_width + 1 to include the case with full warp
    s_warp_occ_logger.assign(n_loggers, 
                             linear_histogram_logger(simd_width + 1, logging_interval, "ShdrWarpOcc"));
@@ -236,16 +261,19 @@ void shader_warp_occ_create( int n_loggers, int simd_width, unsigned long long
 
 void shader_warp_occ_log( int logger_id, int warp_occ)
 {
+   std::vector<linear_histogram_logger> &s_warp_occ_logger = loggers().s_warp_occ_logger;
    s_warp_occ_logger[logger_id].log(warp_occ);
 }
 
 void shader_warp_occ_snapshot( int logger_id, unsigned long long  current_cycle)
 {
+   std::vector<linear_histogram_logger> &s_warp_occ_logger = loggers().s_warp_occ_logger;
    s_warp_occ_logger[logger_id].snap_shot(current_cycle);
 }
 
 void shader_warp_occ_print( FILE *fout )
 {
+   std::vector<linear_histogram_logger> &s_warp_occ_logger = loggers().s_warp_occ_logger;
    for (unsigned i = 0; i < s_warp_occ_logger.size(); i++) {
       s_warp_occ_logger[i].print(fout);
    }
@@ -256,12 +284,12 @@ void shader_warp_occ_print( FILE *fout )
 // per-shadercore memory-access logger
 /////////////////////////////////////////////////////////////////////////////////////
 
-static int s_mem_acc_logger_n_dram = 0;
-static int s_mem_acc_logger_n_bank = 0;
-static std::vector<linear_histogram_logger> s_mem_acc_logger;
+static __thread int s_mem_acc_logger_n_dram = 0;
+static __thread int s_mem_acc_logger_n_bank = 0;
 
 void shader_mem_acc_create( int n_loggers, int n_dram, int n_bank, unsigned long long  logging_interval)
 {
+   std::vector<linear_histogram_logger> &s_mem_acc_logger = loggers().s_mem_acc_logger;
    // (n_bank + 1) to space data out; 2x to separate read and write
    s_mem_acc_logger.assign(n_loggers, 
                            linear_histogram_logger(2 * n_dram * (n_bank + 1), logging_interval, "ShdrMemAcc"));
@@ -277,6 +305,7 @@ void shader_mem_acc_create( int n_loggers, int n_dram, int n_bank, unsigned long
 
 void shader_mem_acc_log( int logger_id, int dram_id, int bank, char rw)
 {
+   std::vector<linear_histogram_logger> &s_mem_acc_logger = loggers().s_mem_acc_logger;
    if (s_mem_acc_logger_n_dram == 0) return;
    int write_offset = 0;
    switch(rw) {
@@ -289,11 +318,13 @@ void shader_mem_acc_log( int logger_id, int dram_id, int bank, char rw)
 
 void shader_mem_acc_snapshot( int logger_id, unsigned long long  current_cycle)
 {
+   std::vector<linear_histogram_logger> &s_mem_acc_logger = loggers().s_mem_acc_logger;
    s_mem_acc_logger[logger_id].snap_shot(current_cycle);
 }
 
 void shader_mem_acc_print( FILE *fout )
 {
+   std::vector<linear_histogram_logger> &s_mem_acc_logger = loggers().s_mem_acc_logger;
    for (unsigned i = 0; i < s_mem_acc_logger.size(); i++) {
       s_mem_acc_logger[i].print(fout);
    }
@@ -304,12 +335,12 @@ void shader_mem_acc_print( FILE *fout )
 // per-shadercore memory-latency logger
 /////////////////////////////////////////////////////////////////////////////////////
 
-static bool s_mem_lat_logger_used = false;
+static __thread bool s_mem_lat_logger_used = false;
 static int s_mem_lat_logger_nbins = 48;     // up to 2^24 = 16M
-static std::vector<linear_histogram_logger> s_mem_lat_logger;
 
 void shader_mem_lat_create( int n_loggers, unsigned long long  logging_interval)
 {
+   std::vector<linear_histogram_logger> &s_mem_lat_logger = loggers().s_mem_lat_logger;
    s_mem_lat_logger.assign(n_loggers, 
                            linear_histogram_logger(s_mem_lat_logger_nbins, logging_interval, "ShdrMemLat"));
 
@@ -324,6 +355,7 @@ void shader_mem_lat_create( int n_loggers, unsigned long long  logging_interval)
 
 void shader_mem_lat_log( int logger_id, int latency)
 {
+   std::vector<linear_histogram_logger> &s_mem_lat_logger = loggers().s_mem_lat_logger;
    if (s_mem_lat_logger_used == false) return;
    if (latency > (1<<(s_mem_lat_logger_nbins/2))) assert(0); // guard for out of bound bin
    assert(latency > 0);
@@ -349,11 +381,13 @@ void shader_mem_lat_log( int logger_id, int latency)
 
 void shader_mem_lat_snapshot( int logger_id, unsigned long long  current_cycle)
 {
+   std::vector<linear_histogram_logger> &s_mem_lat_logger = loggers().s_mem_lat_logger;
    s_mem_lat_logger[logger_id].snap_shot(current_cycle);
 }
 
 void shader_mem_lat_print( FILE *fout )
 {
+   std::vector<linear_histogram_logger> &s_mem_lat_logger = loggers().s_mem_lat_logger;
    for (unsigned i = 0; i < s_mem_lat_logger.size(); i++) {
       s_mem_lat_logger[i].print(fout);
    }
@@ -364,8 +398,7 @@ void shader_mem_lat_print( FILE *fout )
 // per-shadercore cache-miss logger
 /////////////////////////////////////////////////////////////////////////////////////
 
-static int s_cache_access_logger_n_types = 0;
-static std::vector<linear_histogram_logger> s_cache_access_logger;
+static __thread int s_cache_access_logger_n_types = 0;
 
 enum cache_access_logger_types {
    NORMAL, TEXTURE, CONSTANT, INSTRUCTION
@@ -378,6 +411,7 @@ int get_shader_instruction_cache_id() { return INSTRUCTION; }
 
 void shader_cache_access_create( int n_loggers, int n_types, unsigned long long  logging_interval)
 {
+   std::vector<linear_histogram_logger> &s_cache_access_logger = loggers().s_cache_access_logger;
    // There are different type of cache (x2 for recording accesses and misses)
    s_cache_access_logger.assign(n_loggers, 
                                 linear_histogram_logger(n_types * 2, logging_interval, "ShdrCacheMiss"));
@@ -392,6 +426,7 @@ void shader_cache_access_create( int n_loggers, int n_types, unsigned long long
 
 void shader_cache_access_log( int logger_id, int type, int miss)
 {
+   std::vector<linear_histogram_logger> &s_cache_access_logger = loggers().s_cache_access_logger;
    if (s_cache_access_logger_n_types == 0) return;
    if (logger_id < 0) return;
    assert(type == NORMAL || type == TEXTURE || type == CONSTANT || type == INSTRUCTION);
@@ -402,6 +437,7 @@ void shader_cache_access_log( int logger_id, int type, int miss)
 
 void shader_cache_access_unlog( int logger_id, int type, int miss)
 {
+   std::vector<linear_histogram_logger> &s_cache_access_logger = loggers().s_cache_access_logger;
    if (s_cache_access_logger_n_types == 0) return;
    if (logger_id < 0) return;
    assert(type == NORMAL || type == TEXTURE || type == CONSTANT || type == INSTRUCTION);
@@ -412,6 +448,7 @@ void shader_cache_access_unlog( int logger_id, int type, int miss)
 
 void shader_cache_access_print( FILE *fout )
 {
+   std::vector<linear_histogram_logger> &s_cache_access_logger = loggers().s_cache_access_logger;
    for (unsigned i = 0; i < s_cache_access_logger.size(); i++) {
       s_cache_access_logger[i].print(fout);
    }
@@ -422,7 +459,7 @@ void shader_cache_access_print( FILE *fout )
 // per-shadercore CTA count logger (only make sense with gpgpu_spread_blocks_across_cores)
 /////////////////////////////////////////////////////////////////////////////////////
 
-static linear_histogram_logger *s_CTA_count_logger = NULL;
+static __thread linear_histogram_logger *s_CTA_count_logger = NULL;
 
 void shader_CTA_count_create( int n_shaders, unsigned long long  logging_interval)
 {
@@ -467,12 +504,26 @@ void shader_CTA_count_visualizer_print( FILE *fout )
    s_CTA_count_logger->print_visualizer(fout);
 }
 
-void shader_CTA_count_visualizer_gzprint( gzFile fout )
+void shader_CTA_count_visualizer_gzprint( visualizer_log *fout )
 {
    if (s_CTA_count_logger == NULL) return;
    s_CTA_count_logger->print_visualizer(fout);
 }
 
+void stat_tool_reset( )
+{
+   destroy_thread_CFlogger();
+   delete s_CTA_count_logger;
+   s_CTA_count_logger = NULL;
+   delete t_loggers;
+   t_loggers = NULL;
+   min_snap_shot_interval = next_snap_shot_cycle = 0;
+   spill_interval = next_spill_cycle = 0;
+   s_mem_acc_logger_n_dram = s_mem_acc_logger_n_bank = 0;
+   s_mem_lat_logger_used = false;
+   s_cache_access_logger_n_types = 0;
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -561,19 +612,21 @@ void thread_insn_span::print_sparse_histo(FILE *fout) const
    fprintf(fout, "\n");
 }
 
-void thread_insn_span::print_sparse_histo(gzFile fout) const
+void thread_insn_span::print_sparse_histo(visualizer_log *fout) const
 {
    int n_printed_entries = 0;
    span_count_map::const_iterator i_sc = m_insn_span_count.begin();
    for (; i_sc != m_insn_span_count.end(); ++i_sc) {
       unsigned ptx_lineno = translate_pc_to_ptxlineno(i_sc->first);
-      gzprintf(fout, "%u %d ", ptx_lineno, i_sc->second);
+      fout->value(ptx_lineno);
+      fout->value((int)i_sc->second);
       n_printed_entries++;
    }
    if (n_printed_entries == 0) {
-      gzprintf(fout, "0 0 ");
+      fout->value(0);
+      fout->value(0);
    }
-   gzprintf(fout, "\n");
+   fout->end_row();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -641,9 +694,11 @@ void thread_CFlocality::print_visualizer(FILE *fout)
    }
 }
    
-void thread_CFlocality::print_visualizer(gzFile fout)
+void thread_CFlocality::print_visualizer(visualizer_log *fout)
 {
-   gzprintf(fout, "%s: ", m_name.c_str());
+   if (m_visualizer_prefix.empty()) 
+      m_visualizer_prefix = m_name + ": ";
+   fout->begin_row(m_visualizer_prefix.c_str(),true);
    if (m_thd_span_archive.empty()) {
    
       // visualizer do no require snap_shots
@@ -771,17 +826,20 @@ void linear_histogram_logger::print_visualizer(FILE *fout)
    } 
 }
 
-void linear_histogram_logger::print_visualizer(gzFile fout)
+void linear_histogram_logger::print_visualizer(visualizer_log *fout)
 {
    assert(m_lin_hist_archive.empty()); // don't support snapshot for now
-   gzprintf(fout, "%s", m_name.c_str());
-   if (m_id >= 0) {
-      gzprintf(fout, "%02d: ", m_id);
-   } else {
-      gzprintf(fout, ": ");
-   }
+   if (m_visualizer_prefix.empty()) {
+      char id[16];
+      if (m_id >= 0) 
+         snprintf(id,sizeof(id),"%02d: ",m_id);
+      else 
+         snprintf(id,sizeof(id),": ");
+      m_visualizer_prefix = m_name + id;
+   }
+   fout->begin_row(m_visualizer_prefix.c_str(),true);
    m_curr_lin_hist.print_visualizer(fout);
-   gzprintf(fout, "\n");
+   fout->end_row();
    if (m_reset_at_snap_shot) {
       m_curr_lin_hist.reset(0);
    } 
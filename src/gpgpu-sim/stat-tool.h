@@ -33,7 +33,7 @@
 #include "../tr1_hash_map.h"
 
 #include <stdio.h>
-#include <zlib.h>
+#include "visualizer_binlog.h"
 
 /////////////////////////////////////////////////////////////////////////////////////
 // logger snapshot trigger: 
@@ -92,7 +92,7 @@ public:
    void print_span(FILE *fout) const;
    void print_histo(FILE *fout) const;
    void print_sparse_histo(FILE *fout) const;
-   void print_sparse_histo(gzFile fout) const;
+   void print_sparse_histo(visualizer_log *fout) const;
 
 private: 
    typedef tr1_hash_map<address_type, int> span_count_map;
@@ -111,11 +111,12 @@ public:
    void spill(FILE *fout, bool final);
    
    void print_visualizer(FILE *fout);
-   void print_visualizer(gzFile fout);
+   void print_visualizer(visualizer_log *fout);
    void print_span(FILE *fout) const;
    void print_histo(FILE *fout) const;
 private:
    std::string m_name;
+   std::string m_visualizer_prefix; // "name: "
 
    int m_nthreads;
    std::vector<address_type> m_thread_pc;
@@ -171,7 +172,7 @@ private:
    int m_simd_width;
    std::vector<linear_histogram> m_insn_warp_occ;
    int m_id;
-   static int s_ids;
+   static __thread int s_ids;
 };
 
 
@@ -223,9 +224,9 @@ public:
       }
    }
 
-   void print_visualizer(gzFile fout) const {
+   void print_visualizer(visualizer_log *fout) const {
       for (unsigned int i = 0; i < m_linear_histogram.size(); i++) {
-         gzprintf(fout, "%d ", m_linear_histogram[i]);
+         fout->value((int)m_linear_histogram[i]);
       }
    }
 
@@ -245,7 +246,7 @@ public:
    
    ~linear_histogram_logger();
    
-   void set_id(int id) { m_id = id; }
+   void set_id(int id) { m_id = id; m_visualizer_prefix.clear(); }
    void log(int pos) { m_curr_lin_hist.addsample(pos); }
    void unlog(int pos) { m_curr_lin_hist.subsample(pos); }
    void snap_shot(unsigned long long  current_cycle);
@@ -253,7 +254,7 @@ public:
 
    void print(FILE *fout) const;
    void print_visualizer(FILE *fout);
-   void print_visualizer(gzFile fout);
+   void print_visualizer(visualizer_log *fout);
 
 private:
    int m_n_bins;
@@ -263,7 +264,8 @@ private:
    bool m_reset_at_snap_shot;
    std::string m_name;
    int m_id;
-   static int s_ids;
+   std::string m_visualizer_prefix; // "name<id>: ", built on the first sample
+   static __thread int s_ids;
 };
 
 void try_snap_shot (unsigned long long  current_cycle);
@@ -277,7 +279,7 @@ void cflog_snapshot( int logger_id, unsigned long long  cycle );
 void cflog_print(FILE *fout);
 void cflog_print_path_expression(FILE *fout);
 void cflog_visualizer_print(FILE *fout);
-void cflog_visualizer_gzprint(gzFile fout);
+void cflog_visualizer_gzprint(visualizer_log *fout);
 
 void insn_warp_occ_create( int n_loggers, int simd_width );
 void insn_warp_occ_log( int logger_id, address_type pc, int warp_occ );
@@ -318,6 +320,10 @@ void shader_CTA_count_unlog( int shader_id, int nCTAdone );
 void shader_CTA_count_resetnow( );
 void shader_CTA_count_print( FILE *fout );
 void shader_CTA_count_visualizer_print( FILE *fout );
-void shader_CTA_count_visualizer_gzprint(gzFile fout);
+void shader_CTA_count_visualizer_gzprint(visualizer_log *fout);
+
+// drop the calling thread's loggers, so a thread that simulates several
+// configurations one after the other starts each with none
+void stat_tool_reset( );
 
 #endif /* CFLOGGER_H */
@@ -39,27 +39,37 @@
 
 #include <time.h>
 #include <string.h>
-#include <zlib.h>
+#include "visualizer_binlog.h"
+#include "../gpgpusim_entrypoint.h"
 
-static void time_vector_print_interval2gzfile(gzFile outfile);
+static void time_vector_print_interval2gzfile(visualizer_log *outfile);
 
 void gpgpu_sim::visualizer_printstat()
 {
-   gzFile visualizer_file = NULL; // gzFile is basically a pointer to a struct, so it is fine to initialize it as NULL
    if ( !m_config.g_visualizer_enabled )
       return;
 
-   // clean the content of the visualizer log if it is the first time, otherwise attach at the end
-   static bool visualizer_first_printstat = true;
-
-   visualizer_file = gzopen(m_config.g_visualizer_filename, (visualizer_first_printstat)? "w" : "a");
-   if (visualizer_file == NULL) {
-      printf("error - could not open visualizer trace file.\n");
-      exit(1);
+   // the visualizer log is opened (and its old content cleaned) on the first
+   // sample and kept open.  The statistics are written as rows of values,
+   // formatted as text or stored as binary columns, and compressed by the
+   // log's writer thread.  Every simulated device writes its own log.
+   if (m_visualizer == NULL) {
+      m_visualizer = new visualizer_log();
+      bool opened;
+      if (m_config.g_visualizer_binary_filename) {
+         std::string filename = gpgpu_ptx_sim_output_filename(m_config.g_visualizer_binary_filename);
+         opened = m_visualizer->open_binary(filename.c_str(), m_config.g_visualizer_zlevel, m_config.g_visualizer_binary_chunk);
+      } else {
+         std::string filename = gpgpu_ptx_sim_output_filename(m_config.g_visualizer_filename);
+         opened = m_visualizer->open_text(filename.c_str(), m_config.g_visualizer_zlevel);
+      }
+      if (!opened) {
+         printf("error - could not open visualizer trace file.\n");
+         exit(1);
+      }
    }
-   gzsetparams(visualizer_file, m_config.g_visualizer_zlevel, Z_DEFAULT_STRATEGY);
-   visualizer_first_printstat = false;
-   
+   visualizer_log *visualizer_file = m_visualizer;
+
    cflog_visualizer_gzprint(visualizer_file);
    shader_CTA_count_visualizer_gzprint(visualizer_file);
 
@@ -70,44 +80,55 @@ void gpgpu_sim::visualizer_printstat()
    m_power_stats->visualizer_print(visualizer_file);
    //proc->visualizer_print(visualizer_file);
    // other parameters for graphing
-   gzprintf(visualizer_file, "globalcyclecount: %lld\n", gpu_sim_cycle);
-   gzprintf(visualizer_file, "globalinsncount: %lld\n", gpu_sim_insn);
-   gzprintf(visualizer_file, "globaltotinsncount: %lld\n", gpu_tot_sim_insn);
+   visualizer_file->begin_row("globalcyclecount: ");
+   visualizer_file->value(gpu_sim_cycle);
+   visualizer_file->end_row();
+   visualizer_file->begin_row("globalinsncount: ");
+   visualizer_file->value(gpu_sim_insn);
+   visualizer_file->end_row();
+   visualizer_file->begin_row("globaltotinsncount: ");
+   visualizer_file->value(gpu_tot_sim_insn);
+   visualizer_file->end_row();
 
    time_vector_print_interval2gzfile(visualizer_file);
 
-   gzclose(visualizer_file);
+   visualizer_file->end_sample();
 /*
-   gzprintf(visualizer_file, "CacheMissRate_GlobalLocalL1_All: ");
+   visualizer_file->print("CacheMissRate_GlobalLocalL1_All: ");
    for (unsigned i=0;i<m_n_shader;i++) 
-      gzprintf(visualizer_file, "%0.4f ", m_sc[i]->L1_windowed_cache_miss_rate(0));
-   gzprintf(visualizer_file, "\n");
-   gzprintf(visualizer_file, "CacheMissRate_TextureL1_All: ");
+      visualizer_file->print("%0.4f ", m_sc[i]->L1_windowed_cache_miss_rate(0));
+   visualizer_file->print("\n");
+   visualizer_file->print("CacheMissRate_TextureL1_All: ");
    for (unsigned i=0;i<m_n_shader;i++) 
-      gzprintf(visualizer_file, "%0.4f ", m_sc[i]->L1tex_windowed_cache_miss_rate(0));
-   gzprintf(visualizer_file, "\n");
-   gzprintf(visualizer_file, "CacheMissRate_ConstL1_All: ");
+      visualizer_file->print("%0.4f ", m_sc[i]->L1tex_windowed_cache_miss_rate(0));
+   visualizer_file->print("\n");
+   visualizer_file->print("CacheMissRate_ConstL1_All: ");
    for (unsigned i=0;i<m_n_shader;i++) 
-      gzprintf(visualizer_file, "%0.4f ", m_sc[i]->L1const_windowed_cache_miss_rate(0));
-   gzprintf(visualizer_file, "\n");
-   gzprintf(visualizer_file, "CacheMissRate_GlobalLocalL1_noMgHt: ");
+      visualizer_file->print("%0.4f ", m_sc[i]->L1const_windowed_cache_miss_rate(0));
+   visualizer_file->print("\n");
+   visualizer_file->print("CacheMissRate_GlobalLocalL1_noMgHt: ");
    for (unsigned i=0;i<m_n_shader;i++) 
-      gzprintf(visualizer_file, "%0.4f ", m_sc[i]->L1_windowed_cache_miss_rate(1));
-   gzprintf(visualizer_file, "\n");
-   gzprintf(visualizer_file, "CacheMissRate_TextureL1_noMgHt: ");
+      visualizer_file->print("%0.4f ", m_sc[i]->L1_windowed_cache_miss_rate(1));
+   visualizer_file->print("\n");
+   visualizer_file->print("CacheMissRate_TextureL1_noMgHt: ");
    for (unsigned i=0;i<m_n_shader;i++) 
-      gzprintf(visualizer_file, "%0.4f ", m_sc[i]->L1tex_windowed_cache_miss_rate(1));
-   gzprintf(visualizer_file, "\n");
-   gzprintf(visualizer_file, "CacheMissRate_ConstL1_noMgHt: ");
+      visualizer_file->print("%0.4f ", m_sc[i]->L1tex_windowed_cache_miss_rate(1));
+   visualizer_file->print("\n");
+   visualizer_file->print("CacheMissRate_ConstL1_noMgHt: ");
    for (unsigned i=0;i<m_n_shader;i++) 
-      gzprintf(visualizer_file, "%0.4f ", m_sc[i]->L1const_windowed_cache_miss_rate(1));
-   gzprintf(visualizer_file, "\n");
+      visualizer_file->print("%0.4f ", m_sc[i]->L1const_windowed_cache_miss_rate(1));
+   visualizer_file->print("\n");
    // reset for next interval
    for (unsigned i=0;i<m_n_shader;i++) 
       m_sc[i]->new_cache_window();
 */
 }
 
+void gpgpu_sim::detach_output_files()
+{
+   m_visualizer = NULL;
+}
+
 #include <list>
 #include <vector>
 #include <iostream>
@@ -329,23 +350,23 @@ public:
       }
       fprintf (outfile,"\n") ;
    }   
-   void print_to_gzfile(gzFile outfile) {
+   void print_to_gzfile(visualizer_log *outfile) {
       unsigned i; 
       calculate_dist();
-      gzprintf (outfile,"LDmemlatdist:") ;
+      outfile->begin_row("LDmemlatdist: ");
       for ( i=0;i<ld_vector_size;i++ ) {
-         gzprintf (outfile," %d", (int)ld_time_dist[i]); 
+         outfile->value((int)ld_time_dist[i]); 
       }
-      gzprintf (outfile,"\n") ;
-      gzprintf (outfile,"STmemlatdist:") ;
+      outfile->end_row();
+      outfile->begin_row("STmemlatdist: ");
       for ( i=0;i<st_vector_size;i++ ) {
-         gzprintf (outfile," %d", (int)st_time_dist[i]); 
+         outfile->value((int)st_time_dist[i]); 
       }
-      gzprintf (outfile,"\n") ;
+      outfile->end_row();
    }   
 };
 
-my_time_vector* g_my_time_vector; 
+__thread my_time_vector* g_my_time_vector; 
 
 void time_vector_create(int size) {
    g_my_time_vector = new my_time_vector(size,size); 
@@ -356,7 +377,7 @@ void time_vector_print(void) {
    g_my_time_vector->print_dist();
 }
 
-void time_vector_print_interval2gzfile(gzFile outfile) {
+void time_vector_print_interval2gzfile(visualizer_log *outfile) {
    g_my_time_vector->print_to_gzfile(outfile);
 }
 
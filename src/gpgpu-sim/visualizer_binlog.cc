@@ -0,0 +1,445 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "visualizer_binlog.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <zlib.h>
+#include "async_gzwriter.h"
+
+static const char vbl_magic[8] = {'G','P','U','V','I','S','B','L'};
+static const unsigned vbl_version = 2;
+static const unsigned vbl_max_precision = 17;
+static const unsigned vbl_max_chunk_size = 1U << 30;
+
+static void put_u32( std::string &out, unsigned v )
+{
+   for (unsigned i=0; i<4; i++)
+      out.push_back((char)((v >> (8*i)) & 0xff));
+}
+
+// zigzag + LEB128: small deltas of either sign take a single byte
+static void put_varint( std::string &out, long long v )
+{
+   unsigned long long u = ((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63);
+   while (u >= 0x80) {
+      out.push_back((char)(u | 0x80));
+      u >>= 7;
+   }
+   out.push_back((char)u);
+}
+
+// bounds-checked cursor over a decoded chunk
+class vbl_cursor {
+public:
+   vbl_cursor( const std::string &buf ) : m_buf(buf), m_pos(0), m_bad(false) {}
+   bool bad() const { return m_bad; }
+   bool take( size_t n ) 
+   {
+      if (m_bad || m_buf.size() - m_pos < n) {
+         m_bad = true;
+         return false;
+      }
+      m_pos += n;
+      return true;
+   }
+   unsigned u8() { return take(1)? (unsigned char)m_buf[m_pos-1] : 0; }
+   unsigned u32()
+   {
+      if (!take(4)) return 0;
+      unsigned v = 0;
+      for (unsigned i=0; i<4; i++) 
+         v |= ((unsigned)(unsigned char)m_buf[m_pos-4+i]) << (8*i);
+      return v;
+   }
+   long long varint()
+   {
+      unsigned long long u = 0;
+      for (unsigned shift=0; shift<64; shift+=7) {
+         if (!take(1)) return 0;
+         unsigned char b = m_buf[m_pos-1];
+         u |= (unsigned long long)(b & 0x7f) << shift;
+         if (!(b & 0x80)) 
+            return (long long)(u >> 1) ^ -(long long)(u & 1);
+      }
+      m_bad = true;
+      return 0;
+   }
+   std::string str( unsigned n )
+   {
+      if (!take(n)) return std::string();
+      return m_buf.substr(m_pos-n,n);
+   }
+private:
+   const std::string &m_buf;
+   size_t m_pos;
+   bool m_bad;
+};
+
+static unsigned long long pow10_u64( unsigned p )
+{
+   unsigned long long r = 1;
+   while (p--) r *= 10;
+   return r;
+}
+
+static void format_value( std::string &out, visualizer_binlog_kind kind, unsigned precision, long long v )
+{
+   char buf[64];
+   if (kind == VBL_INT) {
+      snprintf(buf,sizeof(buf),"%lld",v);
+   } else {
+      unsigned long long u = (v < 0)? -(unsigned long long)v : (unsigned long long)v;
+      unsigned long long scale = pow10_u64(precision);
+      snprintf(buf,sizeof(buf),"%s%llu.%0*llu",(v<0)?"-":"",u/scale,(int)precision,u%scale);
+   }
+   out += buf;
+}
+
+bool visualizer_binlog_column::same_shape( const visualizer_binlog_column &other ) const
+{
+   if (kind != other.kind || prefix != other.prefix)
+      return false;
+   if (kind == VBL_TEXT)
+      return true;
+   return precision == other.precision && trailing_space == other.trailing_space && width == other.width;
+}
+
+visualizer_log::visualizer_log()
+{
+   m_out = new async_gzwriter();
+   m_binary = false;
+   m_chunk_samples = 1;
+   m_row_trailing_space = false;
+   m_row_empty = true;
+   m_sample_rows = 0;
+   m_n_samples = 0;
+}
+
+visualizer_log::~visualizer_log()
+{
+   close();
+   delete m_out;
+}
+
+bool visualizer_log::open_text( const char *filename, int zlevel )
+{
+   m_binary = false;
+   return m_out->open(filename,"w",zlevel);
+}
+
+bool visualizer_log::open_binary( const char *filename, int zlevel, unsigned chunk_samples )
+{
+   m_binary = true;
+   m_chunk_samples = chunk_samples? chunk_samples : 1;
+   m_sample_rows = 0;
+   m_n_samples = 0;
+   if (!m_out->open(filename,"w",zlevel))
+      return false;
+   std::string header(vbl_magic,sizeof(vbl_magic));
+   put_u32(header,vbl_version);
+   m_out->write(header.data(),header.size());
+   m_out->commit();
+   return true;
+}
+
+bool visualizer_log::is_open() const
+{
+   return m_out->is_open();
+}
+
+void visualizer_log::begin_row( const char *prefix, bool trailing_space )
+{
+   if (!m_binary) {
+      m_out->write(prefix,strlen(prefix));
+      m_row_trailing_space = trailing_space;
+      m_row_empty = true;
+      return;
+   }
+   if (m_sample_rows == m_sample_columns.size()) {
+      m_sample_columns.resize(m_sample_rows+1);
+      m_sample_values.resize(m_sample_rows+1);
+   }
+   visualizer_binlog_column &col = m_sample_columns[m_sample_rows];
+   col.kind = VBL_INT;
+   col.precision = 0;
+   col.trailing_space = trailing_space;
+   col.width = 0;
+   col.prefix = prefix;
+   m_sample_values[m_sample_rows].clear();
+}
+
+void visualizer_log::value( long long v )
+{
+   if (!m_binary) {
+      char buf[32];
+      int n = snprintf(buf,sizeof(buf),m_row_empty? "%lld" : " %lld",v);
+      m_out->write(buf,n);
+      m_row_empty = false;
+      return;
+   }
+   m_sample_values[m_sample_rows].push_back(v);
+}
+
+void visualizer_log::end_row()
+{
+   if (!m_binary) {
+      if (m_row_trailing_space && !m_row_empty)
+         m_out->write(" \n",2);
+      else
+         m_out->write("\n",1);
+      return;
+   }
+   m_sample_columns[m_sample_rows].width = m_sample_values[m_sample_rows].size();
+   m_sample_rows++;
+}
+
+void visualizer_log::end_sample()
+{
+   if (!m_binary) {
+      m_out->commit();
+      return;
+   }
+   if (m_n_samples > 0) {
+      bool same = (m_sample_rows == m_columns.size());
+      for (unsigned c=0; same && c<m_sample_rows; c++) 
+         same = m_sample_columns[c].same_shape(m_columns[c]);
+      if (!same)
+         flush_chunk();
+   }
+   if (m_n_samples == 0) {
+      m_columns.assign(m_sample_columns.begin(),m_sample_columns.begin()+m_sample_rows);
+      m_values.resize(m_sample_rows);
+      for (unsigned c=0; c<m_sample_rows; c++) 
+         m_values[c].clear();
+   }
+   for (unsigned c=0; c<m_sample_rows; c++) 
+      m_values[c].insert(m_values[c].end(),m_sample_values[c].begin(),m_sample_values[c].end());
+   m_sample_rows = 0;
+   m_n_samples++;
+   if (m_n_samples >= m_chunk_samples)
+      flush_chunk();
+}
+
+// encodes the chunk; compression happens on the writer's thread
+void visualizer_log::flush_chunk()
+{
+   if (m_n_samples == 0)
+      return;
+   m_raw.clear();
+   put_u32(m_raw,0); // raw_size, filled in below
+   put_u32(m_raw,m_n_samples);
+   put_u32(m_raw,m_columns.size());
+   for (unsigned c=0; c<m_columns.size(); c++) {
+      const visualizer_binlog_column &col = m_columns[c];
+      m_raw.push_back((char)col.kind);
+      m_raw.push_back((char)col.precision);
+      m_raw.push_back((char)col.trailing_space);
+      put_u32(m_raw,col.width);
+      put_u32(m_raw,col.prefix.size());
+      m_raw += col.prefix;
+   }
+   for (unsigned c=0; c<m_columns.size(); c++) {
+      const std::vector<long long> &v = m_values[c];
+      unsigned w = m_columns[c].width;
+      for (unsigned i=0; i<v.size(); i++) 
+         put_varint(m_raw, (i < w)? v[i] : v[i] - v[i-w]);
+   }
+   std::string size;
+   put_u32(size,m_raw.size()-4);
+   m_raw.replace(0,4,size);
+   m_out->write(m_raw.data(),m_raw.size());
+   m_out->commit();
+   m_n_samples = 0;
+}
+
+void visualizer_log::close()
+{
+   if (m_binary) 
+      flush_chunk();
+   m_out->close();
+}
+
+visualizer_binlog_reader::visualizer_binlog_reader()
+{
+   m_file = NULL;
+   m_version = 0;
+   m_error = NULL;
+   m_next = 0;
+}
+
+visualizer_binlog_reader::~visualizer_binlog_reader()
+{
+   close();
+}
+
+bool visualizer_binlog_reader::open( const char *filename )
+{
+   assert(m_file == NULL);
+   m_error = NULL;
+   m_samples.clear();
+   m_next = 0;
+   // version 2 logs are gzip streams, gzread() passes version 1 files through
+   m_file = gzopen(filename,"rb");
+   if (m_file == NULL) {
+      m_error = "could not open file";
+      return false;
+   }
+   char header[12];
+   if (gzread(m_file,header,sizeof(header)) != (int)sizeof(header) || memcmp(header,vbl_magic,sizeof(vbl_magic)) != 0) {
+      m_error = "not a binary visualizer log";
+      close();
+      return false;
+   }
+   std::string version(header+8,4);
+   vbl_cursor cur(version);
+   m_version = cur.u32();
+   if (m_version != 1 && m_version != vbl_version) {
+      m_error = "unsupported binary visualizer log version";
+      close();
+      return false;
+   }
+   return true;
+}
+
+bool visualizer_binlog_reader::read_chunk()
+{
+   unsigned char sizes[8];
+   unsigned header_size = (m_version == 1)? 8 : 4;
+   int n = gzread(m_file,sizes,header_size);
+   if (n == 0)
+      return false; // clean end of file
+   std::string size_str((const char*)sizes,n < 0? 0 : n);
+   vbl_cursor size_cur(size_str);
+   unsigned raw_size = size_cur.u32();
+   unsigned comp_size = (m_version == 1)? size_cur.u32() : 0;
+   if (size_cur.bad() || raw_size > vbl_max_chunk_size || comp_size > vbl_max_chunk_size) {
+      m_error = "truncated or corrupted chunk header";
+      return false;
+   }
+   std::string raw(raw_size,'\0');
+   if (m_version == 1) {
+      std::vector<Bytef> comp(comp_size+1);
+      if (gzread(m_file,&comp[0],comp_size) != (int)comp_size) {
+         m_error = "truncated chunk";
+         return false;
+      }
+      uLongf dest_size = raw_size;
+      if (uncompress((Bytef*)&raw[0],&dest_size,&comp[0],comp_size) != Z_OK || dest_size != raw_size) {
+         m_error = "corrupted chunk";
+         return false;
+      }
+   } else if (raw_size && gzread(m_file,&raw[0],raw_size) != (int)raw_size) {
+      m_error = "truncated chunk";
+      return false;
+   }
+
+   vbl_cursor cur(raw);
+   unsigned n_samples = cur.u32();
+   unsigned n_columns = cur.u32();
+   if (cur.bad() || (unsigned long long)n_columns*12 > raw_size) {
+      m_error = "corrupted chunk schema";
+      return false;
+   }
+   std::vector<visualizer_binlog_column> cols(n_columns);
+   for (unsigned c=0; c<n_columns && !cur.bad(); c++) {
+      unsigned kind = cur.u8();
+      cols[c].kind = (visualizer_binlog_kind)kind;
+      cols[c].precision = cur.u8();
+      cols[c].trailing_space = cur.u8() != 0;
+      cols[c].width = cur.u32();
+      cols[c].prefix = cur.str(cur.u32());
+      if (kind > VBL_TEXT || cols[c].precision > vbl_max_precision) {
+         m_error = "corrupted chunk schema";
+         return false;
+      }
+   }
+
+   // rebuild the text column by column, then stitch the lines back per sample
+   std::vector< std::vector<std::string> > lines(n_columns);
+   for (unsigned c=0; c<n_columns && !cur.bad(); c++) {
+      const visualizer_binlog_column &col = cols[c];
+      lines[c].resize(n_samples);
+      if (col.kind == VBL_TEXT) {
+         for (unsigned s=0; s<n_samples && !cur.bad(); s++) 
+            lines[c][s] = col.prefix + cur.str(cur.u32());
+         continue;
+      }
+      if ((unsigned long long)n_samples*col.width > raw_size) {
+         m_error = "corrupted chunk data";
+         return false;
+      }
+      std::vector<long long> prev(col.width,0);
+      for (unsigned s=0; s<n_samples && !cur.bad(); s++) {
+         std::string &line = lines[c][s];
+         line = col.prefix;
+         for (unsigned k=0; k<col.width; k++) {
+            prev[k] += cur.varint();
+            if (k) line.push_back(' ');
+            format_value(line,col.kind,col.precision,prev[k]);
+         }
+         if (col.trailing_space && col.width)
+            line.push_back(' ');
+      }
+   }
+   if (cur.bad()) {
+      m_error = "corrupted chunk data";
+      return false;
+   }
+
+   m_samples.assign(n_samples,std::string());
+   for (unsigned s=0; s<n_samples; s++) {
+      for (unsigned c=0; c<n_columns; c++) {
+         m_samples[s] += lines[c][s];
+         m_samples[s].push_back('\n');
+      }
+   }
+   m_next = 0;
+   return true;
+}
+
+bool visualizer_binlog_reader::next_sample( std::string &text )
+{
+   if (m_file == NULL)
+      return false;
+   while (m_next >= m_samples.size()) {
+      if (!read_chunk())
+         return false;
+   }
+   text.swap(m_samples[m_next++]);
+   return true;
+}
+
+void visualizer_binlog_reader::close()
+{
+   if (m_file == NULL)
+      return;
+   gzclose(m_file);
+   m_file = NULL;
+}
@@ -0,0 +1,143 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef VISUALIZER_BINLOG_H_INCLUDED
+#define VISUALIZER_BINLOG_H_INCLUDED
+
+#include <stdio.h>
+#include <zlib.h>
+#include <string>
+#include <vector>
+
+// Visualizer log of one simulator: AerialVision text or compact binary
+// columnar form.
+//
+// The statistics producers write each sample as rows of integer values
+// ("name: v0 v1 ... vn") through visualizer_log.  In text mode the rows are
+// formatted into the usual log lines.  In binary mode the values are kept as
+// numbers: the row at a given position of a sample becomes a column whose
+// prefix ("name: "), value kind and width form a schema shared by all samples
+// of a chunk, so per-shader and per-partition vectors are stored as
+// fixed-width rows, delta coded against the previous sample of the chunk and
+// written as zigzag varints.  A new chunk (with its own schema) is started
+// every chunk_samples samples or when the shape of a sample changes.  Either
+// way the bytes are compressed by an async_gzwriter thread.
+//
+// Binary file layout (little endian), version 2: a gzip stream of
+//   "GPUVISBL" u32 version
+//   chunk*: u32 raw_size, chunk payload
+// Version 1 files are not gzip streams; each chunk is u32 raw_size,
+// u32 compressed_size, zlib compressed payload.
+// Chunk payload:
+//   u32 n_samples, u32 n_columns
+//   n_columns * schema: u8 kind, u8 precision, u8 trailing_space, u32 width,
+//                       u32 prefix_len, prefix
+//   n_columns * data  : INT/FIXED: n_samples*width varint deltas
+//                       TEXT     : n_samples * (u32 len, body)
+//
+// vislog2txt (aerialvision/vislog2txt.cc) converts a binary log back to the
+// text format byte for byte.
+
+enum visualizer_binlog_kind {
+   VBL_INT = 0,   // "%d"-like tokens
+   VBL_FIXED,     // "%.<precision>f" tokens, stored as integer mantissas
+   VBL_TEXT       // anything else, body stored verbatim
+};
+
+struct visualizer_binlog_column {
+   visualizer_binlog_kind kind;
+   unsigned precision;
+   bool trailing_space;
+   unsigned width;
+   std::string prefix;
+
+   bool same_shape( const visualizer_binlog_column &other ) const;
+};
+
+class visualizer_log {
+public:
+   visualizer_log();
+   ~visualizer_log();
+
+   bool open_text( const char *filename, int zlevel );
+   bool open_binary( const char *filename, int zlevel, unsigned chunk_samples );
+   bool is_open() const;
+
+   // one row: prefix followed by the values separated by single spaces, with
+   // a space after the last value if trailing_space is set
+   void begin_row( const char *prefix, bool trailing_space = false );
+   void value( long long v );
+   void end_row();
+   // hand the rows written since the last call to the compression thread
+   void end_sample();
+   // drain and close the file; a later sample appends to it
+   void close();
+
+private:
+   void flush_chunk();
+
+   class async_gzwriter *m_out;
+   bool m_binary;
+   unsigned m_chunk_samples;
+
+   // text mode: state of the row being formatted
+   bool m_row_trailing_space;
+   bool m_row_empty;
+
+   // binary mode: rows of the sample being written, then the chunk
+   unsigned m_sample_rows;
+   std::vector<visualizer_binlog_column> m_sample_columns; // capacity reused
+   std::vector< std::vector<long long> > m_sample_values;
+   unsigned m_n_samples;
+   std::vector<visualizer_binlog_column> m_columns;
+   std::vector< std::vector<long long> > m_values; // per column, sample-major
+   std::string m_raw;
+};
+
+// Decodes a binary log and hands each reconstructed text sample to the caller.
+class visualizer_binlog_reader {
+public:
+   visualizer_binlog_reader();
+   ~visualizer_binlog_reader();
+
+   bool open( const char *filename );
+   // returns false at end of file or on a corrupted chunk (see error())
+   bool next_sample( std::string &text );
+   const char *error() const { return m_error; }
+   void close();
+
+private:
+   bool read_chunk();
+
+   gzFile m_file;
+   unsigned m_version;
+   const char *m_error;
+   std::vector<std::string> m_samples; // decoded samples of the current chunk
+   unsigned m_next;
+};
+
+#endif
@@ -0,0 +1,418 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "warp_trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <zlib.h>
+
+static const char wtrc_magic[8] = {'G','P','U','W','T','R','C','E'};
+static const unsigned wtrc_version = 2;
+static const unsigned wtrc_chunk_header_size = 25;
+static const unsigned wtrc_max_chunk_size = 1U << 30;
+
+// record flags
+enum {
+   WTRC_F_MASK        = 0x01, // exec mask differs from the issue mask
+   WTRC_F_MEM         = 0x02,
+   WTRC_F_ATOMIC      = 0x04,
+   WTRC_F_DONE        = 0x08,
+   WTRC_F_NPC_UNIFORM = 0x10, // all remaining threads go to one non-sequential pc
+   WTRC_F_NPC_LANES   = 0x20, // per thread next pc
+   WTRC_F_RPC         = 0x40
+};
+
+static void put_u32( std::string &out, unsigned v )
+{
+   for (unsigned i=0; i<4; i++)
+      out.push_back((char)((v >> (8*i)) & 0xff));
+}
+
+static unsigned get_u32( const unsigned char *p )
+{
+   return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned)p[3] << 24);
+}
+
+static void put_uvarint( std::string &out, unsigned long long u )
+{
+   while (u >= 0x80) {
+      out.push_back((char)(u | 0x80));
+      u >>= 7;
+   }
+   out.push_back((char)u);
+}
+
+// zigzag: small deltas of either sign take a single byte
+static void put_varint( std::string &out, long long v )
+{
+   put_uvarint(out, ((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63));
+}
+
+static long long unzigzag( unsigned long long u )
+{
+   return (long long)(u >> 1) ^ -(long long)(u & 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void warp_trace_encoder::reset()
+{
+   m_data.clear();
+   m_n_records = 0;
+   m_next_pc = 0;
+   m_last_addr = 0;
+}
+
+void warp_trace_encoder::add( const warp_trace_record &r, const active_mask_t &issue_mask, unsigned isize )
+{
+   const address_type seq_pc = r.pc + isize;
+   active_mask_t live = issue_mask & ~r.done;
+   bool uniform = true;
+   address_type npc = seq_pc;
+   bool first = true;
+   for (unsigned t=0; t<MAX_WARP_SIZE; t++) {
+      if (!live.test(t))
+         continue;
+      if (first) {
+         npc = r.next_pc[t];
+         first = false;
+      } else if (r.next_pc[t] != npc) {
+         uniform = false;
+      }
+   }
+
+   unsigned flags = 0;
+   if (r.exec_mask != issue_mask) flags |= WTRC_F_MASK;
+   if (r.is_mem) flags |= WTRC_F_MEM;
+   if (r.is_atomic) flags |= WTRC_F_ATOMIC;
+   if (r.done.any()) flags |= WTRC_F_DONE;
+   if (!uniform) flags |= WTRC_F_NPC_LANES;
+   else if (npc != seq_pc) flags |= WTRC_F_NPC_UNIFORM;
+   if (r.has_rpc) flags |= WTRC_F_RPC;
+
+   m_data.push_back((char)flags);
+   put_varint(m_data, (long long)r.pc - (long long)m_next_pc);
+   if (flags & WTRC_F_MASK)
+      put_uvarint(m_data, r.exec_mask.to_ulong());
+   if (flags & WTRC_F_MEM) {
+      m_data.push_back((char)r.space.get_type());
+      put_uvarint(m_data, r.space.get_bank());
+      put_uvarint(m_data, r.data_size);
+      for (unsigned t=0; t<MAX_WARP_SIZE; t++) {
+         if (!r.exec_mask.test(t))
+            continue;
+         put_varint(m_data, (long long)(r.addr[t] - m_last_addr));
+         m_last_addr = r.addr[t];
+      }
+   }
+   if (flags & WTRC_F_DONE)
+      put_uvarint(m_data, r.done.to_ulong());
+   if (flags & WTRC_F_NPC_UNIFORM)
+      put_varint(m_data, (long long)npc - (long long)seq_pc);
+   if (flags & WTRC_F_NPC_LANES) {
+      for (unsigned t=0; t<MAX_WARP_SIZE; t++) {
+         if (live.test(t))
+            put_varint(m_data, (long long)r.next_pc[t] - (long long)seq_pc);
+      }
+   }
+   if (flags & WTRC_F_RPC)
+      put_uvarint(m_data, r.rpc);
+
+   m_next_pc = uniform? npc : seq_pc;
+   m_n_records++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void warp_trace_decoder::reset()
+{
+   m_data.clear();
+   m_pos = 0;
+   m_bad = false;
+   m_remaining = 0;
+   m_next_pc = 0;
+   m_last_addr = 0;
+}
+
+void warp_trace_decoder::assign( std::string &data, unsigned n_records )
+{
+   reset();
+   m_data.swap(data);
+   m_remaining = n_records;
+}
+
+unsigned long long warp_trace_decoder::varint()
+{
+   unsigned long long u = 0;
+   for (unsigned shift=0; shift<64; shift+=7) {
+      if (m_pos >= m_data.size()) {
+         m_bad = true;
+         return 0;
+      }
+      unsigned char b = m_data[m_pos++];
+      u |= (unsigned long long)(b & 0x7f) << shift;
+      if (!(b & 0x80))
+         return u;
+   }
+   m_bad = true;
+   return 0;
+}
+
+bool warp_trace_decoder::next( warp_trace_record &r, const active_mask_t &issue_mask, unsigned isize )
+{
+   if (m_remaining == 0 || m_bad || m_pos >= m_data.size())
+      return false;
+   unsigned flags = (unsigned char)m_data[m_pos++];
+   r.pc = m_next_pc + unzigzag(varint());
+   const address_type seq_pc = r.pc + isize;
+
+   r.exec_mask = (flags & WTRC_F_MASK)? active_mask_t(varint()) : issue_mask;
+   r.is_mem = (flags & WTRC_F_MEM) != 0;
+   r.is_atomic = (flags & WTRC_F_ATOMIC) != 0;
+   if (r.is_mem) {
+      if (m_pos >= m_data.size())
+         return false;
+      r.space = memory_space_t((enum _memory_space_t)(unsigned char)m_data[m_pos++]);
+      r.space.set_bank(varint());
+      r.data_size = varint();
+      for (unsigned t=0; t<MAX_WARP_SIZE; t++) {
+         if (!r.exec_mask.test(t))
+            continue;
+         m_last_addr += (new_addr_type)unzigzag(varint());
+         r.addr[t] = m_last_addr;
+      }
+   }
+   r.done = (flags & WTRC_F_DONE)? active_mask_t(varint()) : active_mask_t();
+   active_mask_t live = issue_mask & ~r.done;
+   address_type npc = seq_pc;
+   if (flags & WTRC_F_NPC_UNIFORM)
+      npc = seq_pc + unzigzag(varint());
+   for (unsigned t=0; t<MAX_WARP_SIZE; t++) {
+      if (!live.test(t))
+         continue;
+      r.next_pc[t] = (flags & WTRC_F_NPC_LANES)? seq_pc + unzigzag(varint()) : npc;
+   }
+   r.has_rpc = (flags & WTRC_F_RPC) != 0;
+   if (r.has_rpc)
+      r.rpc = varint();
+
+   m_next_pc = (flags & WTRC_F_NPC_LANES)? seq_pc : npc;
+   m_remaining--;
+   return !m_bad;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool warp_trace_writer::open( const char *filename, int zlevel )
+{
+   // the file itself is not gzip compressed, so that the reader can seek to
+   // any chunk
+   if (!m_out.open(filename,"wbT",zlevel))
+      return false;
+   std::string header(wtrc_magic,sizeof(wtrc_magic));
+   put_u32(header,wtrc_version);
+   m_out.write(header.data(),header.size());
+   m_out.commit();
+   return true;
+}
+
+void warp_trace_writer::add_kernel( unsigned kernel_launch, const std::string &name, dim3 grid, dim3 block )
+{
+   if (!m_out.is_open())
+      return;
+   std::string raw;
+   put_u32(raw,name.size());
+   raw += name;
+   put_u32(raw,grid.x); put_u32(raw,grid.y); put_u32(raw,grid.z);
+   put_u32(raw,block.x); put_u32(raw,block.y); put_u32(raw,block.z);
+   add_chunk(WTRC_KERNEL,kernel_launch,0,0,0,raw);
+}
+
+void warp_trace_writer::add_warp( unsigned kernel_launch, unsigned cta, unsigned warp, warp_trace_encoder &enc )
+{
+   if (m_out.is_open())
+      add_chunk(WTRC_WARP,kernel_launch,cta,warp,enc.n_records(),enc.data());
+   enc.reset();
+}
+
+// queues the chunk header followed by the uncompressed payload;
+// compress_chunk() fills in compressed_size on the writer thread
+void warp_trace_writer::add_chunk( unsigned type, unsigned kernel_launch, unsigned cta, unsigned warp, unsigned n_records, const std::string &raw )
+{
+   std::string header;
+   header.push_back((char)type);
+   put_u32(header,kernel_launch);
+   put_u32(header,cta);
+   put_u32(header,warp);
+   put_u32(header,n_records);
+   put_u32(header,raw.size());
+   put_u32(header,0);
+   assert(header.size() == wtrc_chunk_header_size);
+   m_out.write(header.data(),header.size());
+   m_out.write(raw.data(),raw.size());
+   m_out.commit(compress_chunk);
+}
+
+void warp_trace_writer::compress_chunk( std::string &buf, int zlevel )
+{
+   const unsigned raw_size = buf.size() - wtrc_chunk_header_size;
+   uLongf comp_size = compressBound(raw_size);
+   std::string out(wtrc_chunk_header_size+comp_size,'\0');
+   int err = compress2((Bytef*)&out[wtrc_chunk_header_size],&comp_size,(const Bytef*)buf.data()+wtrc_chunk_header_size,raw_size,zlevel);
+   assert(err == Z_OK);
+   out.replace(0,wtrc_chunk_header_size-4,buf,0,wtrc_chunk_header_size-4);
+   std::string size;
+   put_u32(size,comp_size);
+   out.replace(wtrc_chunk_header_size-4,4,size);
+   out.resize(wtrc_chunk_header_size+comp_size);
+   buf.swap(out);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+warp_trace_reader::warp_trace_reader()
+{
+   m_file = NULL;
+   m_error = NULL;
+}
+
+warp_trace_reader::~warp_trace_reader()
+{
+   close();
+}
+
+bool warp_trace_reader::open( const char *filename )
+{
+   assert(m_file == NULL);
+   m_error = NULL;
+   m_file = fopen(filename,"rb");
+   if (m_file == NULL) {
+      m_error = "could not open file";
+      return false;
+   }
+   unsigned char header[12];
+   if (fread(header,1,sizeof(header),m_file) != sizeof(header) || memcmp(header,wtrc_magic,sizeof(wtrc_magic)) != 0) {
+      m_error = "not a warp trace";
+      close();
+      return false;
+   }
+   if (get_u32(header+8) != wtrc_version) {
+      m_error = "unsupported warp trace version";
+      close();
+      return false;
+   }
+   while (true) {
+      unsigned char h[wtrc_chunk_header_size];
+      size_t n = fread(h,1,sizeof(h),m_file);
+      if (n == 0)
+         break;
+      chunk_info c;
+      c.n_records = get_u32(h+13);
+      c.raw_size = get_u32(h+17);
+      c.comp_size = get_u32(h+21);
+      c.offset = ftell(m_file);
+      if (n != sizeof(h) || h[0] > WTRC_WARP || c.raw_size > wtrc_max_chunk_size || c.comp_size > wtrc_max_chunk_size 
+          || fseek(m_file,c.comp_size,SEEK_CUR) != 0) {
+         m_error = "truncated or corrupted chunk header";
+         close();
+         return false;
+      }
+      unsigned kernel_launch = get_u32(h+1);
+      if (h[0] == WTRC_KERNEL)
+         m_kernels[kernel_launch] = c;
+      else
+         m_warps[std::make_pair(kernel_launch,std::make_pair(get_u32(h+5),get_u32(h+9)))] = c;
+   }
+   return true;
+}
+
+bool warp_trace_reader::read_payload( const chunk_info &c, std::string &raw )
+{
+   std::vector<Bytef> comp(c.comp_size+1);
+   if (fseek(m_file,c.offset,SEEK_SET) != 0 || fread(&comp[0],1,c.comp_size,m_file) != c.comp_size) {
+      m_error = "truncated chunk";
+      return false;
+   }
+   raw.assign(c.raw_size,'\0');
+   uLongf dest_size = c.raw_size;
+   if (uncompress((Bytef*)&raw[0],&dest_size,&comp[0],c.comp_size) != Z_OK || dest_size != c.raw_size) {
+      m_error = "corrupted chunk";
+      return false;
+   }
+   return true;
+}
+
+bool warp_trace_reader::check_kernel( unsigned kernel_launch, const std::string &name, dim3 grid, dim3 block )
+{
+   std::map<unsigned,chunk_info>::const_iterator k = m_kernels.find(kernel_launch);
+   if (m_file == NULL || k == m_kernels.end()) {
+      m_error = "kernel not found in trace";
+      return false;
+   }
+   std::string raw;
+   if (!read_payload(k->second,raw))
+      return false;
+   const unsigned char *p = (const unsigned char*)raw.data();
+   unsigned name_len = raw.size() >= 4? get_u32(p) : ~0U;
+   if (raw.size() != 4 + (size_t)name_len + 24 || raw.compare(4,name_len,name) != 0) {
+      m_error = "kernel name differs from trace";
+      return false;
+   }
+   p += 4 + name_len;
+   if (get_u32(p) != grid.x || get_u32(p+4) != grid.y || get_u32(p+8) != grid.z ||
+       get_u32(p+12) != block.x || get_u32(p+16) != block.y || get_u32(p+20) != block.z) {
+      m_error = "kernel dimensions differ from trace";
+      return false;
+   }
+   return true;
+}
+
+bool warp_trace_reader::load_warp( unsigned kernel_launch, unsigned cta, unsigned warp, warp_trace_decoder &dec )
+{
+   dec.reset();
+   index_t::const_iterator w = m_warps.find(std::make_pair(kernel_launch,std::make_pair(cta,warp)));
+   if (m_file == NULL || w == m_warps.end()) {
+      m_error = "warp not found in trace";
+      return false;
+   }
+   std::string raw;
+   if (!read_payload(w->second,raw))
+      return false;
+   dec.assign(raw,w->second.n_records);
+   return true;
+}
+
+void warp_trace_reader::close()
+{
+   if (m_file)
+      fclose(m_file);
+   m_file = NULL;
+   m_kernels.clear();
+   m_warps.clear();
+}
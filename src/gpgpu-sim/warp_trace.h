@@ -0,0 +1,170 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef WARP_TRACE_H_INCLUDED
+#define WARP_TRACE_H_INCLUDED
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "../abstract_hardware_model.h"
+#include "async_gzwriter.h"
+
+// Per-warp dynamic instruction traces for trace-driven simulation.
+//
+// With -warp_trace_record_file set, every instruction issued by the timing
+// model is appended to the stream of its warp after functional execution:
+// the active mask after predication, the memory space, access size and
+// per-thread addresses of memory instructions, the threads that exited, and
+// the next PC of every thread (which is what the SIMT stack needs to
+// reconverge).  Register operands are not stored, they come from the static
+// instruction at the recorded PC.  Streams are keyed by kernel launch (counted
+// on the device, see kernel_info_t::get_launch_index), CTA and warp within
+// the CTA rather than by hardware slot, so a trace recorded with one
+// configuration replays under any other with the same warp size.
+//
+// With -warp_trace_replay_file set, issue_warp() takes these values from the
+// trace instead of calling ptx_exec_inst(), so no functional simulation is
+// done; device memory is not updated while replaying.
+//
+// File layout (little endian):
+//   "GPUWTRCE" u32 version
+//   chunk*: u8 type, u32 kernel_launch, u32 cta, u32 warp, u32 n_records,
+//           u32 raw_size, u32 compressed_size, compressed payload
+// A KERNEL chunk is written at launch: u32 name_len, name, grid and CTA
+// dimensions (6 x u32).  A WARP chunk holds a whole warp stream and is
+// written when the warp exits; records are varint coded against the previous
+// record of the stream (see warp_trace_encoder::add).
+
+enum warp_trace_chunk_type {
+   WTRC_KERNEL = 0,
+   WTRC_WARP
+};
+
+// values of one dynamic warp instruction besides its static information
+struct warp_trace_record {
+   address_type pc;
+   active_mask_t exec_mask;   // active threads after predication
+   bool is_mem;               // space/data_size/addr are valid
+   bool is_atomic;
+   memory_space_t space;
+   unsigned data_size;
+   new_addr_type addr[MAX_WARP_SIZE];   // per thread, before local memory translation
+   active_mask_t done;        // threads that exited at this instruction
+   address_type next_pc[MAX_WARP_SIZE]; // for issued threads that did not exit
+   bool has_rpc;
+   address_type rpc;          // resolved RECONVERGE_RETURN_PC
+};
+
+class warp_trace_encoder {
+public:
+   warp_trace_encoder() { reset(); }
+   void reset();
+   // issue_mask and isize come from the instruction being recorded
+   void add( const warp_trace_record &r, const active_mask_t &issue_mask, unsigned isize );
+   unsigned n_records() const { return m_n_records; }
+   std::string &data() { return m_data; }
+
+private:
+   std::string m_data;
+   unsigned m_n_records;
+   address_type m_next_pc;
+   new_addr_type m_last_addr;
+};
+
+class warp_trace_decoder {
+public:
+   warp_trace_decoder() { reset(); }
+   void reset();
+   void assign( std::string &data, unsigned n_records );
+   bool empty() const { return m_remaining == 0; }
+   // fills r for the next record; returns false if the stream is exhausted
+   // or corrupted
+   bool next( warp_trace_record &r, const active_mask_t &issue_mask, unsigned isize );
+
+private:
+   unsigned long long varint();
+
+   std::string m_data;
+   size_t m_pos;
+   bool m_bad;
+   unsigned m_remaining;
+   address_type m_next_pc;
+   new_addr_type m_last_addr;
+};
+
+// Owned by a gpgpu_sim; each simulated device records its own trace.  The
+// chunks are compressed and written by the async_gzwriter thread, so that the
+// simulation thread only hands over finished warp streams.
+class warp_trace_writer {
+public:
+   bool open( const char *filename, int zlevel );
+   bool is_open() const { return m_out.is_open(); }
+   void add_kernel( unsigned kernel_launch, const std::string &name, dim3 grid, dim3 block );
+   // consumes the data of enc and resets it
+   void add_warp( unsigned kernel_launch, unsigned cta, unsigned warp, warp_trace_encoder &enc );
+   void close() { m_out.close(); }
+
+private:
+   void add_chunk( unsigned type, unsigned kernel_launch, unsigned cta, unsigned warp, unsigned n_records, const std::string &raw );
+   static void compress_chunk( std::string &buf, int zlevel );
+
+   async_gzwriter m_out; // opened in transparent mode, chunks are compressed individually
+};
+
+class warp_trace_reader {
+public:
+   warp_trace_reader();
+   ~warp_trace_reader();
+
+   // reads the chunk headers of the whole file; payloads are read on demand
+   bool open( const char *filename );
+   const char *error() const { return m_error; }
+   // false if the trace has no kernel with this launch index and name
+   bool check_kernel( unsigned kernel_launch, const std::string &name, dim3 grid, dim3 block );
+   // false if the warp is missing from the trace or its chunk is corrupted
+   bool load_warp( unsigned kernel_launch, unsigned cta, unsigned warp, warp_trace_decoder &dec );
+   void close();
+
+private:
+   struct chunk_info {
+      unsigned n_records, raw_size, comp_size;
+      long offset;
+   };
+   typedef std::map< std::pair<unsigned, std::pair<unsigned,unsigned> >, chunk_info > index_t;
+
+   bool read_payload( const chunk_info &c, std::string &raw );
+
+   FILE *m_file;
+   const char *m_error;
+   std::map<unsigned,chunk_info> m_kernels;
+   index_t m_warps;
+};
+
+#endif
@@ -0,0 +1,280 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "workload_log.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "../cuda-sim/ptx_ir.h"
+#include "../cuda-sim/memory.h"
+
+workload_recorder *g_workload_recorder = NULL;
+
+template<class T> static void put( std::vector<unsigned char> &buf, const T &v )
+{
+   const unsigned char *p = (const unsigned char*)&v;
+   buf.insert(buf.end(),p,p+sizeof(T));
+}
+
+static void put_bytes( std::vector<unsigned char> &buf, const void *data, size_t size )
+{
+   const unsigned char *p = (const unsigned char*)data;
+   buf.insert(buf.end(),p,p+size);
+}
+
+workload_recorder::workload_recorder( const char *filename, const gpgpu_t *gpu )
+{
+   m_gpu = gpu;
+   pthread_mutex_init(&m_lock,NULL);
+   m_fp = fopen(filename,"wb");
+   if (!m_fp) {
+      printf("GPGPU-Sim uArch: ERROR ** cannot create workload log '%s'\n", filename);
+      exit(1);
+   }
+   char magic[8];
+   ::memset(magic,0,sizeof(magic));
+   strncpy(magic,WORKLOAD_MAGIC,sizeof(magic)-1);
+   unsigned version = WORKLOAD_VERSION;
+   fwrite(magic,sizeof(magic),1,m_fp);
+   fwrite(&version,sizeof(version),1,m_fp);
+   printf("GPGPU-Sim uArch: recording workload to '%s'\n", filename);
+}
+
+workload_recorder::~workload_recorder()
+{
+   fclose(m_fp);
+   pthread_mutex_destroy(&m_lock);
+}
+
+void workload_recorder::record( workload_record_type type, const std::vector<unsigned char> &payload )
+{
+   workload_record_header h;
+   h.type = type;
+   h.reserved = 0;
+   h.size = payload.size();
+   pthread_mutex_lock(&m_lock);
+   fwrite(&h,sizeof(h),1,m_fp);
+   if (!payload.empty()) 
+      fwrite(&payload[0],1,payload.size(),m_fp);
+   // the application may never shut the simulator down cleanly
+   fflush(m_fp);
+   pthread_mutex_unlock(&m_lock);
+}
+
+void workload_recorder::module( unsigned source_num, const char *ptx )
+{
+   std::vector<unsigned char> buf;
+   put(buf,source_num);
+   put_bytes(buf,ptx,strlen(ptx));
+   record(WKLD_MODULE,buf);
+}
+
+void workload_recorder::write( unsigned long long addr, size_t size, const void *data )
+{
+   std::vector<unsigned char> buf;
+   put(buf,addr);
+   put_bytes(buf,data,size);
+   record(WKLD_WRITE,buf);
+}
+
+void workload_recorder::memset( unsigned long long addr, unsigned value, size_t count )
+{
+   std::vector<unsigned char> buf;
+   put(buf,addr);
+   put(buf,(unsigned long long)count);
+   put(buf,value);
+   record(WKLD_MEMSET,buf);
+}
+
+void workload_recorder::copy( unsigned long long dst, unsigned long long src, size_t count )
+{
+   std::vector<unsigned char> buf;
+   put(buf,dst);
+   put(buf,src);
+   put(buf,(unsigned long long)count);
+   record(WKLD_COPY,buf);
+}
+
+void workload_recorder::launch( kernel_info_t *kernel )
+{
+   function_info *entry = kernel->entry();
+   std::vector<unsigned char> buf;
+   put(buf,kernel->get_launch_index());
+   std::string name = kernel->name();
+   put(buf,(unsigned)name.size());
+   put_bytes(buf,name.data(),name.size());
+   dim3 grid = kernel->get_grid_dim();
+   dim3 block = kernel->get_cta_dim();
+   unsigned dims[6] = { grid.x, grid.y, grid.z, block.x, block.y, block.z };
+   put_bytes(buf,dims,sizeof(dims));
+   put(buf,*entry->get_kernel_info());
+
+   std::vector<function_info::param_layout> layout;
+   entry->get_param_layout(layout);
+   put(buf,(unsigned)layout.size());
+   memory_space *param_mem = kernel->get_param_memory();
+   for (unsigned i=0; i < layout.size(); i++) {
+      std::vector<unsigned char> data(layout[i].size);
+      if (!data.empty()) 
+         param_mem->read(layout[i].address,data.size(),&data[0]);
+      put(buf,layout[i].index);
+      put(buf,(unsigned)data.size());
+      put_bytes(buf,data.empty() ? NULL : &data[0],data.size());
+   }
+   record(WKLD_LAUNCH,buf);
+}
+
+// bounds-checked reader of one record's payload
+class payload_reader {
+public:
+   payload_reader( const std::vector<unsigned char> &buf ) : m_buf(buf), m_pos(0), m_ok(true) {}
+   template<class T> T get()
+   {
+      T v;
+      memset(&v,0,sizeof(v));
+      get_bytes(&v,sizeof(T));
+      return v;
+   }
+   void get_bytes( void *dst, size_t size )
+   {
+      if (m_pos + size > m_buf.size()) {
+         m_ok = false;
+         return;
+      }
+      if (size) 
+         memcpy(dst,&m_buf[m_pos],size);
+      m_pos += size;
+   }
+   size_t left() const { return m_buf.size() - m_pos; }
+   bool ok() const { return m_ok; }
+private:
+   const std::vector<unsigned char> &m_buf;
+   size_t m_pos;
+   bool m_ok;
+};
+
+bool read_workload_log( const char *filename, std::vector<workload_op> &ops )
+{
+   FILE *fp = fopen(filename,"rb");
+   if (!fp) {
+      printf("GPGPU-Sim: ERROR ** cannot open workload log '%s'\n", filename);
+      return false;
+   }
+   char magic[8];
+   unsigned version = 0;
+   if (fread(magic,sizeof(magic),1,fp) != 1 || strncmp(magic,WORKLOAD_MAGIC,sizeof(magic)) || 
+       fread(&version,sizeof(version),1,fp) != 1 || version != WORKLOAD_VERSION) {
+      printf("GPGPU-Sim: ERROR ** '%s' is not a version %u workload log\n", filename, WORKLOAD_VERSION);
+      fclose(fp);
+      return false;
+   }
+   bool ok = true;
+   workload_record_header h;
+   std::vector<unsigned char> buf;
+   while (fread(&h,sizeof(h),1,fp) == 1) {
+      buf.resize(h.size);
+      if (h.size && fread(&buf[0],1,h.size,fp) != h.size) {
+         ok = false;
+         break;
+      }
+      payload_reader r(buf);
+      workload_op op;
+      op.type = (workload_record_type)h.type;
+      op.addr = op.src = op.count = 0;
+      op.value = op.source_num = op.launch = 0;
+      memset(&op.kinfo,0,sizeof(op.kinfo));
+      switch (h.type) {
+      case WKLD_MODULE:
+         op.source_num = r.get<unsigned>();
+         op.text.resize(r.left());
+         r.get_bytes(&op.text[0],op.text.size());
+         break;
+      case WKLD_WRITE:
+         op.addr = r.get<unsigned long long>();
+         op.data.resize(r.left());
+         r.get_bytes(op.data.empty() ? NULL : &op.data[0],op.data.size());
+         break;
+      case WKLD_MEMSET:
+         op.addr = r.get<unsigned long long>();
+         op.count = r.get<unsigned long long>();
+         op.value = r.get<unsigned>();
+         break;
+      case WKLD_COPY:
+         op.addr = r.get<unsigned long long>();
+         op.src = r.get<unsigned long long>();
+         op.count = r.get<unsigned long long>();
+         break;
+      case WKLD_LAUNCH: {
+         op.launch = r.get<unsigned>();
+         unsigned len = r.get<unsigned>();
+         if (len > r.left()) {
+            ok = false;
+            break;
+         }
+         op.text.resize(len);
+         r.get_bytes(&op.text[0],len);
+         unsigned dims[6];
+         r.get_bytes(dims,sizeof(dims));
+         op.grid.x = dims[0];
+         op.grid.y = dims[1];
+         op.grid.z = dims[2];
+         op.block.x = dims[3];
+         op.block.y = dims[4];
+         op.block.z = dims[5];
+         op.kinfo = r.get<gpgpu_ptx_sim_kernel_info>();
+         unsigned n_args = r.get<unsigned>();
+         for (unsigned i=0; i < n_args && r.ok(); i++) {
+            workload_arg a;
+            a.index = r.get<unsigned>();
+            unsigned size = r.get<unsigned>();
+            if (size > r.left()) {
+               ok = false;
+               break;
+            }
+            a.data.resize(size);
+            r.get_bytes(a.data.empty() ? NULL : &a.data[0],size);
+            op.args.push_back(a);
+         }
+         break;
+      }
+      default:
+         printf("GPGPU-Sim: ERROR ** unknown record type %u in workload log '%s'\n", h.type, filename);
+         fclose(fp);
+         return false;
+      }
+      if (!ok || !r.ok()) {
+         ok = false;
+         break;
+      }
+      ops.push_back(op);
+   }
+   fclose(fp);
+   if (!ok) 
+      printf("GPGPU-Sim: ERROR ** workload log '%s' is truncated\n", filename);
+   return ok;
+}
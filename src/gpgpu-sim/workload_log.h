@@ -0,0 +1,129 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef WORKLOAD_LOG_H_INCLUDED
+#define WORKLOAD_LOG_H_INCLUDED
+
+#include <stdio.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+#include "../abstract_hardware_model.h"
+
+// Recorded workloads (-gpgpu_record_workload <file>).
+//
+// The log holds everything the device sees of an application, in the order
+// the device sees it: the PTX of every module as it is parsed, every write
+// to device memory (memcpy to device or to a symbol, memset, device to
+// device copy, initializers of module globals and constants) and every
+// kernel launch with its grid, block, resource usage and argument bytes.
+// Addresses are device addresses, so a workload replays without cudaMalloc
+// as long as its modules are parsed again in the recorded order.  Only the
+// first simulated device is recorded; texture bindings are not recorded.
+//
+// File layout (host byte order):
+//   "GPUWKLD\0", u32 version
+//   records: workload_record_header, then size bytes of payload
+//     WKLD_MODULE  u32 source_num, PTX text
+//     WKLD_WRITE   u64 addr, data
+//     WKLD_MEMSET  u64 addr, u64 count, u32 value
+//     WKLD_COPY    u64 dst, u64 src, u64 count
+//     WKLD_LAUNCH  u32 launch index, u32 name length, name, u32 grid[3],
+//                  u32 block[3],
+//                  gpgpu_ptx_sim_kernel_info, u32 n_args,
+//                  n_args x (u32 param index, u32 size, size bytes)
+
+#define WORKLOAD_MAGIC "GPUWKLD"
+#define WORKLOAD_VERSION 2
+
+enum workload_record_type {
+   WKLD_MODULE = 1,
+   WKLD_WRITE,
+   WKLD_MEMSET,
+   WKLD_COPY,
+   WKLD_LAUNCH
+};
+
+struct workload_record_header {
+   unsigned type;
+   unsigned reserved;
+   unsigned long long size;
+};
+
+// one kernel argument as passed to function_info::add_param_data
+struct workload_arg {
+   unsigned index;
+   std::vector<unsigned char> data;
+};
+
+// one decoded record; the fields used depend on type
+struct workload_op {
+   workload_record_type type;
+   unsigned long long addr;        // WRITE, MEMSET, COPY (destination)
+   unsigned long long src;         // COPY
+   unsigned long long count;       // MEMSET, COPY
+   unsigned value;                 // MEMSET
+   unsigned source_num;            // MODULE
+   unsigned launch;                // LAUNCH: launch index on the recorded device
+   std::string text;               // MODULE: PTX, LAUNCH: kernel name
+   std::vector<unsigned char> data; // WRITE
+   dim3 grid, block;                // LAUNCH
+   gpgpu_ptx_sim_kernel_info kinfo; // LAUNCH
+   std::vector<workload_arg> args;  // LAUNCH
+};
+
+class workload_recorder {
+public:
+   workload_recorder( const char *filename, const gpgpu_t *gpu );
+   ~workload_recorder();
+
+   // only operations on the recorded device are logged
+   bool records( const gpgpu_t *gpu ) const { return gpu == m_gpu; }
+
+   void module( unsigned source_num, const char *ptx );
+   void write( unsigned long long addr, size_t size, const void *data );
+   void memset( unsigned long long addr, unsigned value, size_t count );
+   void copy( unsigned long long dst, unsigned long long src, size_t count );
+   void launch( kernel_info_t *kernel );
+
+private:
+   void record( workload_record_type type, const std::vector<unsigned char> &payload );
+
+   FILE *m_fp;
+   const gpgpu_t *m_gpu;
+   pthread_mutex_t m_lock; // host thread and simulation thread both record
+};
+
+// NULL unless -gpgpu_record_workload is set
+extern workload_recorder *g_workload_recorder;
+
+// read a recorded workload; returns false (with a message) if the file is
+// missing, not a workload log or truncated
+bool read_workload_log( const char *filename, std::vector<workload_op> &ops );
+
+#endif
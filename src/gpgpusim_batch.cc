@@ -0,0 +1,240 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gpgpusim_batch.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <sstream>
+
+#include "gpgpusim_entrypoint.h"
+#include "cuda-sim/cuda-sim.h"
+#include "cuda-sim/ptx_ir.h"
+#include "cuda-sim/ptx_loader.h"
+#include "cuda-sim/ptx-stats.h"
+#include "gpgpu-sim/gpu-sim.h"
+#include "gpgpu-sim/icnt_wrapper.h"
+#include "gpgpu-sim/stat-tool.h"
+
+// function_info::add_param_data() stages a launch's arguments in the shared
+// IR until finalize() copies them to the kernel's parameter memory; the
+// kernel_info_t constructor also reads and updates the shared entry point
+static pthread_mutex_t g_batch_ir_lock = PTHREAD_MUTEX_INITIALIZER;
+
+bool gpgpusim_workload::load( const char *filename )
+{
+   assert( !m_loaded );
+   if( !read_workload_log(filename,m_ops) ) 
+      return false;
+   print_splash();
+
+   std::vector<symbol_table*> modules;
+   for( unsigned n=0; n < m_ops.size(); n++ ) {
+      const workload_op &op = m_ops[n];
+      if( op.type == WKLD_MODULE ) {
+         modules.push_back( gpgpu_ptx_sim_load_ptx_from_string(op.text.c_str(),op.source_num) );
+      } else if( op.type == WKLD_LAUNCH && m_kernels.find(op.text) == m_kernels.end() ) {
+         function_info *entry = NULL;
+         for( unsigned m=0; m < modules.size() && !entry; m++ ) {
+            symbol *s = modules[m]->lookup(op.text.c_str());
+            if( s ) 
+               entry = s->get_pc();
+         }
+         if( !entry ) {
+            printf("GPGPU-Sim: workload %s launches kernel '%s' that no module defines\n", filename, op.text.c_str());
+            return false;
+         }
+         entry->set_kernel_info(op.kinfo);
+         m_kernels[op.text] = entry;
+      }
+   }
+   printf("GPGPU-Sim: workload %s: %zu records, %zu modules, %zu kernels\n", filename, m_ops.size(), modules.size(), m_kernels.size());
+   m_loaded = true;
+   return true;
+}
+
+function_info *gpgpusim_workload::kernel( const std::string &name ) const
+{
+   std::map<std::string,function_info*>::const_iterator k = m_kernels.find(name);
+   return k == m_kernels.end() ? NULL : k->second;
+}
+
+gpgpusim_batch::gpgpusim_batch( const gpgpusim_workload &workload, unsigned n_threads )
+   : m_workload(workload), m_n_threads(n_threads ? n_threads : 1), m_next(0)
+{
+   pthread_mutex_init(&m_lock,NULL);
+}
+
+void gpgpusim_batch::add_config( const std::string &config_file, const std::string &options )
+{
+   config cfg;
+   cfg.file = config_file;
+   cfg.options = options;
+   m_configs.push_back(cfg);
+}
+
+void *gpgpusim_batch::worker( void *arg )
+{
+   gpgpusim_batch *batch = (gpgpusim_batch*)arg;
+   while( 1 ) {
+      pthread_mutex_lock(&batch->m_lock);
+      unsigned n = batch->m_next++;
+      pthread_mutex_unlock(&batch->m_lock);
+      if( n >= batch->m_configs.size() ) 
+         break;
+      g_sim_output_id = n;
+      batch->simulate(batch->m_configs[n],batch->m_results[n]);
+   }
+   return NULL;
+}
+
+std::vector<gpgpusim_run_result> gpgpusim_batch::run()
+{
+   m_results.clear();
+   m_results.resize(m_configs.size());
+   m_next = 0;
+
+   unsigned n_threads = m_n_threads < m_configs.size() ? m_n_threads : m_configs.size();
+   if( n_threads > 1 ) 
+      icnt_set_shared(true);
+   std::vector<pthread_t> threads(n_threads);
+   for( unsigned t=0; t < n_threads; t++ ) 
+      pthread_create(&threads[t],NULL,worker,this);
+   for( unsigned t=0; t < n_threads; t++ ) 
+      pthread_join(threads[t],NULL);
+   return m_results;
+}
+
+kernel_info_t *gpgpusim_batch::build_kernel( const workload_op &op )
+{
+   function_info *entry = m_workload.kernel(op.text);
+   assert( entry );
+   pthread_mutex_lock(&g_batch_ir_lock);
+   kernel_info_t *kernel = new kernel_info_t(op.grid,op.block,entry);
+   // as recorded, so launch ranges select the same kernels in every configuration
+   kernel->set_launch_index(op.launch);
+   for( unsigned a=0; a < op.args.size(); a++ ) {
+      const workload_arg &arg = op.args[a];
+      gpgpu_ptx_sim_arg param(&arg.data[0],arg.data.size(),0);
+      entry->add_param_data(arg.index,&param);
+   }
+   entry->finalize(kernel->get_param_memory());
+   pthread_mutex_unlock(&g_batch_ir_lock);
+   return kernel;
+}
+
+void gpgpusim_batch::simulate( const config &cfg, gpgpusim_run_result &result )
+{
+   result.config_file = cfg.file;
+   result.options = cfg.options;
+   result.tot_cycles = 0;
+   result.tot_insn = 0;
+
+   // command line: -config <file> followed by the extra options
+   std::vector<std::string> tokens;
+   tokens.push_back("gpgpusim_batch");
+   tokens.push_back("-config");
+   tokens.push_back(cfg.file);
+   std::istringstream in(cfg.options);
+   std::string tok;
+   while( in >> tok ) 
+      tokens.push_back(tok);
+   std::vector<const char*> argv;
+   for( unsigned n=0; n < tokens.size(); n++ ) 
+      argv.push_back(tokens[n].c_str());
+
+   // the statistics loggers are per thread, and this thread may have run another configuration
+   stat_tool_reset();
+   ptx_file_line_stats_reset();
+
+   gpgpu_sim_config *config = new gpgpu_sim_config(); // the simulator keeps a reference, deleted after it
+   gpgpu_sim *gpu = gpgpu_ptx_sim_create_gpu(*config,argv.size(),&argv[0]);
+
+   const std::vector<workload_op> &ops = m_workload.ops();
+   for( unsigned n=0; n < ops.size(); n++ ) {
+      const workload_op &op = ops[n];
+      switch( op.type ) {
+      case WKLD_MODULE: 
+         break;
+      case WKLD_WRITE: 
+         gpu->memcpy_to_gpu(op.addr,&op.data[0],op.data.size());
+         break;
+      case WKLD_MEMSET: 
+         gpu->gpu_memset(op.addr,op.value,op.count);
+         break;
+      case WKLD_COPY: 
+         gpu->memcpy_gpu_to_gpu(op.addr,op.src,op.count);
+         break;
+      case WKLD_LAUNCH: {
+         kernel_info_t *kernel = build_kernel(op);
+         gpgpusim_kernel_stats stats;
+         stats.name = op.text;
+         stats.launch = kernel->get_launch_index();
+         stats.timing = gpu->timing_simulate_kernel(kernel);
+         stats.cycles = stats.insn = 0;
+         stats.ipc = 0;
+         stats.l2_accesses = stats.l2_misses = stats.dram_reads = stats.dram_writes = 0;
+         if( stats.timing ) {
+            unsigned long long l2_accesses, l2_misses, dram_reads, dram_writes;
+            gpu->init();
+            gpu->get_memory_totals(l2_accesses,l2_misses,dram_reads,dram_writes);
+            gpu->launch(kernel);
+            while( gpu->active() ) {
+               gpu->cycle();
+               gpu->deadlock_check();
+            }
+            gpu->print_stats();
+            stats.cycles = gpu_sim_cycle;
+            stats.insn = gpu->gpu_sim_insn;
+            stats.ipc = stats.cycles ? (double)stats.insn / stats.cycles : 0;
+            gpu->get_memory_totals(stats.l2_accesses,stats.l2_misses,stats.dram_reads,stats.dram_writes);
+            stats.l2_accesses -= l2_accesses;
+            stats.l2_misses -= l2_misses;
+            stats.dram_reads -= dram_reads;
+            stats.dram_writes -= dram_writes;
+            gpu->update_stats();
+            while( gpu->finished_kernel() ) 
+               ;
+         } else {
+            gpgpu_cuda_ptx_sim_main_func(*kernel,true);
+         }
+         delete kernel;
+         result.kernels.push_back(stats);
+         break;
+      }
+      default: 
+         assert(0);
+      }
+   }
+   result.tot_cycles = gpu_tot_sim_cycle;
+   result.tot_insn = gpu->gpu_tot_sim_insn;
+   delete gpu; // closes its output files
+   g_the_gpu = NULL;
+   delete config;
+   fflush(stdout);
+}
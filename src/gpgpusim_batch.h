@@ -0,0 +1,124 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef GPGPUSIM_BATCH_H_INCLUDED
+#define GPGPUSIM_BATCH_H_INCLUDED
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gpgpu-sim/workload_log.h"
+
+// Batch simulation of a recorded workload (see gpgpu-sim/workload_log.h)
+// under many configurations, for design-space sweeps.
+//
+//    gpgpusim_workload w;
+//    w.load("app.wkld");
+//    gpgpusim_batch b(w,4);
+//    b.add_config("gpgpusim.config","-gpgpu_n_clusters 8");
+//    b.add_config("gpgpusim.config","-gpgpu_n_clusters 16");
+//    std::vector<gpgpusim_run_result> r = b.run();
+//
+// The workload is read and its PTX parsed once; every configuration then
+// gets its own gpgpu_sim, built and simulated on one of the batch's worker
+// threads, and the parsed IR is shared by all of them.  A simulator and its
+// configuration are deleted after their run.  When configurations use
+// intersim2 they must all name the same -inter_config_file, and since
+// intersim2 keeps its topology and flit pools in globals, every interconnect
+// call of every running configuration takes one process-wide lock: such
+// configurations overlap only outside the interconnect.  -network_mode 2 is
+// fully per simulator and runs concurrently.  Simulator output of concurrent
+// runs is interleaved on stdout.
+
+struct gpgpusim_kernel_stats {
+   std::string name;
+   unsigned launch;                // launch index in the recorded workload
+   bool timing;                    // false: executed functionally only
+   unsigned long long cycles;
+   unsigned long long insn;
+   double ipc;
+   unsigned long long l2_accesses; // during this kernel
+   unsigned long long l2_misses;
+   unsigned long long dram_reads;
+   unsigned long long dram_writes;
+};
+
+struct gpgpusim_run_result {
+   std::string config_file;
+   std::string options;
+   unsigned long long tot_cycles;
+   unsigned long long tot_insn;
+   std::vector<gpgpusim_kernel_stats> kernels;
+};
+
+class gpgpusim_workload {
+public:
+   gpgpusim_workload() : m_loaded(false) {}
+
+   // read the log and parse its modules; false if the log cannot be read
+   bool load( const char *filename );
+
+   const std::vector<workload_op> &ops() const { return m_ops; }
+   // entry point of a recorded kernel; NULL if no module defines it
+   class function_info *kernel( const std::string &name ) const;
+
+private:
+   bool m_loaded;
+   std::vector<workload_op> m_ops;
+   std::map<std::string,class function_info*> m_kernels;
+};
+
+class gpgpusim_batch {
+public:
+   gpgpusim_batch( const gpgpusim_workload &workload, unsigned n_threads );
+
+   // options are given as on the command line, e.g. "-gpgpu_n_clusters 8"
+   void add_config( const std::string &config_file, const std::string &options = "" );
+
+   // simulate the workload under every configuration; results are in
+   // add_config() order
+   std::vector<gpgpusim_run_result> run();
+
+private:
+   struct config {
+      std::string file;
+      std::string options;
+   };
+   static void *worker( void *arg );
+   void simulate( const config &cfg, gpgpusim_run_result &result );
+   class kernel_info_t *build_kernel( const workload_op &op );
+
+   const gpgpusim_workload &m_workload;
+   unsigned m_n_threads;
+   std::vector<config> m_configs;
+   std::vector<gpgpusim_run_result> m_results;
+   unsigned m_next; // next configuration to simulate
+   pthread_mutex_t m_lock;
+};
+
+#endif
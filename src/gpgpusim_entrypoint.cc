@@ -38,6 +38,8 @@
 
 #include <pthread.h>
 #include <semaphore.h>
+#include <unistd.h>
+#include <vector>
 
 #define MAX(a,b) (((a)>(b))?(a):(b))
 
@@ -45,15 +47,40 @@
 
 struct gpgpu_ptx_sim_arg *grid_params;
 
-sem_t g_sim_signal_start;
-sem_t g_sim_signal_finish;
-sem_t g_sim_signal_exit;
-time_t g_simulation_starttime;
-pthread_t g_simulation_thread;
-
-gpgpu_sim_config g_the_gpu_config;
-gpgpu_sim *g_the_gpu;
-stream_manager *g_stream_manager;
+// One simulated GPU: its own configuration, timing model, stream manager and
+// simulation thread.  The device is built on its simulation thread, so the
+// thread-local simulator state (cycle counters, interconnect, uid counters)
+// belongs to it and devices simulate in parallel with each other.
+struct gpgpu_device {
+   unsigned m_id;
+   gpgpu_sim_config m_config;
+   gpgpu_sim *m_gpu;
+   stream_manager *m_stream_manager;
+   time_t m_starttime;
+
+   pthread_t m_thread;
+   pthread_mutex_t m_lock;
+   pthread_cond_t m_cond;  // signaled when m_ready, m_api or m_active change
+   bool m_ready;           // m_gpu and m_stream_manager are constructed
+   int m_api;              // simulation loop requested by start_sim_thread (0 = none)
+   bool m_active;
+   bool m_done;
+
+   sem_t m_signal_start;   // kernel handshake of the sequential (OpenCL) loop
+   sem_t m_signal_finish;
+   sem_t m_signal_exit;
+};
+
+static std::vector<gpgpu_device*> g_devices;
+static pthread_mutex_t g_device_init_lock = PTHREAD_MUTEX_INITIALIZER; // option parsing is not reentrant
+
+// the device the calling thread currently simulates on or issues work to
+static __thread gpgpu_device *t_device = NULL;
+__thread time_t g_simulation_starttime;
+__thread unsigned g_sim_output_id = 0;
+static __thread char g_sim_output_suffix[32];
+__thread gpgpu_sim *g_the_gpu;
+__thread stream_manager *g_stream_manager;
 
 
 
@@ -64,54 +91,114 @@ static const char *sg_argv[] = {"", "-config","gpgpusim.config"};
 
 static void print_simulation_time();
 
-void *gpgpu_sim_thread_sequential(void*)
+// Simulation threads count themselves in g_sim_threads_running while they
+// simulate and test g_pause_requested between cycles, a plain load.  A
+// pausing thread raises the flag and waits for the count to drop to zero;
+// either it sees a simulation thread's increment or that thread sees the
+// flag, as both sides use full barriers.
+static volatile bool g_pause_requested = false;
+static volatile unsigned g_sim_threads_running = 0;
+static pthread_mutex_t g_pause_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_pause_cond = PTHREAD_COND_INITIALIZER; // signaled when either changes
+
+static void sim_step_end()
+{
+   __sync_sub_and_fetch(&g_sim_threads_running,1);
+   if( g_pause_requested ) {
+      pthread_mutex_lock(&g_pause_lock);
+      pthread_cond_broadcast(&g_pause_cond);
+      pthread_mutex_unlock(&g_pause_lock);
+   }
+}
+
+static void sim_step_begin()
+{
+   __sync_add_and_fetch(&g_sim_threads_running,1);
+   while( g_pause_requested ) {
+      sim_step_end();
+      pthread_mutex_lock(&g_pause_lock);
+      while( g_pause_requested ) 
+         pthread_cond_wait(&g_pause_cond,&g_pause_lock);
+      pthread_mutex_unlock(&g_pause_lock);
+      __sync_add_and_fetch(&g_sim_threads_running,1);
+   }
+}
+
+// between two cycles of a simulation thread
+static void sim_step_pause_point()
+{
+   if( g_pause_requested ) {
+      sim_step_end();
+      sim_step_begin();
+   }
+}
+
+void gpgpu_ptx_sim_pause_devices()
+{
+   pthread_mutex_lock(&g_pause_lock);
+   assert( !g_pause_requested );
+   g_pause_requested = true;
+   __sync_synchronize();
+   while( g_sim_threads_running ) 
+      pthread_cond_wait(&g_pause_cond,&g_pause_lock);
+   pthread_mutex_unlock(&g_pause_lock);
+}
+
+void gpgpu_ptx_sim_resume_devices()
+{
+   pthread_mutex_lock(&g_pause_lock);
+   g_pause_requested = false;
+   pthread_cond_broadcast(&g_pause_cond);
+   pthread_mutex_unlock(&g_pause_lock);
+}
+
+static void gpgpu_sim_thread_sequential(gpgpu_device *dev)
 {
    // at most one kernel running at a time
    bool done;
    do {
-      sem_wait(&g_sim_signal_start);
+      sem_wait(&dev->m_signal_start);
       done = true;
       if( g_the_gpu->get_more_cta_left() ) {
           done = false;
+          sim_step_begin();
           g_the_gpu->init();
           while( g_the_gpu->active() ) {
               g_the_gpu->cycle();
               g_the_gpu->deadlock_check();
+              sim_step_pause_point();
           }
+          sim_step_end();
           g_the_gpu->print_stats();
           g_the_gpu->update_stats();
           print_simulation_time();
       }
-      sem_post(&g_sim_signal_finish);
+      sem_post(&dev->m_signal_finish);
    } while(!done);
-   sem_post(&g_sim_signal_exit);
-   return NULL;
+   g_the_gpu->close_output_files();
+   sem_post(&dev->m_signal_exit);
 }
 
-pthread_mutex_t g_sim_lock = PTHREAD_MUTEX_INITIALIZER;
-bool g_sim_active = false;
-bool g_sim_done = true;
-
-void *gpgpu_sim_thread_concurrent(void*)
+static void gpgpu_sim_thread_concurrent(gpgpu_device *dev)
 {
     // concurrent kernel execution simulation thread
     do {
        if(g_debug_execution >= 3) {
-          printf("GPGPU-Sim: *** simulation thread starting and spinning waiting for work ***\n");
+          printf("GPGPU-Sim: *** simulation thread %u starting and waiting for work ***\n", dev->m_id);
           fflush(stdout);
        }
-        while( g_stream_manager->empty_protected() && !g_sim_done )
-            ;
+        g_stream_manager->wait_for_work(&dev->m_done);
         if(g_debug_execution >= 3) {
-           printf("GPGPU-Sim: ** START simulation thread (detected work) **\n");
+           printf("GPGPU-Sim: ** START simulation thread %u (detected work) **\n", dev->m_id);
            g_stream_manager->print(stdout);
            fflush(stdout);
         }
-        pthread_mutex_lock(&g_sim_lock);
-        g_sim_active = true;
-        pthread_mutex_unlock(&g_sim_lock);
+        pthread_mutex_lock(&dev->m_lock);
+        dev->m_active = true;
+        pthread_mutex_unlock(&dev->m_lock);
         bool active = false;
         bool sim_cycles = false;
+        sim_step_begin();
         g_the_gpu->init();
         do {
             // check if a kernel has completed
@@ -132,98 +219,248 @@ void *gpgpu_sim_thread_concurrent(void*)
                 sim_cycles = true;
                 g_the_gpu->deadlock_check();
             }
-            active=g_the_gpu->active() || !g_stream_manager->empty_protected();
+            active=g_the_gpu->active() || !g_stream_manager->empty();
+            sim_step_pause_point();
         } while( active );
         if(g_debug_execution >= 3) {
-           printf("GPGPU-Sim: ** STOP simulation thread (no work) **\n");
+           printf("GPGPU-Sim: ** STOP simulation thread %u (no work) **\n", dev->m_id);
            fflush(stdout);
         }
         if(sim_cycles) {
             g_the_gpu->update_stats();
             print_simulation_time();
         }
-        pthread_mutex_lock(&g_sim_lock);
-        g_sim_active = false;
-        pthread_mutex_unlock(&g_sim_lock);
-    } while( !g_sim_done );
+        sim_step_end();
+        pthread_mutex_lock(&dev->m_lock);
+        dev->m_active = false;
+        pthread_cond_broadcast(&dev->m_cond);
+        pthread_mutex_unlock(&dev->m_lock);
+    } while( !dev->m_done );
     if(g_debug_execution >= 3) {
-       printf("GPGPU-Sim: *** simulation thread exiting ***\n");
+       printf("GPGPU-Sim: *** simulation thread %u exiting ***\n", dev->m_id);
        fflush(stdout);
     }
-    sem_post(&g_sim_signal_exit);
-    return NULL;
+    // the output files are owned by the simulator of this thread
+    g_the_gpu->close_output_files();
+    sem_post(&dev->m_signal_exit);
+}
+
+extern bool g_cuda_launch_blocking;
+
+gpgpu_sim *gpgpu_ptx_sim_create_gpu( gpgpu_sim_config &config, int argc, const char *argv[] )
+{
+   pthread_mutex_lock(&g_device_init_lock);
+   option_parser_t opp = option_parser_create();
+
+   icnt_reg_options(opp);
+   config.reg_options(opp); // register GPU microrachitecture options
+   ptx_reg_options(opp);
+   ptx_opcocde_latency_options(opp);
+   option_parser_cmdline(opp, argc, argv); // parse configuration options
+   if( config.get_kernel_workers() && gpgpu_ptx_sim_num_devices() > 1 ) {
+      // worker processes are reaped with waitpid(-1), which cannot tell devices apart
+      printf("GPGPU-Sim: ERROR ** -gpgpu_kernel_workers cannot be used with more than one simulated device (GPGPUSIM_NUM_DEVICES)\n");
+      exit(1);
+   }
+   fprintf(stdout, "GPGPU-Sim: Configuration options:\n\n");
+   option_parser_print(opp, stdout);
+   // Set the Numeric locale to a standard locale where a decimal point is a "dot" not a "comma"
+   // so it does the parsing correctly independent of the system environment variables
+   assert(setlocale(LC_NUMERIC,"C"));
+   config.init();
+
+   g_the_gpu = new gpgpu_sim(config);
+   pthread_mutex_unlock(&g_device_init_lock);
+
+   g_simulation_starttime = time((time_t *)NULL);
+   return g_the_gpu;
+}
+
+// parse the configuration of a device and build its simulator; runs on the
+// device's simulation thread
+static void gpgpu_device_init(gpgpu_device *dev)
+{
+   // device N may be given its own configuration in gpgpusim.config.N
+   char config_file[64];
+   snprintf(config_file,sizeof(config_file),"%s.%u",sg_argv[2],dev->m_id);
+   const char *argv[] = {sg_argv[0], sg_argv[1], sg_argv[2]};
+   if( dev->m_id > 0 && access(config_file,R_OK) == 0 )
+      argv[2] = config_file;
+   printf("GPGPU-Sim: configuring device %u from %s\n", dev->m_id, argv[2]);
+   g_sim_output_id = dev->m_id;
+
+   gpgpu_ptx_sim_create_gpu(dev->m_config, sg_argc, argv);
+   g_stream_manager = new stream_manager(g_the_gpu,g_cuda_launch_blocking);
+
+   t_device = dev;
+   dev->m_gpu = g_the_gpu;
+   dev->m_stream_manager = g_stream_manager;
+   dev->m_starttime = g_simulation_starttime;
+}
+
+static void *gpgpu_device_thread(void *arg)
+{
+   gpgpu_device *dev = (gpgpu_device*)arg;
+   gpgpu_device_init(dev);
+
+   pthread_mutex_lock(&dev->m_lock);
+   dev->m_ready = true;
+   pthread_cond_broadcast(&dev->m_cond);
+   // the thread outlives exit_simulation so that a later start_sim_thread
+   // resumes with the same thread-local simulator state
+   while( true ) {
+      while( dev->m_api == 0 )
+         pthread_cond_wait(&dev->m_cond,&dev->m_lock);
+      int api = dev->m_api;
+      dev->m_api = 0;
+      pthread_mutex_unlock(&dev->m_lock);
+      if( api == 1 )
+         gpgpu_sim_thread_concurrent(dev);
+      else
+         gpgpu_sim_thread_sequential(dev);
+      pthread_mutex_lock(&dev->m_lock);
+   }
+   return NULL;
+}
+
+static gpgpu_device *current_device()
+{
+   // host threads that never selected a device use device 0
+   if( t_device == NULL )
+      gpgpu_ptx_sim_set_device(0);
+   return t_device;
 }
 
 void synchronize()
 {
+    gpgpu_device *dev = current_device();
     printf("GPGPU-Sim: synchronize waiting for inactive GPU simulation\n");
     g_stream_manager->print(stdout);
     fflush(stdout);
-//    sem_wait(&g_sim_signal_finish);
-    bool done = false;
-    do {
-        pthread_mutex_lock(&g_sim_lock);
-        done = g_stream_manager->empty() && !g_sim_active;
-        pthread_mutex_unlock(&g_sim_lock);
-    } while (!done);
+    // the simulation thread only goes idle once all streams are empty
+    pthread_mutex_lock(&dev->m_lock);
+    while( !g_stream_manager->empty() || dev->m_active ) 
+        pthread_cond_wait(&dev->m_cond,&dev->m_lock);
+    pthread_mutex_unlock(&dev->m_lock);
     printf("GPGPU-Sim: detected inactive GPU simulation thread\n");
     fflush(stdout);
-//    sem_post(&g_sim_signal_start);
 }
 
 void exit_simulation()
 {
-    g_sim_done=true;
-    printf("GPGPU-Sim: exit_simulation called\n");
-    fflush(stdout);
-    sem_wait(&g_sim_signal_exit);
-    printf("GPGPU-Sim: simulation thread signaled exit\n");
-    fflush(stdout);
+    for( unsigned i=0; i < g_devices.size(); i++ ) {
+        gpgpu_device *dev = g_devices[i];
+        if( dev->m_done )
+            continue;
+        dev->m_done=true;
+        // an idle simulation thread sleeps in wait_for_work(), which tests
+        // m_done under the stream manager's lock; notify_all() broadcasts
+        // under that lock, so the thread wakes, leaves its loop and posts
+        // m_signal_exit
+        dev->m_stream_manager->notify_all();
+        printf("GPGPU-Sim: exit_simulation called\n");
+        fflush(stdout);
+        sem_wait(&dev->m_signal_exit);
+        printf("GPGPU-Sim: simulation thread %u signaled exit\n", i);
+        fflush(stdout);
+    }
 }
 
-extern bool g_cuda_launch_blocking;
-
 gpgpu_sim *gpgpu_ptx_sim_init_perf()
 {
    srand(1);
    print_splash();
    read_sim_environment_variables();
    read_parser_environment_variables();
-   option_parser_t opp = option_parser_create();
 
-   icnt_reg_options(opp);
-   g_the_gpu_config.reg_options(opp); // register GPU microrachitecture options
-   ptx_reg_options(opp);
-   ptx_opcocde_latency_options(opp);
-   option_parser_cmdline(opp, sg_argc, sg_argv); // parse configuration options
-   fprintf(stdout, "GPGPU-Sim: Configuration options:\n\n");
-   option_parser_print(opp, stdout);
-   // Set the Numeric locale to a standard locale where a decimal point is a "dot" not a "comma"
-   // so it does the parsing correctly independent of the system environment variables
-   assert(setlocale(LC_NUMERIC,"C"));
-   g_the_gpu_config.init();
+   unsigned num_devices = 1;
+   char *ndev = getenv("GPGPUSIM_NUM_DEVICES");
+   if( ndev && strlen(ndev) ) {
+      sscanf(ndev,"%u",&num_devices);
+      if( num_devices == 0 ) 
+         num_devices = 1;
+   }
+   printf("GPGPU-Sim: simulating %u device(s) (can change with GPGPUSIM_NUM_DEVICES environment variable)\n", num_devices);
+   icnt_set_shared( num_devices > 1 );
+
+   for( unsigned i=0; i < num_devices; i++ ) {
+      gpgpu_device *dev = new gpgpu_device;
+      dev->m_id = i;
+      dev->m_gpu = NULL;
+      dev->m_stream_manager = NULL;
+      pthread_mutex_init(&dev->m_lock,NULL);
+      pthread_cond_init(&dev->m_cond,NULL);
+      dev->m_ready = false;
+      dev->m_api = 0;
+      dev->m_active = false;
+      dev->m_done = true;
+      sem_init(&dev->m_signal_start,0,0);
+      sem_init(&dev->m_signal_finish,0,0);
+      sem_init(&dev->m_signal_exit,0,0);
+      g_devices.push_back(dev);
+   }
+   for( unsigned i=0; i < num_devices; i++ ) 
+      pthread_create(&g_devices[i]->m_thread,NULL,gpgpu_device_thread,g_devices[i]);
+   for( unsigned i=0; i < num_devices; i++ ) {
+      gpgpu_device *dev = g_devices[i];
+      pthread_mutex_lock(&dev->m_lock);
+      while( !dev->m_ready ) 
+         pthread_cond_wait(&dev->m_cond,&dev->m_lock);
+      pthread_mutex_unlock(&dev->m_lock);
+   }
+
+   gpgpu_ptx_sim_set_device(0);
+   return g_the_gpu;
+}
 
-   g_the_gpu = new gpgpu_sim(g_the_gpu_config);
-   g_stream_manager = new stream_manager(g_the_gpu,g_cuda_launch_blocking);
+std::string gpgpu_ptx_sim_output_filename( const char *name )
+{
+   std::string filename(name);
+   if( g_sim_output_id > 0 ) {
+      char suffix[16];
+      snprintf(suffix,sizeof(suffix),".%u",g_sim_output_id);
+      filename += suffix;
+   }
+   filename += g_sim_output_suffix;
+   return filename;
+}
 
-   g_simulation_starttime = time((time_t *)NULL);
+void gpgpu_ptx_sim_set_output_suffix( const char *suffix )
+{
+   snprintf(g_sim_output_suffix,sizeof(g_sim_output_suffix),"%s",suffix);
+}
 
-   sem_init(&g_sim_signal_start,0,0);
-   sem_init(&g_sim_signal_finish,0,0);
-   sem_init(&g_sim_signal_exit,0,0);
+unsigned gpgpu_ptx_sim_num_devices()
+{
+   return g_devices.size();
+}
 
-   return g_the_gpu;
+gpgpu_sim *gpgpu_ptx_sim_device( unsigned n )
+{
+   assert( n < g_devices.size() );
+   return g_devices[n]->m_gpu;
+}
+
+void gpgpu_ptx_sim_set_device( unsigned n )
+{
+   assert( n < g_devices.size() );
+   t_device = g_devices[n];
+   g_the_gpu = t_device->m_gpu;
+   g_stream_manager = t_device->m_stream_manager;
+   g_simulation_starttime = t_device->m_starttime;
 }
 
 void start_sim_thread(int api)
 {
-    if( g_sim_done ) {
-        g_sim_done = false;
-        if( api == 1 ) {
-           pthread_create(&g_simulation_thread,NULL,gpgpu_sim_thread_concurrent,NULL);
-        } else {
-           pthread_create(&g_simulation_thread,NULL,gpgpu_sim_thread_sequential,NULL);
+    for( unsigned i=0; i < g_devices.size(); i++ ) {
+        gpgpu_device *dev = g_devices[i];
+        pthread_mutex_lock(&dev->m_lock);
+        if( dev->m_done ) {
+            dev->m_done = false;
+            dev->m_api = api;
+            pthread_cond_broadcast(&dev->m_cond);
         }
+        pthread_mutex_unlock(&dev->m_lock);
     }
 }
 
@@ -242,15 +479,16 @@ void print_simulation_time()
    printf("\n\ngpgpu_simulation_time = %u days, %u hrs, %u min, %u sec (%u sec)\n",
           (unsigned)d, (unsigned)h, (unsigned)m, (unsigned)s, (unsigned)difference );
    printf("gpgpu_simulation_rate = %u (inst/sec)\n", (unsigned)(g_the_gpu->gpu_tot_sim_insn / difference) );
-   printf("gpgpu_simulation_rate = %u (cycle/sec)\n", (unsigned)(gpu_tot_sim_cycle / difference) );
+   printf("gpgpu_simulation_rate = %u (cycle/sec)\n", (unsigned)(g_the_gpu->tot_sim_cycle() / difference) );
    fflush(stdout);
 }
 
 int gpgpu_opencl_ptx_sim_main_perf( kernel_info_t *grid )
 {
+   gpgpu_device *dev = current_device();
    g_the_gpu->launch(grid);
-   sem_post(&g_sim_signal_start);
-   sem_wait(&g_sim_signal_finish);
+   sem_post(&dev->m_signal_start);
+   sem_wait(&dev->m_signal_finish);
    return 0;
 }
 
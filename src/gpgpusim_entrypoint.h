@@ -31,13 +31,44 @@
 #include "abstract_hardware_model.h"
 
 #include <time.h>
-extern time_t g_simulation_starttime;
+#include <string>
+
+// simulated device the calling thread is bound to: its simulation thread, or
+// for a host thread the device last selected with gpgpu_ptx_sim_set_device
+extern __thread time_t g_simulation_starttime;
+extern __thread class gpgpu_sim *g_the_gpu;
+extern __thread class stream_manager *g_stream_manager;
+
+// number of the simulator running on the calling thread: its device number, or
+// its configuration number in a gpgpusim_batch run
+extern __thread unsigned g_sim_output_id;
+
+// name of an output file written by the calling thread's simulator; simulators
+// other than the first get their own copy, e.g. gpgpu_inst_stats.txt.1
+std::string gpgpu_ptx_sim_output_filename( const char *name );
+// further suffix for the output files of the calling thread, used by forked
+// kernel workers so that they do not overwrite the files of their parent
+void gpgpu_ptx_sim_set_output_suffix( const char *suffix );
 
 
 
 class gpgpu_sim *gpgpu_ptx_sim_init_perf();
 void start_sim_thread(int api);
 
+// parse options from argv (e.g. "-config <file>") into config and build a
+// simulator with it on the calling thread, which becomes its simulation thread
+class gpgpu_sim *gpgpu_ptx_sim_create_gpu( class gpgpu_sim_config &config, int argc, const char *argv[] );
+
+unsigned gpgpu_ptx_sim_num_devices();
+class gpgpu_sim *gpgpu_ptx_sim_device( unsigned n );
+void gpgpu_ptx_sim_set_device( unsigned n );
+
+// hold the simulation threads of all devices between two cycles, for a host
+// thread changing state they share (loading a module on its first use);
+// calls must not nest
+void gpgpu_ptx_sim_pause_devices();
+void gpgpu_ptx_sim_resume_devices();
+
 int gpgpu_opencl_ptx_sim_main_perf( kernel_info_t *grid );
 int gpgpu_opencl_ptx_sim_main_func( kernel_info_t *grid );
 
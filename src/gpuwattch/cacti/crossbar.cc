@@ -90,7 +90,19 @@ double Crossbar::output_buffer()
 
 void Crossbar::compute_power()
 {
+  // The crossbar is laid out with 4x wires and searches for its cell height
+  // adjustment from scratch; put the shared wire models back afterwards so
+  // that calling this again, or building other components later, gives the
+  // same result as the first call
+  Wire::static_state wire_state;
+  Wire::save_static_state(wire_state);
+  CB_ADJ = 1;
+  compute_power_adjusted();
+  Wire::restore_static_state(wire_state);
+}
 
+void Crossbar::compute_power_adjusted()
+{
   Wire winit(4, 4);
   double tri_cap = output_buffer();
   assert(tri_cap > 0);
@@ -117,7 +129,7 @@ void Crossbar::compute_power()
       CB_ADJ+=0.2;
       //cout << "CB ADJ " << CB_ADJ << endl;
       if (CB_ADJ < 4) {
-        this->compute_power();
+        this->compute_power_adjusted();
       }
     }
   }
@@ -142,8 +154,6 @@ void Crossbar::compute_power()
   double res = g_tp.wire_outside_mat.R_per_um * (area.w+area.h) + tr_R_on(g_tp.min_w_nmos_*wdriver.repeater_size, NCH, 1);
   double cap = g_tp.wire_outside_mat.C_per_um * (area.w + area.h) + n_out*tri_inp_cap + n_inp*tri_out_cap;
   delay = horowitz(w1.signal_rise_time(), res*cap, deviceType->Vth/deviceType->Vdd, deviceType->Vth/deviceType->Vdd, RISE);
-
-  Wire wreset();
 }
 
 void Crossbar::print_crossbar()
@@ -61,6 +61,8 @@ class Crossbar : public Component
     double tri_inp_cap, tri_out_cap, tri_ctr_cap, tri_int_cap;
 
   private:
+    void compute_power_adjusted();
+
 	  double CB_ADJ;
 	  /*
 	   * Adjust factor of the height of the cross-point (tri-state buffer) cell (layout) in crossbar
@@ -0,0 +1,244 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Tayler Hetherington, Ahmed ElTantawy,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "solution_cache.h"
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+static const char solution_cache_magic[8] = "CACTISC";
+static const unsigned solution_cache_version = 1;
+
+struct cached_solution {
+	uca_org_t res;
+	mem_array tag_array;
+	mem_array data_array;
+	bool has_tag;
+	bool has_data;
+};
+
+typedef map<unsigned long long, cached_solution> solution_map_t;
+
+static bool         cache_enabled = false;
+static bool         cache_dirty = false;
+static string       cache_filename;
+static solution_map_t cache_entries;
+
+// 64-bit FNV-1a over every field of InputParameter. The fields are hashed
+// one by one so structure padding never takes part in the key.
+class param_hasher {
+public:
+	param_hasher() : m_hash(0xcbf29ce484222325ULL) {}
+	template <class T> void add(const T &v)
+	{
+		const unsigned char *p = (const unsigned char*)&v;
+		for (unsigned i = 0; i < sizeof(T); i++) {
+			m_hash ^= p[i];
+			m_hash *= 0x100000001b3ULL;
+		}
+	}
+	unsigned long long value() const { return m_hash; }
+private:
+	unsigned long long m_hash;
+};
+
+static unsigned long long solution_key(const InputParameter *ip)
+{
+	param_hasher h;
+#define HASH_IP(f) h.add(ip->f)
+	HASH_IP(cache_sz); HASH_IP(line_sz); HASH_IP(assoc); HASH_IP(nbanks);
+	HASH_IP(out_w); HASH_IP(specific_tag); HASH_IP(tag_w); HASH_IP(access_mode);
+	HASH_IP(obj_func_dyn_energy); HASH_IP(obj_func_dyn_power);
+	HASH_IP(obj_func_leak_power); HASH_IP(obj_func_cycle_t);
+	HASH_IP(F_sz_nm); HASH_IP(F_sz_um);
+	HASH_IP(num_rw_ports); HASH_IP(num_rd_ports); HASH_IP(num_wr_ports);
+	HASH_IP(num_se_rd_ports); HASH_IP(num_search_ports);
+	HASH_IP(is_main_mem); HASH_IP(is_cache); HASH_IP(pure_ram); HASH_IP(pure_cam);
+	HASH_IP(rpters_in_htree); HASH_IP(ver_htree_wires_over_array);
+	HASH_IP(broadcast_addr_din_over_ver_htrees); HASH_IP(temp);
+	HASH_IP(ram_cell_tech_type); HASH_IP(peri_global_tech_type);
+	HASH_IP(data_arr_ram_cell_tech_type); HASH_IP(data_arr_peri_global_tech_type);
+	HASH_IP(tag_arr_ram_cell_tech_type); HASH_IP(tag_arr_peri_global_tech_type);
+	HASH_IP(burst_len); HASH_IP(int_prefetch_w); HASH_IP(page_sz_bits);
+	HASH_IP(ic_proj_type); HASH_IP(wire_is_mat_type); HASH_IP(wire_os_mat_type);
+	HASH_IP(wt); HASH_IP(force_wiretype); HASH_IP(print_input_args);
+	HASH_IP(nuca_cache_sz);
+	HASH_IP(ndbl); HASH_IP(ndwl); HASH_IP(nspd); HASH_IP(ndsam1); HASH_IP(ndsam2); HASH_IP(ndcm);
+	HASH_IP(force_cache_config);
+	HASH_IP(cache_level); HASH_IP(cores); HASH_IP(nuca_bank_count); HASH_IP(force_nuca_bank);
+	HASH_IP(delay_wt); HASH_IP(dynamic_power_wt); HASH_IP(leakage_power_wt);
+	HASH_IP(cycle_time_wt); HASH_IP(area_wt);
+	HASH_IP(delay_wt_nuca); HASH_IP(dynamic_power_wt_nuca); HASH_IP(leakage_power_wt_nuca);
+	HASH_IP(cycle_time_wt_nuca); HASH_IP(area_wt_nuca);
+	HASH_IP(delay_dev); HASH_IP(dynamic_power_dev); HASH_IP(leakage_power_dev);
+	HASH_IP(cycle_time_dev); HASH_IP(area_dev);
+	HASH_IP(delay_dev_nuca); HASH_IP(dynamic_power_dev_nuca); HASH_IP(leakage_power_dev_nuca);
+	HASH_IP(cycle_time_dev_nuca); HASH_IP(area_dev_nuca);
+	HASH_IP(ed); HASH_IP(nuca);
+	HASH_IP(fast_access); HASH_IP(block_sz); HASH_IP(tag_assoc); HASH_IP(data_assoc);
+	HASH_IP(is_seq_acc); HASH_IP(fully_assoc); HASH_IP(nsets); HASH_IP(print_detail);
+	HASH_IP(add_ecc_b_);
+	HASH_IP(throughput); HASH_IP(latency); HASH_IP(pipelinable);
+	HASH_IP(pipeline_stages); HASH_IP(per_stage_vector); HASH_IP(with_clock_grid);
+#undef HASH_IP
+	return h.value();
+}
+
+static bool read_solution(FILE *fp, unsigned long long &key, cached_solution &s)
+{
+	unsigned char flags[2];
+	if (fread(&key, sizeof(key), 1, fp) != 1) return false;
+	if (fread(&s.res, sizeof(uca_org_t), 1, fp) != 1) return false;
+	if (fread(flags, sizeof(flags), 1, fp) != 1) return false;
+	s.has_tag = flags[0];
+	s.has_data = flags[1];
+	if (s.has_tag && fread(&s.tag_array, sizeof(mem_array), 1, fp) != 1) return false;
+	if (s.has_data && fread(&s.data_array, sizeof(mem_array), 1, fp) != 1) return false;
+	// pointers in the dump are meaningless, they are re-established on lookup
+	s.res.tag_array2 = NULL;
+	s.res.data_array2 = NULL;
+	s.tag_array.arr_min = NULL;
+	s.data_array.arr_min = NULL;
+	return true;
+}
+
+static void write_solution(FILE *fp, unsigned long long key, const cached_solution &s)
+{
+	unsigned char flags[2] = { s.has_tag, s.has_data };
+	fwrite(&key, sizeof(key), 1, fp);
+	fwrite(&s.res, sizeof(uca_org_t), 1, fp);
+	fwrite(flags, sizeof(flags), 1, fp);
+	if (s.has_tag) fwrite(&s.tag_array, sizeof(mem_array), 1, fp);
+	if (s.has_data) fwrite(&s.data_array, sizeof(mem_array), 1, fp);
+}
+
+void solution_cache_open(const char *filename)
+{
+	cache_entries.clear();
+	cache_dirty = false;
+	cache_enabled = (filename != NULL);
+	if (!cache_enabled)
+		return;
+	cache_filename = filename;
+
+	FILE *fp = fopen(filename, "rb");
+	if (fp == NULL)
+		return;
+
+	char magic[8];
+	unsigned hdr[3];
+	unsigned long long count = 0;
+	bool valid = (fread(magic, sizeof(magic), 1, fp) == 1)
+	          && (fread(hdr, sizeof(hdr), 1, fp) == 1)
+	          && (fread(&count, sizeof(count), 1, fp) == 1)
+	          && !memcmp(magic, solution_cache_magic, sizeof(magic))
+	          && hdr[0] == solution_cache_version
+	          && hdr[1] == sizeof(uca_org_t)
+	          && hdr[2] == sizeof(mem_array);
+	if (!valid) {
+		cout << "Warning: ignoring incompatible CACTI solution cache " << filename << endl;
+	} else {
+		for (unsigned long long i = 0; i < count; i++) {
+			unsigned long long key;
+			cached_solution s;
+			if (!read_solution(fp, key, s)) {
+				cout << "Warning: CACTI solution cache " << filename << " is truncated" << endl;
+				break;
+			}
+			cache_entries[key] = s;
+		}
+	}
+	fclose(fp);
+}
+
+void solution_cache_close()
+{
+	if (cache_enabled && cache_dirty) {
+		// write to a private file first so concurrent runs never see a partial cache
+		char tmpname[1024];
+		snprintf(tmpname, sizeof(tmpname), "%s.%d.tmp", cache_filename.c_str(), (int)getpid());
+		FILE *fp = fopen(tmpname, "wb");
+		if (fp == NULL) {
+			cout << "Warning: could not write CACTI solution cache " << tmpname << endl;
+		} else {
+			unsigned hdr[3] = { solution_cache_version, sizeof(uca_org_t), sizeof(mem_array) };
+			unsigned long long count = cache_entries.size();
+			fwrite(solution_cache_magic, sizeof(solution_cache_magic), 1, fp);
+			fwrite(hdr, sizeof(hdr), 1, fp);
+			fwrite(&count, sizeof(count), 1, fp);
+			for (solution_map_t::const_iterator i = cache_entries.begin(); i != cache_entries.end(); ++i)
+				write_solution(fp, i->first, i->second);
+			fclose(fp);
+			rename(tmpname, cache_filename.c_str());
+		}
+	}
+	cache_entries.clear();
+	cache_enabled = false;
+	cache_dirty = false;
+}
+
+bool solution_cache_lookup(const InputParameter *ip, uca_org_t *res)
+{
+	if (!cache_enabled)
+		return false;
+	solution_map_t::const_iterator i = cache_entries.find(solution_key(ip));
+	if (i == cache_entries.end())
+		return false;
+
+	// callers own (and scale, and delete) the arrays of the result, hand out copies
+	const cached_solution &s = i->second;
+	*res = s.res;
+	res->tag_array2 = s.has_tag ? new mem_array(s.tag_array) : NULL;
+	res->data_array2 = s.has_data ? new mem_array(s.data_array) : NULL;
+	return true;
+}
+
+void solution_cache_insert(const InputParameter *ip, const uca_org_t &res)
+{
+	if (!cache_enabled)
+		return;
+	cached_solution s;
+	s.res = res;
+	s.res.tag_array2 = NULL;
+	s.res.data_array2 = NULL;
+	s.has_tag = (res.tag_array2 != NULL);
+	s.has_data = (res.data_array2 != NULL);
+	if (s.has_tag) {
+		s.tag_array = *res.tag_array2;
+		s.tag_array.arr_min = NULL;
+	}
+	if (s.has_data) {
+		s.data_array = *res.data_array2;
+		s.data_array.arr_min = NULL;
+	}
+	cache_entries[solution_key(ip)] = s;
+	cache_dirty = true;
+}
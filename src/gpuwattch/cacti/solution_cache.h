@@ -0,0 +1,57 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Tayler Hetherington, Ahmed ElTantawy,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SOLUTION_CACHE_H_
+#define SOLUTION_CACHE_H_
+
+#include "cacti_interface.h"
+
+// On-disk cache of CACTI array organizations. solve() performs an
+// exhaustive search over array partitionings, which dominates the time
+// needed to build the McPAT processor model. The selected organization
+// only depends on the InputParameter handed to cacti_interface(), so the
+// result is stored under a hash of those parameters and reloaded on later
+// runs instead of searching again.
+//
+// The cache file is a raw dump of the result structures and is only valid
+// for the binary that wrote it (the header records the structure sizes).
+
+// Load the cache from 'filename' (a missing file is not an error) and start
+// recording new solutions. Passing NULL disables the cache.
+void solution_cache_open(const char *filename);
+
+// Write back any newly recorded solutions and release the cache.
+void solution_cache_close();
+
+// Copy the cached solution for the parameters in 'ip' into 'res'.
+// Returns false if no solution has been recorded for them.
+bool solution_cache_lookup(const InputParameter *ip, uca_org_t *res);
+
+// Record the solution computed by solve() for the parameters in 'ip'.
+void solution_cache_insert(const InputParameter *ip, const uca_org_t &res);
+
+#endif /* SOLUTION_CACHE_H_ */
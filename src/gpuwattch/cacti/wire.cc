@@ -120,6 +120,36 @@ Wire::~Wire()
 
 
 
+void Wire::save_static_state(static_state &s)
+{
+  s.global            = global;
+  s.global_5          = global_5;
+  s.global_10         = global_10;
+  s.global_20         = global_20;
+  s.global_30         = global_30;
+  s.low_swing         = low_swing;
+  s.wire_width_init   = wire_width_init;
+  s.wire_spacing_init = wire_spacing_init;
+  s.initialized       = initialized;
+}
+
+
+
+void Wire::restore_static_state(const static_state &s)
+{
+  global            = s.global;
+  global_5          = s.global_5;
+  global_10         = s.global_10;
+  global_20         = s.global_20;
+  global_30         = s.global_30;
+  low_swing         = s.low_swing;
+  wire_width_init   = s.wire_width_init;
+  wire_spacing_init = s.wire_spacing_init;
+  initialized       = s.initialized;
+}
+
+
+
 void
 Wire::calculate_wire_stats()
 {
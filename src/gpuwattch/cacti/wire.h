@@ -94,6 +94,18 @@ class Wire : public Component
     static double wire_spacing_init;
     void print_wire();
 
+    // The static wire models above are shared by every Wire; a caller that
+    // re-initializes them with its own scaling saves and restores them so
+    // the components built after it do not see the change
+    struct static_state
+    {
+      Component global, global_5, global_10, global_20, global_30, low_swing;
+      double wire_width_init, wire_spacing_init;
+      int initialized;
+    };
+    static void save_static_state(static_state &s);
+    static void restore_static_state(const static_state &s);
+
   private:
 
     int nsense; // no. of sense amps connected to a low-swing wire if it
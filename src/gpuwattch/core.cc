@@ -715,7 +715,8 @@ LoadStoreU::LoadStoreU(ParseXML* XML_interface, int ithCore_, InputParameter* in
  interface_ip(*interface_ip_),
  coredynp(dyn_p_),
  LSQ(0),
- exist(exist_)
+ exist(exist_),
+ rt_xbar_power_valid(false)
 {
 	  if (!exist) return;
 	  int  idx, tag, data, size, line, assoc;
@@ -1462,7 +1463,8 @@ RegFU::RegFU(ParseXML* XML_interface, int ithCore_, InputParameter* interface_ip
  IRF (0),
  FRF (0),
  RFWIN (0),
- exist(exist_)
+ exist(exist_),
+ rt_xbar_power_valid(false)
  {
 	/*
 	 * processors have separate architectural register files for each thread.
@@ -3610,7 +3612,12 @@ void LoadStoreU::computeEnergy(bool is_tdp)
 	executionTime=XML->sys.total_cycles/(XML->sys.target_core_clockrate*1e6);//Syed
 
 	//RF crossbar power (Syed)
-	xbar_shared->compute_power();
+	//The crossbar power does not depend on activity, and building its wires is
+	//the most expensive part of a runtime sample, so only do it once for those
+	if (is_tdp || !rt_xbar_power_valid) {
+		xbar_shared->compute_power();
+		rt_xbar_power_valid = !is_tdp;
+	}
    
 	if (is_tdp)
 	    {
@@ -4353,11 +4360,14 @@ void RegFU::computeEnergy(bool is_tdp)
 
   executionTime=XML->sys.total_cycles/(XML->sys.target_core_clockrate*1e6);//Syed
  //RF crossbar power (Syed Gilani)
- xbar_rfu->compute_power();
-
+ //Activity independent, computed once for runtime samples (see LoadStoreU)
+ if (is_tdp || !rt_xbar_power_valid) {
+	 xbar_rfu->compute_power();
 
- //Arbiter power
- arbiter_rfu->compute_power(); 
+	 //Arbiter power
+	 arbiter_rfu->compute_power();
+	 rt_xbar_power_valid = !is_tdp;
+ }
 
 	if (is_tdp)
     {
@@ -4729,7 +4739,7 @@ void EXECU::displayEnergy(uint32_t indent,int plevel,bool is_tdp)
 
 
 //Jingwen
-void Core::compute()
+void Core::compute(const bool *dirty)
 {
     //power_point_product_masks
     double pppm_t[4]    = {1,1,1,1};
@@ -4740,16 +4750,33 @@ void Core::compute()
 	 //Set pipeline duty cycle for this inteval 
 	coredynp.pipeline_duty_cycle=XML->sys.core[ithCore].pipeline_duty_cycle;
     rt_power.reset();
-    ifu->rt_power.reset();
-    lsu->rt_power.reset();
-    mmu->rt_power.reset();
-    exu->rt_power.reset();
-
 
+	// A unit whose inputs did not change since the last call gets back the
+	// runtime power computeEnergy() gave it then; a NULL mask recomputes all
+	if (dirty == NULL || dirty[PROC_CORE_IFU]) {
+		ifu->rt_power.reset();
 		ifu->computeEnergy(false);
+		ifu_rt_power = ifu->rt_power;
+	} else
+		ifu->rt_power = ifu_rt_power;
+	if (dirty == NULL || dirty[PROC_CORE_LSU]) {
+		lsu->rt_power.reset();
 		lsu->computeEnergy(false);
+		lsu_rt_power = lsu->rt_power;
+	} else
+		lsu->rt_power = lsu_rt_power;
+	if (dirty == NULL || dirty[PROC_CORE_MMU]) {
+		mmu->rt_power.reset();
 		mmu->computeEnergy(false);
+		mmu_rt_power = mmu->rt_power;
+	} else
+		mmu->rt_power = mmu_rt_power;
+	if (dirty == NULL || dirty[PROC_CORE_EXU]) {
+		exu->rt_power.reset();
 		exu->computeEnergy(false);
+		exu_rt_power = exu->rt_power;
+	} else
+		exu->rt_power = exu_rt_power;
 
 
 		if (XML->sys.homogeneous_cores==1)
@@ -169,6 +169,7 @@ class LoadStoreU :public Component {
 	vector<NoC *>  nocs;
 	bool exist;
    Crossbar *xbar_shared;
+	bool rt_xbar_power_valid; // xbar_shared power already computed for runtime samples
 	Component noc;
 	LoadStoreU(ParseXML *XML_interface, int ithCore_, InputParameter* interface_ip_,const CoreDynParam & dyn_p_, bool exist_=true);
     void computeEnergy(bool is_tdp=true);
@@ -216,6 +217,7 @@ class RegFU :public Component {
 	//OC Modelling (Syed)
 	Crossbar * xbar_rfu;
    MCPAT_Arbiter * arbiter_rfu;
+	bool rt_xbar_power_valid; // xbar_rfu/arbiter_rfu power already computed for runtime samples
 	RegFU(ParseXML *XML_interface, int ithCore_, InputParameter* interface_ip_,const CoreDynParam & dyn_p_, double exClockRate, bool exist_=true);
     void computeEnergy(bool is_tdp=true);
     void displayEnergy(uint32_t indent = 0,int plevel = 100, bool is_tdp=true);
@@ -255,6 +257,23 @@ class EXECU :public Component {
 };
 
 
+// Components whose runtime power Processor::compute() can update
+// independently of each other. The core units are tracked separately so a
+// sample that only changes, say, the cache counters does not re-run the
+// execution units; PROC_CORE_PIPELINE covers the cheap per-core terms (duty
+// cycle, idle cores) that Core::compute() always re-evaluates.
+enum proc_component_t {
+	PROC_CORE_IFU=0,
+	PROC_CORE_LSU,
+	PROC_CORE_MMU,
+	PROC_CORE_EXU,
+	PROC_CORE_PIPELINE,
+	PROC_CACHES,
+	PROC_MCS,
+	PROC_NOCS,
+	NUM_PROC_COMPONENTS
+};
+
 class Core :public Component {
   public:
 
@@ -491,8 +510,13 @@ class Core :public Component {
 
 
 
-	void compute();
+	void compute(const bool *dirty = NULL);
 	~Core();
+
+  private:
+	// unit runtime power without the pipeline share, reused by compute()
+	// while the unit's inputs are unchanged
+	powerDef ifu_rt_power, lsu_rt_power, mmu_rt_power, exu_rt_power;
 };
 
 #endif /* CORE_H_ */
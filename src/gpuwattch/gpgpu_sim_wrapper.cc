@@ -26,6 +26,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "gpgpu_sim_wrapper.h"
+#include "cacti/solution_cache.h"
 #include <sys/stat.h>
 #define SP_BASE_POWER 0
 #define SFU_BASE_POWER  0
@@ -58,7 +59,7 @@ enum pwr_cmp_t {
 };
 
 
-gpgpu_sim_wrapper::gpgpu_sim_wrapper( bool power_simulation_enabled, char* xmlfile) {
+gpgpu_sim_wrapper::gpgpu_sim_wrapper( bool power_simulation_enabled, char* xmlfile, char* cacti_cache_dir) {
 	   kernel_sample_count=0;
 	   total_sample_count=0;
 
@@ -84,10 +85,6 @@ gpgpu_sim_wrapper::gpgpu_sim_wrapper( bool power_simulation_enabled, char* xmlfi
 	   const_dynamic_power=0;
 	   proc_power=0;
 
-	   g_power_filename = NULL;
-	   g_power_trace_filename = NULL;
-	   g_metric_trace_filename = NULL;
-	   g_steady_state_tracking_filename = NULL;
 	   xml_filename= xmlfile;
 	   g_power_simulation_enabled= power_simulation_enabled;
 	   g_power_trace_enabled= false;
@@ -102,16 +99,51 @@ gpgpu_sim_wrapper::gpgpu_sim_wrapper( bool power_simulation_enabled, char* xmlfi
 	   if (g_power_simulation_enabled){
 	       p->parse(xml_filename);
 	   }
+	   // Reuse the CACTI array organizations found by earlier runs with the same
+	   // XML, building the processor model is dominated by that search otherwise
+	   if (g_power_simulation_enabled && cacti_cache_dir){
+	       solution_cache_open(cacti_cache_filename(cacti_cache_dir).c_str());
+	   }
 	   proc = new Processor(p);
+	   solution_cache_close();
+	   for(unsigned i=0; i<NUM_PROC_COMPONENTS; i++)
+		   cmp_dirty[i]=true;
+	   coefficients_stale=true;
 	   power_trace_file = NULL;
 	   metric_trace_file = NULL;
 	   steady_state_tacking_file = NULL;
 	   has_written_avg=false;
+	   mcpat_init=true;
 	   init_inst_val=false;
 
 }
 
-gpgpu_sim_wrapper::~gpgpu_sim_wrapper() { }
+gpgpu_sim_wrapper::~gpgpu_sim_wrapper()
+{
+	// deleting a writer drains and closes it if close_files() was not called
+	delete power_trace_file;
+	delete metric_trace_file;
+	delete steady_state_tacking_file;
+}
+
+std::string gpgpu_sim_wrapper::cacti_cache_filename(const char* cache_dir) const
+{
+	// Key the cache file on the XML contents; individual solutions are further
+	// keyed on the technology and array parameters handed to CACTI
+	unsigned long long hash = 0xcbf29ce484222325ULL;
+	FILE *fp = fopen(xml_filename, "rb");
+	if (fp) {
+		int c;
+		while ((c = fgetc(fp)) != EOF) {
+			hash ^= (unsigned char)c;
+			hash *= 0x100000001b3ULL;
+		}
+		fclose(fp);
+	}
+	char buf[1024];
+	snprintf(buf, sizeof(buf), "%s/gpuwattch_cacti_%016llx.cache", cache_dir, hash);
+	return std::string(buf);
+}
 
 bool gpgpu_sim_wrapper::sanity_check(double a, double b)
 {
@@ -122,14 +154,13 @@ bool gpgpu_sim_wrapper::sanity_check(double a, double b)
 
 	return false;
 }
-void gpgpu_sim_wrapper::init_mcpat(char* xmlfile, char* powerfilename, char* power_trace_filename,char* metric_trace_filename,
-								   char * steady_state_filename, bool power_sim_enabled,bool trace_enabled,
+void gpgpu_sim_wrapper::init_mcpat(char* xmlfile, const char* powerfilename, const char* power_trace_filename,const char* metric_trace_filename,
+								   const char * steady_state_filename, bool power_sim_enabled,bool trace_enabled,
 								   bool steady_state_enabled,bool power_per_cycle_dump,double steady_power_deviation,
 								   double steady_min_period, int zlevel, double init_val,int stat_sample_freq ){
 	// Write File Headers for (-metrics trace, -power trace)
 
 	reset_counters();
-   static bool mcpat_init=true;
 
    // initialize file name if it is not set
    time_t curr_time;
@@ -160,55 +191,58 @@ void gpgpu_sim_wrapper::init_mcpat(char* xmlfile, char* powerfilename, char* pow
 
 	   //p->sys.total_cycles=gpu_stat_sample_freq*4;
 	   p->sys.total_cycles=gpu_stat_sample_freq;
+	   // the sample length changes the execution time of every component
+	   for(unsigned i=0; i<NUM_PROC_COMPONENTS; i++)
+		   cmp_dirty[i]=true;
 	   power_trace_file = NULL;
 	   metric_trace_file = NULL;
 	   steady_state_tacking_file = NULL;
 
 
 	   if (g_power_trace_enabled ){
-		   power_trace_file = gzopen(g_power_trace_filename, "w");
-		   metric_trace_file = gzopen(g_metric_trace_filename, "w");
-		   if ((power_trace_file == NULL) || (metric_trace_file == NULL)) {
+		   // the trace files stay open for the whole run; samples are
+		   // compressed and written by the writers' background threads
+		   power_trace_file = new async_gzwriter();
+		   metric_trace_file = new async_gzwriter();
+		   if (!power_trace_file->open(g_power_trace_filename.c_str(), "w", g_power_trace_zlevel) ||
+		       !metric_trace_file->open(g_metric_trace_filename.c_str(), "w", g_power_trace_zlevel)) {
 			   printf("error - could not open trace files \n");
 			   exit(1);
 		   }
-		   gzsetparams(power_trace_file, g_power_trace_zlevel, Z_DEFAULT_STRATEGY);
 
-		   gzprintf(power_trace_file,"power,");
+		   power_trace_file->print("power,");
 		   for(unsigned i=0; i<num_pwr_cmps; i++){
-			   gzprintf(power_trace_file,pwr_cmp_label[i]);
+			   power_trace_file->print("%s",pwr_cmp_label[i]);
 		   }
-		   gzprintf(power_trace_file,"\n");
+		   power_trace_file->print("\n");
 
-		   gzsetparams(metric_trace_file, g_power_trace_zlevel, Z_DEFAULT_STRATEGY);
 		   for(unsigned i=0; i<num_perf_counters; i++){
-			   gzprintf(metric_trace_file,perf_count_label[i]);
+			   metric_trace_file->print("%s",perf_count_label[i]);
 		   }
-		   gzprintf(metric_trace_file,"\n");
+		   metric_trace_file->print("\n");
 
-		   gzclose(power_trace_file);
-		   gzclose(metric_trace_file);
+		   power_trace_file->commit();
+		   metric_trace_file->commit();
 	   }
 	   if(g_steady_power_levels_enabled){
-		   steady_state_tacking_file = gzopen(g_steady_state_tracking_filename, "w");
-		   if ((steady_state_tacking_file == NULL)) {
+		   steady_state_tacking_file = new async_gzwriter();
+		   if (!steady_state_tacking_file->open(g_steady_state_tracking_filename.c_str(), "w", g_power_trace_zlevel)) {
 			   printf("error - could not open trace files \n");
 			   exit(1);
 		   }
-		   gzsetparams(steady_state_tacking_file,g_power_trace_zlevel, Z_DEFAULT_STRATEGY);
-		   gzprintf(steady_state_tacking_file,"start,end,power,IPC,");
+		   steady_state_tacking_file->print("start,end,power,IPC,");
 		   for(unsigned i=0; i<num_perf_counters; i++){
-			   gzprintf(steady_state_tacking_file,perf_count_label[i]);
+			   steady_state_tacking_file->print("%s",perf_count_label[i]);
 		   }
-		   gzprintf(steady_state_tacking_file,"\n");
+		   steady_state_tacking_file->print("\n");
 
-		   gzclose(steady_state_tacking_file);
+		   steady_state_tacking_file->commit();
 	   }
 
 	   mcpat_init = false;
 	   has_written_avg=false;
-	   powerfile.open(g_power_filename);
-       int flg=chmod(g_power_filename, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+	   powerfile.open(g_power_filename.c_str());
+       int flg=chmod(g_power_filename.c_str(), S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
        assert(flg==0);
    }
    sample_val = 0;
@@ -238,24 +272,24 @@ void gpgpu_sim_wrapper::reset_counters(){
 
 void gpgpu_sim_wrapper::set_inst_power(bool clk_gated_lanes, double tot_cycles, double busy_cycles, double tot_inst, double int_inst, double fp_inst, double load_inst, double store_inst, double committed_inst)
 {
-	p->sys.core[0].gpgpu_clock_gated_lanes = clk_gated_lanes;
-	p->sys.core[0].total_cycles = tot_cycles;
-	p->sys.core[0].busy_cycles = busy_cycles;
-	p->sys.core[0].total_instructions  = tot_inst * p->sys.scaling_coefficients[TOT_INST];
-	p->sys.core[0].int_instructions    = int_inst * p->sys.scaling_coefficients[FP_INT];
-	p->sys.core[0].fp_instructions     = fp_inst  * p->sys.scaling_coefficients[FP_INT];
-	p->sys.core[0].load_instructions  = load_inst;
-	p->sys.core[0].store_instructions = store_inst;
-	p->sys.core[0].committed_instructions = committed_inst;
+	update_input(p->sys.core[0].gpgpu_clock_gated_lanes, clk_gated_lanes, PROC_CORE_PIPELINE);
+	update_input(p->sys.core[0].total_cycles, tot_cycles, PROC_CORE_PIPELINE);
+	update_input(p->sys.core[0].busy_cycles, busy_cycles, PROC_CORE_PIPELINE);
+	update_input(p->sys.core[0].total_instructions, tot_inst * p->sys.scaling_coefficients[TOT_INST], PROC_CORE_IFU);
+	update_input(p->sys.core[0].int_instructions, int_inst * p->sys.scaling_coefficients[FP_INT], PROC_CORE_EXU);
+	update_input(p->sys.core[0].fp_instructions, fp_inst  * p->sys.scaling_coefficients[FP_INT], PROC_CORE_EXU);
+	update_input(p->sys.core[0].load_instructions, load_inst, PROC_CORE_LSU);
+	update_input(p->sys.core[0].store_instructions, store_inst, PROC_CORE_LSU);
+	update_input(p->sys.core[0].committed_instructions, committed_inst, PROC_CORE_PIPELINE);
 	sample_perf_counters[FP_INT]=int_inst+fp_inst;
 	sample_perf_counters[TOT_INST]=tot_inst;
 }
 
 void gpgpu_sim_wrapper::set_regfile_power(double reads, double writes,double ops)
 {
-	p->sys.core[0].int_regfile_reads = reads * p->sys.scaling_coefficients[REG_RD];
-	p->sys.core[0].int_regfile_writes = writes * p->sys.scaling_coefficients[REG_WR];
-	p->sys.core[0].non_rf_operands =  ops *p->sys.scaling_coefficients[NON_REG_OPs];
+	update_input(p->sys.core[0].int_regfile_reads, reads * p->sys.scaling_coefficients[REG_RD], PROC_CORE_EXU);
+	update_input(p->sys.core[0].int_regfile_writes, writes * p->sys.scaling_coefficients[REG_WR], PROC_CORE_EXU);
+	update_input(p->sys.core[0].non_rf_operands, ops *p->sys.scaling_coefficients[NON_REG_OPs], PROC_CORE_EXU);
 	sample_perf_counters[REG_RD]=reads;
 	sample_perf_counters[REG_WR]=writes;
 	sample_perf_counters[NON_REG_OPs]=ops;
@@ -266,8 +300,8 @@ void gpgpu_sim_wrapper::set_regfile_power(double reads, double writes,double ops
 
 void gpgpu_sim_wrapper::set_icache_power(double hits, double misses)
 {
-	p->sys.core[0].icache.read_accesses = hits * p->sys.scaling_coefficients[IC_H]+misses * p->sys.scaling_coefficients[IC_M];
-	p->sys.core[0].icache.read_misses = misses * p->sys.scaling_coefficients[IC_M];
+	update_input(p->sys.core[0].icache.read_accesses, hits * p->sys.scaling_coefficients[IC_H]+misses * p->sys.scaling_coefficients[IC_M], PROC_CORE_IFU);
+	update_input(p->sys.core[0].icache.read_misses, misses * p->sys.scaling_coefficients[IC_M], PROC_CORE_IFU);
 	sample_perf_counters[IC_H]=hits;
 	sample_perf_counters[IC_M]=misses;
 
@@ -276,8 +310,8 @@ void gpgpu_sim_wrapper::set_icache_power(double hits, double misses)
 
 void gpgpu_sim_wrapper::set_ccache_power(double hits, double misses)
 {
-	p->sys.core[0].ccache.read_accesses = hits * p->sys.scaling_coefficients[CC_H]+misses * p->sys.scaling_coefficients[CC_M];
-	p->sys.core[0].ccache.read_misses = misses * p->sys.scaling_coefficients[CC_M];
+	update_input(p->sys.core[0].ccache.read_accesses, hits * p->sys.scaling_coefficients[CC_H]+misses * p->sys.scaling_coefficients[CC_M], PROC_CORE_LSU);
+	update_input(p->sys.core[0].ccache.read_misses, misses * p->sys.scaling_coefficients[CC_M], PROC_CORE_LSU);
 	sample_perf_counters[CC_H]=hits;
 	sample_perf_counters[CC_M]=misses;
 	// TODO: coalescing logic is counted as part of the caches power (this is not valid for no-caches architectures)
@@ -286,8 +320,8 @@ void gpgpu_sim_wrapper::set_ccache_power(double hits, double misses)
 
 void gpgpu_sim_wrapper::set_tcache_power(double hits, double misses)
 {
-	p->sys.core[0].tcache.read_accesses = hits * p->sys.scaling_coefficients[TC_H]+misses * p->sys.scaling_coefficients[TC_M];
-	p->sys.core[0].tcache.read_misses = misses* p->sys.scaling_coefficients[TC_M];
+	update_input(p->sys.core[0].tcache.read_accesses, hits * p->sys.scaling_coefficients[TC_H]+misses * p->sys.scaling_coefficients[TC_M], PROC_CORE_LSU);
+	update_input(p->sys.core[0].tcache.read_misses, misses* p->sys.scaling_coefficients[TC_M], PROC_CORE_LSU);
 	sample_perf_counters[TC_H]=hits;
 	sample_perf_counters[TC_M]=misses;
 	// TODO: coalescing logic is counted as part of the caches power (this is not valid for no-caches architectures)
@@ -295,7 +329,7 @@ void gpgpu_sim_wrapper::set_tcache_power(double hits, double misses)
 
 void gpgpu_sim_wrapper::set_shrd_mem_power(double accesses)
 {
-	p->sys.core[0].sharedmemory.read_accesses = accesses * p->sys.scaling_coefficients[SHRD_ACC];
+	update_input(p->sys.core[0].sharedmemory.read_accesses, accesses * p->sys.scaling_coefficients[SHRD_ACC], PROC_CORE_LSU);
 	sample_perf_counters[SHRD_ACC]=accesses;
 
 
@@ -303,10 +337,10 @@ void gpgpu_sim_wrapper::set_shrd_mem_power(double accesses)
 
 void gpgpu_sim_wrapper::set_l1cache_power(double read_hits, double read_misses, double write_hits, double write_misses)
 {
-	p->sys.core[0].dcache.read_accesses = read_hits * p->sys.scaling_coefficients[DC_RH] +read_misses * p->sys.scaling_coefficients[DC_RM];
-	p->sys.core[0].dcache.read_misses =  read_misses * p->sys.scaling_coefficients[DC_RM];
-	p->sys.core[0].dcache.write_accesses = write_hits * p->sys.scaling_coefficients[DC_WH]+write_misses * p->sys.scaling_coefficients[DC_WM];
-	p->sys.core[0].dcache.write_misses = write_misses * p->sys.scaling_coefficients[DC_WM];
+	update_input(p->sys.core[0].dcache.read_accesses, read_hits * p->sys.scaling_coefficients[DC_RH] +read_misses * p->sys.scaling_coefficients[DC_RM], PROC_CORE_LSU);
+	update_input(p->sys.core[0].dcache.read_misses, read_misses * p->sys.scaling_coefficients[DC_RM], PROC_CORE_LSU);
+	update_input(p->sys.core[0].dcache.write_accesses, write_hits * p->sys.scaling_coefficients[DC_WH]+write_misses * p->sys.scaling_coefficients[DC_WM], PROC_CORE_LSU);
+	update_input(p->sys.core[0].dcache.write_misses, write_misses * p->sys.scaling_coefficients[DC_WM], PROC_CORE_LSU);
 	sample_perf_counters[DC_RH]=read_hits;
 	sample_perf_counters[DC_RM]=read_misses;
 	sample_perf_counters[DC_WH]=write_hits;
@@ -319,13 +353,13 @@ void gpgpu_sim_wrapper::set_l1cache_power(double read_hits, double read_misses,
 
 void gpgpu_sim_wrapper::set_l2cache_power(double read_hits, double read_misses, double write_hits, double write_misses)
 {
-	p->sys.l2.total_accesses = read_hits* p->sys.scaling_coefficients[L2_RH]+read_misses * p->sys.scaling_coefficients[L2_RM]+ write_hits * p->sys.scaling_coefficients[L2_WH]+write_misses  * p->sys.scaling_coefficients[L2_WM];
-	p->sys.l2.read_accesses = read_hits* p->sys.scaling_coefficients[L2_RH]+read_misses* p->sys.scaling_coefficients[L2_RM];
-	p->sys.l2.write_accesses = write_hits * p->sys.scaling_coefficients[L2_WH]+write_misses * p->sys.scaling_coefficients[L2_WM];
-	p->sys.l2.read_hits = read_hits * p->sys.scaling_coefficients[L2_RH];
-	p->sys.l2.read_misses = read_misses  * p->sys.scaling_coefficients[L2_RM];
-	p->sys.l2.write_hits =write_hits * p->sys.scaling_coefficients[L2_WH];
-	p->sys.l2.write_misses = write_misses * p->sys.scaling_coefficients[L2_WM];
+	update_input(p->sys.l2.total_accesses, read_hits* p->sys.scaling_coefficients[L2_RH]+read_misses * p->sys.scaling_coefficients[L2_RM]+ write_hits * p->sys.scaling_coefficients[L2_WH]+write_misses  * p->sys.scaling_coefficients[L2_WM], PROC_CACHES);
+	update_input(p->sys.l2.read_accesses, read_hits* p->sys.scaling_coefficients[L2_RH]+read_misses* p->sys.scaling_coefficients[L2_RM], PROC_CACHES);
+	update_input(p->sys.l2.write_accesses, write_hits * p->sys.scaling_coefficients[L2_WH]+write_misses * p->sys.scaling_coefficients[L2_WM], PROC_CACHES);
+	update_input(p->sys.l2.read_hits, read_hits * p->sys.scaling_coefficients[L2_RH], PROC_CACHES);
+	update_input(p->sys.l2.read_misses, read_misses  * p->sys.scaling_coefficients[L2_RM], PROC_CACHES);
+	update_input(p->sys.l2.write_hits, write_hits * p->sys.scaling_coefficients[L2_WH], PROC_CACHES);
+	update_input(p->sys.l2.write_misses, write_misses * p->sys.scaling_coefficients[L2_WM], PROC_CACHES);
 	sample_perf_counters[L2_RH]=read_hits;
 	sample_perf_counters[L2_RM]=read_misses;
 	sample_perf_counters[L2_WH]=write_hits;
@@ -334,23 +368,23 @@ void gpgpu_sim_wrapper::set_l2cache_power(double read_hits, double read_misses,
 
 void gpgpu_sim_wrapper::set_idle_core_power(double num_idle_core)
 {
-	p->sys.num_idle_cores = num_idle_core;
+	update_input(p->sys.num_idle_cores, num_idle_core, PROC_CORE_PIPELINE);
 	sample_perf_counters[IDLE_CORE_N]=num_idle_core;
 }
 
 void gpgpu_sim_wrapper::set_duty_cycle_power(double duty_cycle)
 {
-	p->sys.core[0].pipeline_duty_cycle = duty_cycle  * p->sys.scaling_coefficients[PIPE_A];
+	update_input(p->sys.core[0].pipeline_duty_cycle, duty_cycle  * p->sys.scaling_coefficients[PIPE_A], PROC_CORE_PIPELINE);
 	sample_perf_counters[PIPE_A]=duty_cycle;
 
 }
 
 void gpgpu_sim_wrapper::set_mem_ctrl_power(double reads, double writes, double dram_precharge)
 {
-	p->sys.mc.memory_accesses = reads  * p->sys.scaling_coefficients[MEM_RD]+ writes * p->sys.scaling_coefficients[MEM_WR];
-	p->sys.mc.memory_reads = reads *p->sys.scaling_coefficients[MEM_RD];
-	p->sys.mc.memory_writes = writes*p->sys.scaling_coefficients[MEM_WR];
-	p->sys.mc.dram_pre = dram_precharge*p->sys.scaling_coefficients[MEM_PRE];
+	update_input(p->sys.mc.memory_accesses, reads  * p->sys.scaling_coefficients[MEM_RD]+ writes * p->sys.scaling_coefficients[MEM_WR], PROC_MCS);
+	update_input(p->sys.mc.memory_reads, reads *p->sys.scaling_coefficients[MEM_RD], PROC_MCS);
+	update_input(p->sys.mc.memory_writes, writes*p->sys.scaling_coefficients[MEM_WR], PROC_MCS);
+	update_input(p->sys.mc.dram_pre, dram_precharge*p->sys.scaling_coefficients[MEM_PRE], PROC_MCS);
 	sample_perf_counters[MEM_RD]=reads;
 	sample_perf_counters[MEM_WR]=writes;
 	sample_perf_counters[MEM_PRE]=dram_precharge;
@@ -359,12 +393,11 @@ void gpgpu_sim_wrapper::set_mem_ctrl_power(double reads, double writes, double d
 
 void gpgpu_sim_wrapper::set_exec_unit_power(double fpu_accesses, double ialu_accesses, double sfu_accesses)
 {
-	p->sys.core[0].fpu_accesses = fpu_accesses*p->sys.scaling_coefficients[FPU_ACC];
+	update_input(p->sys.core[0].fpu_accesses, fpu_accesses*p->sys.scaling_coefficients[FPU_ACC], PROC_CORE_EXU);
     //Integer ALU (not present in Tesla)
-	p->sys.core[0].ialu_accesses = ialu_accesses*p->sys.scaling_coefficients[SP_ACC];
+	update_input(p->sys.core[0].ialu_accesses, ialu_accesses*p->sys.scaling_coefficients[SP_ACC], PROC_CORE_EXU);
 	//Sfu accesses
-	p->sys.core[0].mul_accesses = sfu_accesses*p->sys.scaling_coefficients[SFU_ACC];
-
+	update_input(p->sys.core[0].mul_accesses, sfu_accesses*p->sys.scaling_coefficients[SFU_ACC], PROC_CORE_EXU);
 	sample_perf_counters[SP_ACC]=ialu_accesses;
 	sample_perf_counters[SFU_ACC]=sfu_accesses;
 	sample_perf_counters[FPU_ACC]=fpu_accesses;
@@ -374,13 +407,13 @@ void gpgpu_sim_wrapper::set_exec_unit_power(double fpu_accesses, double ialu_acc
 
 void gpgpu_sim_wrapper::set_active_lanes_power(double sp_avg_active_lane, double sfu_avg_active_lane)
 {
-	p->sys.core[0].sp_average_active_lanes = sp_avg_active_lane;
-	p->sys.core[0].sfu_average_active_lanes = sfu_avg_active_lane;
+	update_input(p->sys.core[0].sp_average_active_lanes, sp_avg_active_lane, PROC_CORE_EXU);
+	update_input(p->sys.core[0].sfu_average_active_lanes, sfu_avg_active_lane, PROC_CORE_EXU);
 }
 
 void gpgpu_sim_wrapper::set_NoC_power(double noc_tot_reads, double noc_tot_writes )
 {
-	p->sys.NoC[0].total_accesses = noc_tot_reads * p->sys.scaling_coefficients[NOC_A] + noc_tot_writes * p->sys.scaling_coefficients[NOC_A];
+	update_input(p->sys.NoC[0].total_accesses, noc_tot_reads * p->sys.scaling_coefficients[NOC_A] + noc_tot_writes * p->sys.scaling_coefficients[NOC_A], PROC_NOCS);
 	sample_perf_counters[NOC_A]=noc_tot_reads+noc_tot_writes;
 }
 
@@ -437,25 +470,29 @@ void gpgpu_sim_wrapper::power_metrics_calculations()
 
 void gpgpu_sim_wrapper::print_trace_files()
 {
-	open_files();
-
 	for(unsigned i=0; i<num_perf_counters; ++i){
-		gzprintf(metric_trace_file,"%f,",sample_perf_counters[i]);
+		metric_trace_file->print("%f,",sample_perf_counters[i]);
 	}
-	gzprintf(metric_trace_file,"\n");
+	metric_trace_file->print("\n");
 
-	gzprintf(power_trace_file,"%f,",proc_power);
+	power_trace_file->print("%f,",proc_power);
 	for(unsigned i=0; i<num_pwr_cmps; ++i){
-		gzprintf(power_trace_file,"%f,",sample_cmp_pwr[i]);
+		power_trace_file->print("%f,",sample_cmp_pwr[i]);
 	}
-	gzprintf(power_trace_file,"\n");
+	power_trace_file->print("\n");
 
-	close_files();
+	metric_trace_file->commit();
+	power_trace_file->commit();
 
 }
 
 void gpgpu_sim_wrapper::update_coefficients()
 {
+	// The coefficients only depend on McPAT state, which is unchanged unless
+	// compute() re-evaluated a component since they were last derived
+	if(!coefficients_stale)
+		return;
+	coefficients_stale=false;
 
 	initpower_coeff[FP_INT]=proc->cores[0]->get_coefficient_fpint_insts();
 	effpower_coeff[FP_INT]=initpower_coeff[FP_INT] * p->sys.scaling_coefficients[FP_INT];
@@ -608,7 +645,18 @@ void gpgpu_sim_wrapper::update_components_power()
 
 void gpgpu_sim_wrapper::compute()
 {
-	proc->compute();
+	// Only re-evaluate the components whose activity factors changed
+	// since the previous sample, the others keep their runtime power
+	bool any_dirty=false;
+	for(unsigned i=0; i<NUM_PROC_COMPONENTS; i++)
+		any_dirty|=cmp_dirty[i];
+	if(!any_dirty)
+		return;
+
+	proc->compute(cmp_dirty);
+	for(unsigned i=0; i<NUM_PROC_COMPONENTS; i++)
+		cmp_dirty[i]=false;
+	coefficients_stale=true;
 }
 void gpgpu_sim_wrapper::print_power_kernel_stats(double gpu_sim_cycle, double gpu_tot_sim_cycle, double init_value, const std::string & kernel_info_string, bool print_trace)
 {
@@ -671,14 +719,14 @@ void gpgpu_sim_wrapper::print_steady_state(int position, double init_val){
 
 	if((samples.size() > gpu_steady_min_period)){ // If steady state occurred for some time, print to file
 		has_written_avg=true;
-		gzprintf(steady_state_tacking_file,"%u,%d,%f,%f,",sample_start,total_sample_count,temp_avg,temp_ipc);
+		steady_state_tacking_file->print("%u,%d,%f,%f,",sample_start,total_sample_count,temp_avg,temp_ipc);
 		for(unsigned i=0; i<num_perf_counters; ++i){
-			gzprintf(steady_state_tacking_file,"%f,", samples_counter.at(i)/((double)samples.size()));
+			steady_state_tacking_file->print("%f,", samples_counter.at(i)/((double)samples.size()));
 		}
-		gzprintf(steady_state_tacking_file,"\n");
+		steady_state_tacking_file->print("\n");
 	}else{
 		if(!has_written_avg && position)
-			gzprintf(steady_state_tacking_file,"ERROR! Not enough steady state points to generate average\n");
+			steady_state_tacking_file->print("ERROR! Not enough steady state points to generate average\n");
 	}
 
 	sample_start = 0;
@@ -694,7 +742,6 @@ void gpgpu_sim_wrapper::detect_print_steady_state(int position, double init_val)
 {
 	// Calculating Average
     if(g_power_simulation_enabled && g_steady_power_levels_enabled){
-    	steady_state_tacking_file = gzopen(g_steady_state_tracking_filename,"a");
 		if(position==0){
 			if(samples.size() == 0){
 				// First sample
@@ -736,26 +783,20 @@ void gpgpu_sim_wrapper::detect_print_steady_state(int position, double init_val)
 		}else{
 			print_steady_state(position, init_val);
 		}
-		gzclose(steady_state_tacking_file);
+		steady_state_tacking_file->commit();
     }
 }
 
-void gpgpu_sim_wrapper::open_files()
-{
-    if(g_power_simulation_enabled){
-        if (g_power_trace_enabled ){
-            power_trace_file = gzopen(g_power_trace_filename,  "a");
-            metric_trace_file = gzopen(g_metric_trace_filename, "a");
-        }
-    }
-}
 void gpgpu_sim_wrapper::close_files()
 {
+    // the files are only created by the first init_mcpat()
     if(g_power_simulation_enabled){
-  	  if(g_power_trace_enabled){
-  		  gzclose(power_trace_file);
-  		  gzclose(metric_trace_file);
-  	  }
+  	  if(power_trace_file)
+  		  power_trace_file->close();
+  	  if(metric_trace_file)
+  		  metric_trace_file->close();
+  	  if(steady_state_tacking_file)
+  		  steady_state_tacking_file->close();
   	 }
 
 }
@@ -35,7 +35,7 @@
 #include <string>
 #include <iostream>
 #include <fstream>
-#include <zlib.h>
+#include "../gpgpu-sim/async_gzwriter.h"
 #include <string.h>
 
 
@@ -52,16 +52,15 @@ struct avg_max_min_counters{
 
 class gpgpu_sim_wrapper {
 public:
-	gpgpu_sim_wrapper(bool power_simulation_enabled, char* xmlfile);
+	gpgpu_sim_wrapper(bool power_simulation_enabled, char* xmlfile, char* cacti_cache_dir=NULL);
 	~gpgpu_sim_wrapper();
 
-	void init_mcpat(char* xmlfile, char* powerfile, char* power_trace_file,char* metric_trace_file,
-			char * steady_state_file,bool power_sim_enabled,bool trace_enabled,bool steady_state_enabled,
+	void init_mcpat(char* xmlfile, const char* powerfile, const char* power_trace_file,const char* metric_trace_file,
+			const char * steady_state_file,bool power_sim_enabled,bool trace_enabled,bool steady_state_enabled,
 			bool power_per_cycle_dump,double steady_power_deviation,double steady_min_period,int zlevel,
 			double init_val,int stat_sample_freq);
 	void detect_print_steady_state(int position, double init_val);
 	void close_files();
-	void open_files();
 	void compute();
 	void dump();
 	void print_trace_files();
@@ -89,9 +88,24 @@ public:
 private:
 
 	void print_steady_state(int position, double init_val);
+	std::string cacti_cache_filename(const char* cache_dir) const;
+
+	// Set a McPAT activity input, marking the processor component it feeds
+	// for recomputation if the value changed since the previous sample
+	template <typename T, typename V>
+	void update_input(T &input, V value, proc_component_t cmp)
+	{
+		T new_value = (T)value;
+		if (input != new_value) {
+			input = new_value;
+			cmp_dirty[cmp] = true;
+		}
+	}
 
 	Processor* proc;
 	ParseXML * p;
+	bool cmp_dirty[NUM_PROC_COMPONENTS]; // components with changed activity since the last compute()
+	bool coefficients_stale; // McPAT state changed since update_coefficients() last ran
     // power parameters
     double const_dynamic_power;
     double proc_power;
@@ -109,6 +123,7 @@ private:
     avg_max_min_counters<double> gpu_tot_power; // Global GPU power avg/max/min values (across kernels)
 
     bool has_written_avg;
+    bool mcpat_init; // the output files are created by the first init_mcpat()
 
     std::vector<double> sample_cmp_pwr; // Current sample component powers
     std::vector<double> sample_perf_counters; // Current sample component perf. counts
@@ -124,10 +139,11 @@ private:
     std::vector<double> pwr_counter;
 
     char *xml_filename;
-    char *g_power_filename;
-    char *g_power_trace_filename;
-    char *g_metric_trace_filename;
-    char * g_steady_state_tracking_filename;
+    // copies, the callers pass a different name for every simulated device
+    std::string g_power_filename;
+    std::string g_power_trace_filename;
+    std::string g_metric_trace_filename;
+    std::string g_steady_state_tracking_filename;
     bool g_power_simulation_enabled;
     bool g_steady_power_levels_enabled;
     bool g_power_trace_enabled;
@@ -139,9 +155,9 @@ private:
     int gpu_stat_sample_freq;
 
     std::ofstream powerfile;
-    gzFile power_trace_file;
-    gzFile metric_trace_file;
-    gzFile steady_state_tacking_file;
+    async_gzwriter *power_trace_file;
+    async_gzwriter *metric_trace_file;
+    async_gzwriter *steady_state_tacking_file;
 };
 
 #endif /* GPGPU_SIM_WRAPPER_H_ */
@@ -69,6 +69,7 @@ SRCS  = \
   processor.cc \
   router.cc \
   sharedcache.cc \
+  solution_cache.cc \
   subarray.cc \
   technology.cc \
   uca.cc \
@@ -440,12 +440,20 @@ Processor::Processor(ParseXML *XML_interface)
 //  globalClock.optimize_wire();
 }
 
-void Processor::compute () 
+void Processor::compute (const bool *dirty)
 {
   int i;
   double pppm_t[4]    = {1,1,1,1};
 
-  rt_power.reset();
+  // Components whose activity did not change since the last call keep their
+  // runtime power from then; a NULL mask recomputes every component.
+  bool cores_dirty = (dirty == NULL);
+  for (i = PROC_CORE_IFU; i <= PROC_CORE_PIPELINE && !cores_dirty; i++)
+	  cores_dirty = dirty[i];
+  if (cores_dirty)
+  {
+  powerDef &sect_power = section_rt_power[PROC_SECT_CORES];
+  sect_power.reset();
   //power.reset();
   //core.power.reset();
 
@@ -454,20 +462,25 @@ void Processor::compute ()
   {
       cores[i]->executionTime = XML->sys.total_cycles /(XML->sys.core[i].clock_rate*1e6); 
       cores[i]->rt_power.reset();
-		  cores[i]->compute();
+		  cores[i]->compute(dirty);
 		  //cores[i]->computeEnergy(false);
 		  if (procdynp.homoCore){
 			  set_pppm(pppm_t,1/cores[i]->executionTime, procdynp.numCore,procdynp.numCore,procdynp.numCore);
 			  core.rt_power = core.rt_power + cores[i]->rt_power*pppm_t;
-			  rt_power = rt_power  + core.rt_power;
+			  sect_power = sect_power  + core.rt_power;
 		  }
 		  else{
 			  set_pppm(pppm_t,1/cores[i]->executionTime, 1, 1, 1);
 			  core.rt_power = core.rt_power + cores[i]->rt_power*pppm_t;
-			  rt_power = rt_power  + cores[i]->rt_power*pppm_t;
+			  sect_power = sect_power  + cores[i]->rt_power*pppm_t;
 		  }
   }
+  }
 
+  if (dirty == NULL || dirty[PROC_CACHES])
+  {
+  powerDef &sect_power = section_rt_power[PROC_SECT_CACHES];
+  sect_power.reset();
   if (!XML->sys.Private_L2)
   {
   if (numL2 >0)
@@ -480,12 +493,12 @@ void Processor::compute ()
 		  if (procdynp.homoL2){
 			  set_pppm(pppm_t,1/l2array[i]->cachep.executionTime, procdynp.numL2,procdynp.numL2,procdynp.numL2);
 			  l2.rt_power = l2.rt_power + l2array[i]->rt_power*pppm_t;
-			  rt_power = rt_power  + l2.rt_power;
+			  sect_power = sect_power  + l2.rt_power;
 		  }
 		  else{
 			  set_pppm(pppm_t,1/l2array[i]->cachep.executionTime, 1, 1, 1);
 			  l2.rt_power = l2.rt_power + l2array[i]->rt_power*pppm_t;
-			  rt_power = rt_power  + l2array[i]->rt_power*pppm_t;
+			  sect_power = sect_power  + l2array[i]->rt_power*pppm_t;
 		  }
 	  }
   }
@@ -499,13 +512,13 @@ void Processor::compute ()
 		  if (procdynp.homoL3){
 			  set_pppm(pppm_t,1/l3array[i]->cachep.executionTime, procdynp.numL3,procdynp.numL3,procdynp.numL3);
         l3.rt_power = l3.rt_power + l3array[i]->rt_power*pppm_t;
-			  rt_power = rt_power  + l3.rt_power;
+			  sect_power = sect_power  + l3.rt_power;
 
 		  }
 		  else{
 			  set_pppm(pppm_t,1/l3array[i]->cachep.executionTime, 1, 1, 1);
         l3.rt_power = l3.rt_power + l3array[i]->rt_power*pppm_t;
-        rt_power = rt_power  + l3array[i]->rt_power*pppm_t;
+        sect_power = sect_power  + l3array[i]->rt_power*pppm_t;
 
 		  }
 	  }
@@ -519,13 +532,13 @@ void Processor::compute ()
 		  if (procdynp.homoL1Dir){
 			  set_pppm(pppm_t,1/l1dirarray[i]->cachep.executionTime, procdynp.numL1Dir,procdynp.numL1Dir,procdynp.numL1Dir);
         l1dir.rt_power = l1dir.rt_power + l1dirarray[i]->rt_power*pppm_t;
-			  rt_power = rt_power  + l1dir.rt_power;
+			  sect_power = sect_power  + l1dir.rt_power;
 
 		  }
 		  else{
 			  set_pppm(pppm_t,1/l1dirarray[i]->cachep.executionTime, 1, 1, 1);
         l1dir.rt_power = l1dir.rt_power + l1dirarray[i]->rt_power*pppm_t;
-			  rt_power = rt_power  + l1dirarray[i]->rt_power;
+			  sect_power = sect_power  + l1dirarray[i]->rt_power;
 		  }
 	  }
 
@@ -539,17 +552,21 @@ void Processor::compute ()
 		  if (procdynp.homoL2Dir){
 			  set_pppm(pppm_t,1/l2dirarray[i]->cachep.executionTime, procdynp.numL2Dir,procdynp.numL2Dir,procdynp.numL2Dir);
         l2dir.rt_power = l2dir.rt_power + l2dirarray[i]->rt_power*pppm_t;
-			  rt_power = rt_power  + l2dir.rt_power;
+			  sect_power = sect_power  + l2dir.rt_power;
 
 		  }
 		  else{
 			  set_pppm(pppm_t,1/l2dirarray[i]->cachep.executionTime, 1, 1, 1);
         l2dir.rt_power = l2dir.rt_power + l2dirarray[i]->rt_power*pppm_t;
-			  rt_power = rt_power  + l2dirarray[i]->rt_power*pppm_t;
+			  sect_power = sect_power  + l2dirarray[i]->rt_power*pppm_t;
 		  }
 	  }
+  }
 
-
+  if (dirty == NULL || dirty[PROC_MCS])
+  {
+  powerDef &sect_power = section_rt_power[PROC_SECT_MCS];
+  sect_power.reset();
   mcs.rt_power.reset();
   if (XML->sys.mc.number_mcs >0 && XML->sys.mc.memory_channels_per_mc>0)
   {
@@ -558,9 +575,10 @@ void Processor::compute ()
 	  mc->computeEnergy(false);
 	  set_pppm(pppm_t,1/mc->mcp.executionTime, XML->sys.mc.number_mcs,XML->sys.mc.number_mcs,XML->sys.mc.number_mcs);
 	  mcs.rt_power = mc->rt_power*pppm_t;
-	  rt_power = rt_power  + mcs.rt_power;
+	  sect_power = sect_power  + mcs.rt_power;
 
   }
+  }
   
 
 /*  
@@ -600,6 +618,10 @@ void Processor::compute ()
 	   // * area must be obtain to decide the link routing
 	  */ 
 	  //Compute energy of NoC (w or w/o links) or buses
+  if (dirty == NULL || dirty[PROC_NOCS])
+  {
+  powerDef &sect_power = section_rt_power[PROC_SECT_NOCS];
+  sect_power.reset();
     noc.rt_power.reset();
 	  for (i = 0;i < numNOC; i++)
 	  {
@@ -608,16 +630,20 @@ void Processor::compute ()
 		  if (procdynp.homoNOC){
 			  set_pppm(pppm_t,1/nocs[i]->nocdynp.executionTime, procdynp.numNOC,procdynp.numNOC,procdynp.numNOC);
 			  noc.rt_power = noc.rt_power + nocs[i]->rt_power*pppm_t;
-			  rt_power = rt_power  + noc.rt_power;
+			  sect_power = sect_power  + noc.rt_power;
 		  }
 		  else
 		  {
 			  set_pppm(pppm_t,1/nocs[i]->nocdynp.executionTime, 1, 1, 1);
 			  noc.rt_power = noc.rt_power + nocs[i]->rt_power*pppm_t;
-			  rt_power = rt_power  + nocs[i]->rt_power*pppm_t;
+			  sect_power = sect_power  + nocs[i]->rt_power*pppm_t;
 		  }
 	  } 
-    
+  }
+
+  rt_power.reset();
+  for (i = 0; i < NUM_PROC_SECTIONS; i++)
+	  rt_power = rt_power + section_rt_power[i];
 
 //  //clock power
 //  globalClock.init_wire_external(is_default, &interface_ip);
@@ -54,6 +54,16 @@
 #include "iocontrollers.h"
 #include "../gpgpu-sim/visualizer.h"
 
+// Sections of Processor::compute(); each keeps its runtime power from the
+// last time one of its components was dirty
+enum proc_section_t {
+	PROC_SECT_CORES=0,
+	PROC_SECT_CACHES,
+	PROC_SECT_MCS,
+	PROC_SECT_NOCS,
+	NUM_PROC_SECTIONS
+};
+
 class Processor : public Component
 {
   public:
@@ -77,9 +87,10 @@ class Processor : public Component
     //wire	globalInterconnect;
     //clock_network globalClock;
     Component core, l2, l3, l1dir, l2dir, noc, mcs, cc, nius, pcies,flashcontrollers;
+    powerDef section_rt_power[NUM_PROC_SECTIONS]; // runtime power of the cores, shared caches, MCs and NoCs
     int  numCore, numL2, numL3, numNOC, numL1Dir, numL2Dir;
     Processor(ParseXML *XML_interface);
-    void compute();
+    void compute(const bool *dirty = NULL);
     void set_proc_param();
     void visualizer_print( gzFile visualizer_file );
     void displayEnergy(uint32_t indent = 0,int plevel = 100, bool is_tdp_parm=true);
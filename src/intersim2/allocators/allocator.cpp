@@ -41,6 +41,8 @@
 #include "selalloc.hpp"
 #include "separable_input_first.hpp"
 #include "separable_output_first.hpp"
+#include "bit_islip.hpp"
+#include "bit_wavefront.hpp"
 //
 /////////////////////////////////////////////////////////////////////////
 
@@ -251,6 +253,128 @@ void DenseAllocator::PrintRequests( ostream * os ) const
   *os << "]." << endl;
 }
 
+//==================================================
+// BitAllocator
+//==================================================
+
+BitAllocator::BitAllocator( Module *parent, const string& name,
+			    int inputs, int outputs ) :
+  DenseAllocator( parent, name, inputs, outputs )
+{
+  _in_words = ( _inputs + 63 ) / 64;
+  _out_words = ( _outputs + 63 ) / 64;
+  _in_bits.resize(_inputs * _out_words, 0);
+  _out_bits.resize(_outputs * _in_words, 0);
+  _in_occ.resize(_in_words, 0);
+  _out_occ.resize(_out_words, 0);
+}
+
+int BitAllocator::_FindFirstFrom( tWord const * row, int words, int start )
+{
+  int w = start >> 6;
+  tWord bits = row[w] & ( ~(tWord)0 << ( start & 63 ) );
+  for ( int i = w; ; ) {
+    if ( bits ) {
+      return ( i << 6 ) + __builtin_ctzll( bits );
+    }
+    if ( ++i == words ) {
+      break;
+    }
+    bits = row[i];
+  }
+  for ( int i = 0; i <= w; ++i ) {
+    if ( row[i] ) {
+      return ( i << 6 ) + __builtin_ctzll( row[i] );
+    }
+  }
+  return -1;
+}
+
+bool BitAllocator::_Any( tWord const * row, int words )
+{
+  for ( int i = 0; i < words; ++i ) {
+    if ( row[i] ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void BitAllocator::Clear( )
+{
+  // only visit the rows that hold requests
+  for ( int w = 0; w < _in_words; ++w ) {
+    for ( tWord iw = _in_occ[w]; iw; iw &= iw - 1 ) {
+      int const in = ( w << 6 ) + __builtin_ctzll( iw );
+      tWord * const row = &_in_bits[in * _out_words];
+      for ( int v = 0; v < _out_words; ++v ) {
+	for ( tWord ow = row[v]; ow; ow &= ow - 1 ) {
+	  int const out = ( v << 6 ) + __builtin_ctzll( ow );
+	  _request[in][out].label = -1;
+	  _ClearBit( &_out_bits[out * _in_words], in );
+	}
+	row[v] = 0;
+      }
+    }
+    _in_occ[w] = 0;
+  }
+  _out_occ.assign(_out_words, 0);
+  Allocator::Clear();
+}
+
+void BitAllocator::AddRequest( int in, int out, int label, 
+			       int in_pri, int out_pri )
+{
+  DenseAllocator::AddRequest(in, out, label, in_pri, out_pri);
+  _SetBit( &_in_bits[in * _out_words], out );
+  _SetBit( &_out_bits[out * _in_words], in );
+  _SetBit( &_in_occ[0], in );
+  _SetBit( &_out_occ[0], out );
+}
+
+void BitAllocator::RemoveRequest( int in, int out, int label )
+{
+  DenseAllocator::RemoveRequest(in, out, label);
+  _ClearBit( &_in_bits[in * _out_words], out );
+  _ClearBit( &_out_bits[out * _in_words], in );
+  if ( !_Any( _InRow(in), _out_words ) ) {
+    _ClearBit( &_in_occ[0], in );
+  }
+  if ( !_Any( _OutRow(out), _in_words ) ) {
+    _ClearBit( &_out_occ[0], out );
+  }
+}
+
+bool BitAllocator::InputHasRequests( int in ) const
+{
+  return _TestBit( &_in_occ[0], in );
+}
+
+bool BitAllocator::OutputHasRequests( int out ) const
+{
+  return _TestBit( &_out_occ[0], out );
+}
+
+int BitAllocator::NumInputRequests( int in ) const
+{
+  int result = 0;
+  tWord const * const row = _InRow(in);
+  for ( int w = 0; w < _out_words; ++w ) {
+    result += __builtin_popcountll( row[w] );
+  }
+  return result;
+}
+
+int BitAllocator::NumOutputRequests( int out ) const
+{
+  int result = 0;
+  tWord const * const row = _OutRow(out);
+  for ( int w = 0; w < _in_words; ++w ) {
+    result += __builtin_popcountll( row[w] );
+  }
+  return result;
+}
+
 //==================================================
 // SparseAllocator
 //==================================================
@@ -469,6 +593,13 @@ Allocator *Allocator::NewAllocator( Module *parent, const string& name,
     string arb_type = param_str.empty() ? (config ? config->GetStr("arb_type") : "round_robin") : param_str;
     a = new SeparableOutputFirstAllocator( parent, name, inputs, outputs,
 					   arb_type );
+  } else if ( alloc_name == "bit_islip" ) {
+    int iters = param_str.empty() ? (config ? config->GetInt("alloc_iters") : 1) : atoi(param_str.c_str());
+    a = new iSLIP_Bits( parent, name, inputs, outputs, iters );
+  } else if ( alloc_name == "bit_wavefront" ) {
+    a = new Wavefront_Bits( parent, name, inputs, outputs );
+  } else if ( alloc_name == "bit_rr_wavefront" ) {
+    a = new Wavefront_Bits( parent, name, inputs, outputs, true );
   }
 
 //==================================================
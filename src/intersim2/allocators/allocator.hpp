@@ -119,6 +119,59 @@ public:
 
 };
 
+//==================================================
+// A bit allocator is a dense allocator that also
+// keeps the request matrix as bit rows per input
+// and per output, so that allocators can select
+// among requests with word-level operations.
+//==================================================
+
+class BitAllocator : public DenseAllocator {
+protected:
+  typedef unsigned long long tWord;
+
+  int _in_words;   // words per row indexed by input
+  int _out_words;  // words per row indexed by output
+
+  vector<tWord> _in_bits;   // [in * _out_words + w], bit = output
+  vector<tWord> _out_bits;  // [out * _in_words + w], bit = input
+  vector<tWord> _in_occ;    // inputs with at least one request
+  vector<tWord> _out_occ;   // outputs with at least one request
+
+  inline tWord const * _InRow( int in ) const {return &_in_bits[in * _out_words];}
+  inline tWord const * _OutRow( int out ) const {return &_out_bits[out * _in_words];}
+
+  static inline bool _TestBit( tWord const * row, int i ) {
+    return (row[i >> 6] >> (i & 63)) & 1;
+  }
+  static inline void _SetBit( tWord * row, int i ) {
+    row[i >> 6] |= (tWord)1 << (i & 63);
+  }
+  static inline void _ClearBit( tWord * row, int i ) {
+    row[i >> 6] &= ~((tWord)1 << (i & 63));
+  }
+  // first set bit at or after start, wrapping around; -1 if none
+  static int _FindFirstFrom( tWord const * row, int words, int start );
+  static bool _Any( tWord const * row, int words );
+
+public:
+  BitAllocator( Module *parent, const string& name,
+		int inputs, int outputs );
+
+  void Clear( );
+
+  void AddRequest( int in, int out, int label = 1, 
+		   int in_pri = 0, int out_pri = 0 );
+  void RemoveRequest( int in, int out, int label = 1 );
+
+  bool OutputHasRequests( int out ) const;
+  bool InputHasRequests( int in ) const;
+
+  int NumOutputRequests( int out ) const;
+  int NumInputRequests( int in ) const;
+
+};
+
 //==================================================
 // A sparse allocator only stores the requests
 // (allows for a more efficient implementation).
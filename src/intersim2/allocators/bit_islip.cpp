@@ -0,0 +1,114 @@
+/*
+ Copyright (c) 2007-2012, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "booksim.hpp"
+#include <cassert>
+
+#include "bit_islip.hpp"
+
+iSLIP_Bits::iSLIP_Bits( Module *parent, const string& name,
+			int inputs, int outputs, int iters ) :
+  BitAllocator( parent, name, inputs, outputs ),
+  _iSLIP_iter(iters)
+{
+  _gptrs.resize(_outputs, 0);
+  _aptrs.resize(_inputs, 0);
+  _free_in.resize(_in_words);
+  _grants.resize(_inputs * _out_words, 0);
+  _granted_in.resize(_in_words, 0);
+  _candidates.resize(_in_words);
+}
+
+void iSLIP_Bits::Allocate( )
+{
+  for ( int w = 0; w < _in_words; ++w ) {
+    _free_in[w] = 0;
+  }
+  for ( int input = 0; input < _inputs; ++input ) {
+    if ( _inmatch[input] == -1 ) {
+      _SetBit( &_free_in[0], input );
+    }
+  }
+
+  for ( int iter = 0; iter < _iSLIP_iter; ++iter ) {
+    // Grant phase: each free output picks the first free requesting
+    // input at or after its grant pointer
+
+    bool any_grant = false;
+
+    for ( int v = 0; v < _out_words; ++v ) {
+      for ( tWord ow = _out_occ[v]; ow; ow &= ow - 1 ) {
+	int const output = ( v << 6 ) + __builtin_ctzll( ow );
+	if ( _outmatch[output] != -1 ) {
+	  continue;
+	}
+	tWord const * const req = _OutRow(output);
+	bool any = false;
+	for ( int w = 0; w < _in_words; ++w ) {
+	  _candidates[w] = req[w] & _free_in[w];
+	  any = any || _candidates[w];
+	}
+	if ( !any ) {
+	  continue;
+	}
+	int const input = _FindFirstFrom( &_candidates[0], _in_words, _gptrs[output] );
+	_SetBit( &_grants[input * _out_words], output );
+	_SetBit( &_granted_in[0], input );
+	any_grant = true;
+      }
+    }
+
+    if ( !any_grant ) {
+      break;
+    }
+
+    // Accept phase: each granted input accepts the first granting output
+    // at or after its accept pointer
+
+    for ( int w = 0; w < _in_words; ++w ) {
+      for ( tWord iw = _granted_in[w]; iw; iw &= iw - 1 ) {
+	int const input = ( w << 6 ) + __builtin_ctzll( iw );
+	tWord * const grants = &_grants[input * _out_words];
+	int const output = _FindFirstFrom( grants, _out_words, _aptrs[input] );
+	assert( output >= 0 );
+
+	_inmatch[input]   = output;
+	_outmatch[output] = input;
+	_ClearBit( &_free_in[0], input );
+
+	// Only update pointers if accepted during the 1st iteration
+	if ( iter == 0 ) {
+	  _gptrs[output] = ( input + 1 ) % _inputs;
+	  _aptrs[input]  = ( output + 1 ) % _outputs;
+	}
+
+	for ( int v = 0; v < _out_words; ++v ) {
+	  grants[v] = 0;
+	}
+      }
+      _granted_in[w] = 0;
+    }
+  }
+}
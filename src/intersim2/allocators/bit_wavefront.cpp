@@ -0,0 +1,140 @@
+/*
+ Copyright (c) 2007-2012, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "booksim.hpp"
+#include <algorithm>
+#include <functional>
+#include <cassert>
+
+#include "bit_wavefront.hpp"
+
+Wavefront_Bits::Wavefront_Bits( Module *parent, const string& name,
+				int inputs, int outputs, bool skip_diags ) :
+  BitAllocator( parent, name, inputs, outputs ),
+  _last_in(-1), _last_out(-1), _skip_diags(skip_diags), 
+  _square(max(inputs, outputs)), _pri(0), _num_requests(0)
+{
+  _diag_bits.resize(_square * _out_words, 0);
+}
+
+void Wavefront_Bits::Clear( )
+{
+  for ( int w = 0; w < _in_words; ++w ) {
+    for ( tWord iw = _in_occ[w]; iw; iw &= iw - 1 ) {
+      int const in = ( w << 6 ) + __builtin_ctzll( iw );
+      tWord const * const row = _InRow(in);
+      for ( int v = 0; v < _out_words; ++v ) {
+	for ( tWord ow = row[v]; ow; ow &= ow - 1 ) {
+	  int const out = ( v << 6 ) + __builtin_ctzll( ow );
+	  _ClearBit( &_diag_bits[( ( in + out ) % _square ) * _out_words], out );
+	}
+      }
+    }
+  }
+  BitAllocator::Clear();
+}
+
+void Wavefront_Bits::AddRequest( int in, int out, int label, 
+				 int in_pri, int out_pri )
+{
+  BitAllocator::AddRequest(in, out, label, in_pri, out_pri);
+  _SetBit( &_diag_bits[( ( in + out ) % _square ) * _out_words], out );
+  _num_requests++;
+  _last_in = in;
+  _last_out = out;
+  pair<int, int> const pri(out_pri, in_pri);
+  if ( find( _priorities.begin(), _priorities.end(), pri ) == _priorities.end() ) {
+    _priorities.push_back(pri);
+  }
+}
+
+void Wavefront_Bits::RemoveRequest( int in, int out, int label )
+{
+  BitAllocator::RemoveRequest(in, out, label);
+  _ClearBit( &_diag_bits[( ( in + out ) % _square ) * _out_words], out );
+}
+
+void Wavefront_Bits::Allocate( )
+{
+  int first_diag = -1;
+
+  if(_num_requests == 0)
+
+    // bypass allocator completely if there were no requests
+    return;
+  
+  if(_num_requests == 1) {
+
+    // if we only had a single request, we can immediately grant it
+    _inmatch[_last_in] = _last_out;
+    _outmatch[_last_out] = _last_in;
+    first_diag = _last_in + _last_out;
+
+  } else {
+
+    // highest priority first, as Wavefront walks its priority set backwards
+    sort(_priorities.begin(), _priorities.end(), greater<pair<int, int> >());
+    bool const single_pri = ( _priorities.size() == 1 );
+
+    for(size_t p_idx = 0; p_idx < _priorities.size(); ++p_idx) {
+      int const out_pri = _priorities[p_idx].first;
+      int const in_pri = _priorities[p_idx].second;
+
+      // requests on one diagonal never share an input or an output, so
+      // every free one can be granted
+      for ( int p = 0; p < _square; ++p ) {
+	int const diag = ( _pri + p ) % _square;
+	tWord const * const row = &_diag_bits[diag * _out_words];
+	for ( int v = 0; v < _out_words; ++v ) {
+	  for ( tWord ow = row[v]; ow; ow &= ow - 1 ) {
+	    int const output = ( v << 6 ) + __builtin_ctzll( ow );
+	    int const input = ( diag + _square - output ) % _square;
+	    if ( ( _inmatch[input] == -1 ) && ( _outmatch[output] == -1 ) &&
+		 ( single_pri ||
+		   ( ( _request[input][output].in_pri == in_pri ) &&
+		     ( _request[input][output].out_pri == out_pri ) ) ) ) {
+	      // Grant!
+	      _inmatch[input] = output;
+	      _outmatch[output] = input;
+	      if(first_diag < 0) {
+		first_diag = input + output;
+	      }
+	    }
+	  }
+	}
+      }
+    }
+  }
+
+  _num_requests = 0;
+  _last_in = -1;
+  _last_out = -1;
+  _priorities.clear();
+
+  assert(first_diag >= 0);
+
+  // Round-robin the priority diagonal
+  _pri = ( ( _skip_diags ? first_diag : _pri ) + 1 ) % _square;
+}
@@ -0,0 +1,63 @@
+/*
+ Copyright (c) 2007-2012, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _BIT_WAVEFRONT_HPP_
+#define _BIT_WAVEFRONT_HPP_
+
+#include <vector>
+
+#include "allocator.hpp"
+
+// Wavefront allocator over request bits grouped by diagonal; grants the
+// same matches as Wavefront.
+class Wavefront_Bits : public BitAllocator {
+
+private:
+  int _last_in;
+  int _last_out;
+  vector<pair<int, int> > _priorities;  // distinct (out_pri, in_pri)
+  bool _skip_diags;
+
+  // [d * _out_words + w], bit = output of request (in, out) with
+  // (in + out) % _square == d
+  vector<tWord> _diag_bits;
+
+protected:
+  int _square;
+  int _pri;
+  int _num_requests;
+
+public:
+  Wavefront_Bits( Module *parent, const string& name,
+		  int inputs, int outputs, bool skip_diags = false );
+
+  void Clear( );
+  void AddRequest( int in, int out, int label = 1, 
+		   int in_pri = 0, int out_pri = 0 );
+  void RemoveRequest( int in, int out, int label = 1 );
+  void Allocate( );
+};
+
+#endif
@@ -37,7 +37,7 @@
 #ifndef _CHANNEL_HPP
 #define _CHANNEL_HPP
 
-#include <queue>
+#include <vector>
 #include <cassert>
 
 #include "globals.hpp"
@@ -66,17 +66,27 @@ public:
   virtual void Evaluate() {}
   virtual void WriteOutputs();
 
+  virtual bool IsIdle() const {
+    return !_input && !_output && !_wait_count;
+  }
+
 protected:
   int _delay;
   T * _input;
   T * _output;
-  queue<pair<int, T *> > _wait_queue;
+
+  // flits/credits in transit, oldest first. At most one item enters per
+  // cycle and each leaves _delay-1 cycles later, so _delay slots suffice.
+  vector<pair<int, T *> > _wait_queue;
+  int _wait_head;
+  int _wait_count;
 
 };
 
 template<typename T>
 Channel<T>::Channel(Module * parent, string const & name)
-  : TimedModule(parent, name), _delay(1), _input(0), _output(0) {
+  : TimedModule(parent, name), _delay(1), _input(0), _output(0),
+    _wait_queue(1), _wait_head(0), _wait_count(0) {
 }
 
 template<typename T>
@@ -85,11 +95,15 @@ void Channel<T>::SetLatency(int cycles) {
     Error("Channel must have positive delay.");
   }
   _delay = cycles ;
+  assert(!_wait_count);
+  _wait_queue.assign(cycles, make_pair(0, (T *)0));
+  _wait_head = 0;
 }
 
 template<typename T>
 void Channel<T>::Send(T * data) {
   _input = data;
+  _Wake();
 }
 
 template<typename T>
@@ -100,7 +114,13 @@ T * Channel<T>::Receive() {
 template<typename T>
 void Channel<T>::ReadInputs() {
   if(_input) {
-    _wait_queue.push(make_pair(GetSimTime() + _delay - 1, _input));
+    assert(_wait_count < _delay);
+    int tail = _wait_head + _wait_count;
+    if(tail >= _delay) {
+      tail -= _delay;
+    }
+    _wait_queue[tail] = make_pair(GetSimTime() + _delay - 1, _input);
+    ++_wait_count;
     _input = 0;
   }
 }
@@ -108,10 +128,10 @@ void Channel<T>::ReadInputs() {
 template<typename T>
 void Channel<T>::WriteOutputs() {
   _output = 0;
-  if(_wait_queue.empty()) {
+  if(!_wait_count) {
     return;
   }
-  pair<int, T *> const & item = _wait_queue.front();
+  pair<int, T *> const & item = _wait_queue[_wait_head];
   int const & time = item.first;
   if(GetSimTime() < time) {
     return;
@@ -119,7 +139,11 @@ void Channel<T>::WriteOutputs() {
   assert(GetSimTime() == time);
   _output = item.second;
   assert(_output);
-  _wait_queue.pop();
+  if(++_wait_head == _delay) {
+    _wait_head = 0;
+  }
+  --_wait_count;
+  _WakeConsumer();
 }
 
 #endif
@@ -28,14 +28,37 @@
 #ifndef _CREDIT_HPP_
 #define _CREDIT_HPP_
 
-#include <set>
+#include <vector>
 #include <stack>
+#include <algorithm>
+#include <pthread.h>
 
 class Credit {
 
 public:
 
-  set<int> vc;
+  // the credited VCs in ascending order, without duplicates. Kept in a
+  // vector rather than a set: a pooled credit reuses its storage, so
+  // crediting a VC does not allocate a tree node every cycle.
+  class VCSet {
+  public:
+    typedef vector<int>::const_iterator const_iterator;
+    void insert(int vc) {
+      vector<int>::iterator i = lower_bound(_vcs.begin(), _vcs.end(), vc);
+      if(i == _vcs.end() || *i != vc) {
+        _vcs.insert(i, vc);
+      }
+    }
+    void clear() { _vcs.clear(); }
+    bool empty() const { return _vcs.empty(); }
+    size_t size() const { return _vcs.size(); }
+    const_iterator begin() const { return _vcs.begin(); }
+    const_iterator end() const { return _vcs.end(); }
+  private:
+    vector<int> _vcs;
+  };
+
+  VCSet vc;
 
   // these are only used by the event router
   bool head, tail;
@@ -47,10 +70,15 @@ public:
   void Free();
   static void FreeAll();
   static int OutStanding();
+
+  // serialize New()/Free() while subnets are stepped on several threads
+  static void SetThreadSafe(bool thread_safe);
 private:
 
   static stack<Credit *> _all;
   static stack<Credit *> _free;
+  static bool _thread_safe;
+  static pthread_mutex_t _lock;
 
   Credit();
   ~Credit() {}
@@ -28,6 +28,8 @@
 #include <sstream>
 #include <fstream>
 #include <limits> 
+#include <sched.h>
+#include <unistd.h>
 
 #include "gputrafficmanager.hpp"
 #include "interconnect_interface.hpp"
@@ -47,10 +49,167 @@ GPUTrafficManager::GPUTrafficManager( const Configuration &config, const vector<
       _input_queue[subnet][node].resize(_classes);
     }
   }
+
+  _ejected_this_cycle.resize(_subnets);
+  for ( int subnet = 0; subnet < _subnets; ++subnet) {
+    _ejected_this_cycle[subnet].resize(_nodes, NULL);
+  }
+
+  _parallel_subnets = false;
+  _worker_generation = 0;
+  _workers_done = 0;
+  _workers_sleeping = 0;
+  _worker_phase = phase_read_inputs;
+  _workers_exit = false;
+  if(config.GetInt("parallel_subnets") && (_subnets > 1)) {
+    if(sysconf(_SC_NPROCESSORS_ONLN) < 2) {
+      cout << "WARNING: parallel_subnets ignored: only one processor is online."
+           << endl;
+    } else if(_CanStepSubnetsInParallel(config)) {
+      _StartSubnetWorkers();
+    } else {
+      cout << "WARNING: parallel_subnets ignored: only iq routers with"
+           << " deterministic routing and allocation can be stepped in parallel."
+           << endl;
+    }
+  }
 }
 
 GPUTrafficManager::~GPUTrafficManager()
 {
+  _StopSubnetWorkers();
+}
+
+// Results match serial stepping only if the networks do not draw from the
+// shared random number generator and keep no cross-router static state.
+bool GPUTrafficManager::_CanStepSubnetsInParallel( const Configuration &config ) const
+{
+  static char const * const deterministic_rf[] = {
+    "dest_tag_fly", "dim_order_mesh", "dim_order_ni_mesh", "dim_order_pni_mesh",
+    "dor_mesh", "dim_order_torus", "dim_order_ni_torus", "dim_order_bal_torus",
+    "dor_cmesh", "dor_no_express_cmesh", "min_anynet", NULL
+  };
+  if(config.GetStr("router") != "iq") {
+    return false;
+  }
+  if((config.GetStr("vc_allocator") == "pim") ||
+     (config.GetStr("sw_allocator") == "pim")) {
+    return false;
+  }
+  string const rf = config.GetStr("routing_function") + "_" + config.GetStr("topology");
+  for(int i = 0; deterministic_rf[i]; ++i) {
+    if(rf == deterministic_rf[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void GPUTrafficManager::_StartSubnetWorkers( )
+{
+  pthread_mutex_init(&_worker_lock, NULL);
+  pthread_cond_init(&_worker_wake, NULL);
+  Credit::SetThreadSafe(true);
+  _subnet_workers.resize(_subnets - 1);
+  for(int i = 0; i < _subnets - 1; ++i) {
+    SubnetWorker & w = _subnet_workers[i];
+    w.tm = this;
+    w.subnet = i + 1;
+    if(pthread_create(&w.thread, NULL, _SubnetWorkerMain, &w)) {
+      Error("Unable to create interconnect subnet worker thread");
+    }
+  }
+  _parallel_subnets = true;
+}
+
+void GPUTrafficManager::_StopSubnetWorkers( )
+{
+  if(!_parallel_subnets) {
+    return;
+  }
+  pthread_mutex_lock(&_worker_lock);
+  _workers_exit = true;
+  __atomic_store_n(&_worker_generation, _worker_generation + 1, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&_worker_wake);
+  pthread_mutex_unlock(&_worker_lock);
+  for(size_t i = 0; i < _subnet_workers.size(); ++i) {
+    pthread_join(_subnet_workers[i].thread, NULL);
+  }
+  _subnet_workers.clear();
+  Credit::SetThreadSafe(false);
+  pthread_cond_destroy(&_worker_wake);
+  pthread_mutex_destroy(&_worker_lock);
+  _parallel_subnets = false;
+}
+
+void * GPUTrafficManager::_SubnetWorkerMain( void * arg )
+{
+  SubnetWorker * const w = static_cast<SubnetWorker *>(arg);
+  GPUTrafficManager * const tm = w->tm;
+  unsigned seen = 0;
+  while(true) {
+    // the next phase usually follows within microseconds, so spin briefly
+    // before sleeping (e.g. while the rest of the GPU is being cycled)
+    unsigned gen;
+    int spins = 0;
+    while((gen = __atomic_load_n(&tm->_worker_generation, __ATOMIC_ACQUIRE)) == seen) {
+      if(++spins < 20000) {
+        sched_yield();
+        continue;
+      }
+      pthread_mutex_lock(&tm->_worker_lock);
+      ++tm->_workers_sleeping;
+      while(__atomic_load_n(&tm->_worker_generation, __ATOMIC_ACQUIRE) == seen) {
+        pthread_cond_wait(&tm->_worker_wake, &tm->_worker_lock);
+      }
+      --tm->_workers_sleeping;
+      pthread_mutex_unlock(&tm->_worker_lock);
+      spins = 0;
+    }
+    seen = gen;
+    if(tm->_workers_exit) {
+      break;
+    }
+    tm->_StepNetwork(w->subnet, tm->_worker_phase);
+    __atomic_add_fetch(&tm->_workers_done, 1, __ATOMIC_RELEASE);
+  }
+  return NULL;
+}
+
+void GPUTrafficManager::_StepNetwork( int subnet, NetworkPhase phase )
+{
+  if(phase == phase_read_inputs) {
+    _net[subnet]->ReadInputs( );
+  } else {
+    _net[subnet]->Evaluate( );
+    _net[subnet]->WriteOutputs( );
+  }
+}
+
+void GPUTrafficManager::_StepNetworks( NetworkPhase phase )
+{
+  if(!_parallel_subnets) {
+    for(int subnet = 0; subnet < _subnets; ++subnet) {
+      _StepNetwork(subnet, phase);
+    }
+    return;
+  }
+
+  unsigned const n_workers = _subnet_workers.size();
+  _worker_phase = phase;
+  __atomic_store_n(&_workers_done, 0, __ATOMIC_RELAXED);
+  pthread_mutex_lock(&_worker_lock);
+  __atomic_store_n(&_worker_generation, _worker_generation + 1, __ATOMIC_RELEASE);
+  if(_workers_sleeping) {
+    pthread_cond_broadcast(&_worker_wake);
+  }
+  pthread_mutex_unlock(&_worker_lock);
+
+  _StepNetwork(0, phase);
+
+  while(__atomic_load_n(&_workers_done, __ATOMIC_ACQUIRE) < n_workers) {
+    sched_yield();
+  }
 }
 
 void GPUTrafficManager::Init()
@@ -343,8 +502,6 @@ void GPUTrafficManager::_Step()
     cout << "WARNING: Possible network deadlock.\n";
   }
   
-  vector<map<int, Flit *> > flits(_subnets);
-  
   for ( int subnet = 0; subnet < _subnets; ++subnet ) {
     for ( int n = 0; n < _nodes; ++n ) {
       Flit * const f = _net[subnet]->ReadFlit( n );
@@ -373,7 +530,7 @@ void GPUTrafficManager::_Step()
           << " VC " << ejected_flit->vc << ")"
           << "from ejection buffer." << endl;
         }
-        flits[subnet].insert(make_pair(n, ejected_flit));
+        _ejected_this_cycle[subnet][n] = ejected_flit;
         if((_sim_state == warming_up) || (_sim_state == running)) {
           ++_accepted_flits[ejected_flit->cl][n];
           if(ejected_flit->tail) {
@@ -386,7 +543,7 @@ void GPUTrafficManager::_Step()
       Credit * const c = _net[subnet]->ReadCredit( n );
       if ( c ) {
 #ifdef TRACK_FLOWS
-        for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
+        for(Credit::VCSet::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
           int const vc = *iter;
           assert(!_outstanding_classes[n][subnet][vc].empty());
           int cl = _outstanding_classes[n][subnet][vc].front();
@@ -399,8 +556,8 @@ void GPUTrafficManager::_Step()
         c->Free();
       }
     }
-    _net[subnet]->ReadInputs( );
   }
+  _StepNetworks(phase_read_inputs);
 
 // GPGPUSim will generate/inject packets from interconnection interface
 #if 0
@@ -422,7 +579,7 @@ void GPUTrafficManager::_Step()
       int class_limit = _classes;
       
       if(_hold_switch_for_packet) {
-        list<Flit *> const & pp = _input_queue[subnet][n][last_class];
+        RingQueue<Flit *> const & pp = _input_queue[subnet][n][last_class];
         if(!pp.empty() && !pp.front()->head &&
            !dest_buf->IsFullFor(pp.front()->vc)) {
           f = pp.front();
@@ -438,7 +595,7 @@ void GPUTrafficManager::_Step()
         
         int const c = (last_class + i) % _classes;
         
-        list<Flit *> const & pp = _input_queue[subnet][n][c];
+        RingQueue<Flit *> const & pp = _input_queue[subnet][n][c];
         
         if(pp.empty()) {
           continue;
@@ -637,9 +794,9 @@ void GPUTrafficManager::_Step()
   //Send the credit To the network
   for(int subnet = 0; subnet < _subnets; ++subnet) {
     for(int n = 0; n < _nodes; ++n) {
-      map<int, Flit *>::const_iterator iter = flits[subnet].find(n);
-      if(iter != flits[subnet].end()) {
-        Flit * const f = iter->second;
+      Flit * const f = _ejected_this_cycle[subnet][n];
+      if(f) {
+        _ejected_this_cycle[subnet][n] = NULL;
 
         f->atime = _time;
         if(f->watch) {
@@ -660,11 +817,9 @@ void GPUTrafficManager::_Step()
         _RetireFlit(f, n);
       }
     }
-    flits[subnet].clear();
-    // _InteralStep here
-    _net[subnet]->Evaluate( );
-    _net[subnet]->WriteOutputs( );
   }
+  // _InteralStep here
+  _StepNetworks(phase_evaluate);
   
   ++_time;
   assert(_time);
@@ -31,6 +31,7 @@
 #include <iostream>
 #include <vector>
 #include <list>
+#include <pthread.h>
 
 #include "config_utils.hpp"
 #include "stats.hpp"
@@ -38,6 +39,7 @@
 #include "booksim.hpp"
 #include "booksim_config.hpp"
 #include "flit.hpp"
+#include "ring_queue.hpp"
 
 class GPUTrafficManager : public TrafficManager {
   
@@ -47,8 +49,41 @@ protected:
   virtual int  _IssuePacket( int source, int cl );
   virtual void _Step();
   
-  // record size of _partial_packets for each subnet
-  vector<vector<vector<list<Flit *> > > > _input_queue;
+  // record size of _partial_packets for each subnet; ring buffers, so
+  // injecting a flit does not allocate a list node
+  vector<vector<vector<RingQueue<Flit *> > > > _input_queue;
+
+  // flits ejected this cycle, [subnet][node]; NULL when none
+  vector<vector<Flit *> > _ejected_this_cycle;
+
+  // Subnets share no routers or channels, so with parallel_subnets set the
+  // network phases of subnets 1.._subnets-1 run on one worker thread each
+  // while the calling thread steps subnet 0. Traffic manager bookkeeping
+  // between the phases stays serial.
+  enum NetworkPhase { phase_read_inputs, phase_evaluate };
+
+  struct SubnetWorker {
+    GPUTrafficManager * tm;
+    int subnet;
+    pthread_t thread;
+  };
+
+  bool _parallel_subnets;
+  vector<SubnetWorker> _subnet_workers;
+  pthread_mutex_t _worker_lock;
+  pthread_cond_t _worker_wake;
+  unsigned _worker_generation;
+  unsigned _workers_done;
+  int _workers_sleeping;
+  NetworkPhase _worker_phase;
+  bool _workers_exit;
+
+  bool _CanStepSubnetsInParallel( const Configuration &config ) const;
+  void _StartSubnetWorkers( );
+  void _StopSubnetWorkers( );
+  static void * _SubnetWorkerMain( void * arg );
+  void _StepNetwork( int subnet, NetworkPhase phase );
+  void _StepNetworks( NetworkPhase phase );
   
 public:
   
@@ -57,6 +92,9 @@ public:
   
   // correspond to TrafficManger::Run/SingleSim
   void Init();
+
+  // true if subnet worker threads were started (parallel_subnets)
+  bool ParallelSubnets() const { return _parallel_subnets; }
   
   // TODO: if it is not good...
   friend class InterconnectInterface;
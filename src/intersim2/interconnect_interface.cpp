@@ -342,6 +342,11 @@ void InterconnectInterface::WriteOutBuffer(int subnet, int output_icntID, Flit*
   _ejection_buffer[subnet][output_icntID][vc].push(flit);
 }
 
+bool InterconnectInterface::UsesWorkerThreads() const
+{
+  return _traffic_manager->ParallelSubnets();
+}
+
 int InterconnectInterface::GetIcntTime() const
 {
   return _traffic_manager->getTime();
@@ -61,6 +61,8 @@ public:
   virtual void DisplayStats() const;
   virtual void DisplayOverallStats() const;
   unsigned GetFlitSize() const;
+  // true if stepping the network relies on helper threads
+  bool UsesWorkerThreads() const;
   
   virtual void DisplayState(FILE* fp) const;
   
@@ -43,6 +43,9 @@ IntersimConfig::IntersimConfig()
   _int_map["input_buffer_size"] = 0;
   _int_map["ejection_buffer_size"] = 0; // if left zero the simulator will use the vc_buf_size instead
   _int_map["boundary_buffer_size"] = 16;
+
+  // step each subnet's routers and channels on its own thread
+  _int_map["parallel_subnets"] = 0;
   
 
   // FIXME: obsolete, unsupport configs
@@ -179,30 +179,43 @@ void Network::_Alloc( )
   }
 }
 
+// Only modules in _active_modules are stepped. Channels are woken when a flit
+// or credit is sent into them and wake the router that reads them when it
+// comes out the other end; a router stays in the set until it has nothing
+// buffered. Skipped modules would have done nothing, so results are unchanged.
 void Network::ReadInputs( )
 {
-  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
-      iter != _timed_modules.end();
+  // topologies add their routers after _Alloc(), so register lazily
+  while(_active_modules.Size() < _timed_modules.size()) {
+    _active_modules.Add(_timed_modules[_active_modules.Size()]);
+  }
+  _active_modules.Update();
+
+  vector<int> const & active = _active_modules.Active();
+  for(vector<int>::const_iterator iter = active.begin();
+      iter != active.end();
       ++iter) {
-    (*iter)->ReadInputs( );
+    _active_modules.GetModule(*iter)->ReadInputs( );
   }
 }
 
 void Network::Evaluate( )
 {
-  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
-      iter != _timed_modules.end();
+  vector<int> const & active = _active_modules.Active();
+  for(vector<int>::const_iterator iter = active.begin();
+      iter != active.end();
       ++iter) {
-    (*iter)->Evaluate( );
+    _active_modules.GetModule(*iter)->Evaluate( );
   }
 }
 
 void Network::WriteOutputs( )
 {
-  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
-      iter != _timed_modules.end();
+  vector<int> const & active = _active_modules.Active();
+  for(vector<int>::const_iterator iter = active.begin();
+      iter != active.end();
       ++iter) {
-    (*iter)->WriteOutputs( );
+    _active_modules.GetModule(*iter)->WriteOutputs( );
   }
 }
 
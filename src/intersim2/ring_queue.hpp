@@ -0,0 +1,123 @@
+/*
+ Copyright (c) 2007-2012, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+//////////////////////////////////////////////////////////////////////
+//
+//  File Name: ring_queue.hpp
+//
+//  A FIFO kept in a circular vector. Unlike std::deque or std::list
+//   it allocates only when it grows past its largest size so far, so
+//   queues that are filled and drained every cycle stop allocating
+//   once they reach their steady-state depth.
+//
+//  Growing moves the elements: references and iterators into the
+//   queue are only valid until the next push_back.
+//
+/////
+#ifndef _RING_QUEUE_HPP_
+#define _RING_QUEUE_HPP_
+
+#include <vector>
+#include <cassert>
+#include <cstddef>
+
+using namespace std;
+
+template<typename T>
+class RingQueue {
+public:
+  class iterator {
+  public:
+    iterator() : _q(0), _i(0) {}
+    iterator(RingQueue * q, size_t i) : _q(q), _i(i) {}
+    T & operator*() const { return _q->_at(_i); }
+    T * operator->() const { return &_q->_at(_i); }
+    iterator & operator++() { ++_i; return *this; }
+    bool operator==(iterator const & other) const { return _i == other._i; }
+    bool operator!=(iterator const & other) const { return _i != other._i; }
+  private:
+    RingQueue * _q;
+    size_t _i;
+  };
+
+  RingQueue() : _head(0), _count(0) {}
+
+  bool empty() const { return !_count; }
+  size_t size() const { return _count; }
+
+  T & front() { assert(_count); return _data[_head]; }
+  T const & front() const { assert(_count); return _data[_head]; }
+
+  void push_back(T const & item);
+  void pop_front();
+  void clear() { _head = 0; _count = 0; }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, _count); }
+
+private:
+  T & _at(size_t i) {
+    size_t pos = _head + i;
+    if(pos >= _data.size()) {
+      pos -= _data.size();
+    }
+    return _data[pos];
+  }
+
+  vector<T> _data;
+  size_t _head;
+  size_t _count;
+};
+
+template<typename T>
+void RingQueue<T>::push_back(T const & item) {
+  if(_count == _data.size()) {
+    // item may refer into the old storage
+    T const copy = item;
+    vector<T> grown;
+    grown.reserve(_data.empty() ? 8 : 2 * _data.size());
+    for(size_t i = 0; i < _count; ++i) {
+      grown.push_back(_at(i));
+    }
+    grown.resize(grown.capacity());
+    _data.swap(grown);
+    _head = 0;
+    _data[_count++] = copy;
+    return;
+  }
+  _at(_count) = item;
+  ++_count;
+}
+
+template<typename T>
+void RingQueue<T>::pop_front() {
+  assert(_count);
+  if(++_head == _data.size()) {
+    _head = 0;
+  }
+  --_count;
+}
+
+#endif
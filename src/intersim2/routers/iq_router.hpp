@@ -36,6 +36,7 @@
 
 #include "router.hpp"
 #include "routefunc.hpp"
+#include "ring_queue.hpp"
 
 using namespace std;
 
@@ -67,18 +68,21 @@ class IQRouter : public Router {
   int _vc_alloc_delay;
   int _sw_alloc_delay;
   
-  map<int, Flit *> _in_queue_flits;
+  // staged per input / per input credit port for the current cycle
+  vector<Flit *> _in_queue_flits;
 
-  deque<pair<int, pair<Credit *, int> > > _proc_credits;
+  // pipeline stages; ring buffers so that the steady flow of VCs and flits
+  // through them does not allocate
+  RingQueue<pair<int, pair<Credit *, int> > > _proc_credits;
 
-  deque<pair<int, pair<int, int> > > _route_vcs;
-  deque<pair<int, pair<pair<int, int>, int> > > _vc_alloc_vcs;  
-  deque<pair<int, pair<pair<int, int>, int> > > _sw_hold_vcs;
-  deque<pair<int, pair<pair<int, int>, int> > > _sw_alloc_vcs;
+  RingQueue<pair<int, pair<int, int> > > _route_vcs;
+  RingQueue<pair<int, pair<pair<int, int>, int> > > _vc_alloc_vcs;  
+  RingQueue<pair<int, pair<pair<int, int>, int> > > _sw_hold_vcs;
+  RingQueue<pair<int, pair<pair<int, int>, int> > > _sw_alloc_vcs;
 
-  deque<pair<int, pair<Flit *, pair<int, int> > > > _crossbar_flits;
+  RingQueue<pair<int, pair<Flit *, pair<int, int> > > > _crossbar_flits;
 
-  map<int, Credit *> _out_queue_credits;
+  vector<Credit *> _out_queue_credits;
 
   vector<Buffer *> _buf;
   vector<BufferState *> _next_buf;
@@ -93,9 +97,9 @@ class IQRouter : public Router {
   tRoutingFunction   _rf;
 
   int _output_buffer_size;
-  vector<queue<Flit *> > _output_buffer;
+  vector<RingQueue<Flit *> > _output_buffer;
 
-  vector<queue<Credit *> > _credit_buffer;
+  vector<RingQueue<Credit *> > _credit_buffer;
 
   bool _hold_switch_for_packet;
   vector<int> _switch_hold_in;
@@ -160,6 +164,8 @@ public:
 
   virtual void ReadInputs( );
   virtual void WriteOutputs( );
+
+  virtual bool IsIdle( ) const;
   
   void Display( ostream & os = cout ) const;
 
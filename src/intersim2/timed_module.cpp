@@ -0,0 +1,77 @@
+/*
+ Copyright (c) 2007-2012, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+
+#include "timed_module.hpp"
+
+void ActiveModuleSet::Add(TimedModule * module)
+{
+  int const id = _modules.size();
+  _modules.push_back(module);
+  _active.push_back(id);
+  _is_active.push_back(true);
+  _is_woken.push_back(false);
+  module->SetActiveSet(this, id);
+}
+
+void ActiveModuleSet::Wake(int id)
+{
+  if(!_is_woken[id]) {
+    _is_woken[id] = true;
+    _woken.push_back(id);
+  }
+}
+
+void ActiveModuleSet::Update()
+{
+  size_t k = 0;
+  for(size_t i = 0; i < _active.size(); ++i) {
+    int const id = _active[i];
+    if(_is_woken[id] || !_modules[id]->IsIdle()) {
+      _active[k++] = id;
+    } else {
+      _is_active[id] = false;
+    }
+  }
+  _active.resize(k);
+
+  size_t const kept = _active.size();
+  for(size_t i = 0; i < _woken.size(); ++i) {
+    int const id = _woken[i];
+    _is_woken[id] = false;
+    if(!_is_active[id]) {
+      _is_active[id] = true;
+      _active.push_back(id);
+    }
+  }
+  _woken.clear();
+
+  // keep the original module order so results match a full sweep
+  if(_active.size() > kept) {
+    sort(_active.begin() + kept, _active.end());
+    inplace_merge(_active.begin(), _active.begin() + kept, _active.end());
+  }
+}
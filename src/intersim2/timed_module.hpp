@@ -28,17 +28,72 @@
 #ifndef _TIMED_MODULE_HPP_
 #define _TIMED_MODULE_HPP_
 
+#include <vector>
+
 #include "module.hpp"
 
+class TimedModule;
+
+// Set of timed modules that need to be stepped. A module leaves the set once
+// IsIdle() reports that stepping it would be a no-op, and is put back by
+// Wake() when a flit or credit is sent to it.
+class ActiveModuleSet {
+
+public:
+  void Add(TimedModule * module);
+  inline size_t Size() const {return _modules.size();}
+
+  void Wake(int id);
+  // drop idle modules and merge the ones woken since the last call
+  void Update();
+
+  inline vector<int> const & Active() const {return _active;}
+  inline TimedModule * GetModule(int id) const {return _modules[id];}
+
+private:
+  vector<TimedModule *> _modules;
+  vector<int> _active;
+  vector<int> _woken;
+  vector<bool> _is_active;
+  vector<bool> _is_woken;
+};
+
 class TimedModule : public Module {
 
+  ActiveModuleSet * _active_set;
+  int _active_id;
+  TimedModule * _consumer;
+
+protected:
+  // schedule this module / the module that reads its outputs
+  inline void _Wake() {
+    if(_active_set) {
+      _active_set->Wake(_active_id);
+    }
+  }
+  inline void _WakeConsumer() {
+    if(_consumer) {
+      _consumer->_Wake();
+    }
+  }
+
 public:
-  TimedModule(Module * parent, string const & name) : Module(parent, name) {}
+  TimedModule(Module * parent, string const & name)
+    : Module(parent, name), _active_set(0), _active_id(-1), _consumer(0) {}
   virtual ~TimedModule() {}
   
   virtual void ReadInputs() = 0;
   virtual void Evaluate() = 0;
   virtual void WriteOutputs() = 0;
+
+  // true if a step without new input would not change any state
+  virtual bool IsIdle() const {return false;}
+
+  void SetActiveSet(ActiveModuleSet * active_set, int id) {
+    _active_set = active_set;
+    _active_id = id;
+  }
+  void SetConsumer(TimedModule * consumer) {_consumer = consumer;}
 };
 
 #endif
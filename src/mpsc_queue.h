@@ -0,0 +1,203 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MPSC_QUEUE_H_INCLUDED
+#define MPSC_QUEUE_H_INCLUDED
+
+#include <assert.h>
+#include <stdlib.h>
+
+// Lock-free queues with many producers and a single consumer, built on the
+// GCC __sync builtins.  Neither allocates once constructed.
+
+// Bounded FIFO over a preallocated ring of cells.
+//
+// Each cell carries a sequence number that tells its state for the current
+// lap of the ring: equal to the position when free for a producer, one more
+// when it holds a published value.  Producers claim a position with a
+// compare-and-swap on m_tail, copy the value in and then publish it by
+// advancing the cell's sequence number; the consumer frees the cell by
+// moving its sequence number on to the next lap.  A claimed but not yet
+// published cell at the head makes front() return NULL until its producer
+// is done.
+template<class T> class mpsc_ring {
+public:
+   explicit mpsc_ring( unsigned capacity /* a power of two */ )
+   {
+      assert( capacity > 0 && (capacity & (capacity-1)) == 0 );
+      m_mask = capacity - 1;
+      m_cells = new cell[capacity];
+      for( unsigned i=0; i < capacity; i++ ) 
+         m_cells[i].seq = i;
+      m_head = m_tail = 0;
+   }
+   ~mpsc_ring()
+   {
+      delete[] m_cells;
+   }
+
+   // producers: false, and nothing queued, if the ring is full
+   bool try_push( const T &value )
+   {
+      unsigned pos = m_tail;
+      cell *c;
+      for(;;) {
+         c = &m_cells[pos & m_mask];
+         __sync_synchronize();
+         int dif = (int)(c->seq - pos);
+         if( dif == 0 ) {
+            if( __sync_bool_compare_and_swap(&m_tail,pos,pos+1) ) 
+               break;
+         } else if( dif < 0 ) {
+            return false; // the consumer has not freed this cell yet
+         }
+         pos = m_tail; // another producer took pos
+      }
+      c->value = value;
+      __sync_synchronize();
+      c->seq = pos + 1;
+      return true;
+   }
+
+   // any thread: whether a push would find the ring full right now
+   bool full() const
+   {
+      __sync_synchronize();
+      return m_tail - m_head > m_mask;
+   }
+
+   // consumer: oldest element, NULL if there is none or its producer is
+   // still copying it in
+   T *front()
+   {
+      cell *c = &m_cells[m_head & m_mask];
+      if( c->seq != m_head + 1 ) 
+         return NULL;
+      __sync_synchronize();
+      return &c->value;
+   }
+
+   // consumer: drop the element returned by front()
+   void pop()
+   {
+      cell *c = &m_cells[m_head & m_mask];
+      assert( c->seq == m_head + 1 );
+      __sync_synchronize();
+      c->seq = m_head + m_mask + 1;
+      m_head = m_head + 1;
+   }
+
+private:
+   struct cell {
+      volatile unsigned seq;
+      T value;
+   };
+
+   mpsc_ring( const mpsc_ring & ); // not copyable
+   mpsc_ring &operator=( const mpsc_ring & );
+
+   cell *m_cells;
+   unsigned m_mask;
+   char m_pad0[64];
+   volatile unsigned m_head; // consumer side
+   char m_pad1[64]; // keep the two ends on separate cache lines
+   volatile unsigned m_tail; // producer side
+};
+
+// Unbounded intrusive FIFO of objects derived from mpsc_node; an object can
+// be in at most one such queue at a time.
+//
+// Producers swap themselves in as the newest node and then link the
+// previous newest node to them, so a push never waits.  Between those two
+// steps the list is briefly cut, and pop() returns NULL rather than wait;
+// the consumer simply tries again later.  A stub node keeps the list
+// non-empty so that the last real node can be handed out.
+struct mpsc_node {
+   mpsc_node() : m_mpsc_next(NULL) {}
+   mpsc_node * volatile m_mpsc_next;
+};
+
+template<class T> class mpsc_list {
+public:
+   mpsc_list()
+   {
+      m_head = m_tail = &m_stub;
+   }
+
+   // producers
+   void push( T *value )
+   {
+      link( static_cast<mpsc_node*>(value) );
+   }
+
+   // consumer: oldest element, removed from the queue; NULL if there is
+   // none or a push is half done
+   T *pop()
+   {
+      mpsc_node *tail = m_tail;
+      mpsc_node *next = tail->m_mpsc_next;
+      if( tail == &m_stub ) {
+         if( next == NULL ) 
+            return NULL;
+         m_tail = tail = next;
+         next = next->m_mpsc_next;
+      }
+      if( next == NULL ) {
+         __sync_synchronize();
+         if( tail != m_head ) 
+            return NULL; // a producer has swapped in but not linked yet
+         link(&m_stub);
+         next = tail->m_mpsc_next;
+         if( next == NULL ) 
+            return NULL;
+      }
+      __sync_synchronize();
+      m_tail = next;
+      return static_cast<T*>(tail);
+   }
+
+private:
+   void link( mpsc_node *n )
+   {
+      n->m_mpsc_next = NULL;
+      mpsc_node *prev = m_head;
+      __sync_synchronize();
+      while( !__sync_bool_compare_and_swap(&m_head,prev,n) ) 
+         prev = m_head;
+      prev->m_mpsc_next = n;
+   }
+
+   mpsc_list( const mpsc_list & ); // not copyable
+   mpsc_list &operator=( const mpsc_list & );
+
+   mpsc_node * volatile m_head; // producer side, newest node
+   char m_pad[64]; // keep the two ends on separate cache lines
+   mpsc_node *m_tail; // consumer side, oldest node
+   mpsc_node m_stub;
+};
+
+#endif
@@ -0,0 +1,338 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// ptx_runner: run one PTX kernel on GPGPU-Sim without a CUDA host program.
+//
+//   ptx_runner -ptx <file.ptx> -kernel <name> -grid X[,Y[,Z]] -block X[,Y[,Z]]
+//              -args <argfile> [-out <prefix>] [-functional]
+//              [-regs N] [-smem N] [-lmem N] [-cmem N] [gpgpu-sim options...]
+//
+// The simulator is configured from ./gpgpusim.config (or -config <file>)
+// plus any remaining options on the command line.  -functional skips the
+// timing model; otherwise -gpgpu_timing_kernels and friends decide as for a
+// CUDA application.  No ptxas is run, so the kernel's resource usage is
+// taken from -regs/-smem/-lmem/-cmem (default 0).  Globals with explicit
+// initializers in the PTX are not loaded.
+//
+// The argument file describes the device buffers and the kernel arguments
+// (host byte order):
+//   "PTXARGS\0", u32 version (1)
+//   u32 n_buffers, then per buffer:
+//     u64 size, u32 flags (bit 0: write to <prefix><n>.bin after the kernel),
+//     u64 init_size (<= size), init_size bytes copied to the start of the buffer
+//   u32 n_args, then per argument in parameter order:
+//     u32 kind, u32 size, and
+//       kind 0 (value):  size bytes
+//       kind 1 (buffer): u32 buffer index; the argument is the buffer's device
+//                        address, size is the pointer width (4 or 8)
+// The number and byte sizes of the arguments are checked against the
+// kernel's parameters before the launch.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "../gpgpusim_entrypoint.h"
+#include "../abstract_hardware_model.h"
+#include "../cuda-sim/cuda-sim.h"
+#include "../cuda-sim/ptx_ir.h"
+#include "../cuda-sim/ptx_loader.h"
+#include "../gpgpu-sim/gpu-sim.h"
+
+#define PTX_ARGS_MAGIC "PTXARGS"
+#define PTX_ARGS_VERSION 1
+#define PTX_ARG_VALUE 0
+#define PTX_ARG_BUFFER 1
+#define PTX_BUFFER_DUMP 1
+
+// the runtime hooks libcuda and libopencl otherwise provide to cuda-sim
+void register_ptx_function( const char *name, function_info *impl )
+{
+}
+
+void ptxinfo_addinfo()
+{
+}
+
+struct runner_buffer {
+   unsigned long long size;
+   unsigned flags;
+   std::vector<unsigned char> init;
+   unsigned long long addr;
+};
+
+struct runner_arg {
+   unsigned kind;
+   std::vector<unsigned char> data; // value, or the device address once buffers are placed
+   unsigned buffer;
+};
+
+static void usage( const char *argv0 )
+{
+   printf("usage: %s -ptx <file.ptx> -kernel <name> -grid X[,Y[,Z]] -block X[,Y[,Z]] -args <argfile>\n"
+          "          [-out <prefix>] [-functional] [-regs N] [-smem N] [-lmem N] [-cmem N]\n"
+          "          [gpgpu-sim options...]\n", argv0);
+   exit(1);
+}
+
+static void fatal( const char *msg, const char *arg )
+{
+   printf("ptx_runner: ERROR ** %s %s\n", msg, arg);
+   exit(1);
+}
+
+static dim3 parse_dim3( const char *s )
+{
+   dim3 d;
+   d.x = d.y = d.z = 1;
+   int n = sscanf(s,"%u,%u,%u",&d.x,&d.y,&d.z);
+   if( n < 1 || !d.x || !d.y || !d.z ) 
+      fatal("bad dimensions",s);
+   return d;
+}
+
+static std::string read_text_file( const char *filename )
+{
+   FILE *fp = fopen(filename,"r");
+   if( !fp ) 
+      fatal("cannot open",filename);
+   std::string result;
+   char buf[4096];
+   size_t n;
+   while( (n = fread(buf,1,sizeof(buf),fp)) > 0 ) 
+      result.append(buf,n);
+   fclose(fp);
+   return result;
+}
+
+static void read_bytes( FILE *fp, void *dst, size_t size, const char *filename )
+{
+   if( size && fread(dst,1,size,fp) != size ) 
+      fatal("truncated argument file",filename);
+}
+
+static unsigned read_u32( FILE *fp, const char *filename )
+{
+   unsigned v;
+   read_bytes(fp,&v,sizeof(v),filename);
+   return v;
+}
+
+static unsigned long long read_u64( FILE *fp, const char *filename )
+{
+   unsigned long long v;
+   read_bytes(fp,&v,sizeof(v),filename);
+   return v;
+}
+
+static void read_arg_file( const char *filename, std::vector<runner_buffer> &buffers, std::vector<runner_arg> &args )
+{
+   FILE *fp = fopen(filename,"rb");
+   if( !fp ) 
+      fatal("cannot open",filename);
+   char magic[8];
+   read_bytes(fp,magic,sizeof(magic),filename);
+   if( memcmp(magic,PTX_ARGS_MAGIC,sizeof(magic)) || read_u32(fp,filename) != PTX_ARGS_VERSION ) 
+      fatal("not a ptx_runner argument file (or wrong version):",filename);
+
+   buffers.resize(read_u32(fp,filename));
+   for( unsigned n=0; n < buffers.size(); n++ ) {
+      runner_buffer &b = buffers[n];
+      b.size = read_u64(fp,filename);
+      b.flags = read_u32(fp,filename);
+      unsigned long long init_size = read_u64(fp,filename);
+      if( init_size > b.size ) 
+         fatal("buffer initializer larger than the buffer in",filename);
+      b.init.resize(init_size);
+      read_bytes(fp,b.init.empty() ? NULL : &b.init[0],init_size,filename);
+      b.addr = 0;
+   }
+
+   args.resize(read_u32(fp,filename));
+   for( unsigned n=0; n < args.size(); n++ ) {
+      runner_arg &a = args[n];
+      a.kind = read_u32(fp,filename);
+      unsigned size = read_u32(fp,filename);
+      a.data.resize(size);
+      a.buffer = 0;
+      if( a.kind == PTX_ARG_VALUE ) {
+         read_bytes(fp,a.data.empty() ? NULL : &a.data[0],size,filename);
+      } else if( a.kind == PTX_ARG_BUFFER ) {
+         a.buffer = read_u32(fp,filename);
+         if( a.buffer >= buffers.size() || (size != 4 && size != 8) ) 
+            fatal("bad buffer argument in",filename);
+      } else {
+         fatal("unknown argument kind in",filename);
+      }
+   }
+   fclose(fp);
+}
+
+int main( int argc, const char *argv[] )
+{
+   const char *ptx_file = NULL;
+   const char *kernel_name = NULL;
+   const char *arg_file = NULL;
+   const char *out_prefix = "ptx_runner_out_";
+   dim3 grid, block;
+   bool have_grid = false, have_block = false, functional = false, have_config = false;
+   gpgpu_ptx_sim_kernel_info kinfo;
+   memset(&kinfo,0,sizeof(kinfo));
+
+   // runner options are taken out, the rest goes to the simulator
+   std::vector<const char*> sim_argv;
+   sim_argv.push_back(argv[0]);
+   for( int i=1; i < argc; i++ ) {
+      std::string opt = argv[i];
+      bool has_value = i+1 < argc;
+      if( opt == "-functional" ) functional = true;
+      else if( opt == "-ptx" && has_value ) ptx_file = argv[++i];
+      else if( opt == "-kernel" && has_value ) kernel_name = argv[++i];
+      else if( opt == "-args" && has_value ) arg_file = argv[++i];
+      else if( opt == "-out" && has_value ) out_prefix = argv[++i];
+      else if( opt == "-grid" && has_value ) { grid = parse_dim3(argv[++i]); have_grid = true; }
+      else if( opt == "-block" && has_value ) { block = parse_dim3(argv[++i]); have_block = true; }
+      else if( opt == "-regs" && has_value ) kinfo.regs = atoi(argv[++i]);
+      else if( opt == "-smem" && has_value ) kinfo.smem = atoi(argv[++i]);
+      else if( opt == "-lmem" && has_value ) kinfo.lmem = atoi(argv[++i]);
+      else if( opt == "-cmem" && has_value ) kinfo.cmem = atoi(argv[++i]);
+      else if( opt == "-help" || opt == "--help" ) usage(argv[0]);
+      else {
+         if( opt == "-config" ) 
+            have_config = true;
+         sim_argv.push_back(argv[i]);
+      }
+   }
+   if( !ptx_file || !kernel_name || !arg_file || !have_grid || !have_block ) 
+      usage(argv[0]);
+   if( !have_config ) {
+      sim_argv.insert(sim_argv.begin()+1,"gpgpusim.config");
+      sim_argv.insert(sim_argv.begin()+1,"-config");
+   }
+
+   std::vector<runner_buffer> buffers;
+   std::vector<runner_arg> args;
+   read_arg_file(arg_file,buffers,args);
+
+   print_splash();
+   gpgpu_sim_config config;
+   gpgpu_sim *gpu = gpgpu_ptx_sim_create_gpu(config,sim_argv.size(),&sim_argv[0]);
+
+   std::string ptx = read_text_file(ptx_file);
+   symbol_table *symtab = gpgpu_ptx_sim_load_ptx_from_string(ptx.c_str(),1);
+   symbol *s = symtab->lookup(kernel_name);
+   function_info *entry = s ? s->get_pc() : NULL;
+   if( !entry || !entry->is_entry_point() ) 
+      fatal("no kernel entry point named",kernel_name);
+   entry->set_kernel_info(kinfo);
+
+   // the argument file must match the kernel's parameter list, finalize()
+   // would otherwise read past short arguments or abort on missing ones
+   const std::map<unsigned,param_info> &formals = entry->get_param_info();
+   if( args.size() != formals.size() ) {
+      printf("ptx_runner: ERROR ** kernel %s takes %zu argument(s), %s has %zu\n",
+             kernel_name, formals.size(), arg_file, args.size());
+      usage(argv[0]);
+   }
+   for( unsigned n=0; n < args.size(); n++ ) {
+      std::map<unsigned,param_info>::const_iterator f = formals.find(n);
+      if( f == formals.end() ) {
+         printf("ptx_runner: ERROR ** kernel %s has no parameter %u\n", kernel_name, n);
+         usage(argv[0]);
+      }
+      size_t nbytes = f->second.get_size() / 8;
+      if( args[n].data.size() != nbytes ) {
+         printf("ptx_runner: ERROR ** argument %u of %s is %zu bytes, parameter %s is %zu bytes\n",
+                n, arg_file, args[n].data.size(), f->second.get_name().c_str(), nbytes);
+         usage(argv[0]);
+      }
+   }
+
+   // place and initialize the buffers, then resolve buffer arguments
+   for( unsigned n=0; n < buffers.size(); n++ ) {
+      runner_buffer &b = buffers[n];
+      b.addr = (unsigned long long)(size_t)gpu->gpu_malloc(b.size);
+      gpu->gpu_memset(b.addr,0,b.size);
+      if( !b.init.empty() ) 
+         gpu->memcpy_to_gpu(b.addr,&b.init[0],b.init.size());
+   }
+   for( unsigned n=0; n < args.size(); n++ ) {
+      runner_arg &a = args[n];
+      if( a.kind == PTX_ARG_BUFFER ) 
+         memcpy(&a.data[0],&buffers[a.buffer].addr,a.data.size());
+   }
+
+   kernel_info_t *kernel = new kernel_info_t(grid,block,entry);
+   gpu->assign_launch_index(kernel);
+   std::vector<gpgpu_ptx_sim_arg> params(args.size());
+   for( unsigned n=0; n < args.size(); n++ ) {
+      params[n] = gpgpu_ptx_sim_arg(args[n].data.empty() ? NULL : &args[n].data[0],args[n].data.size(),0);
+      entry->add_param_data(n,&params[n]);
+   }
+   entry->finalize(kernel->get_param_memory());
+
+   printf("ptx_runner: launching %s grid (%u,%u,%u) block (%u,%u,%u)\n", kernel_name,
+          grid.x, grid.y, grid.z, block.x, block.y, block.z);
+   bool timing = !functional && gpu->timing_simulate_kernel(kernel);
+   if( timing ) {
+      gpu->init();
+      gpu->launch(kernel);
+      while( gpu->active() ) {
+         gpu->cycle();
+         gpu->deadlock_check();
+      }
+      gpu->print_stats();
+      printf("ptx_runner: %s cycles = %llu insn = %llu ipc = %.4f\n", kernel_name,
+             gpu_sim_cycle, gpu->gpu_sim_insn, gpu_sim_cycle ? (double)gpu->gpu_sim_insn / gpu_sim_cycle : 0.0);
+      gpu->update_stats();
+   } else {
+      gpgpu_cuda_ptx_sim_main_func(*kernel,true);
+      printf("ptx_runner: %s executed functionally\n", kernel_name);
+   }
+   delete kernel;
+
+   for( unsigned n=0; n < buffers.size(); n++ ) {
+      const runner_buffer &b = buffers[n];
+      if( !(b.flags & PTX_BUFFER_DUMP) ) 
+         continue;
+      std::vector<unsigned char> data(b.size);
+      if( b.size ) 
+         gpu->memcpy_from_gpu(&data[0],b.addr,b.size);
+      char filename[1024];
+      snprintf(filename,sizeof(filename),"%s%u.bin",out_prefix,n);
+      FILE *fp = fopen(filename,"wb");
+      if( !fp || (b.size && fwrite(&data[0],1,data.size(),fp) != data.size()) ) 
+         fatal("cannot write",filename);
+      fclose(fp);
+      printf("ptx_runner: buffer %u (%llu bytes) written to %s\n", n, b.size, filename);
+   }
+   fflush(stdout);
+   return 0;
+}
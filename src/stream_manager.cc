@@ -29,85 +29,77 @@
 #include "gpgpusim_entrypoint.h"
 #include "cuda-sim/cuda-sim.h"
 #include "gpgpu-sim/gpu-sim.h"
+#include "gpgpu-sim/kernel_workers.h"
+#include "gpgpu-sim/workload_log.h"
 
 unsigned CUstream_st::sm_next_stream_uid = 0;
 
 CUstream_st::CUstream_st() 
+    : m_operations(MAX_QUEUED_STREAM_OPERATIONS)
 {
     m_pending = false;
+    m_size = 0;
+    m_scheduled = 0;
+    m_manager = NULL;
     m_uid = sm_next_stream_uid++;
-    pthread_mutex_init(&m_lock,NULL);
+}
+
+CUstream_st::~CUstream_st()
+{
 }
 
 bool CUstream_st::empty()
 {
-    pthread_mutex_lock(&m_lock);
-    bool empty = m_operations.empty();
-    pthread_mutex_unlock(&m_lock);
-    return empty;
+    __sync_synchronize();
+    return m_size == 0;
 }
 
 bool CUstream_st::busy()
 {
-    pthread_mutex_lock(&m_lock);
-    bool pending = m_pending;
-    pthread_mutex_unlock(&m_lock);
-    return pending;
+    // called by gpu thread
+    return m_pending;
 }
 
 void CUstream_st::synchronize() 
 {
     // called by host thread
-    bool done=false;
-    do{
-        pthread_mutex_lock(&m_lock);
-        done = m_operations.empty();
-        pthread_mutex_unlock(&m_lock);
-    } while ( !done );
+    m_manager->wait_stream(this);
 }
 
 void CUstream_st::push( const stream_operation &op )
 {
-    // called by host thread
-    pthread_mutex_lock(&m_lock);
-    m_operations.push_back( op );
-    pthread_mutex_unlock(&m_lock);
+    // called by host thread; counted before it is queued, so a retiring
+    // operation never sees the stream empty while this one is on its way
+    __sync_add_and_fetch(&m_size,1);
+    while( !m_operations.try_push(op) ) 
+        m_manager->wait_stream_space(this);
 }
 
 void CUstream_st::record_next_done()
 {
     // called by gpu thread
-    pthread_mutex_lock(&m_lock);
     assert(m_pending);
-    m_operations.pop_front();
+    m_operations.pop();
     m_pending=false;
-    pthread_mutex_unlock(&m_lock);
+    m_manager->operation_done(this); // may be the last access to this stream
 }
 
 
 stream_operation CUstream_st::next()
 {
-    // called by gpu thread
-    pthread_mutex_lock(&m_lock);
+    // called by gpu thread; a no-op while a host thread is still copying
+    // the front operation in
+    stream_operation *op = m_operations.front();
+    if( op == NULL ) 
+        return stream_operation();
     m_pending = true;
-    stream_operation result = m_operations.front();
-    pthread_mutex_unlock(&m_lock);
-    return result;
+    return *op;
 }
 
 void CUstream_st::print(FILE *fp)
 {
-    pthread_mutex_lock(&m_lock);
-    fprintf(fp,"GPGPU-Sim API:    stream %u has %zu operations\n", m_uid, m_operations.size() );
-    std::list<stream_operation>::iterator i;
-    unsigned n=0;
-    for( i=m_operations.begin(); i!=m_operations.end(); i++ ) {
-        stream_operation &op = *i;
-        fprintf(fp,"GPGPU-Sim API:       %u : ", n++);
-        op.print(fp);
-        fprintf(fp,"\n");
-    }
-    pthread_mutex_unlock(&m_lock);
+    // the operations themselves belong to the simulation thread; only report how many there are
+    fprintf(fp,"GPGPU-Sim API:    stream %u has %u operations\n", m_uid, m_size );
 }
 
 
@@ -154,16 +146,25 @@ void stream_operation::do_operation( gpgpu_sim *gpu )
         if( gpu->can_start_kernel() ) {
         	gpu->set_cache_config(m_kernel->name());
         	printf("kernel \'%s\' transfer to GPU hardware scheduler\n", m_kernel->name().c_str() );
-            if( m_sim_mode )
+            if( g_workload_recorder && g_workload_recorder->records(gpu) ) 
+                g_workload_recorder->launch(m_kernel);
+            if( !gpu->checkpoint_kernel_launch(m_kernel) ) {
+                // precedes the checkpoint being restored: retire without simulating
+                g_stream_manager->register_finished_kernel(m_kernel->get_uid());
+            } else if( m_sim_mode || !gpu->timing_simulate_kernel(m_kernel) ) {
+                gpgpu_cuda_ptx_sim_main_func( *m_kernel );
+            } else if( gpu->get_kernel_workers() ) {
+                // a forked worker does the timing, this process only advances device memory
+                gpu->get_kernel_workers()->fork_kernel(gpu,m_kernel);
                 gpgpu_cuda_ptx_sim_main_func( *m_kernel );
-            else
+            } else
                 gpu->launch( m_kernel );
         }
         break;
     case stream_event: {
         printf("event update\n");
         time_t wallclock = time((time_t *)NULL);
-        m_event->update( gpu_tot_sim_cycle, wallclock );
+        m_event->update( gpu->tot_sim_cycle(), wallclock );
         m_stream->record_next_done();
         } 
         break;
@@ -194,22 +195,40 @@ stream_manager::stream_manager( gpgpu_sim *gpu, bool cuda_launch_blocking )
     m_gpu = gpu;
     m_service_stream_zero = false;
     m_cuda_launch_blocking = cuda_launch_blocking;
+    m_concurrent_ops = 0;
+    m_waiters = 0;
+    m_stream_zero.set_manager(this);
     pthread_mutex_init(&m_lock,NULL);
+    pthread_cond_init(&m_cond,NULL);
 }
 
 bool stream_manager::operation( bool * sim)
 {
-    pthread_mutex_lock(&m_lock);
+    // completions wake up waiting host threads from operation_done()
     bool check=check_finished_kernel();
     if(check)m_gpu->print_stats();
     stream_operation op =front();
     op.do_operation( m_gpu );
-    pthread_mutex_unlock(&m_lock);
-    //pthread_mutex_lock(&m_lock);
     // simulate a clock cycle on the GPU
     return check;
 }
 
+void stream_manager::operation_done( CUstream_st *stream )
+{
+    // called by gpu simulation thread
+    bool concurrent = stream != &m_stream_zero;
+    if( concurrent ) 
+        stream->unschedule();
+    unsigned remaining = stream->retire();
+    if( concurrent ) {
+        __sync_sub_and_fetch(&m_concurrent_ops,1);
+        // a host thread cannot destroy a stream that still has operations
+        if( remaining && stream->try_schedule() ) 
+            m_ready_local.push_back(stream);
+    }
+    notify();
+}
+
 bool stream_manager::check_finished_kernel()
 {
 
@@ -224,7 +243,9 @@ bool stream_manager::register_finished_kernel(unsigned grid_uid)
     // called by gpu simulation thread
     if(grid_uid > 0){
     CUstream_st *stream = m_grid_id_to_stream[grid_uid];
-    kernel_info_t *kernel = stream->front().get_kernel();
+    stream_operation *op = stream->front();
+    assert(op);
+    kernel_info_t *kernel = op->get_kernel();
     assert( grid_uid == kernel->get_uid() );
     stream->record_next_done();
     m_grid_id_to_stream.erase(grid_uid);
@@ -255,25 +276,37 @@ stream_operation stream_manager::front()
             m_service_stream_zero = false;
         }
     } else {
-        std::list<struct CUstream_st*>::iterator s;
-        for( s=m_streams.begin(); s != m_streams.end(); s++) {
-            CUstream_st *stream = *s;
-            if( !stream->busy() && !stream->empty() ) {
-                result = stream->next();
-                if( result.is_kernel() ) {
-                    unsigned grid_id = result.get_kernel()->get_uid();
-                    m_grid_id_to_stream[grid_id] = stream;
-                }
-                break;
+        CUstream_st *stream = next_ready_stream();
+        if( stream ) {
+            result = stream->next();
+            if( result.is_noop() ) 
+                m_ready_local.push_back(stream); // retry once its operation is copied in
+            else if( result.is_kernel() ) {
+                unsigned grid_id = result.get_kernel()->get_uid();
+                m_grid_id_to_stream[grid_id] = stream;
             }
         }
     }
     return result;
 }
 
+CUstream_st *stream_manager::next_ready_stream()
+{
+    // called by gpu simulation thread; streams are served in the order they became ready
+    CUstream_st *s;
+    while( (s = m_ready.pop()) != NULL ) 
+        m_ready_local.push_back(s);
+    if( m_ready_local.empty() ) 
+        return NULL;
+    CUstream_st *stream = m_ready_local.front();
+    m_ready_local.pop_front();
+    return stream;
+}
+
 void stream_manager::add_stream( struct CUstream_st *stream )
 {
     // called by host thread
+    stream->set_manager(this);
     pthread_mutex_lock(&m_lock);
     m_streams.push_back(stream);
     pthread_mutex_unlock(&m_lock);
@@ -282,9 +315,8 @@ void stream_manager::add_stream( struct CUstream_st *stream )
 void stream_manager::destroy_stream( CUstream_st *stream )
 {
     // called by host thread
+    stream->synchronize();
     pthread_mutex_lock(&m_lock);
-    while( !stream->empty() )
-        ; 
     std::list<CUstream_st *>::iterator s;
     for( s=m_streams.begin(); s != m_streams.end(); s++ ) {
         if( *s == stream ) {
@@ -298,39 +330,13 @@ void stream_manager::destroy_stream( CUstream_st *stream )
 
 bool stream_manager::concurrent_streams_empty()
 {
-    bool result = true;
-    // called by gpu simulation thread
-    std::list<struct CUstream_st *>::iterator s;
-    for( s=m_streams.begin(); s!=m_streams.end();++s ) {
-        struct CUstream_st *stream = *s;
-        if( !stream->empty() ) {
-            //stream->print(stdout);
-            result = false;
-        }
-    }
-    return result;
-}
-
-bool stream_manager::empty_protected()
-{
-    bool result = true;
-    pthread_mutex_lock(&m_lock);
-    if( !concurrent_streams_empty() )
-        result = false;
-    if( !m_stream_zero.empty() )
-        result = false;
-    pthread_mutex_unlock(&m_lock);
-    return result;
+    __sync_synchronize();
+    return m_concurrent_ops == 0;
 }
 
 bool stream_manager::empty()
 {
-    bool result = true;
-    if( !concurrent_streams_empty() ) 
-        result = false;
-    if( !m_stream_zero.empty() ) 
-        result = false;
-    return result;
+    return concurrent_streams_empty() && m_stream_zero.empty();
 }
 
 
@@ -355,37 +361,104 @@ void stream_manager::print_impl( FILE *fp)
 
 void stream_manager::push( stream_operation op )
 {
+    // called by host thread
     struct CUstream_st *stream = op.get_stream();
+    if( op.is_kernel() ) 
+        m_gpu->assign_launch_index(op.get_kernel());
 
     // block if stream 0 (or concurrency disabled) and pending concurrent operations exist
     bool block= !stream || m_cuda_launch_blocking;
-    while(block) {
-        pthread_mutex_lock(&m_lock);
-        block = !concurrent_streams_empty();
-        pthread_mutex_unlock(&m_lock);
-    };
-
-    pthread_mutex_lock(&m_lock);
+    if( block && !concurrent_streams_empty() ) {
+        begin_wait();
+        while( !concurrent_streams_empty() ) 
+            pthread_cond_wait(&m_cond,&m_lock);
+        end_wait();
+    }
     if( stream && !m_cuda_launch_blocking ) {
+        __sync_add_and_fetch(&m_concurrent_ops,1);
         stream->push(op);
+        if( stream->try_schedule() ) 
+            m_ready.push(stream);
     } else {
         op.set_stream(&m_stream_zero);
         m_stream_zero.push(op);
     }
     if(g_debug_execution >= 3)
-       print_impl(stdout);
-    pthread_mutex_unlock(&m_lock);
-    if( m_cuda_launch_blocking || stream == NULL ) {
-        unsigned int wait_amount = 100; 
-        unsigned int wait_cap = 100000; // 100ms 
-        while( !empty() ) {
-            // sleep to prevent CPU hog by empty spin
-            // sleep time increased exponentially ensure fast response when needed 
-            usleep(wait_amount); 
-            wait_amount *= 2; 
-            if (wait_amount > wait_cap) 
-               wait_amount = wait_cap; 
-        }
+       print(stdout);
+    notify(); // wake up the simulation thread
+    if( block ) {
+        begin_wait();
+        while( !empty() ) 
+            pthread_cond_wait(&m_cond,&m_lock);
+        end_wait();
     }
 }
 
+// A thread about to wait on m_cond registers in m_waiters before testing its
+// condition, and notify() reads m_waiters only after the state change it
+// announces; with a full barrier on both sides either the waiter sees the
+// change or notify() sees the waiter, so no wake-up is lost while the common
+// case of nobody waiting costs no lock.
+void stream_manager::begin_wait()
+{
+    pthread_mutex_lock(&m_lock);
+    __sync_add_and_fetch(&m_waiters,1);
+}
+
+void stream_manager::end_wait()
+{
+    __sync_sub_and_fetch(&m_waiters,1);
+    pthread_mutex_unlock(&m_lock);
+}
+
+void stream_manager::notify()
+{
+    __sync_synchronize();
+    if( m_waiters ) 
+        notify_all();
+}
+
+void stream_manager::wait_for_work( volatile bool *done )
+{
+    // called by gpu simulation thread
+    begin_wait();
+    while( empty() && !*done ) 
+        pthread_cond_wait(&m_cond,&m_lock);
+    end_wait();
+}
+
+void stream_manager::wait_event( CUevent_st *e )
+{
+    // called by host thread
+    begin_wait();
+    while( !e->done() ) 
+        pthread_cond_wait(&m_cond,&m_lock);
+    end_wait();
+}
+
+void stream_manager::wait_stream( CUstream_st *stream )
+{
+    // called by host thread
+    begin_wait();
+    while( !stream->empty() ) 
+        pthread_cond_wait(&m_cond,&m_lock);
+    end_wait();
+}
+
+void stream_manager::wait_stream_space( CUstream_st *stream )
+{
+    // called by host thread whose push found the stream's ring full;
+    // operation_done() notifies after every retired operation
+    begin_wait();
+    while( stream->full() ) 
+        pthread_cond_wait(&m_cond,&m_lock);
+    end_wait();
+}
+
+void stream_manager::notify_all()
+{
+    pthread_mutex_lock(&m_lock);
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_lock);
+}
+
@@ -29,6 +29,8 @@
 #define STREAM_MANAGER_H_INCLUDED
 
 #include "abstract_hardware_model.h"
+#include "mpsc_queue.h"
+#include <deque>
 #include <list>
 #include <pthread.h>
 #include <time.h>
@@ -209,29 +211,54 @@ private:
    static int m_next_event_uid;
 };
 
-struct CUstream_st {
+// Host threads block in CUstream_st::push() while this many operations are
+// queued on the stream, as they would on a full launch queue in hardware
+#define MAX_QUEUED_STREAM_OPERATIONS 1024
+
+// Operations of a stream sit in a lock-free ring filled by any number of
+// host threads and drained by the simulation thread alone.  m_size counts
+// queued operations including the one in progress and those a host thread
+// is still copying in; once a host thread sees it at zero the simulation
+// thread no longer touches the stream, so it may be destroyed.
+struct CUstream_st : public mpsc_node {
 public:
     CUstream_st(); 
+    ~CUstream_st();
     bool empty();
     bool busy();
     void synchronize();
     void push( const stream_operation &op );
     void record_next_done();
     stream_operation next();
-    stream_operation &front() { return m_operations.front(); }
+    stream_operation *front() { return m_operations.front(); } // NULL if none is ready
+    bool full() { return m_operations.full(); }
     void print( FILE *fp );
     unsigned get_uid() const { return m_uid; }
 
+    // readiness bookkeeping of the stream manager: a stream is scheduled
+    // while it waits in the ready queue or has an operation in progress
+    void set_manager( class stream_manager *manager ) { m_manager = manager; }
+    bool try_schedule() { return __sync_bool_compare_and_swap(&m_scheduled,0,1); }
+    void unschedule() { m_scheduled = 0; __sync_synchronize(); }
+    unsigned retire() { return __sync_sub_and_fetch(&m_size,1); }
+
 private:
     unsigned m_uid;
     static unsigned sm_next_stream_uid;
 
-    std::list<stream_operation> m_operations;
-    bool m_pending; // front operation has started but not yet completed
+    mpsc_ring<stream_operation> m_operations;
+    volatile unsigned m_size;
+    volatile int m_scheduled;
+    bool m_pending; // front operation has started but not yet completed (simulation thread only)
 
-    pthread_mutex_t m_lock; // ensure only one host or gpu manipulates stream operation at one time
+    class stream_manager *m_manager;
 };
 
+// Streams with a runnable operation wait in a ready queue, so the
+// simulation thread finds the next operation without scanning all streams.
+// Host threads append streams that become ready to m_ready; the simulation
+// thread keeps streams that are still non-empty after an operation
+// completes in m_ready_local.
 class stream_manager {
 public:
     stream_manager( gpgpu_sim *gpu, bool cuda_launch_blocking );
@@ -241,21 +268,44 @@ public:
     void add_stream( CUstream_st *stream );
     void destroy_stream( CUstream_st *stream );
     bool concurrent_streams_empty();
-    bool empty_protected();
     bool empty();
     void print( FILE *fp);
     void push( stream_operation op );
     bool operation(bool * sim);
+    // called by the simulation thread when the front operation of stream is retired
+    void operation_done( CUstream_st *stream );
+
+    // blocking hand-off between the host threads and the simulation thread;
+    // m_cond is broadcast, when anyone waits on it, whenever operations are
+    // pushed or completed
+    void wait_for_work( volatile bool *done );
+    void wait_event( class CUevent_st *e );
+    void wait_stream( CUstream_st *stream );
+    void wait_stream_space( CUstream_st *stream );
+    // unconditional broadcast, for state changed outside the stream manager
+    // (exit_simulation() setting the device's done flag)
+    void notify_all();
 private:
     void print_impl( FILE *fp);
+    void notify();
+    void begin_wait();
+    void end_wait();
+    CUstream_st *next_ready_stream();
 
     bool m_cuda_launch_blocking;
     gpgpu_sim *m_gpu;
-    std::list<CUstream_st *> m_streams;
+    std::list<CUstream_st *> m_streams; // guarded by m_lock
     std::map<unsigned,CUstream_st *> m_grid_id_to_stream;
     CUstream_st m_stream_zero;
     bool m_service_stream_zero;
+    volatile unsigned m_concurrent_ops; // operations queued on streams other than stream zero
+
+    mpsc_list<CUstream_st> m_ready;
+    std::deque<CUstream_st*> m_ready_local;
+
     pthread_mutex_t m_lock;
+    pthread_cond_t m_cond;
+    volatile unsigned m_waiters; // threads waiting on m_cond
 };
 
 #endif
@@ -27,6 +27,17 @@
 
 #include "trace.h"
 #include "string.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <assert.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <string>
+#include <vector>
+
+#include "gpgpusim_entrypoint.h"
 
 namespace Trace {
 
@@ -44,6 +55,10 @@ namespace Trace {
     int sampling_memory_partition = -1;
     bool trace_streams_enabled[NUM_TRACE_STREAMS] = {false};
     const char* config_str;
+    const char* binary_file = NULL;
+    bool binary_output = false;
+
+    static void binary_open( const char *filename );
 
     void init()
     {
@@ -52,5 +67,340 @@ namespace Trace {
                 trace_streams_enabled[ i ] = true;
             }
         }
+        if ( binary_file != NULL && enabled ) {
+            // every simulated device traces to its own file
+            binary_open( gpgpu_ptx_sim_output_filename(binary_file).c_str() );
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+    // binary trace output
+
+    // Single producer / single consumer ring of records. The owning thread
+    // only advances m_head, the flush thread only advances m_tail.
+    class binary_ring {
+    public:
+        static const unsigned size = 1 << 16; // records, must be a power of 2
+
+        binary_ring() : m_head(0), m_tail(0) { m_records = new binary_record_t[size]; }
+        ~binary_ring() { delete[] m_records; }
+
+        binary_record_t *slot( unsigned long long pos ) { return &m_records[pos & (size-1)]; }
+        unsigned long long head() const { return m_head; }
+        // waits for the flush thread until n more records fit
+        void wait_for_space( unsigned n );
+        void publish( unsigned n )
+        {
+            __sync_synchronize(); // records are written before they are visible
+            m_head = m_head + n;
+        }
+        // copies all published records to out, returns the number copied
+        unsigned drain( std::vector<binary_record_t> &out )
+        {
+            unsigned long long head = m_head;
+            __sync_synchronize();
+            unsigned long long tail = m_tail;
+            for (unsigned long long i = tail; i < head; i++) 
+                out.push_back(m_records[i & (size-1)]);
+            __sync_synchronize(); // copies complete before slots are reused
+            m_tail = head;
+            return head - tail;
+        }
+        bool half_full() const { return m_head - m_tail > size/2; }
+
+    private:
+        binary_record_t *m_records;
+        volatile unsigned long long m_head;
+        volatile unsigned long long m_tail;
+    };
+
+    struct binary_format_t {
+        std::string fmt;
+        int stream;
+        trace_prefix_type prefix;
+        unsigned flags;
+        std::vector<char> arg_kinds; // one per conversion, see parse_format()
+    };
+
+    // a trace file and the rings of the threads that trace to it
+    struct binary_file_t {
+        std::string name;
+        FILE *fp;
+        unsigned formats_written;
+        std::vector<binary_ring*> rings;
+    };
+
+    static std::vector<binary_file_t*> g_binary_files;
+    static pthread_mutex_t g_binary_lock = PTHREAD_MUTEX_INITIALIZER; // formats, rings, files
+    static pthread_cond_t g_binary_wakeup = PTHREAD_COND_INITIALIZER;
+    static pthread_t g_binary_thread;
+    static bool g_binary_thread_running = false;
+    static bool g_binary_stop = false;
+    // fixed capacity so that producers can read registered entries without
+    // taking the lock while other threads register new ones
+    static const unsigned max_binary_formats = 1 << 14;
+    static binary_format_t *g_binary_formats[max_binary_formats];
+    static unsigned g_binary_n_formats = 0;
+    static __thread binary_file_t *t_binary_file = NULL; // opened by this thread
+    static __thread binary_ring *t_binary_ring = NULL;
+
+    void binary_ring::wait_for_space( unsigned n )
+    {
+        assert( n <= size );
+        while ( size - (m_head - m_tail) < n ) {
+            pthread_mutex_lock(&g_binary_lock);
+            pthread_cond_signal(&g_binary_wakeup);
+            pthread_mutex_unlock(&g_binary_lock);
+            sched_yield();
+        }
+    }
+
+    // Records the argument kinds of a printf format: 'i' int, 'l' long,
+    // 'L' long long, 'd' double, 'p' pointer, 's' string. Returns false for
+    // formats the packer cannot handle; those are formatted at trace time.
+    static bool parse_format( const char *fmt, std::vector<char> &kinds )
+    {
+        for ( const char *c = fmt; *c; c++ ) {
+            if ( *c != '%' ) continue;
+            c++;
+            if ( *c == '%' ) continue;
+            while ( *c && strchr("-+ #0123456789.", *c) ) c++;
+            if ( *c == '*' ) return false;
+            int longs = 0;
+            while ( *c && strchr("hlqjzt", *c) ) {
+                if ( *c == 'l' ) longs++;
+                if ( *c == 'q' || *c == 'j' ) longs = 2;
+                if ( (*c == 'z' || *c == 't') && sizeof(size_t) == sizeof(long) ) longs = 1;
+                c++;
+            }
+            switch ( *c ) {
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+                kinds.push_back( longs == 0? 'i' : (longs == 1? 'l' : 'L') );
+                break;
+            case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                kinds.push_back('d');
+                break;
+            case 'p': kinds.push_back('p'); break;
+            case 's': kinds.push_back('s'); break;
+            default: return false; // 'n', 'L' doubles, wide chars, malformed
+            }
+            if ( !*c ) return false;
+        }
+        return kinds.size() <= binary_record_args;
+    }
+
+    static void write_u32( FILE *fp, unsigned v ) { fwrite(&v,sizeof(v),1,fp); }
+
+    // called with g_binary_lock held; format ids are global, so every file
+    // gets all formats registered so far
+    static void write_new_formats( binary_file_t &file )
+    {
+        for ( ; file.formats_written < g_binary_n_formats; file.formats_written++ ) {
+            const binary_format_t &f = *g_binary_formats[file.formats_written];
+            write_u32(file.fp,BLOCK_FORMAT_DEF);
+            write_u32(file.fp,file.formats_written);
+            write_u32(file.fp,f.stream);
+            write_u32(file.fp,f.prefix);
+            write_u32(file.fp,f.flags);
+            write_u32(file.fp,f.fmt.size());
+            fwrite(f.fmt.data(),1,f.fmt.size(),file.fp);
+        }
+    }
+
+    static void binary_flush( std::vector<binary_record_t> &batch )
+    {
+        pthread_mutex_lock(&g_binary_lock);
+        for ( unsigned i = 0; i < g_binary_files.size(); i++ ) {
+            binary_file_t &file = *g_binary_files[i];
+            batch.clear();
+            for ( unsigned r = 0; r < file.rings.size(); r++ ) 
+                file.rings[r]->drain(batch);
+            // every drained record refers to a format registered before it was
+            // published, so writing the formats after draining is sufficient
+            write_new_formats(file);
+            if ( !batch.empty() ) {
+                write_u32(file.fp,BLOCK_RECORDS);
+                write_u32(file.fp,batch.size());
+                fwrite(&batch[0],sizeof(binary_record_t),batch.size(),file.fp);
+            }
+        }
+        pthread_mutex_unlock(&g_binary_lock);
+    }
+
+    static void *binary_flush_thread( void * )
+    {
+        std::vector<binary_record_t> batch;
+        pthread_mutex_lock(&g_binary_lock);
+        while ( !g_binary_stop ) {
+            struct timeval now;
+            gettimeofday(&now,NULL);
+            struct timespec timeout;
+            timeout.tv_sec = now.tv_sec + (now.tv_usec + 10000) / 1000000;
+            timeout.tv_nsec = ((now.tv_usec + 10000) % 1000000) * 1000;
+            pthread_cond_timedwait(&g_binary_wakeup,&g_binary_lock,&timeout);
+            pthread_mutex_unlock(&g_binary_lock);
+            binary_flush(batch);
+            pthread_mutex_lock(&g_binary_lock);
+        }
+        pthread_mutex_unlock(&g_binary_lock);
+        return NULL;
+    }
+
+    // opens the trace file of the calling thread's device; a single flush
+    // thread serves all files
+    static void binary_open( const char *filename )
+    {
+        pthread_mutex_lock(&g_binary_lock);
+        for ( unsigned i = 0; i < g_binary_files.size(); i++ ) {
+            if ( g_binary_files[i]->name == filename ) {
+                t_binary_file = g_binary_files[i];
+                pthread_mutex_unlock(&g_binary_lock);
+                return;
+            }
+        }
+        FILE *fp = fopen(filename,"wb");
+        if ( fp == NULL ) {
+            printf("GPGPU-Sim: error - could not open binary trace file %s\n", filename);
+            exit(1);
+        }
+        fwrite(binary_file_magic,1,sizeof(binary_file_magic),fp);
+        write_u32(fp,binary_file_version);
+        write_u32(fp,sizeof(binary_record_t));
+        for ( unsigned i = 0; i < NUM_TRACE_STREAMS; i++ ) {
+            write_u32(fp,BLOCK_STREAM_DEF);
+            write_u32(fp,i);
+            write_u32(fp,strlen(trace_streams_str[i]));
+            fwrite(trace_streams_str[i],1,strlen(trace_streams_str[i]),fp);
+        }
+        binary_file_t *file = new binary_file_t;
+        file->name = filename;
+        file->fp = fp;
+        file->formats_written = 0;
+        g_binary_files.push_back(file);
+        t_binary_file = file;
+        binary_output = true;
+        if ( !g_binary_thread_running ) {
+            g_binary_thread_running = true;
+            pthread_create(&g_binary_thread,NULL,binary_flush_thread,NULL);
+            atexit(binary_close);
+        }
+        pthread_mutex_unlock(&g_binary_lock);
+    }
+
+    void binary_close()
+    {
+        pthread_mutex_lock(&g_binary_lock);
+        bool running = g_binary_thread_running;
+        g_binary_thread_running = false;
+        g_binary_stop = true;
+        pthread_cond_signal(&g_binary_wakeup);
+        pthread_mutex_unlock(&g_binary_lock);
+        if ( !running )
+            return;
+        pthread_join(g_binary_thread,NULL);
+        std::vector<binary_record_t> batch;
+        binary_flush(batch);
+        pthread_mutex_lock(&g_binary_lock);
+        for ( unsigned i = 0; i < g_binary_files.size(); i++ ) 
+            fclose(g_binary_files[i]->fp);
+        g_binary_files.clear();
+        binary_output = false;
+        pthread_mutex_unlock(&g_binary_lock);
+    }
+
+    void binary_record( int *fmt_id, unsigned long long cycle, int stream, trace_prefix_type prefix,
+                        int unit, int subunit, const char *fmt, ... )
+    {
+        if ( t_binary_ring == NULL ) {
+            // threads that did not open a trace file (e.g. the host thread)
+            // trace to the first device's file
+            t_binary_ring = new binary_ring();
+            pthread_mutex_lock(&g_binary_lock);
+            if ( t_binary_file == NULL ) 
+                t_binary_file = g_binary_files[0];
+            t_binary_file->rings.push_back(t_binary_ring);
+            pthread_mutex_unlock(&g_binary_lock);
+        }
+        // call sites register lazily from whichever thread traces first;
+        // the id is published with release semantics once the format is in place
+        int id = __atomic_load_n(fmt_id, __ATOMIC_ACQUIRE);
+        if ( id < 0 ) {
+            binary_format_t *f = new binary_format_t;
+            f->fmt = fmt;
+            f->stream = stream;
+            f->prefix = prefix;
+            f->flags = parse_format(fmt,f->arg_kinds)? 0 : FORMAT_PREFORMATTED;
+            pthread_mutex_lock(&g_binary_lock);
+            id = __atomic_load_n(fmt_id, __ATOMIC_RELAXED);
+            if ( id < 0 ) {
+                if ( g_binary_n_formats == max_binary_formats ) {
+                    printf("GPGPU-Sim: error - too many trace call sites for the binary trace\n");
+                    abort();
+                }
+                g_binary_formats[g_binary_n_formats] = f;
+                id = g_binary_n_formats++;
+                __atomic_store_n(fmt_id, id, __ATOMIC_RELEASE);
+            } else {
+                delete f;
+            }
+            pthread_mutex_unlock(&g_binary_lock);
+        }
+        // registered formats are never modified
+        const binary_format_t &f = *g_binary_formats[id];
+
+        binary_record_t r;
+        memset(&r,0,sizeof(r));
+        r.cycle = cycle;
+        r.fmt_id = id;
+        r.unit = unit;
+        r.subunit = subunit;
+        std::string strings; // NUL terminated %s arguments
+        va_list ap;
+        va_start(ap,fmt);
+        if ( f.flags & FORMAT_PREFORMATTED ) {
+            char buf[1024];
+            vsnprintf(buf,sizeof(buf),fmt,ap);
+            strings.append(buf,strlen(buf)+1);
+        } else {
+            for ( unsigned a = 0; a < f.arg_kinds.size(); a++ ) {
+                switch ( f.arg_kinds[a] ) {
+                case 'i': r.arg[a] = (long long)va_arg(ap,int); break;
+                case 'l': r.arg[a] = (long long)va_arg(ap,long); break;
+                case 'L': r.arg[a] = va_arg(ap,long long); break;
+                case 'd': { double d = va_arg(ap,double); memcpy(&r.arg[a],&d,sizeof(d)); } break;
+                case 'p': r.arg[a] = (unsigned long long)(size_t)va_arg(ap,void*); break;
+                case 's': {
+                    const char *str = va_arg(ap,const char*);
+                    if ( str == NULL ) str = "(null)";
+                    r.arg[a] = strings.size();
+                    strings.append(str,strlen(str)+1);
+                    } break;
+                }
+            }
+        }
+        va_end(ap);
+
+        r.n_cont = (strings.size() + sizeof(binary_record_t) - 1) / sizeof(binary_record_t);
+        if ( r.n_cont + 1 > binary_ring::size / 2 ) {
+            // keep huge strings from monopolizing the ring
+            r.n_cont = binary_ring::size / 2 - 1;
+            strings.resize(r.n_cont * sizeof(binary_record_t));
+            strings[strings.size()-1] = '\0';
+        }
+        binary_ring *ring = t_binary_ring;
+        ring->wait_for_space(r.n_cont + 1);
+        unsigned long long pos = ring->head();
+        *ring->slot(pos) = r;
+        for ( unsigned c = 0; c < r.n_cont; c++ ) {
+            binary_record_t *slot = ring->slot(pos + 1 + c);
+            size_t offset = c * sizeof(binary_record_t);
+            size_t len = strings.size() - offset;
+            if ( len > sizeof(binary_record_t) ) len = sizeof(binary_record_t);
+            memset(slot,0,sizeof(binary_record_t));
+            memcpy(slot,strings.data() + offset,len);
+        }
+        ring->publish(r.n_cont + 1);
+        if ( ring->half_full() ) 
+            pthread_cond_signal(&g_binary_wakeup);
     }
 } 
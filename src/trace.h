@@ -31,8 +31,8 @@
 #ifndef __TRACE_H__
 #define __TRACE_H__
 
-extern unsigned long long  gpu_sim_cycle;
-extern unsigned long long  gpu_tot_sim_cycle;
+extern __thread unsigned long long  gpu_sim_cycle;
+extern __thread unsigned long long  gpu_tot_sim_cycle;
 
 namespace Trace {
 
@@ -50,9 +50,61 @@ namespace Trace {
     extern const char* trace_streams_str[];
     extern bool trace_streams_enabled[NUM_TRACE_STREAMS];
     extern const char* config_str;
+    extern const char* binary_file;
+    extern bool binary_output;
 
     void init();
 
+    // Binary trace output (-trace_binary_file).
+    //
+    // Instead of printing, each trace call appends a fixed-size record to a
+    // lock-free ring buffer owned by the calling thread. A background thread
+    // drains the rings into the trace file of the thread's device (with
+    // several simulated devices, each writes its own file, see
+    // gpgpu_ptx_sim_output_filename); trace_decode renders the file as
+    // the text the printf-based trace would have produced. The format string
+    // of a call site is registered once and referred to by id, arguments are
+    // stored as raw 64-bit words and %s arguments are copied into
+    // continuation records that follow the event record.
+
+    // which *_DPRINTF family produced a record (selects the printed prefix)
+    enum trace_prefix_type {
+        PREFIX_SIM = 0,     // DPRINTF
+        PREFIX_SHADER,      // SHADER_DPRINTF
+        PREFIX_SCHED,       // SCHED_DPRINTF
+        PREFIX_MEMPART      // MEMPART_DPRINTF
+    };
+
+    const unsigned binary_record_args = 5;
+    struct binary_record_t {
+        unsigned long long cycle;
+        unsigned fmt_id;
+        short unit;            // core / memory partition id
+        short subunit;         // scheduler id
+        unsigned n_cont;       // continuation records holding string args
+        unsigned pad;
+        unsigned long long arg[binary_record_args];
+    };
+
+    // file layout: binary_file_magic, u32 version, u32 sizeof(binary_record_t)
+    // followed by blocks starting with a u32 block type
+    const char binary_file_magic[8] = {'G','P','U','S','I','M','T','R'};
+    const unsigned binary_file_version = 1;
+    enum binary_block_type {
+        BLOCK_STREAM_DEF = 1,   // u32 id, u32 len, name
+        BLOCK_FORMAT_DEF,       // u32 id, u32 stream, u32 prefix, u32 flags, u32 len, fmt
+        BLOCK_RECORDS           // u32 count, count*binary_record_t
+    };
+    // format flag: the record holds the message formatted at trace time
+    // (format strings the packer does not understand, e.g. with '*' widths)
+    const unsigned FORMAT_PREFORMATTED = 1;
+
+    // *fmt_id is the call site's format slot (-1 until registered); it is read and
+    // published atomically, so a call site may first fire on any thread
+    void binary_record( int *fmt_id, unsigned long long cycle, int stream, trace_prefix_type prefix,
+                        int unit, int subunit, const char *fmt, ... );
+    void binary_close();
+
 } // namespace Trace
 
 
@@ -62,10 +114,16 @@ namespace Trace {
 #define DTRACE(x) ((Trace::trace_streams_enabled[Trace::x]) && Trace::enabled)
 #define DPRINTF(x, ...) do {\
     if (DTRACE(x)) {\
-        printf( SIM_PRINT_STR,\
-                gpu_sim_cycle + gpu_tot_sim_cycle,\
-                Trace::trace_streams_str[Trace::x] );\
-        printf(__VA_ARGS__);\
+        if (Trace::binary_output) {\
+            static int trace_fmt_id = -1;\
+            Trace::binary_record( &trace_fmt_id, gpu_sim_cycle + gpu_tot_sim_cycle,\
+                                  Trace::x, Trace::PREFIX_SIM, -1, -1, __VA_ARGS__ );\
+        } else {\
+            printf( SIM_PRINT_STR,\
+                    gpu_sim_cycle + gpu_tot_sim_cycle,\
+                    Trace::trace_streams_str[Trace::x] );\
+            printf(__VA_ARGS__);\
+        }\
     }\
 } while (0)
 
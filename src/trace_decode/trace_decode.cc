@@ -0,0 +1,199 @@
+// Copyright (c) 2009-2013, Tor M. Aamodt, Timothy Rogers,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Renders a binary trace written with -trace_binary_file as the text the
+// printf-based DPRINTF/SHADER_DPRINTF/SCHED_DPRINTF/MEMPART_DPRINTF would
+// have printed.
+//
+// usage: trace_decode <binary trace file>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#ifndef TRACING_ON
+#define TRACING_ON 1
+#endif
+#include "../trace.h"
+#include "../gpgpu-sim/shader_trace.h"
+#include "../gpgpu-sim/l2cache_trace.h"
+
+// the trace headers refer to the simulator's cycle counters
+__thread unsigned long long gpu_sim_cycle = 0;
+__thread unsigned long long gpu_tot_sim_cycle = 0;
+
+struct format_def {
+   unsigned stream;
+   unsigned prefix;
+   unsigned flags;
+   std::string fmt;
+};
+
+static bool read_u32( FILE *fp, unsigned &v )
+{
+   return fread(&v,sizeof(v),1,fp) == 1;
+}
+
+static bool read_str( FILE *fp, std::string &s )
+{
+   unsigned len;
+   if (!read_u32(fp,len) || len > (1U << 20))
+      return false;
+   s.resize(len);
+   return len == 0 || fread(&s[0],1,len,fp) == len;
+}
+
+// prints one conversion spec with its argument word
+static void print_arg( const std::string &spec, char kind, unsigned long long word, const char *strings )
+{
+   const char *f = spec.c_str();
+   switch (kind) {
+   case 'i': printf(f,(int)word); break;
+   case 'l': printf(f,(long)word); break;
+   case 'L': printf(f,(long long)word); break;
+   case 'd': { double d; memcpy(&d,&word,sizeof(d)); printf(f,d); } break;
+   case 'p': printf(f,(void*)(size_t)word); break;
+   case 's': printf(f,strings + word); break;
+   }
+}
+
+// mirrors Trace::parse_format() in trace.cc
+static void print_message( const std::string &fmt, const Trace::binary_record_t &r, const char *strings )
+{
+   unsigned a = 0;
+   const char *c = fmt.c_str();
+   while (*c) {
+      if (*c != '%') {
+         putchar(*c++);
+         continue;
+      }
+      const char *start = c++;
+      if (*c == '%') {
+         putchar('%');
+         c++;
+         continue;
+      }
+      while (*c && strchr("-+ #0123456789.", *c)) c++;
+      int longs = 0;
+      while (*c && strchr("hlqjzt", *c)) {
+         if (*c == 'l') longs++;
+         if (*c == 'q' || *c == 'j') longs = 2;
+         if ((*c == 'z' || *c == 't') && sizeof(size_t) == sizeof(long)) longs = 1;
+         c++;
+      }
+      char kind;
+      switch (*c) {
+      case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A': kind = 'd'; break;
+      case 'p': kind = 'p'; break;
+      case 's': kind = 's'; break;
+      default: kind = (longs == 0)? 'i' : ((longs == 1)? 'l' : 'L'); break;
+      }
+      c++;
+      if (a < Trace::binary_record_args)
+         print_arg(std::string(start,c-start),kind,r.arg[a++],strings);
+   }
+}
+
+int main( int argc, char **argv )
+{
+   if (argc != 2) {
+      fprintf(stderr,"usage: %s <binary trace file>\n", argv[0]);
+      return 1;
+   }
+   FILE *fp = fopen(argv[1],"rb");
+   if (fp == NULL) {
+      fprintf(stderr,"error - could not open %s\n", argv[1]);
+      return 1;
+   }
+   char magic[sizeof(Trace::binary_file_magic)];
+   unsigned version, record_size;
+   if (fread(magic,1,sizeof(magic),fp) != sizeof(magic) || memcmp(magic,Trace::binary_file_magic,sizeof(magic)) != 0 
+       || !read_u32(fp,version) || !read_u32(fp,record_size)) {
+      fprintf(stderr,"error - %s is not a GPGPU-Sim binary trace\n", argv[1]);
+      return 1;
+   }
+   if (version != Trace::binary_file_version || record_size != sizeof(Trace::binary_record_t)) {
+      fprintf(stderr,"error - %s: unsupported trace version %u (record size %u)\n", argv[1], version, record_size);
+      return 1;
+   }
+
+   std::map<unsigned,std::string> streams;
+   std::map<unsigned,format_def> formats;
+   std::vector<Trace::binary_record_t> records;
+   unsigned block;
+   bool ok = true;
+   while (ok && read_u32(fp,block)) {
+      unsigned id;
+      if (block == Trace::BLOCK_STREAM_DEF) {
+         ok = read_u32(fp,id) && read_str(fp,streams[id]);
+      } else if (block == Trace::BLOCK_FORMAT_DEF) {
+         format_def def;
+         ok = read_u32(fp,id) && read_u32(fp,def.stream) && read_u32(fp,def.prefix) 
+              && read_u32(fp,def.flags) && read_str(fp,def.fmt);
+         if (ok) formats[id] = def;
+      } else if (block == Trace::BLOCK_RECORDS) {
+         unsigned count;
+         ok = read_u32(fp,count) && count <= (1U << 24);
+         if (!ok) break;
+         records.resize(count);
+         ok = count == 0 || fread(&records[0],sizeof(Trace::binary_record_t),count,fp) == count;
+         for (unsigned i = 0; ok && i < count; i++) {
+            const Trace::binary_record_t &r = records[i];
+            std::map<unsigned,format_def>::const_iterator f = formats.find(r.fmt_id);
+            if (f == formats.end() || r.n_cont > count - i - 1) {
+               ok = false;
+               break;
+            }
+            std::string strings((const char*)&records[i+1], r.n_cont*sizeof(Trace::binary_record_t));
+            strings.push_back('\0');
+            const char *stream = streams[f->second.stream].c_str();
+            switch (f->second.prefix) {
+            case Trace::PREFIX_SHADER: printf(SHADER_PRINT_STR, r.cycle, stream, r.unit); break;
+            case Trace::PREFIX_SCHED: printf(SCHED_PRINT_STR, r.cycle, stream, r.unit, r.subunit); break;
+            case Trace::PREFIX_MEMPART: printf(MEMPART_PRINT_STR, r.cycle, stream, r.unit); break;
+            default: printf(SIM_PRINT_STR, r.cycle, stream); break;
+            }
+            if (f->second.flags & Trace::FORMAT_PREFORMATTED)
+               fputs(strings.c_str(),stdout);
+            else
+               print_message(f->second.fmt,r,strings.c_str());
+            i += r.n_cont;
+         }
+      } else {
+         ok = false;
+      }
+   }
+   fclose(fp);
+   if (!ok) {
+      fprintf(stderr,"error - %s: truncated or corrupted trace\n", argv[1]);
+      return 1;
+   }
+   return 0;
+}